@@ -0,0 +1,449 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 内核吞吐量基准测试,按照Thread-Metric的七项测试编写:
+ * cooperative  5个同优先级任务,计数后eTaskYield()
+ * preemptive   5个不同优先级的任务,依次eTaskResume()更高优先级的任务后挂起自己
+ * interrupt    任务产生软件中断,中断中eSemGive(),任务eSemTake()
+ * irqpreempt   任务产生软件中断,中断中eTaskResume()更高优先级的任务
+ * message      一个任务向EASYRTOS_QUEUE发送16字节消息后取回
+ * sync         一个任务eSemTake()后eSemGive()
+ * memory       一个任务eMalloc(128)后eFree()
+ * 报告任务的优先级最高,每项测试运行TM_PERIODS个TM_INTERVAL_S秒的周期,
+ * 每个周期输出一次完成的操作数,测试之间删除所有测试任务.
+ * 平台有关的部分见tmPort.h.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+#include "easyRTOSQueue.h"
+#include "easyRTOSMm.h"
+#include "tmPort.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define TM_STACK_SIZE_BYTES    192
+
+/* 每个周期的秒数以及每项测试的周期数 */
+#ifndef TM_INTERVAL_S
+#define TM_INTERVAL_S          30
+#endif
+#ifndef TM_PERIODS
+#define TM_PERIODS             1
+#endif
+
+#define TM_TASK_NUM            5
+#define TM_REPORT_PRIO         1
+#define TM_TASK_PRIO           10
+#define TM_MSG_WORDS           4
+#define TM_QUEUE_DEEP          10
+#define TM_ALLOC_SIZE          128
+#define TM_HEAP_SIZE           512
+
+typedef struct tm_test
+{
+  const char *name;
+  void (*start)(void);        /* 创建测试任务,任务在报告任务延时后开始运行 */
+  uint8_t (*check)(void);     /* 检查计数是否合理,TRUE为正常 */
+} TM_TEST;
+
+NEAR static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+NEAR static uint8_t reportTaskStack[TM_STACK_SIZE_BYTES];
+NEAR static uint8_t tmTaskStack[TM_TASK_NUM][TM_STACK_SIZE_BYTES];
+static uint8_t heapRoom[TM_HEAP_SIZE];
+static uint32_t queueBuff[TM_QUEUE_DEEP * TM_MSG_WORDS];
+
+EASYRTOS_TCB reportTcb;
+EASYRTOS_TCB tmTcb[TM_TASK_NUM];
+EASYRTOS_SEM tmSem;
+EASYRTOS_QUEUE tmQueue;
+
+/* 每个测试任务以及中断的计数 */
+static volatile uint32_t tmCounter[TM_TASK_NUM];
+static volatile uint32_t tmIsrCounter;
+static volatile uint32_t tmErrors;
+static uint8_t tmTaskNum;
+
+void reportTaskFunc (uint32_t param);
+void cooperativeTaskFunc (uint32_t param);
+void preemptiveTaskFunc (uint32_t param);
+void interruptTaskFunc (uint32_t param);
+void irqPreemptTaskFunc (uint32_t param);
+void messageTaskFunc (uint32_t param);
+void syncTaskFunc (uint32_t param);
+void memoryTaskFunc (uint32_t param);
+static void cooperativeStart (void);
+static void preemptiveStart (void);
+static void interruptStart (void);
+static void irqPreemptStart (void);
+static void messageStart (void);
+static void syncStart (void);
+static void memoryStart (void);
+static uint8_t balanceCheck (void);
+static uint8_t interruptCheck (void);
+static uint8_t errorCheck (void);
+static void interruptIsr (void);
+static void irqPreemptIsr (void);
+static void tmTaskCreate (uint8_t n, uint8_t prio, void (*entry)(uint32_t));
+static void tmPutDec (uint32_t value, uint8_t width);
+
+static const TM_TEST tmTests[] =
+{
+  { "cooperative", cooperativeStart, balanceCheck },
+  { "preemptive",  preemptiveStart,  balanceCheck },
+  { "interrupt",   interruptStart,   interruptCheck },
+  { "irqpreempt",  irqPreemptStart,  interruptCheck },
+  { "message",     messageStart,     errorCheck },
+  { "sync",        syncStart,        errorCheck },
+  { "memory",      memoryStart,      errorCheck }
+};
+
+int main( void )
+{
+  ERESULT status;
+
+  tmPortInit ();
+
+  status = easyRTOSInit(&idleTaskStack[0], IDLE_STACK_SIZE_BYTES);
+  if (status == EASYRTOS_OK)
+  {
+    archInitSystemTickTimer();
+
+    eMemInit(heapRoom, TM_HEAP_SIZE);
+
+    status += eTaskCreat(&reportTcb, TM_REPORT_PRIO, reportTaskFunc, 0,
+                 &reportTaskStack[0], TM_STACK_SIZE_BYTES, "REPORT", 1);
+    if (status == EASYRTOS_OK)
+    {
+      easyRTOSStart();
+    }
+  }
+
+  tmPortPuts ("tmBench: init failed\r\n");
+  return 0;
+}
+
+/* 依次运行各项测试,报告任务延时期间测试任务运行 */
+void reportTaskFunc (uint32_t param)
+{
+  uint8_t t;
+  uint8_t i;
+  uint8_t period;
+  uint32_t ops;
+  uint32_t last;
+  const char *name;
+
+  tmPortPuts ("tmBench: ops per ");
+  tmPutDec (TM_INTERVAL_S, 0);
+  tmPortPuts (" s\r\n");
+
+  for (t = 0; t < sizeof(tmTests)/sizeof(tmTests[0]); t++)
+  {
+    for (i = 0; i < TM_TASK_NUM; i++)
+    {
+      tmCounter[i] = 0;
+    }
+    tmIsrCounter = 0;
+    tmErrors = 0;
+    tmTaskNum = 0;
+    tmTests[t].start ();
+
+    last = 0;
+    for (period = 1; period <= TM_PERIODS; period++)
+    {
+      (void)eTimerDelay (DELAY_S(TM_INTERVAL_S));
+
+      /* 报告任务优先级最高,读取期间计数不会变化 */
+      ops = 0;
+      for (i = 0; i < tmTaskNum; i++)
+      {
+        ops += tmCounter[i];
+      }
+      ops += tmIsrCounter;
+
+      /* 名称左对齐到12个字符 */
+      tmPortPuts (tmTests[t].name);
+      for (name = tmTests[t].name; *name; name++)
+      {
+        ;
+      }
+      tmPortPuts (&"            "[name - tmTests[t].name]);
+      tmPortPuts ("period ");
+      tmPutDec (period, 0);
+      tmPortPuts (" ops");
+      tmPutDec (ops - last, 12);
+      tmPortPuts (tmTests[t].check () ? "\r\n" : " ERROR\r\n");
+      last = ops;
+    }
+
+    for (i = 0; i < tmTaskNum; i++)
+    {
+      (void)eTaskDelete (&tmTcb[i], 0);
+    }
+  }
+
+  tmPortDone ();
+  (void)eTaskSuspend (&reportTcb);
+}
+
+/* 创建第n个测试任务 */
+static void tmTaskCreate (uint8_t n, uint8_t prio, void (*entry)(uint32_t))
+{
+  if (eTaskCreat(&tmTcb[n], prio, entry, n, &tmTaskStack[n][0],
+                 TM_STACK_SIZE_BYTES, "TM", 10 + n) == EASYRTOS_OK)
+  {
+    tmTaskNum = n + 1;
+  }
+  else
+  {
+    tmErrors++;
+  }
+}
+
+/* 协作调度 */
+static void cooperativeStart (void)
+{
+  uint8_t i;
+
+  for (i = 0; i < TM_TASK_NUM; i++)
+  {
+    tmTaskCreate (i, TM_TASK_PRIO, cooperativeTaskFunc);
+  }
+}
+
+void cooperativeTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    tmCounter[param]++;
+    eTaskYield ();
+  }
+}
+
+/* 抢占调度,任务0优先级最低,只有任务0一开始就绪 */
+static void preemptiveStart (void)
+{
+  uint8_t i;
+
+  for (i = 0; i < TM_TASK_NUM; i++)
+  {
+    tmTaskCreate (i, (uint8_t)(TM_TASK_PRIO - i), preemptiveTaskFunc);
+    if (i != 0)
+    {
+      (void)eTaskSuspend (&tmTcb[i]);
+    }
+  }
+}
+
+void preemptiveTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    tmCounter[param]++;
+    if (param < TM_TASK_NUM - 1)
+    {
+      (void)eTaskResume (&tmTcb[param + 1]);
+    }
+    if (param != 0)
+    {
+      (void)eTaskSuspend (&tmTcb[param]);
+    }
+  }
+}
+
+/* 中断处理 */
+static void interruptStart (void)
+{
+  tmSem = eSemCreateCount (0);
+  tmPortIrqConnect (interruptIsr);
+  tmTaskCreate (0, TM_TASK_PRIO, interruptTaskFunc);
+}
+
+void interruptTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    tmPortIrqRaise ();
+    if (eSemTake (&tmSem, -1) == EASYRTOS_OK)
+    {
+      tmCounter[param]++;
+    }
+    else
+    {
+      tmErrors++;
+    }
+  }
+}
+
+static void interruptIsr (void)
+{
+  tmIsrCounter++;
+  (void)eSemGive (&tmSem);
+}
+
+/* 中断抢占,任务1优先级较高,由中断恢复 */
+static void irqPreemptStart (void)
+{
+  tmPortIrqConnect (irqPreemptIsr);
+  tmTaskCreate (0, TM_TASK_PRIO, irqPreemptTaskFunc);
+  tmTaskCreate (1, TM_TASK_PRIO - 1, irqPreemptTaskFunc);
+  (void)eTaskSuspend (&tmTcb[1]);
+}
+
+void irqPreemptTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    if (param == 0)
+    {
+      tmPortIrqRaise ();
+    }
+    tmCounter[param]++;
+    if (param != 0)
+    {
+      (void)eTaskSuspend (&tmTcb[param]);
+    }
+  }
+}
+
+static void irqPreemptIsr (void)
+{
+  tmIsrCounter++;
+  (void)eTaskResume (&tmTcb[1]);
+}
+
+/* 消息处理 */
+static void messageStart (void)
+{
+  tmQueue = eQueueCreate ((void *)queueBuff, TM_MSG_WORDS * sizeof(uint32_t), TM_QUEUE_DEEP);
+  tmTaskCreate (0, TM_TASK_PRIO, messageTaskFunc);
+}
+
+void messageTaskFunc (uint32_t param)
+{
+  uint32_t msgOut[TM_MSG_WORDS];
+  uint32_t msgIn[TM_MSG_WORDS];
+  uint8_t i;
+
+  for (i = 0; i < TM_MSG_WORDS; i++)
+  {
+    msgOut[i] = i;
+  }
+
+  for (;;)
+  {
+    if ((eQueueGive (&tmQueue, -1, msgOut) != EASYRTOS_OK)
+        || (eQueueTake (&tmQueue, -1, msgIn) != EASYRTOS_OK)
+        || (msgIn[0] != msgOut[0]) || (msgIn[TM_MSG_WORDS - 1] != msgOut[TM_MSG_WORDS - 1]))
+    {
+      tmErrors++;
+    }
+    msgOut[0]++;
+    msgOut[TM_MSG_WORDS - 1]++;
+    tmCounter[param]++;
+  }
+}
+
+/* 同步 */
+static void syncStart (void)
+{
+  tmSem = eSemCreateCount (1);
+  tmTaskCreate (0, TM_TASK_PRIO, syncTaskFunc);
+}
+
+void syncTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    if ((eSemTake (&tmSem, -1) != EASYRTOS_OK) || (eSemGive (&tmSem) != EASYRTOS_OK))
+    {
+      tmErrors++;
+    }
+    tmCounter[param]++;
+  }
+}
+
+/* 内存分配 */
+static void memoryStart (void)
+{
+  tmTaskCreate (0, TM_TASK_PRIO, memoryTaskFunc);
+}
+
+void memoryTaskFunc (uint32_t param)
+{
+  uint8_t *addr;
+
+  for (;;)
+  {
+    addr = eMalloc (TM_ALLOC_SIZE);
+    if (addr != NULL)
+    {
+      eFree (addr);
+    }
+    else
+    {
+      tmErrors++;
+    }
+    tmCounter[param]++;
+  }
+}
+
+/* 各任务的计数相差不超过1 */
+static uint8_t balanceCheck (void)
+{
+  uint8_t i;
+  uint32_t min = tmCounter[0];
+  uint32_t max = tmCounter[0];
+
+  for (i = 1; i < tmTaskNum; i++)
+  {
+    if (tmCounter[i] < min)
+    {
+      min = tmCounter[i];
+    }
+    if (tmCounter[i] > max)
+    {
+      max = tmCounter[i];
+    }
+  }
+
+  return ((tmErrors == 0) && (tmTaskNum == TM_TASK_NUM) && (max - min <= 1));
+}
+
+/* 每次中断对应一次任务的计数 */
+static uint8_t interruptCheck (void)
+{
+  uint32_t diff = tmIsrCounter - tmCounter[tmTaskNum - 1];
+
+  return ((tmErrors == 0) && (tmIsrCounter != 0) && ((diff == 0) || (diff == 1)));
+}
+
+static uint8_t errorCheck (void)
+{
+  return ((tmErrors == 0) && (tmCounter[0] != 0));
+}
+
+/* 输出十进制数,右对齐到width个字符,width为0时不补空格 */
+static void tmPutDec (uint32_t value, uint8_t width)
+{
+  char buff[16];
+  uint8_t len = sizeof(buff) - 1;
+
+  buff[len] = '\0';
+  do
+  {
+    buff[--len] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+
+  while ((len > 0) && ((uint8_t)(sizeof(buff) - 1 - len) < width))
+  {
+    buff[--len] = ' ';
+  }
+
+  tmPortPuts (&buff[len]);
+}
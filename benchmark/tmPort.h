@@ -0,0 +1,28 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 吞吐量基准测试(tmBenchmain.c)与平台有关的部分.
+ * STM8见tmPortStm8.c,软件中断使用trap指令,结果通过UART1输出;
+ * Linux主机仿真见tmPortLinux.c,软件中断使用archSoftIrqRaise(),结果输出到stdout.
+ */
+#ifndef __TMPORT__H__
+#define __TMPORT__H__
+
+/* 软件中断的处理函数,在中断上下文中运行,可以调用内核接口 */
+typedef void ( * TM_IRQ_FUNC ) ( void ) ;
+
+extern void tmPortInit (void);
+extern void tmPortIrqConnect (TM_IRQ_FUNC handler);
+extern void tmPortIrqRaise (void);
+extern void tmPortPuts (const char *s);
+extern void tmPortDone (void);
+
+#if defined(__SDCC)
+/* SDCC要求中断函数的原型在main()所在的文件中可见 */
+INTERRUPT_HANDLER_TRAP(TM_TrapISR);
+#endif
+
+#endif
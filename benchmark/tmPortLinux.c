@@ -0,0 +1,41 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 吞吐量基准测试的Linux主机仿真部分,软件中断使用移植的SIGUSR1.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "tmPort.h"
+
+void tmPortInit (void)
+{
+    setvbuf (stdout, NULL, _IOLBF, 0);
+}
+
+void tmPortIrqConnect (TM_IRQ_FUNC handler)
+{
+    archSoftIrqConnect (handler);
+}
+
+void tmPortIrqRaise (void)
+{
+    archSoftIrqRaise ();
+}
+
+void tmPortPuts (const char *s)
+{
+    (void)fputs (s, stdout);
+}
+
+/* 所有测试结束,退出进程 */
+void tmPortDone (void)
+{
+    exit (0);
+}
@@ -0,0 +1,138 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 吞吐量基准测试的STM8部分,IAR和SDCC通用.
+ * 软件中断为trap指令,不受中断优先级屏蔽,只在任务中临界区以外调用.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "tmPort.h"
+
+#define TM_BAUD                115200
+
+static TM_IRQ_FUNC tmIrqHandler = NULL;
+
+/**
+ * 功能: 内部时钟16M,初始化输出结果使用的UART1.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
+ * UART1_Init(...);
+ */
+void tmPortInit (void)
+{
+    CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
+
+    UART1_DeInit();
+    UART1_Init((uint32_t)TM_BAUD, UART1_WORDLENGTH_8D, UART1_STOPBITS_1,
+               UART1_PARITY_NO, UART1_SYNCMODE_CLOCK_DISABLE, UART1_MODE_TX_ENABLE);
+}
+
+/**
+ * 功能: 设置trap中断中调用的处理函数.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * TM_IRQ_FUNC handler 处理函数       无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void tmPortIrqConnect (TM_IRQ_FUNC handler)
+{
+    tmIrqHandler = handler;
+}
+
+/**
+ * 功能: 执行trap指令,返回前已经执行完处理函数.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * trap();
+ */
+void tmPortIrqRaise (void)
+{
+    trap();
+}
+
+/**
+ * 功能: 以查询方式通过UART1发送字符串.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * const char *s 字符串          无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void tmPortPuts (const char *s)
+{
+    while (*s)
+    {
+      while ((UART1->SR & UART1_SR_TXE) == 0)
+      {
+      }
+      UART1->DR = (uint8_t)*s++;
+    }
+}
+
+/**
+ * 功能: 所有测试结束,STM8上没有需要做的事情.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void tmPortDone (void)
+{
+}
+
+/**
+ * 功能: trap中断,与其他调用内核接口的中断结构相同.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * eIntEnter ();
+ * archIsrStackCall (tmIrqHandler);
+ * eIntExit (FALSE);
+ */
+INTERRUPT_HANDLER_TRAP(TM_TrapISR)
+{
+    eIntEnter ();
+
+    if (tmIrqHandler)
+    {
+      archIsrStackCall (tmIrqHandler);
+    }
+
+    eIntExit (FALSE);
+}
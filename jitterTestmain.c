@@ -0,0 +1,245 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 中断延迟和调度抖动测试:TIM2通道1每JITTER_PERIOD us产生一次比较中断,比较值
+ * 即为中断到达的时间.中断中释放信号量唤醒优先级最高的任务,内核统计
+ * 到达->eIntEnter()以及到达->该任务运行的时间.负载与latencyTestmain.c相同.
+ * 需要EASYRTOS_LATENCY_HIST为1,EASYRTOS_LATENCY_TIMER为2.
+ * 每秒把两个直方图的最小值,最大值,中位数,99%和99.9%保存在jitterResult中,
+ * 在C-SPY的Watch窗口中查看,单位为us,以最大值作为验收标准.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+#include "easyRTOSQueue.h"
+#include "easyRTOSLatency.h"
+
+#if (EASYRTOS_LATENCY_HIST != 1) || (EASYRTOS_LATENCY_TIMER != 2)
+#error "jitterTestmain.c needs EASYRTOS_LATENCY_HIST 1 and EASYRTOS_LATENCY_TIMER 2"
+#endif
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define TASK_STACK_SIZE_BYTES  192
+
+/* 比较中断的周期,单位us,不与系统心跳成整数倍,使采样均匀分布 */
+#define JITTER_PERIOD          997
+
+#define LOAD_MSG_SIZE          32
+#define LOAD_MSG_NUM           4
+
+NEAR static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+NEAR static uint8_t wakeTaskStack[TASK_STACK_SIZE_BYTES];
+NEAR static uint8_t reportTaskStack[TASK_STACK_SIZE_BYTES];
+NEAR static uint8_t sendTaskStack[TASK_STACK_SIZE_BYTES];
+NEAR static uint8_t recvTaskStack[TASK_STACK_SIZE_BYTES];
+
+EASYRTOS_TCB wakeTcb;
+EASYRTOS_TCB reportTcb;
+EASYRTOS_TCB sendTcb;
+EASYRTOS_TCB recvTcb;
+EASYRTOS_SEM wakeSem;
+EASYRTOS_QUEUE loadQueue;
+static uint8_t loadQueueBuff[LOAD_MSG_SIZE * LOAD_MSG_NUM];
+
+typedef struct jitterStat
+{
+  uint32_t count;                     /* 采样次数 */
+  uint16_t min;                       /* 最小值 */
+  uint16_t max;                       /* 最大值 */
+  uint16_t p50;                       /* 中位数 */
+  uint16_t p99;                       /* 99% */
+  uint16_t p999;                      /* 99.9% */
+} JITTER_STAT;
+
+typedef struct jitterResult
+{
+  JITTER_STAT irq;                    /* 到达->eIntEnter() */
+  JITTER_STAT task;                   /* 到达->wakeTask运行 */
+  uint32_t wakeups;                   /* wakeTask被唤醒的次数 */
+  uint32_t messages;                  /* 负载任务传递的消息数 */
+} JITTER_RESULT;
+
+JITTER_RESULT jitterResult;
+
+void wakeTaskFunc (uint32_t param);
+void reportTaskFunc (uint32_t param);
+void sendTaskFunc (uint32_t param);
+void recvTaskFunc (uint32_t param);
+static void jitterStatUpdate (uint8_t type, JITTER_STAT *stat);
+static void jitterTimerInit (void);
+static void jitterHandler (void);
+
+int main( void )
+{
+  ERESULT status;
+
+  /* 内部时钟 16M */
+  CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
+
+  status = easyRTOSInit(&idleTaskStack[0], IDLE_STACK_SIZE_BYTES);
+  if (status == EASYRTOS_OK)
+  {
+    archInitSystemTickTimer();
+
+    wakeSem = eSemCreateBinary ();
+    loadQueue = eQueueCreate ((void *)loadQueueBuff, LOAD_MSG_SIZE, LOAD_MSG_NUM);
+
+    status += eTaskCreat(&wakeTcb,
+                 5,
+                 wakeTaskFunc,
+                 0,
+                 &wakeTaskStack[0],
+                 TASK_STACK_SIZE_BYTES,
+                 "WAKE",
+                 1);
+    status += eTaskCreat(&reportTcb,
+                 8,
+                 reportTaskFunc,
+                 0,
+                 &reportTaskStack[0],
+                 TASK_STACK_SIZE_BYTES,
+                 "REPORT",
+                 2);
+    status += eTaskCreat(&sendTcb,
+                 10,
+                 sendTaskFunc,
+                 0,
+                 &sendTaskStack[0],
+                 TASK_STACK_SIZE_BYTES,
+                 "SEND",
+                 3);
+    status += eTaskCreat(&recvTcb,
+                 9,
+                 recvTaskFunc,
+                 0,
+                 &recvTaskStack[0],
+                 TASK_STACK_SIZE_BYTES,
+                 "RECV",
+                 4);
+    if (status == EASYRTOS_OK)
+    {
+      /* eLatencyInit()已经启动了TIM2,这里只设置通道1 */
+      jitterTimerInit ();
+      easyRTOSStart();
+    }
+  }
+  return 0;
+}
+
+/* 被比较中断唤醒的任务 */
+void wakeTaskFunc (uint32_t param)
+{
+  while (1)
+  {
+    if (eSemTake (&wakeSem, 0) == EASYRTOS_OK)
+    {
+      jitterResult.wakeups++;
+    }
+  }
+}
+
+/* 每秒更新一次统计结果 */
+void reportTaskFunc (uint32_t param)
+{
+  while (1)
+  {
+    eTimerDelay (DELAY_S(1));
+
+    /* 在此处设置断点查看 jitterResult */
+    jitterStatUpdate (LATENCY_IRQ, &jitterResult.irq);
+    jitterStatUpdate (LATENCY_TASK, &jitterResult.task);
+  }
+}
+
+/* 发送任务,队列满时阻塞 */
+void sendTaskFunc (uint32_t param)
+{
+  uint8_t msg[LOAD_MSG_SIZE];
+  uint8_t i;
+
+  for (i = 0; i < LOAD_MSG_SIZE; i++)
+  {
+    msg[i] = i;
+  }
+
+  while (1)
+  {
+    (void)eQueueGive (&loadQueue, 0, msg);
+    msg[0]++;
+  }
+}
+
+/* 接收任务,每次接收都会唤醒发送任务 */
+void recvTaskFunc (uint32_t param)
+{
+  uint8_t msg[LOAD_MSG_SIZE];
+
+  while (1)
+  {
+    if (eQueueTake (&loadQueue, 0, msg) == EASYRTOS_OK)
+    {
+      jitterResult.messages++;
+    }
+  }
+}
+
+/* 从内核的直方图计算统计结果 */
+static void jitterStatUpdate (uint8_t type, JITTER_STAT *stat)
+{
+  EASYRTOS_LAT_HIST hist;
+
+  if (eLatencyGet (type, &hist) == EASYRTOS_OK)
+  {
+    stat->count = hist.count;
+    stat->min = hist.min;
+    stat->max = hist.max;
+    stat->p50 = eLatencyPercentile (&hist, 500);
+    stat->p99 = eLatencyPercentile (&hist, 990);
+    stat->p999 = eLatencyPercentile (&hist, 999);
+  }
+}
+
+/* TIM2通道1冻结输出比较,只产生中断 */
+static void jitterTimerInit (void)
+{
+  uint16_t next = (uint16_t)(archRunTimeGet () + JITTER_PERIOD);
+
+  TIM2->CCMR1 = 0;
+  TIM2->CCR1H = (uint8_t)(next >> 8);
+  TIM2->CCR1L = (uint8_t)(next & 0xFF);
+  TIM2->SR1 = (uint8_t)(~TIM2_SR1_CC1IF);
+  TIM2->IER |= TIM2_IER_CC1IE;
+}
+
+/* 设置下一次比较值并唤醒wakeTask,在中断堆栈上运行 */
+static void jitterHandler (void)
+{
+  uint16_t next = (uint16_t)(archLatencyCapture () + JITTER_PERIOD);
+
+  TIM2->CCR1H = (uint8_t)(next >> 8);
+  TIM2->CCR1L = (uint8_t)(next & 0xFF);
+  TIM2->SR1 = (uint8_t)(~TIM2_SR1_CC1IF);
+
+  (void)eSemGive (&wakeSem);
+}
+
+/**
+ * TIM2比较中断,比较值即为到达时间,在eIntEnter()之后交给内核统计,
+ * 之后才能修改比较值.
+ */
+#pragma vector = ITC_IRQ_TIM2_CAPCOM + 2
+__interrupt void TIM2_JitterISR (void)
+{
+  eIntEnter ();
+
+  eLatencyIrq (archLatencyCapture ());
+
+  archIsrStackCall (jitterHandler);
+
+  eIntExit (FALSE);
+}
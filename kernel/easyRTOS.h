@@ -1,13 +1,38 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #ifndef __EASYRTOS__H__
 #define __EASYRTOS__H__
 
+#if defined(EASYRTOS_PORT_LINUX)
+/* Linux主机仿真移植,见port/linux */
+#include "easyRTOSportLinux.h"
+#else
 #include "stm8s.h"
+#endif
+#include "easyRTOSConfig.h"
+
+/**
+ * 内核状态变量的存储类型.默认为普通的全局变量,主机上同时仿真多个系统时
+ * 由移植定义为线程局部存储,每个线程拥有一份独立的内核.
+ */
+#ifndef EASYRTOS_NODE_LOCAL
+#define EASYRTOS_NODE_LOCAL
+#endif
+
+/**
+ * 汇编实现的移植函数的调用约定.SDCC 4.2以后默认用寄存器传递参数(sdcccall(1)),
+ * 汇编按照所有参数都在堆栈中、由调用者清理的sdcccall(0)编写.IAR中为空.
+ */
+#if defined(__SDCC) && defined(__SDCCCALL)
+#define ARCH_ASM_CALL __sdcccall(0)
+#else
+#define ARCH_ASM_CALL
+#endif
+
 /* Constants */
 #define TRUE                    1
 #define FALSE                   0
@@ -20,65 +45,109 @@
 #define TASKNAMELEN   10
 #define TASKSTATE     uint8_t
 
-#define TASK_RUN      0x01    /**/
-#define TASK_READY    0x02    /**/
-#define TASK_PENDED   0x04    /**/
-#define TASK_DELAY    0x08    /*ӳ*/
-#define TASK_SUSPEND  0x10    /**/
+#define TASK_RUN      0x01    /*运行*/
+#define TASK_READY    0x02    /*就绪*/
+#define TASK_PENDED   0x04    /*悬挂*/
+#define TASK_DELAY    0x08    /*延迟*/
+#define TASK_SUSPEND  0x10    /*挂起*/
+#define TASK_DELETED  0x20    /*删除*/
+
+/* 优先级位图分组,每组16个优先级 */
+#define EASYRTOS_PRIO_GRP   (EASYRTOS_PRIO_NUM >> 4)
+
+/* idleTask使用最低的优先级 */
+#define EASYRTOS_IDLE_PRIO  (EASYRTOS_PRIO_NUM - 1)
 
 typedef void ( * TIMER_CB_FUNC ) ( POINTER cb_data ) ;
 
 typedef struct easyRTOS_timer
 {
-  TIMER_CB_FUNC   cb_func;    /* ص */
-  POINTER	        cb_data;    /* صĲָ */
-  uint32_t	      cb_ticks;   /* ʱcount */
+  TIMER_CB_FUNC   cb_func;    /* 回调函数 */
+  POINTER	        cb_data;    /* 回调函数的参数指针 */
+  uint32_t	      cb_ticks;   /* 定时器count计数,注册后由定时器队列内部使用 */
 
-	/* ڲ */
-  struct easyRTOS_timer *next_timer;		/* ˫ */
+	/* 内部数据 */
+  struct easyRTOS_timer *next_timer;		/* 双向链表 */
+#if (EASYRTOS_TIMER_WHEEL == 1)
+  struct easyRTOS_timer **prev_next;  /* 指向前一个定时器的next_timer或者槽头,NULL表示未注册 */
+#endif
+#if (EASYRTOS_WORK_QUEUE == 1)
+  uint8_t         deferred;   /* TRUE:到期后由工作任务回调 */
+#endif
 } EASYRTOS_TIMER;
 
 typedef struct easyRTOS_tcb
 {
-    /* ջָ.񱻵лʱ,ջָ뱣 */
+    /* 任务栈指针.当任务被调度器切换的时候,栈指针保存在这个变量中 */
     POINTER sp_save_ptr;
 
-    /* ̵߳ȼ (0-255) */
+    /* 线程的优先级 (0-255),优先级继承时为提升后的优先级 */
     uint8_t priority;
 
+    /* 任务设置的优先级,互斥锁释放后恢复到该优先级 */
+    uint8_t basePriority;
+
+    /* 时间片长度以及本次运行剩余的心跳数 */
+    uint8_t timeSlice;
+    uint8_t sliceLeft;
+
     /**
-     *  Լ.
+     *  任务函数入口以及参数.
      */
     void (*entry_point)(uint32_t);
     uint32_t entryParam;
 
-    /* ָ */
-    struct easyRTOS_tcb *prev_tcb;    /* ָǰһTCB˫TCBָ*/
-    struct easyRTOS_tcb *next_tcb;    /* ָһTCB˫TCBָ*/
+    /* 任务队列指针链表 */
+    struct easyRTOS_tcb *prev_tcb;    /* 指向前一个TCB的双向TCB链表指针*/
+    struct easyRTOS_tcb *next_tcb;    /* 指向后一个TCB的双向TCB链表指针*/
 
     /**
-     *  ״̬:
-     *  
-     *  ӳ
-     *  
-     *  
-     *  
+     *  任务状态:
+     *  挂起
+     *  延迟
+     *  就绪
+     *  运行
+     *  悬挂
      */
     TASKSTATE state;
     int8_t pendedWakeStatus;        
     EASYRTOS_TIMER *pended_timo_cb;  
     EASYRTOS_TIMER *delay_timo_cb;   
 
-    /* ID */
+    /* 任务通知值以及通知状态,见easyRTOSNotify.h */
+    uint32_t notifyValue;
+    uint8_t notifyState;
+
+    /* 等待的事件标志以及等待选项,唤醒后为满足条件时的事件标志,见easyRTOSEvent.h */
+    uint32_t eventWait;
+    uint8_t eventOpt;
+
+    /* 任务悬挂所在的队列,优先级改变时需要在该队列中重新排序 */
+    struct easyRTOS_tcb **pended_q;
+
+    /* 任务正在等待的互斥锁,以及已经拥有的互斥锁链表,用于优先级继承 */
+    struct easyRTOSSem *pended_mutex;
+    struct easyRTOSSem *mutex_held;
+
+    /* 任务ID */
     uint8_t taskID;
 
-    /*  */
+    /* 任务名称 */
     uint8_t taskName[TASKNAMELEN];
 
-    /* ڴ֮ʵ̬ʱ,CPUʹʱʹ */
+    /* 任务在创建之后的实际运行态的时间,计算CPU使用率时使用 */
     uint32_t taskRunTime;
+
+    /* 任务堆栈的起始地址(栈底,最低地址)以及大小 */
+    POINTER stack_base;
+    uint16_t stack_size;
+
+#if (EASYRTOS_RUNTIME_STATS == 1)
+    /* 所有已创建任务的链表,用于清零统计 */
+    struct easyRTOS_tcb *next_task;
+#endif
 } EASYRTOS_TCB;
 
-extern void archContextSwitch (EASYRTOS_TCB *old_tcb_ptr, EASYRTOS_TCB *new_tcb_ptr);
-extern void archFirstTaskRestore (EASYRTOS_TCB *new_tcb_ptr);
+extern void archContextSwitch (EASYRTOS_TCB *old_tcb_ptr, EASYRTOS_TCB *new_tcb_ptr) ARCH_ASM_CALL;
+extern void archFirstTaskRestore (EASYRTOS_TCB *new_tcb_ptr) ARCH_ASM_CALL;
 #endif
@@ -0,0 +1,192 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ */
+#ifndef __EASYRTOSCONFIG_H__
+#define __EASYRTOSCONFIG_H__
+
+/**
+ * 以下均为默认值,可以在编译参数中用-D覆盖,例如比较不同的内核配置时
+ * make EXTRA_CFLAGS=-DEASYRTOS_TIMER_WHEEL=1
+ */
+
+/**
+ * 系统支持的优先级数量,必须为16的整数倍,最大256.
+ * 每个优先级占用一个就绪链表头(2Byte),RAM紧张时可以适当减小.
+ * 最低的优先级(EASYRTOS_PRIO_NUM-1)保留给idleTask.
+ */
+#ifndef EASYRTOS_PRIO_NUM
+#define EASYRTOS_PRIO_NUM       64
+#endif
+
+/**
+ * 相同优先级任务轮转的默认时间片,单位为系统心跳(1~255).任务运行满一个时间片
+ * 后才让给相同优先级的就绪任务.为0时相同优先级的任务不轮转,只在阻塞或者
+ * 调用eTaskYield()时让出CPU.可以通过eTaskSetTimeSlice()单独设置每个任务.
+ */
+#ifndef EASYRTOS_TIME_SLICE
+#define EASYRTOS_TIME_SLICE     10
+#endif
+
+/**
+ * 调度请求标志.只有相同或者更高优先级的任务就绪、当前任务优先级降低或者
+ * 时间片用完时才进入调度器,其余情况easyRTOSSched()直接返回,不进入临界区
+ * 也不检查就绪队列.
+ * 1:使能 0:关闭(每次都完整地执行调度器)
+ */
+#ifndef EASYRTOS_RESCHED_FLAG
+#define EASYRTOS_RESCHED_FLAG   1
+#endif
+
+/**
+ * 内核中断优先级.
+ * 0:临界区关闭全部中断.
+ * 1或2:临界区只把CPU优先级提升到该软件优先级,更高优先级的中断不会被内核延迟.
+ * easyRTOSInit()把所有中断的软件优先级设置为该值,不调用内核接口的中断可以在
+ * 之后用ITC_SetSoftwarePriority()设置为更高的优先级.调用内核接口的中断
+ * (包括eIntEnter()/eIntExit())不能高于该优先级.
+ */
+#ifndef EASYRTOS_KERNEL_IRQ_LEVEL
+#define EASYRTOS_KERNEL_IRQ_LEVEL  0
+#endif
+
+/**
+ * 中断堆栈大小(Byte).最外层中断通过archIsrStackCall()切换到该堆栈运行中断处理,
+ * 定时器回调等不再占用任务堆栈.硬件压栈、eIntEnter()/eIntExit()以及任务切换仍在
+ * 被中断的任务堆栈上进行.为0时中断全部运行在任务堆栈上.
+ */
+#ifndef EASYRTOS_ISR_STACK_SIZE
+#define EASYRTOS_ISR_STACK_SIZE    128
+#endif
+
+/**
+ * 中断下半部工作队列.中断通过eWorkPost()提交函数和参数,由eWorkInit()创建的
+ * 工作任务依次执行,eTimerRegisterDeferred()注册的定时器回调也在工作任务中执行.
+ * 1:使能 0:关闭
+ */
+#ifndef EASYRTOS_WORK_QUEUE
+#define EASYRTOS_WORK_QUEUE     0
+#endif
+
+/* 工作队列的长度,必须为2的整数次幂,最大128.每项占用4Byte */
+#ifndef EASYRTOS_WORK_QUEUE_SIZE
+#define EASYRTOS_WORK_QUEUE_SIZE   8
+#endif
+
+/* 工作任务的优先级,通常高于所有应用任务 */
+#ifndef EASYRTOS_WORK_PRIO
+#define EASYRTOS_WORK_PRIO      0
+#endif
+
+/**
+ * 无心跳空闲模式.当只有idleTask就绪时,停止TIM4系统心跳,根据下一个定时器
+ * 到期的时间用TIM3计时并进入wait模式(wfi),被TIM3或者其他中断唤醒后按TIM3
+ * 的计数补偿systemTicks,提前唤醒不会丢失系统时间.wait模式下外设时钟仍然运行,
+ * 功耗高于Active-halt.
+ * 1:使能 0:关闭
+ */
+#ifndef EASYRTOS_TICKLESS_IDLE
+#define EASYRTOS_TICKLESS_IDLE  0
+#endif
+
+/* 距离下一个定时器到期超过该心跳数才进入低功耗 */
+#ifndef EASYRTOS_TICKLESS_MIN_TICKS
+#define EASYRTOS_TICKLESS_MIN_TICKS  4
+#endif
+
+/**
+ * 单次低功耗的最长心跳数(2000Hz时约512ms),不能超过TIM3的计时范围(约1s).
+ */
+#ifndef EASYRTOS_TICKLESS_MAX_TICKS
+#define EASYRTOS_TICKLESS_MAX_TICKS  1024
+#endif
+
+/**
+ * 定时器队列的实现方式.
+ * 0:按到期时间排序的差值链表,注册O(n),取消O(n),占用RAM最少.
+ * 1:哈希时间轮,注册/取消/心跳处理均为O(1),每个定时器多占用2Byte.
+ */
+#ifndef EASYRTOS_TIMER_WHEEL
+#define EASYRTOS_TIMER_WHEEL    0
+#endif
+
+/**
+ * 时间轮的槽数量,必须为2的整数次幂,每个槽占用2Byte.
+ * 槽数量越多,每个心跳需要检查的定时器越少.
+ */
+#ifndef EASYRTOS_TIMER_WHEEL_SIZE
+#define EASYRTOS_TIMER_WHEEL_SIZE  32
+#endif
+
+/**
+ * 任务运行时间统计.使用TIM2作为1us的自由计数器,在任务切换和中断进出时累加
+ * 运行时间,通过eTaskCpuUsage()等接口获取CPU使用率.
+ * 计数为32位,总时间超过约36分钟时所有计数同时减半,不会溢出,此后的使用率
+ * 偏向最近的运行情况.需要精确的统计区间时调用eRunTimeStatsReset()重新开始.
+ * 1:使能 0:关闭
+ */
+#ifndef EASYRTOS_RUNTIME_STATS
+#define EASYRTOS_RUNTIME_STATS  0
+#endif
+
+/**
+ * 任务堆栈检查.创建任务时用STACK_PAINT_BYTE填充整个堆栈,
+ * eTaskStackFree()从栈底开始统计未被改写的字节数,即堆栈的最小剩余量.
+ * 1:使能 0:关闭
+ */
+#ifndef EASYRTOS_STACK_CHECK
+#define EASYRTOS_STACK_CHECK    1
+#endif
+
+/**
+ * 内核跟踪记录.任务切换,中断进出,信号量/队列操作以及定时器到期时写入8Byte的
+ * 记录,时间戳使用TIM2的1us自由计数(与运行时间统计共用).通过eTraceDump()
+ * 从UART1导出,用tools/中的解析工具查看.
+ * 1:使能 0:关闭
+ */
+#ifndef EASYRTOS_TRACE
+#define EASYRTOS_TRACE          0
+#endif
+
+/* 跟踪记录的条数,必须为2的整数次幂,每条8Byte */
+#ifndef EASYRTOS_TRACE_BUF_SIZE
+#define EASYRTOS_TRACE_BUF_SIZE 64
+#endif
+
+/* 导出跟踪记录的UART1波特率 */
+#ifndef EASYRTOS_TRACE_BAUD
+#define EASYRTOS_TRACE_BAUD     115200
+#endif
+
+/**
+ * 中断延迟和调度抖动直方图.被测中断在eIntEnter()之后调用eLatencyIrq()给出
+ * 中断到达的时间,统计到达->eIntEnter()以及到达->中断退出后第一个运行的任务
+ * 两个直方图,通过eLatencyGet()/eLatencyPercentile()在运行时查询.
+ * 1:使能 0:关闭
+ */
+#ifndef EASYRTOS_LATENCY_HIST
+#define EASYRTOS_LATENCY_HIST   0
+#endif
+
+/**
+ * 延迟测量使用的定时器.
+ * 1:TIM1不分频自由计数,单位为CPU周期,CH1输入捕获外部引脚(PC1)的上升沿,
+ *   到达时间为捕获值.
+ * 2:TIM2的1us自由计数(与运行时间统计共用),到达时间由应用给出,例如
+ *   TIM2输出比较产生激励时为比较值.
+ */
+#ifndef EASYRTOS_LATENCY_TIMER
+#define EASYRTOS_LATENCY_TIMER  2
+#endif
+
+/* 直方图的格数以及每格的宽度(定时器计数),最后一格包含更大的值,每格4Byte */
+#ifndef EASYRTOS_LATENCY_BUCKETS
+#define EASYRTOS_LATENCY_BUCKETS      16
+#endif
+#ifndef EASYRTOS_LATENCY_BUCKET_WIDTH
+#define EASYRTOS_LATENCY_BUCKET_WIDTH 4
+#endif
+
+#endif
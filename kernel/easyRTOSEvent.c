@@ -0,0 +1,501 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 事件标志组:32个事件标志,任务可以等待其中任意一个或者全部标志置位.
+ * 悬挂队列以及timeout定时器的处理与信号量相同.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSEvent.h"
+
+/* 判断事件标志是否满足任务的等待条件 */
+#define EVENT_MATCH(flags, mask, options) \
+  (((options) & EVENT_WAIT_ALL) ? (((flags) & (mask)) == (mask)) : (((flags) & (mask)) != 0))
+
+/* 全局函数 */
+EASYRTOS_EVENT eEventCreate (void);
+ERESULT eEventDelete (EASYRTOS_EVENT *event);
+ERESULT eEventSet (EASYRTOS_EVENT *event, uint32_t flags);
+ERESULT eEventClear (EASYRTOS_EVENT *event, uint32_t flags);
+uint32_t eEventGet (EASYRTOS_EVENT *event);
+ERESULT eEventWait (EASYRTOS_EVENT *event, uint32_t mask, uint8_t options, int32_t timeout, uint32_t *flags);
+
+/* 私有函数 */
+static void eEventTimerCallback (POINTER cb_data);
+
+/**
+ * 功能: 事件标志组创建,所有标志清零,并返回.
+ *
+ * 参数:
+ * 输入:                                   输出:
+ * 无                                      无
+ *
+ * 返回:
+ * EASYRTOS_EVENT
+ * 
+ * 调用的函数:
+ * 无.
+ */
+EASYRTOS_EVENT eEventCreate (void)
+{
+  EASYRTOS_EVENT event;
+
+  /* 清除所有标志 */
+  event.flags = 0;
+
+  /* 初始化被事件标志组悬挂的任务的队列 */
+  event.suspQ = NULL;
+
+  return event;
+}
+
+/**
+ * 功能: 删除事件标志组,并唤醒所有等待的任务加入Ready列表中,被唤醒的任务返回
+ * EASYRTOS_ERR_DELETED.同时取消该任务注册的定时器.若有任务被唤醒,则会启动调度器.
+ *
+ * 参数:
+ * 输入:                                   输出:
+ * EASYRTOS_EVENT *event 事件标志组指针    EASYRTOS_EVENT *event 事件标志组指针
+ *
+ * 返回:
+ * 返回 EASYRTOS_OK 成功
+ * 返回 EASYRTOS_ERR_QUEUE 将任务放置到Ready队列中失败
+ * 返回 EASYRTOS_ERR_TIMER 取消定时器失败
+ * 返回 EASYRTOS_ERR_PARAM 输入参数错误
+ * 
+ * 调用的函数:
+ * tcb_dequeue_head (&event->suspQ);
+ * tcbEnqueueReady (tcb_ptr);
+ * eTimerCancel (tcb_ptr->pended_timo_cb);
+ * eSchedLock ();
+ * eSchedUnlock ();
+ */
+ERESULT eEventDelete (EASYRTOS_EVENT *event)
+{
+  ERESULT status;
+  CRITICAL_STORE;
+  EASYRTOS_TCB *tcb_ptr;
+  uint8_t woken_threads = FALSE;
+
+  /* 参数检查 */
+  if (event == NULL)
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  status = EASYRTOS_OK;
+
+  /* 唤醒完所有任务之前不切换任务 */
+  eSchedLock ();
+
+  /* 唤醒所有被悬挂的任务 */
+  while (1)
+  {
+    /* 进入临界区 */
+    CRITICAL_ENTER ();
+
+    tcb_ptr = tcb_dequeue_head (&event->suspQ);
+    if (tcb_ptr == NULL)
+    {
+      /* 没有被悬挂的任务了 */
+      CRITICAL_EXIT ();
+      break;
+    }
+
+    /* 对被悬挂的任务返回错误标志 */
+    tcb_ptr->pendedWakeStatus = EASYRTOS_ERR_DELETED;
+    tcb_ptr->pended_q = NULL;
+
+    /* 若悬挂有timeout，取消对应的定时器 */
+    if (tcb_ptr->pended_timo_cb)
+    {
+      if (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK)
+      {
+        status = EASYRTOS_ERR_TIMER;
+      }
+      tcb_ptr->pended_timo_cb = NULL;
+    }
+
+    /* 将任务TCB加入Ready的链表 */
+    if (tcbEnqueueReady (tcb_ptr) != EASYRTOS_OK)
+    {
+      CRITICAL_EXIT ();
+      status = EASYRTOS_ERR_QUEUE;
+      break;
+    }
+    tcb_ptr->state = TASK_READY;
+
+    /* 退出临界区 */
+    CRITICAL_EXIT ();
+
+    woken_threads = TRUE;
+  }
+
+  eSchedUnlock ();
+
+  /* 有任务被唤醒则调用调度器,中断中由eIntExit()调用 */
+  if ((woken_threads == TRUE) && eCurrentContext())
+  {
+    easyRTOSSched (FALSE);
+  }
+
+  return (status);
+}
+
+/**
+ * 功能: 置位事件标志,唤醒所有等待条件被满足的任务.设置了EVENT_AUTO_CLEAR的任务
+ * 等待的标志在所有任务检查完之后才清除,所以同一次置位可以同时满足多个任务.
+ * 可以在中断中调用,有任务被唤醒时在任务上下文中启动调度器,中断中由eIntExit()启动.
+ *
+ * 参数:
+ * 输入:                                   输出:
+ * EASYRTOS_EVENT *event 事件标志组指针    EASYRTOS_EVENT *event 事件标志组指针
+ * uint32_t flags 需要置位的标志
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_QUEUE 将任务加入Ready队列失败
+ * EASYRTOS_ERR_TIMER 取消定时器失败
+ * 
+ * 调用的函数:
+ * tcb_dequeue_entry (&event->suspQ, tcb_ptr);
+ * tcbEnqueueReady (tcb_ptr);
+ * eTimerCancel (tcb_ptr->pended_timo_cb);
+ * easyRTOSSched (FALSE);
+ */
+ERESULT eEventSet (EASYRTOS_EVENT *event, uint32_t flags)
+{
+  ERESULT status = EASYRTOS_OK;
+  CRITICAL_STORE;
+  EASYRTOS_TCB *tcb_ptr;
+  EASYRTOS_TCB *next_ptr;
+  uint32_t clear_flags = 0;
+  uint8_t woken_threads = FALSE;
+
+  /* 参数检查 */
+  if (event == NULL)
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  event->flags |= flags;
+
+  /* 按优先级顺序检查所有等待的任务 */
+  tcb_ptr = event->suspQ;
+  while (tcb_ptr)
+  {
+    /* 加入Ready队列后next_tcb会改变,先保存 */
+    next_ptr = tcb_ptr->next_tcb;
+
+    if (EVENT_MATCH(event->flags, tcb_ptr->eventWait, tcb_ptr->eventOpt))
+    {
+      if (tcb_ptr->eventOpt & EVENT_AUTO_CLEAR)
+      {
+        clear_flags |= tcb_ptr->eventWait;
+      }
+
+      /* 返回满足条件时的事件标志 */
+      tcb_ptr->eventWait = event->flags;
+
+      (void)tcb_dequeue_entry (&event->suspQ, tcb_ptr);
+      tcb_ptr->pended_q = NULL;
+
+      /* 解除timeout注册的定时器 */
+      if (tcb_ptr->pended_timo_cb)
+      {
+        if (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK)
+        {
+          status = EASYRTOS_ERR_TIMER;
+        }
+        tcb_ptr->pended_timo_cb = NULL;
+      }
+
+      if (tcbEnqueueReady (tcb_ptr) != EASYRTOS_OK)
+      {
+        status = EASYRTOS_ERR_QUEUE;
+      }
+      else
+      {
+        tcb_ptr->pendedWakeStatus = EASYRTOS_OK;
+        tcb_ptr->state = TASK_READY;
+        woken_threads = TRUE;
+      }
+    }
+
+    tcb_ptr = next_ptr;
+  }
+
+  event->flags &= ~clear_flags;
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  if ((woken_threads == TRUE) && eCurrentContext())
+  {
+    easyRTOSSched (FALSE);
+  }
+
+  return (status);
+}
+
+/**
+ * 功能: 清除事件标志.可以在中断中调用.
+ *
+ * 参数:
+ * 输入:                                   输出:
+ * EASYRTOS_EVENT *event 事件标志组指针    EASYRTOS_EVENT *event 事件标志组指针
+ * uint32_t flags 需要清除的标志
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * 
+ * 调用的函数:
+ * 无
+ */
+ERESULT eEventClear (EASYRTOS_EVENT *event, uint32_t flags)
+{
+  CRITICAL_STORE;
+
+  /* 参数检查 */
+  if (event == NULL)
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  CRITICAL_ENTER ();
+  event->flags &= ~flags;
+  CRITICAL_EXIT ();
+
+  return (EASYRTOS_OK);
+}
+
+/**
+ * 功能: 读取当前的事件标志.
+ *
+ * 参数:
+ * 输入:                                   输出:
+ * EASYRTOS_EVENT *event 事件标志组指针    无
+ *
+ * 返回:
+ * uint32_t 事件标志,event为NULL时返回0
+ * 
+ * 调用的函数:
+ * 无
+ */
+uint32_t eEventGet (EASYRTOS_EVENT *event)
+{
+  uint32_t flags;
+  CRITICAL_STORE;
+
+  if (event == NULL)
+  {
+    return (0);
+  }
+
+  /* STM8上32位读取不是原子操作 */
+  CRITICAL_ENTER ();
+  flags = event->flags;
+  CRITICAL_EXIT ();
+
+  return (flags);
+}
+
+/**
+ * 功能: 等待事件标志.options为EVENT_WAIT_ANY时mask中任意一位置位即满足,
+ * 为EVENT_WAIT_ALL时mask中所有位都置位才满足,加上EVENT_AUTO_CLEAR则满足后
+ * 清除mask中的位.条件不满足时根据timeout悬挂任务:
+ * 1.timeout>0 悬挂调用的任务,当timeout到期的时候唤醒任务并返回timeout标志
+ * 2.timeout=0 永久悬挂调用的任务,直到条件满足.
+ * 3.timeout=-1 不悬挂任务,返回EASYRTOS_WOULDBLOCK.
+ *
+ * 参数:
+ * 输入:                                   输出:
+ * EASYRTOS_EVENT *event 事件标志组指针    uint32_t *flags 满足条件时(清除之前)的事件标志,
+ * uint32_t mask 等待的标志                                 失败时为当前的事件标志,可以为NULL
+ * uint8_t options 等待选项 EVENT_XXX
+ * int32_t timeout timeout时间,依赖于心跳时间
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_TIMEOUT timeout到期
+ * EASYRTOS_WOULDBLOCK 条件不满足,timeout=-1
+ * EASYRTOS_ERR_DELETED 事件标志组在悬挂任务时被删除
+ * EASYRTOS_ERR_SUSPENDED 等待时任务被挂起
+ * EASYRTOS_ERR_CONTEXT 错误的上下文调用
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_QUEUE 将任务加入悬挂队列失败
+ * EASYRTOS_ERR_TIMER 注册定时器失败
+ * 
+ * 调用的函数:
+ * eCurrentContext();
+ * tcbEnqueuePriority (&event->suspQ, curr_tcb_ptr);
+ * eTimerRegister (&timerCb);
+ * tcb_dequeue_entry (&event->suspQ, curr_tcb_ptr);
+ * easyRTOSSched (FALSE);
+ */
+ERESULT eEventWait (EASYRTOS_EVENT *event, uint32_t mask, uint8_t options, int32_t timeout, uint32_t *flags)
+{
+  CRITICAL_STORE;
+  ERESULT status;
+  EVENT_TIMER timerData;
+  EASYRTOS_TIMER timerCb;
+  EASYRTOS_TCB *curr_tcb_ptr;
+
+  /* 参数检查 */
+  if ((event == NULL) || (mask == 0))
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  /* 条件已经满足,直接返回 */
+  if (EVENT_MATCH(event->flags, mask, options))
+  {
+    if (flags)
+    {
+      *flags = event->flags;
+    }
+    if (options & EVENT_AUTO_CLEAR)
+    {
+      event->flags &= ~mask;
+    }
+    CRITICAL_EXIT ();
+    return (EASYRTOS_OK);
+  }
+
+  /* timeout == -1, 不需要悬挂 */
+  if (timeout < 0)
+  {
+    if (flags)
+    {
+      *flags = event->flags;
+    }
+    CRITICAL_EXIT ();
+    return (EASYRTOS_WOULDBLOCK);
+  }
+
+  /* 中断中不能悬挂 */
+  curr_tcb_ptr = eCurrentContext();
+  if (curr_tcb_ptr == NULL)
+  {
+    CRITICAL_EXIT ();
+    return (EASYRTOS_ERR_CONTEXT);
+  }
+
+  /* 将该任务加入该事件标志组的悬挂列表 */
+  if (tcbEnqueuePriority (&event->suspQ, curr_tcb_ptr) != EASYRTOS_OK)
+  {
+    CRITICAL_EXIT ();
+    return (EASYRTOS_ERR_QUEUE);
+  }
+
+  /* 保存等待条件,由eEventSet()检查 */
+  curr_tcb_ptr->eventWait = mask;
+  curr_tcb_ptr->eventOpt = options;
+  curr_tcb_ptr->state = TASK_PENDED;
+  curr_tcb_ptr->pended_q = &event->suspQ;
+  curr_tcb_ptr->pended_timo_cb = NULL;
+  status = EASYRTOS_OK;
+
+  /* 根据timeout的值，决定是否需要注册定时器回调 */
+  if (timeout)
+  {
+    timerData.tcb_ptr = curr_tcb_ptr;
+    timerData.event_ptr = event;
+
+    timerCb.cb_func = eEventTimerCallback;
+    timerCb.cb_data = (POINTER)&timerData;
+    timerCb.cb_ticks = timeout;
+    curr_tcb_ptr->pended_timo_cb = &timerCb;
+
+    if (eTimerRegister (&timerCb) != EASYRTOS_OK)
+    {
+      /* 注册失败,清除队列 */
+      (void)tcb_dequeue_entry (&event->suspQ, curr_tcb_ptr);
+      curr_tcb_ptr->state = TASK_RUN;
+      curr_tcb_ptr->pended_timo_cb = NULL;
+      curr_tcb_ptr->pended_q = NULL;
+      status = EASYRTOS_ERR_TIMER;
+    }
+  }
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  if (status == EASYRTOS_OK)
+  {
+    /* 任务被悬挂，调用调度器启动一个新的任务 */
+    easyRTOSSched (FALSE);
+
+    /**
+     * 通过eEventSet()唤醒返回EASYRTOS_OK,eventWait中为满足条件时的事件标志.
+     * timeout时返回EASYRTOS_TIMEOUT,被删除时返回EASYRTOS_ERR_DELETED.
+     */
+    status = curr_tcb_ptr->pendedWakeStatus;
+    if (flags)
+    {
+      *flags = (status == EASYRTOS_OK) ? curr_tcb_ptr->eventWait : eEventGet (event);
+    }
+  }
+
+  return (status);
+}
+
+/**
+ * 功能: 事件标志组注册的定时器的回调函数,给到期的任务返回EASYRTOS_TIMEOUT的标志.
+ * 将到期的任务移除悬挂列表,并加入Ready列表.
+ *
+ * 参数:
+ * 输入:                                                输出:
+ * POINTER cb_data 回调函数数据包含需要唤醒的TCB等信息   无
+ * 
+ * 返回:void
+ * 
+ * 调用的函数:
+ * tcb_dequeue_entry (&timer_data_ptr->event_ptr->suspQ, timer_data_ptr->tcb_ptr);
+ * tcbEnqueueReady (timer_data_ptr->tcb_ptr);
+ */
+static void eEventTimerCallback (POINTER cb_data)
+{
+  EVENT_TIMER *timer_data_ptr;
+  CRITICAL_STORE;
+
+  timer_data_ptr = (EVENT_TIMER *)cb_data;
+
+  if (timer_data_ptr)
+  {
+    /* 进入临界区 */
+    CRITICAL_ENTER ();
+
+    /* 设置标志，表明任务是由于timeout到期而唤醒的  */
+    timer_data_ptr->tcb_ptr->pendedWakeStatus = EASYRTOS_TIMEOUT;
+    timer_data_ptr->tcb_ptr->pended_timo_cb = NULL;
+    timer_data_ptr->tcb_ptr->pended_q = NULL;
+
+    /* 将任务移除事件标志组悬挂队列 */
+    (void)tcb_dequeue_entry (&timer_data_ptr->event_ptr->suspQ, timer_data_ptr->tcb_ptr);
+
+    /* 将任务加入Ready队列 */
+    if (tcbEnqueueReady (timer_data_ptr->tcb_ptr) == EASYRTOS_OK)
+    {
+      timer_data_ptr->tcb_ptr->state = TASK_READY;
+    }
+
+    /* 退出临界区 */
+    CRITICAL_EXIT ();
+
+    /* 这里没有启动调度器，因为之后在退出timer ISR的时候会通过eIntExit()启动 */
+  }
+}
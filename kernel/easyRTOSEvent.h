@@ -0,0 +1,35 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ */
+#ifndef __EASYRTOSEVENT_H
+#define __EASYRTOSEVENT_H
+
+/* eEventWait()的等待选项,可以组合使用 */
+#define EVENT_WAIT_ANY    0x00    /* mask中任意一位置位即满足 */
+#define EVENT_WAIT_ALL    0x01    /* mask中所有位都置位才满足 */
+#define EVENT_AUTO_CLEAR  0x02    /* 满足后清除mask中的位 */
+
+typedef struct easyRTOSEvent
+{
+    EASYRTOS_TCB * suspQ;  /* 等待事件标志的任务队列 */
+    uint32_t       flags;  /* 32个事件标志 */
+} EASYRTOS_EVENT;
+
+typedef struct easyRTOSEventTimer
+{
+    EASYRTOS_TCB   *tcb_ptr;    /* 具有timeout的悬挂任务 */
+    EASYRTOS_EVENT *event_ptr;  /* 阻塞任务的事件标志组 */
+} EVENT_TIMER;
+
+/* 全局函数 */
+extern EASYRTOS_EVENT eEventCreate (void);
+extern ERESULT eEventDelete (EASYRTOS_EVENT *event);
+extern ERESULT eEventSet (EASYRTOS_EVENT *event, uint32_t flags);
+extern ERESULT eEventClear (EASYRTOS_EVENT *event, uint32_t flags);
+extern uint32_t eEventGet (EASYRTOS_EVENT *event);
+extern ERESULT eEventWait (EASYRTOS_EVENT *event, uint32_t mask, uint8_t options, int32_t timeout, uint32_t *flags);
+
+#endif
@@ -0,0 +1,331 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 中断延迟和调度抖动直方图.被测中断的结构为:
+ *   eIntEnter ();
+ *   eLatencyIrq (archLatencyCapture ());   到达时间,也可以由应用自己计算
+ *   ...                                    唤醒任务
+ *   eIntExit (FALSE);
+ * eIntEnter()记录进入中断的时间,eLatencyIrq()把两者之差计入LATENCY_IRQ.
+ * 最外层中断退出时若有到达时间,在archContextSwitch()返回,即中断之后第一个运行
+ * 的任务恢复运行时,把与到达时间之差计入LATENCY_TASK.中断退出时没有发生任务
+ * 切换则不计入,两个直方图的采样次数之差即为没有切换的次数.
+ * 时间戳为16位自由计数,测量的延迟不能超过一个计数周期.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSLatency.h"
+
+#if (EASYRTOS_LATENCY_HIST == 1)
+
+/* 本地数据 */
+static EASYRTOS_NODE_LOCAL EASYRTOS_LAT_HIST latHist[LATENCY_HIST_NUM];
+
+/* 最近一次进入中断的时间 */
+static EASYRTOS_NODE_LOCAL uint16_t latEnterStamp = 0;
+
+/* 被测中断的到达时间 */
+static EASYRTOS_NODE_LOCAL uint16_t latArrival = 0;
+
+/* 中断中调用了eLatencyIrq(),等待中断退出 */
+static EASYRTOS_NODE_LOCAL uint8_t latPending = FALSE;
+
+/* 最外层中断正在调度,下一个恢复运行的任务计入LATENCY_TASK */
+static EASYRTOS_NODE_LOCAL uint8_t latArmed = FALSE;
+
+/* 全局函数 */
+void eLatencyInit (void);
+void eLatencyIntEnter (void);
+void eLatencyIntExit (int nest);
+void eLatencySchedDone (void);
+void eLatencySwitchIn (void);
+void eLatencyIrq (uint16_t arrival);
+ERESULT eLatencyGet (uint8_t type, EASYRTOS_LAT_HIST *hist);
+uint16_t eLatencyPercentile (const EASYRTOS_LAT_HIST *hist, uint16_t permille);
+void eLatencyReset (void);
+
+/* 私有函数 */
+static void latHistAdd (EASYRTOS_LAT_HIST *hist, uint16_t value);
+
+/**
+ * 功能: 清空直方图并初始化时间戳使用的定时器.由easyRTOSInit()调用.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * eLatencyReset ();
+ * archLatencyInit ();
+ */
+void eLatencyInit (void)
+{
+  latPending = FALSE;
+  latArmed = FALSE;
+  eLatencyReset ();
+  archLatencyInit ();
+}
+
+/**
+ * 功能: 记录进入中断的时间.由eIntEnter()通过LATENCY_INT_ENTER()调用.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * archLatencyStamp ();
+ */
+void eLatencyIntEnter (void)
+{
+  latEnterStamp = archLatencyStamp ();
+}
+
+/**
+ * 功能: 退出最外层中断时,若中断中给出了到达时间,则在调度之前准备记录
+ * 下一个运行的任务.由eIntExit()通过LATENCY_INT_EXIT()调用.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * int nest 退出后的中断嵌套层数 无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * 无
+ */
+void eLatencyIntExit (int nest)
+{
+  if ((nest == 0) && (latPending == TRUE))
+  {
+    latPending = FALSE;
+    latArmed = TRUE;
+  }
+}
+
+/**
+ * 功能: 调度器返回到被中断的任务,没有发生切换时放弃这次采样.
+ * 由eIntExit()通过LATENCY_SCHED_DONE()调用.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * 无
+ */
+void eLatencySchedDone (void)
+{
+  latArmed = FALSE;
+}
+
+/**
+ * 功能: 任务从archContextSwitch()返回,若是被测中断之后第一个运行的任务,
+ * 则记录从中断到达到此时的时间.由eTaskSwitch()通过LATENCY_SWITCH_IN()调用,
+ * 此时仍在临界区中.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * archLatencyStamp ();
+ * latHistAdd (&latHist[LATENCY_TASK], value);
+ */
+void eLatencySwitchIn (void)
+{
+  if (latArmed == TRUE)
+  {
+    latArmed = FALSE;
+    latHistAdd (&latHist[LATENCY_TASK], (uint16_t)(archLatencyStamp () - latArrival));
+  }
+}
+
+/**
+ * 功能: 给出被测中断的到达时间,在中断中eIntEnter()之后调用.
+ * 同一次中断中多次调用时以最后一次的到达时间计算LATENCY_TASK.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * uint16_t arrival 到达时间          无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * latHistAdd (&latHist[LATENCY_IRQ], value);
+ */
+void eLatencyIrq (uint16_t arrival)
+{
+  CRITICAL_STORE;
+
+  CRITICAL_ENTER ();
+  latHistAdd (&latHist[LATENCY_IRQ], (uint16_t)(latEnterStamp - arrival));
+  latArrival = arrival;
+  latPending = TRUE;
+  CRITICAL_EXIT ();
+}
+
+/**
+ * 功能: 复制一个直方图.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * uint8_t type 直方图类型 LATENCY_XXX EASYRTOS_LAT_HIST *hist 直方图
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ *
+ * 调用的函数:
+ * 无
+ */
+ERESULT eLatencyGet (uint8_t type, EASYRTOS_LAT_HIST *hist)
+{
+  CRITICAL_STORE;
+
+  if ((type >= LATENCY_HIST_NUM) || (hist == NULL))
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  CRITICAL_ENTER ();
+  *hist = latHist[type];
+  CRITICAL_EXIT ();
+
+  return (EASYRTOS_OK);
+}
+
+/**
+ * 功能: 根据直方图计算百分位数.结果为该百分位所在格的上限,不超过最大值;
+ * 落在最后一格时为最大值.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * const EASYRTOS_LAT_HIST *hist      无
+ * 由eLatencyGet()得到的直方图
+ * uint16_t permille 千分位,例如500为
+ * 中位数,999为99.9%
+ *
+ * 返回:
+ * uint16_t 百分位数,没有采样时为0
+ *
+ * 调用的函数:
+ * 无
+ */
+uint16_t eLatencyPercentile (const EASYRTOS_LAT_HIST *hist, uint16_t permille)
+{
+  uint32_t target;
+  uint32_t sum = 0;
+  uint16_t upper;
+  uint8_t i;
+
+  if ((hist == NULL) || (hist->count == 0))
+  {
+    return (0);
+  }
+  if (permille > 1000)
+  {
+    permille = 1000;
+  }
+
+  /* count*permille/1000向上取整,分开计算避免溢出,至少一个采样 */
+  target = (hist->count / 1000) * permille
+           + ((hist->count % 1000) * permille + 999) / 1000;
+  if (target == 0)
+  {
+    target = 1;
+  }
+
+  for (i = 0; i < EASYRTOS_LATENCY_BUCKETS - 1; i++)
+  {
+    sum += hist->bucket[i];
+    if (sum >= target)
+    {
+      upper = (uint16_t)((i + 1) * EASYRTOS_LATENCY_BUCKET_WIDTH - 1);
+      return ((upper < hist->max) ? upper : hist->max);
+    }
+  }
+
+  return (hist->max);
+}
+
+/**
+ * 功能: 清空所有直方图,开始新的统计.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * 无
+ */
+void eLatencyReset (void)
+{
+  CRITICAL_STORE;
+  uint8_t type;
+  uint8_t i;
+
+  CRITICAL_ENTER ();
+  for (type = 0; type < LATENCY_HIST_NUM; type++)
+  {
+    latHist[type].count = 0;
+    latHist[type].min = 0xFFFF;
+    latHist[type].max = 0;
+    for (i = 0; i < EASYRTOS_LATENCY_BUCKETS; i++)
+    {
+      latHist[type].bucket[i] = 0;
+    }
+  }
+  CRITICAL_EXIT ();
+}
+
+/**
+ * 功能: 把一个采样计入直方图,调用时已经在临界区中.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * EASYRTOS_LAT_HIST *hist 直方图     无
+ * uint16_t value 采样
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * 无
+ */
+static void latHistAdd (EASYRTOS_LAT_HIST *hist, uint16_t value)
+{
+  uint16_t slot;
+
+  hist->count++;
+  if (value < hist->min)
+  {
+    hist->min = value;
+  }
+  if (value > hist->max)
+  {
+    hist->max = value;
+  }
+
+  slot = (uint16_t)(value / EASYRTOS_LATENCY_BUCKET_WIDTH);
+  if (slot >= EASYRTOS_LATENCY_BUCKETS)
+  {
+    slot = EASYRTOS_LATENCY_BUCKETS - 1;
+  }
+  hist->bucket[slot]++;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ */
+#ifndef __EASYRTOSLATENCY_H
+#define __EASYRTOSLATENCY_H
+
+/* 直方图类型 */
+#define LATENCY_IRQ             0   /* 中断到达->eIntEnter() */
+#define LATENCY_TASK            1   /* 中断到达->中断退出后第一个运行的任务 */
+#define LATENCY_HIST_NUM        2
+
+#if (EASYRTOS_LATENCY_HIST == 1)
+
+/* 单位均为EASYRTOS_LATENCY_TIMER的计数 */
+typedef struct easyRTOSLatHist
+{
+    uint32_t  count;                              /* 采样次数 */
+    uint16_t  min;                                /* 最小值 */
+    uint16_t  max;                                /* 最大值 */
+    uint32_t  bucket[EASYRTOS_LATENCY_BUCKETS];   /* 每格EASYRTOS_LATENCY_BUCKET_WIDTH */
+} EASYRTOS_LAT_HIST;
+
+/* 内核调用 */
+#define LATENCY_INT_ENTER()     eLatencyIntEnter ()
+#define LATENCY_INT_EXIT(nest)  eLatencyIntExit (nest)
+#define LATENCY_SCHED_DONE()    eLatencySchedDone ()
+#define LATENCY_SWITCH_IN()     eLatencySwitchIn ()
+
+/* 全局函数 */
+extern void eLatencyInit (void);
+extern void eLatencyIntEnter (void);
+extern void eLatencyIntExit (int nest);
+extern void eLatencySchedDone (void);
+extern void eLatencySwitchIn (void);
+extern void eLatencyIrq (uint16_t arrival);
+extern ERESULT eLatencyGet (uint8_t type, EASYRTOS_LAT_HIST *hist);
+extern uint16_t eLatencyPercentile (const EASYRTOS_LAT_HIST *hist, uint16_t permille);
+extern void eLatencyReset (void);
+
+#else
+
+#define LATENCY_INT_ENTER()
+#define LATENCY_INT_EXIT(nest)
+#define LATENCY_SCHED_DONE()
+#define LATENCY_SWITCH_IN()
+
+#endif
+
+#endif
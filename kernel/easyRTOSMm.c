@@ -1,35 +1,35 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
-/* ڲ */
+/* 内部变量 */
 #include "easyRTOS.h"
 #include "easyRTOSkernel.h"
 #include "easyRTOSMm.h"
-static uint8_t *mem_heap;
-static uint8_t *mem_brk;
+static EASYRTOS_NODE_LOCAL uint8_t *mem_heap;
+static EASYRTOS_NODE_LOCAL uint8_t *mem_brk;
 
-/* ⲿɵú */
+/* 外部可调用函数 */
 void eMemInit(uint8_t* heapAddr,uint16_t maxHeap);
 uint8_t *eMalloc(uint16_t size);
 void eFree(uint8_t *addr);
 
-/* ڲ */
+/* 内部函数 */
 static uint8_t *memBlockMerge(uint8_t *bp);
 static void memBlockInit(void);
 static uint8_t *findFitBp(uint16_t size);
 static void placeBlock(uint8_t *bp,uint16_t size);
 static uint8_t *memBlockMerge(uint8_t *bp);
 /*
- *  ʽڴռ䣬ÿڴͷheadβfootмڴ
- *  ɣַӣջѵĽɶĽǣʾΪ
- *  һСΪ0ѷͷ0/1
+ *  分配器采用隐式链表管理内存分配空间，每个内存块由头（head）尾（foot）和中间内存组
+ *  成，由下往上生长（地址增加，区别于栈）。堆的结束由堆最后的结束块标记，结束块表示为
+ *  一个大小为0的已分配头（0/1）
  */
 
 /*------------------------------------------------------------------------------*/
-//ʼ ÿĿҪ4Byteͷ+4Byteβ Էn ByteʵҪռn+8Byte
+//分配器初始化 每个被分配的块需要4Byte头+4Byte尾 所以分配n Byte实际需要空间n+8Byte
 void eMemInit(uint8_t* heapAddr,uint16_t maxHeap)
 {
   mem_heap = heapAddr;
@@ -37,50 +37,51 @@ void eMemInit(uint8_t* heapAddr,uint16_t maxHeap)
   memBlockInit();
 }
 
-//ڴ ҵʵָп飬bpûкʵ򷵻NULL
+//申请内存分配 找到合适的则分割空闲块，返回bp，若没有合适的则返回NULL
+//遍历堆时调度器上锁，不关闭中断，不能在中断中调用
 uint8_t *eMalloc(uint16_t size)
 {
   uint8_t *bp;
   if (size==0)return NULL;
+  eSchedLock();
   if ((bp = findFitBp(size))!=NULL)
   {
     placeBlock(bp,size);
-    return bp;
-  }
-  else
-  {
-    return NULL;
   }
+  eSchedUnlock();
+  return bp;
 }
 
-//ͷѷڴ
+//释放已分配的内存
 void eFree(uint8_t *bp)
 {
   uint16_t size = GET_SIZE(HDRP(bp));
+  eSchedLock();
   PUT(HDRP(bp),PACKHF(size,0));
   PUT(FTRP(bp),PACKHF(size,0));
   memBlockMerge(bp);
+  eSchedUnlock();
 }
 
-//ʼ
+//块初始化
 static void memBlockInit(void)
 {
   uint8_t *bp = mem_heap+HDSIZE;
   uint32_t data = PACKHF((uint32_t)(mem_brk - mem_heap),0);
-  static uint8_t *p;
-  //ʼһfree
+  uint8_t *p;
+  //初始化第一个free块
   PUT(HDRP(bp),data);
   PUT(FTRP(bp),data);
-  //ý־
+  //设置结束块标志
   p=NEXT_BLKP(bp);
   PUT(HDRP(p),PACKHF(0,1));
 }
 
-//ѰʴСĿ ֱǷNULLҵ򷵻ؿпbp
+//搜寻合适大小的块 直到结束块标记返回NULL，找到则返回空闲块的bp
 static uint8_t *findFitBp(uint16_t size)
 {
   uint8_t *bp;
-  //Ϊ ҵ󷵻ظbp
+  //结束条件为遇到结束符号 找到后返回该bp
   for (bp = mem_heap+HDSIZE;!((GET_SIZE(HDRP(bp)) == 0) && (GET_ALLOC(HDRP(bp)) == 1)); bp = NEXT_BLKP(bp))
   {
     if ( (GET_SIZE(HDRP(bp)) >= (size+HDSIZE+FTSIZE)) && (!GET_ALLOC(HDRP(bp))) )
@@ -88,53 +89,57 @@ static uint8_t *findFitBp(uint16_t size)
       return bp;
     }
   }
-  //δҵ NULL
+  //未找到 返回NULL
   return NULL;
 }
 
-//ָ
+//分割块 剩余部分放不下一个块时整块分配，避免产生大小为0的空闲块
 static void placeBlock(uint8_t *bp,uint16_t size)
 {
   uint16_t blockSize = GET_SIZE(HDRP(bp));
   uint16_t blockSizeNeed = size+HDSIZE+FTSIZE;
+  if ((blockSize-blockSizeNeed) <= (HDSIZE+FTSIZE))
+  {
+    PUT(HDRP(bp),PACKHF(blockSize,1));
+    PUT(FTRP(bp),PACKHF(blockSize,1));
+    return;
+  }
   PUT(HDRP(bp),PACKHF(blockSizeNeed,1));
   PUT(FTRP(bp),PACKHF(blockSizeNeed,1));
   PUT(HDRP(NEXT_BLKP(bp)),PACKHF(blockSize-blockSizeNeed,0));
   PUT(FTRP(NEXT_BLKP(bp)),PACKHF(blockSize-blockSizeNeed,0));
 }
 
-//пϲ
+//空闲块合并 堆中第一个块前面没有块，视为已占用
+//先算出合并后的大小和头尾位置再写入，写入后的头会改变HDRP/FTRP的计算结果
 static uint8_t *memBlockMerge(uint8_t *bp)
 {
-  uint8_t prevAlloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
+  uint8_t prevAlloc = (bp == mem_heap+HDSIZE) ? 1 : GET_ALLOC(FTRP(PREV_BLKP(bp)));
   uint8_t nextAlloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+  uint32_t size = GET_SIZE(HDRP(bp));
+  uint8_t *hdr = HDRP(bp);
+  uint8_t *ftr = FTRP(bp);
 
-  //ռãֱӷ
+  //都被占用，则直接返回
   if (prevAlloc && nextAlloc)
   {
     return bp;
   }
-  //ǰ汻ռãУϲ
-  else if (prevAlloc && !nextAlloc)
-  {
-    PUT(HDRP(bp),PACKHF(GET_SIZE(HDRP(bp))+GET_SIZE(HDRP(NEXT_BLKP(bp))),0));
-    PUT(FTRP(NEXT_BLKP(bp)),PACKHF(GET_SIZE(HDRP(bp))+GET_SIZE(HDRP(NEXT_BLKP(bp))),0));
-    return bp;
-  }
-  //汻ռãǰУǰϲ
-  else if (!prevAlloc && nextAlloc)
+  //后面块空闲，向后合并
+  if (!nextAlloc)
   {
-    PUT(HDRP(PREV_BLKP(bp)),PACKHF(GET_SIZE(HDRP(bp))+GET_SIZE(HDRP(PREV_BLKP(bp))),0));
-    PUT(FTRP(bp),PACKHF(GET_SIZE(HDRP(bp))+GET_SIZE(HDRP(PREV_BLKP(bp))),0));
-    return PREV_BLKP(bp);
+    size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
+    ftr = FTRP(NEXT_BLKP(bp));
   }
-  //涼У˫ϲ
-  else if (!prevAlloc && !nextAlloc)
+  //前面块空闲，向前合并
+  if (!prevAlloc)
   {
-    PUT(HDRP(PREV_BLKP(bp)),PACKHF(GET_SIZE(HDRP(bp)) + GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(HDRP(NEXT_BLKP(bp))),0));
-    PUT(FTRP(NEXT_BLKP(bp)),PACKHF(GET_SIZE(HDRP(bp)) + GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(HDRP(NEXT_BLKP(bp))),0));
-    return PREV_BLKP(bp);
+    size += GET_SIZE(HDRP(PREV_BLKP(bp)));
+    hdr = HDRP(PREV_BLKP(bp));
+    bp = PREV_BLKP(bp);
   }
-  else return NULL;
+  PUT(hdr,PACKHF(size,0));
+  PUT(ftr,PACKHF(size,0));
+  return bp;
 }
 
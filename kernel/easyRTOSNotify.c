@@ -0,0 +1,421 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 任务通知:每个任务的TCB中有一个32位的通知值,可以代替二值信号量,计数信号量
+ * 以及事件标志向指定的任务发送信号.等待的任务不在任何悬挂队列中,通知时直接
+ * 将任务加入Ready队列,不需要搜索悬挂队列,也不需要单独的信号量结构体.
+ * 一个任务只有一个通知值,所以只适合有唯一接收者的场合.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSNotify.h"
+
+/* 全局函数 */
+ERESULT eTaskNotify (EASYRTOS_TCB *tcb_ptr, uint32_t value, uint8_t action);
+ERESULT eTaskNotifyGive (EASYRTOS_TCB *tcb_ptr);
+ERESULT eTaskNotifyTake (uint8_t clear, int32_t timeout, uint32_t *value);
+ERESULT eTaskNotifyWait (uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, int32_t timeout);
+
+/* 私有函数 */
+static ERESULT eNotifyPend (EASYRTOS_TCB *tcb_ptr, int32_t timeout);
+static void eNotifyTimerCallback (POINTER cb_data);
+
+/**
+ * 功能: 向任务发送通知,按action修改任务的通知值.若任务正在等待通知,则直接
+ * 将其加入Ready队列,在任务上下文中调用时启动调度器.可以在中断中调用,中断中
+ * 由eIntExit()启动调度器.
+ *
+ * 参数:
+ * 输入:                                      输出:
+ * EASYRTOS_TCB *tcb_ptr 接收通知的任务       EASYRTOS_TCB *tcb_ptr 接收通知的任务
+ * uint32_t value 通知值
+ * uint8_t action 对通知值的操作 NOTIFY_XXX
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_OVF NOTIFY_NO_OVERWRITE时上一个通知还没有被取走
+ * EASYRTOS_ERR_QUEUE 将任务加入Ready队列失败
+ * EASYRTOS_ERR_TIMER 取消定时器失败
+ *
+ * 调用的函数:
+ * eTimerCancel (tcb_ptr->pended_timo_cb);
+ * tcbEnqueueReady (tcb_ptr);
+ * eCurrentContext ();
+ * easyRTOSSched (FALSE);
+ */
+ERESULT eTaskNotify (EASYRTOS_TCB *tcb_ptr, uint32_t value, uint8_t action)
+{
+  ERESULT status = EASYRTOS_OK;
+  uint8_t woken = FALSE;
+  CRITICAL_STORE;
+
+  /* 参数检查 */
+  if ((tcb_ptr == NULL) || (tcb_ptr->state == TASK_DELETED))
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  switch (action)
+  {
+    case NOTIFY_NO_ACTION:
+      break;
+
+    case NOTIFY_SET_BITS:
+      tcb_ptr->notifyValue |= value;
+      break;
+
+    case NOTIFY_INCREMENT:
+      tcb_ptr->notifyValue++;
+      break;
+
+    case NOTIFY_OVERWRITE:
+      tcb_ptr->notifyValue = value;
+      break;
+
+    case NOTIFY_NO_OVERWRITE:
+      if (tcb_ptr->notifyState == NOTIFY_PENDING)
+      {
+        status = EASYRTOS_ERR_OVF;
+      }
+      else
+      {
+        tcb_ptr->notifyValue = value;
+      }
+      break;
+
+    default:
+      status = EASYRTOS_ERR_PARAM;
+      break;
+  }
+
+  if (status == EASYRTOS_OK)
+  {
+    /**
+     * 任务正在等待通知则直接唤醒.任务等待时被挂起(state为TASK_SUSPEND)则
+     * 只保留通知,恢复后由eTaskNotifyTake()/eTaskNotifyWait()取走.
+     */
+    if ((tcb_ptr->notifyState == NOTIFY_WAITING) && (tcb_ptr->state == TASK_PENDED))
+    {
+      /* 解除timeout注册的定时器 */
+      if ((tcb_ptr->pended_timo_cb != NULL)
+          && (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK))
+      {
+        status = EASYRTOS_ERR_TIMER;
+      }
+      tcb_ptr->pended_timo_cb = NULL;
+
+      if (tcbEnqueueReady (tcb_ptr) != EASYRTOS_OK)
+      {
+        status = EASYRTOS_ERR_QUEUE;
+      }
+      else
+      {
+        tcb_ptr->pendedWakeStatus = EASYRTOS_OK;
+        tcb_ptr->state = TASK_READY;
+        woken = TRUE;
+      }
+    }
+    tcb_ptr->notifyState = NOTIFY_PENDING;
+  }
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  /* 中断中由eIntExit()调用调度器 */
+  if ((woken == TRUE) && eCurrentContext ())
+  {
+    easyRTOSSched (FALSE);
+  }
+
+  return (status);
+}
+
+/**
+ * 功能: 通知值加1,与eTaskNotifyTake()配合作为轻量的计数信号量或二值信号量使用.
+ * 可以在中断中调用.
+ *
+ * 参数:
+ * 输入:                                      输出:
+ * EASYRTOS_TCB *tcb_ptr 接收通知的任务       EASYRTOS_TCB *tcb_ptr 接收通知的任务
+ *
+ * 返回:
+ * 同eTaskNotify()
+ *
+ * 调用的函数:
+ * eTaskNotify (tcb_ptr, 0, NOTIFY_INCREMENT);
+ */
+ERESULT eTaskNotifyGive (EASYRTOS_TCB *tcb_ptr)
+{
+  return (eTaskNotify (tcb_ptr, 0, NOTIFY_INCREMENT));
+}
+
+/**
+ * 功能: 当前任务等待通知值不为0,然后将通知值清零(clear为TRUE,二值信号量)或者
+ * 减1(clear为FALSE,计数信号量).只能在任务上下文中调用.
+ * 被NOTIFY_NO_ACTION等不改变通知值的通知唤醒时,返回EASYRTOS_OK,value为0.
+ *
+ * 参数:
+ * 输入:                                      输出:
+ * uint8_t clear TRUE清零,FALSE减1           uint32_t *value 取走之前的通知值,可以为NULL
+ * int32_t timeout 0永久等待,>0等待的心跳数,-1不等待
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_TIMEOUT timeout时间到
+ * EASYRTOS_WOULDBLOCK 通知值为0并且timeout为-1
+ * EASYRTOS_ERR_SUSPENDED 等待时任务被挂起
+ * EASYRTOS_ERR_CONTEXT 不在任务上下文中
+ * EASYRTOS_ERR_TIMER 注册定时器失败
+ *
+ * 调用的函数:
+ * eCurrentContext ();
+ * eNotifyPend (curr_tcb_ptr, timeout);
+ */
+ERESULT eTaskNotifyTake (uint8_t clear, int32_t timeout, uint32_t *value)
+{
+  ERESULT status = EASYRTOS_OK;
+  EASYRTOS_TCB *curr_tcb_ptr;
+  CRITICAL_STORE;
+
+  /* 只能在任务上下文中等待 */
+  curr_tcb_ptr = eCurrentContext ();
+  if (curr_tcb_ptr == NULL)
+  {
+    return (EASYRTOS_ERR_CONTEXT);
+  }
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  if (curr_tcb_ptr->notifyValue == 0)
+  {
+    /* 丢弃没有改变通知值的通知,等待新的通知 */
+    curr_tcb_ptr->notifyState = NOTIFY_NONE;
+    CRITICAL_EXIT ();
+
+    status = eNotifyPend (curr_tcb_ptr, timeout);
+
+    CRITICAL_ENTER ();
+  }
+
+  if (value)
+  {
+    *value = curr_tcb_ptr->notifyValue;
+  }
+
+  /* timeout与通知同时发生时以通知为准 */
+  if (curr_tcb_ptr->notifyValue != 0)
+  {
+    if (clear == TRUE)
+    {
+      curr_tcb_ptr->notifyValue = 0;
+    }
+    else
+    {
+      curr_tcb_ptr->notifyValue--;
+    }
+    status = EASYRTOS_OK;
+  }
+  curr_tcb_ptr->notifyState = NOTIFY_NONE;
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  return (status);
+}
+
+/**
+ * 功能: 当前任务等待通知,作为事件标志使用.等待之前清除通知值中clear_on_entry
+ * 的位(已有通知未取走时不清除),收到通知后返回通知值并清除clear_on_exit的位.
+ * 只能在任务上下文中调用.
+ *
+ * 参数:
+ * 输入:                                      输出:
+ * uint32_t clear_on_entry 等待前清除的位     uint32_t *value 通知值,可以为NULL
+ * uint32_t clear_on_exit 收到通知后清除的位
+ * int32_t timeout 0永久等待,>0等待的心跳数,-1不等待
+ *
+ * 返回:
+ * EASYRTOS_OK 收到通知
+ * EASYRTOS_TIMEOUT timeout时间到
+ * EASYRTOS_WOULDBLOCK 没有通知并且timeout为-1
+ * EASYRTOS_ERR_SUSPENDED 等待时任务被挂起
+ * EASYRTOS_ERR_CONTEXT 不在任务上下文中
+ * EASYRTOS_ERR_TIMER 注册定时器失败
+ *
+ * 调用的函数:
+ * eCurrentContext ();
+ * eNotifyPend (curr_tcb_ptr, timeout);
+ */
+ERESULT eTaskNotifyWait (uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, int32_t timeout)
+{
+  ERESULT status = EASYRTOS_OK;
+  EASYRTOS_TCB *curr_tcb_ptr;
+  CRITICAL_STORE;
+
+  /* 只能在任务上下文中等待 */
+  curr_tcb_ptr = eCurrentContext ();
+  if (curr_tcb_ptr == NULL)
+  {
+    return (EASYRTOS_ERR_CONTEXT);
+  }
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  if (curr_tcb_ptr->notifyState != NOTIFY_PENDING)
+  {
+    curr_tcb_ptr->notifyValue &= ~clear_on_entry;
+    CRITICAL_EXIT ();
+
+    status = eNotifyPend (curr_tcb_ptr, timeout);
+
+    CRITICAL_ENTER ();
+  }
+
+  /* timeout与通知同时发生时以通知为准 */
+  if (curr_tcb_ptr->notifyState == NOTIFY_PENDING)
+  {
+    status = EASYRTOS_OK;
+  }
+
+  if (value)
+  {
+    *value = curr_tcb_ptr->notifyValue;
+  }
+  if (status == EASYRTOS_OK)
+  {
+    curr_tcb_ptr->notifyValue &= ~clear_on_exit;
+  }
+  curr_tcb_ptr->notifyState = NOTIFY_NONE;
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  return (status);
+}
+
+/**
+ * 功能: 悬挂当前任务直到收到通知或者timeout到期.任务不加入任何悬挂队列
+ * (pended_q为NULL),由eTaskNotify()直接加入Ready队列.
+ *
+ * 参数:
+ * 输入:                                      输出:
+ * EASYRTOS_TCB *tcb_ptr 当前任务             无
+ * int32_t timeout 0永久等待,>0等待的心跳数,-1不等待
+ *
+ * 返回:
+ * EASYRTOS_OK 收到通知
+ * EASYRTOS_TIMEOUT timeout时间到
+ * EASYRTOS_WOULDBLOCK timeout为-1
+ * EASYRTOS_ERR_SUSPENDED 等待时任务被挂起
+ * EASYRTOS_ERR_TIMER 注册定时器失败
+ *
+ * 调用的函数:
+ * eTimerRegister (&timerCb);
+ * easyRTOSSched (FALSE);
+ */
+static ERESULT eNotifyPend (EASYRTOS_TCB *tcb_ptr, int32_t timeout)
+{
+  EASYRTOS_TIMER timerCb;
+  CRITICAL_STORE;
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  /* 检查之后通知已经到达 */
+  if (tcb_ptr->notifyState == NOTIFY_PENDING)
+  {
+    CRITICAL_EXIT ();
+    return (EASYRTOS_OK);
+  }
+
+  /* timeout == -1, 不需要悬挂 */
+  if (timeout < 0)
+  {
+    CRITICAL_EXIT ();
+    return (EASYRTOS_WOULDBLOCK);
+  }
+
+  tcb_ptr->notifyState = NOTIFY_WAITING;
+  tcb_ptr->state = TASK_PENDED;
+  tcb_ptr->pended_q = NULL;
+  tcb_ptr->pended_timo_cb = NULL;
+
+  /* 根据timeout的值，决定是否需要注册定时器回调 */
+  if (timeout)
+  {
+    timerCb.cb_func = eNotifyTimerCallback;
+    timerCb.cb_data = (POINTER)tcb_ptr;
+    timerCb.cb_ticks = timeout;
+    tcb_ptr->pended_timo_cb = &timerCb;
+
+    if (eTimerRegister (&timerCb) != EASYRTOS_OK)
+    {
+      /* 注册失败,任务继续运行 */
+      tcb_ptr->pended_timo_cb = NULL;
+      tcb_ptr->state = TASK_RUN;
+      tcb_ptr->notifyState = NOTIFY_NONE;
+      CRITICAL_EXIT ();
+      return (EASYRTOS_ERR_TIMER);
+    }
+  }
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  /* 任务被悬挂，调用调度器启动一个新的任务 */
+  easyRTOSSched (FALSE);
+
+  return (tcb_ptr->pendedWakeStatus);
+}
+
+/**
+ * 功能: 等待通知的timeout定时器的回调函数,给到期的任务返回EASYRTOS_TIMEOUT
+ * 的标志,并加入Ready列表.
+ *
+ * 参数:
+ * 输入:                                      输出:
+ * POINTER cb_data 等待通知的任务TCB          无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * tcbEnqueueReady (tcb_ptr);
+ */
+static void eNotifyTimerCallback (POINTER cb_data)
+{
+  EASYRTOS_TCB *tcb_ptr = (EASYRTOS_TCB *)cb_data;
+  CRITICAL_STORE;
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  if ((tcb_ptr->notifyState == NOTIFY_WAITING) && (tcb_ptr->state == TASK_PENDED))
+  {
+    /* 设置标志，表明任务是由于timeout到期而唤醒的  */
+    tcb_ptr->pendedWakeStatus = EASYRTOS_TIMEOUT;
+    tcb_ptr->pended_timo_cb = NULL;
+    tcb_ptr->notifyState = NOTIFY_NONE;
+
+    /* 将任务加入Ready队列 */
+    if (tcbEnqueueReady (tcb_ptr) == EASYRTOS_OK)
+    {
+      tcb_ptr->state = TASK_READY;
+    }
+  }
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  /* 这里没有启动调度器，因为之后在退出timer ISR的时候会通过eIntExit()启动 */
+}
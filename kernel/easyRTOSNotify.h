@@ -0,0 +1,28 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ */
+#ifndef __EASYRTOSNOTIFY_H
+#define __EASYRTOSNOTIFY_H
+
+/* 任务通知状态 */
+#define NOTIFY_NONE       0x00    /* 没有通知 */
+#define NOTIFY_WAITING    0x01    /* 任务正在等待通知 */
+#define NOTIFY_PENDING    0x02    /* 通知已到达,还没有被取走 */
+
+/* eTaskNotify()对通知值的操作 */
+#define NOTIFY_NO_ACTION  0x00    /* 只通知,不改变通知值 */
+#define NOTIFY_SET_BITS   0x01    /* 通知值与value按位或 */
+#define NOTIFY_INCREMENT  0x02    /* 通知值加1,相当于计数信号量的Give */
+#define NOTIFY_OVERWRITE  0x03    /* 通知值设置为value */
+#define NOTIFY_NO_OVERWRITE 0x04  /* 没有未取走的通知时,通知值设置为value */
+
+/* 全局函数 */
+extern ERESULT eTaskNotify (EASYRTOS_TCB *tcb_ptr, uint32_t value, uint8_t action);
+extern ERESULT eTaskNotifyGive (EASYRTOS_TCB *tcb_ptr);
+extern ERESULT eTaskNotifyTake (uint8_t clear, int32_t timeout, uint32_t *value);
+extern ERESULT eTaskNotifyWait (uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, int32_t timeout);
+
+#endif
@@ -1,7 +1,7 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #include "easyRTOS.h"
@@ -9,74 +9,87 @@
 #include "easyRTOSport.h"
 #include "easyRTOSTimer.h"
 #include "easyRTOSQueue.h"
+#include "easyRTOSTrace.h"
 
 #include "string.h"
 
-/* ˽к */
-static ERESULT queue_remove (EASYRTOS_QUEUE *qptr, void* msgptr);
-static ERESULT queue_insert (EASYRTOS_QUEUE *qptr, void* msgptr);
+/* 私有函数 */
+static uint8_t *queue_reserve_remove (EASYRTOS_QUEUE *qptr);
+static uint8_t *queue_reserve_insert (EASYRTOS_QUEUE *qptr);
+static ERESULT queue_remove (EASYRTOS_QUEUE *qptr, uint8_t *slot, void* msgptr);
+static ERESULT queue_insert (EASYRTOS_QUEUE *qptr, uint8_t *slot, void* msgptr);
+static ERESULT queue_wake (EASYRTOS_TCB **suspQ, uint8_t count);
 static void eQueueTimerCallback (POINTER cb_data);
+static uint8_t queue_timeout_remain (int32_t *timeout, uint32_t deadline, ERESULT *status);
 
-/* ȫֺ */
+/* 全局函数 */
 EASYRTOS_QUEUE eQueueCreate ( void *buff_ptr, uint32_t unit_size, uint32_t max_num_msgs);
 ERESULT eQueueDelete (EASYRTOS_QUEUE *qptr);
 ERESULT eQueueTake (EASYRTOS_QUEUE *qptr, int32_t timeout, void *msgptr);
 ERESULT eQueueGive (EASYRTOS_QUEUE *qptr, int32_t timeout, void *msgptr);
 
 /**
- * : д,ʼнṹڵĲ,.
+ * 功能: 队列创建,初始化队列结构体内的参数,并返回.
  *
- * :
- * :                                   :
- * void *buff_ptr Ϣַָ      
- * uint32_t unit_size Ϣռֽ
- * uint32_t max_num_msgs Ϣ
+ * 参数:
+ * 输入:                                   输出:
+ * void *buff_ptr 队列消息保存地址指针      无
+ * uint32_t unit_size 单个消息所占字节
+ * uint32_t max_num_msgs 总消息数量
  *
- * :
+ * 返回:
  * EASYRTOS_QUEUE
  * 
- * õĺ:
- * .
+ * 调用的函数:
+ * 无.
  */
 EASYRTOS_QUEUE eQueueCreate ( void *buff_ptr, uint32_t unit_size, uint32_t max_num_msgs)
 {
   EASYRTOS_QUEUE qptr;
 
-  /* 洢 */
+  /* 存储队列详情 */
   qptr.buff_ptr = buff_ptr;
   qptr.unit_size = unit_size;
   qptr.max_num_msgs = max_num_msgs;
 
-  /* ʼ */
+  /* 初始化被阻塞任务队列 */
   qptr.putSuspQ = NULL;
   qptr.getSuspQ = NULL;
 
-  /* ʼ/Ƴ */
+  /* 初始化插入/移除索引 */
   qptr.insert_index = 0;
   qptr.remove_index = 0;
   qptr.num_msgs_stored = 0;
+  qptr.put_busy = 0;
+  qptr.put_done = 0;
+  qptr.get_busy = 0;
+  qptr.get_done = 0;
 
   return (qptr);
 }
 
 /**
- * : ɾ,бöҵReadyб.ͬʱȡ
- * עĶʱ.񱻻,.
+ * 功能: 删除队列,并唤醒所有被该队列悬挂的任务加入Ready列表中.同时取消该任务
+ * 注册的定时器.若有任务被唤醒,则会启动调度器.
+ * 唤醒过程中调度器上锁,被唤醒的任务在所有任务都唤醒后才会运行,每个任务只在
+ * 移出悬挂队列时短暂地关闭中断.
  *
- * :
- * :                                   :
- * EASYRTOS_QUEUE *qptr ָ           EASYRTOS_QUEUE *qptr ָ
+ * 参数:
+ * 输入:                                   输出:
+ * EASYRTOS_QUEUE *qptr 队列指针           EASYRTOS_QUEUE *qptr 队列指针
  *
- * :
- * EASYRTOS_OK ɹ
- * EASYRTOS_ERR_QUEUE õReadyʧ
- * EASYRTOS_ERR_TIMER ȡʱʧ
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_QUEUE 将任务放置到Ready队列中失败
+ * EASYRTOS_ERR_TIMER 取消定时器失败
  * 
- * õĺ:
+ * 调用的函数:
  * tcb_dequeue_head (&qptr->getSuspQ);
  * tcb_dequeue_head (&qptr->putSuspQ);
- * tcbEnqueuePriority (&tcb_readyQ, tcb_ptr);
+ * tcbEnqueueReady (tcb_ptr);
  * eTimerCancel (tcb_ptr->pended_timo_cb);
+ * eSchedLock ();
+ * eSchedUnlock ();
  * eCurrentContext();
  * easyRTOSSched (FALSE);
  */
@@ -87,82 +100,87 @@ ERESULT eQueueDelete (EASYRTOS_QUEUE *qptr)
   EASYRTOS_TCB *tcb_ptr;
   uint8_t wokenTasks = FALSE;
 
-  /*  */
+  /* 参数检查 */
   if (qptr == NULL)
   {
     status = EASYRTOS_ERR_PARAM;
   }
   else
   {
-    /* ĬϷ */
+    /* 默认返回 */
     status = EASYRTOS_OK;
 
-    /* бҵ񣨽ReadyУ */
+    /* 唤醒完所有任务之前不切换任务 */
+    eSchedLock ();
+
+    /* 唤醒所有被悬挂的任务（将其加入Ready队列） */
     while (1)
     {
-      /* ٽ */
+      /* 进入临界区 */
       CRITICAL_ENTER ();
 
-      /* Ƿ̱߳ ȴͻȴգ */
+      /* 检查是否有线程被悬挂 （等待发送或等待接收） */
       if (((tcb_ptr = tcb_dequeue_head (&qptr->getSuspQ)) != NULL)
           || ((tcb_ptr = tcb_dequeue_head (&qptr->putSuspQ)) != NULL))
       {
 
-        /* ش״̬ */
+        /* 返回错误状态 */
         tcb_ptr->pendedWakeStatus = EASYRTOS_ERR_DELETED;
 
-        /* Ready */
-        if (tcbEnqueuePriority (&tcb_readyQ, tcb_ptr) != EASYRTOS_OK)
+        /* 将任务加入Ready队列 */
+        if (tcbEnqueueReady (tcb_ptr) != EASYRTOS_OK)
         {
-          /* ˳ٽ */
+          /* 退出临界区 */
           CRITICAL_EXIT ();
 
-          /* ˳ѭش */
+          /* 退出循环，返回错误 */
           status = EASYRTOS_ERR_QUEUE;
           break;
         }
         else tcb_ptr->state = TASK_READY;
 
-        /* ȡעĶʱ */
+        /* 取消阻塞任务注册的定时器 */
         if (tcb_ptr->pended_timo_cb)
         {
-          /* ȡص */
+          /* 取消回调函数 */
           if (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK)
           {
-              /* ˳ٽ */
+              /* 退出临界区 */
               CRITICAL_EXIT ();
 
-              /* ˳ѭش */
+              /* 退出循环，返回错误 */
               status = EASYRTOS_ERR_TIMER;
               break;
           }
 
-          /* ûжʱص */
+          /* 标记任务没有定时器回调 */
           tcb_ptr->pended_timo_cb = NULL;
         }
 
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
 
-        /* Ƿõ */
+        /* 是否调用调度器 */
         wokenTasks= TRUE;
       }
 
-      /* ûбҵ */
+      /* 没有被悬挂的任务 */
       else
       {
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
         break;
       }
     }
 
-    /* 񱻻ѣõ */
+    eSchedUnlock ();
+
+    /* 若有任务被唤醒，调用调度器 */
     if (wokenTasks == TRUE)
     {
       /**
-       * ֻĻõ
-       * жϻeIntExit()õ
+       * 只在任务上下文环境调用调度器。
+       * 中断环境会有eIntExit()调用调度器。
        */
       if (eCurrentContext())
         easyRTOSSched (FALSE);
@@ -173,35 +191,37 @@ ERESULT eQueueDelete (EASYRTOS_QUEUE *qptr)
 }
 
 /**
- * : ȡе,ԶΪ,timeoutĲֵͬвͬĴʽ.
- * 1.timeout>0 ҵõ,timeoutڵʱ񲢷timeout־
- * 2.timeout=0 ҵõ,ֱӶеȵ.
- * 3.timeout=-1 ,Ϊջ᷵ضΪձ־.
- * ҵʱ,õ.
+ * 功能: 取出队列中的数据,若对队列为空,根据timeout的不同值有不同的处理方式.
+ * 1.timeout>0 悬挂调用的任务,当timeout到期的时候唤醒任务并返回timeout标志
+ * 2.timeout=0 永久悬挂调用的任务,直到从队列中等到数据.
+ * 3.timeout=-1 不悬挂任务,若队列为空会返回队列为空标志.
+ * 当有任务被悬挂的时候,将会调用调度器.被唤醒后消息已经被中断或者更高优先级
+ * 的任务取走时,以剩余的timeout重新悬挂.
  *
- * :
- * :                                        :
- * EASYRTOS_QUEUE *qptr ָ                EASYRTOS_QUEUE *qptr ָ
- * int32_t timeout timeoutʱ,ʱ   void *msgptr ȡϢ
- * void *msgptr ȡϢ                 
+ * 参数:
+ * 输入:                                        输出:
+ * EASYRTOS_QUEUE *qptr 队列指针                EASYRTOS_QUEUE *qptr 队列指针
+ * int32_t timeout timeout时间,依赖于心跳时间   void *msgptr 获取的消息
+ * void *msgptr 获取的消息                 
  * 
- * :
- * EASYRTOS_OK ɹ
- * EASYRTOS_TIMEOUT źtimeout
- * EASYRTOS_WOULDBLOCK ᱻҵtimeoutΪ-1Է
- * EASYRTOS_ERR_DELETED ʱɾ
- * EASYRTOS_ERR_CONTEXT ĵ
- * EASYRTOS_ERR_PARAM 
- * EASYRTOS_ERR_QUEUE жʧ
- * EASYRTOS_ERR_TIMER עᶨʱδɹ
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_TIMEOUT 信号量timeout到期
+ * EASYRTOS_WOULDBLOCK 本来会被悬挂但由于timeout为-1所以返回了
+ * EASYRTOS_ERR_DELETED 队列在悬挂任务时被删除
+ * EASYRTOS_ERR_CONTEXT 错误的上下文调用
+ * EASYRTOS_ERR_PARAM 参数错误
+ * EASYRTOS_ERR_QUEUE 将任务加入运行队列失败
+ * EASYRTOS_ERR_TIMER 注册定时器未成功
  * 
- * õĺ:
+ * 调用的函数:
  * eCurrentContext();
  * tcbEnqueuePriority (&qptr->getSuspQ, curr_tcb_ptr);
  * eTimerRegister (&timerCb);
  * tcb_dequeue_entry (&qptr->getSuspQ, curr_tcb_ptr);
  * easyRTOSSched (FALSE);
- * queue_remove (qptr, msgptr);
+ * queue_reserve_remove (qptr);
+ * queue_remove (qptr, slot, msgptr);
  */
 ERESULT eQueueTake (EASYRTOS_QUEUE *qptr, int32_t timeout, void *msgptr)
 {
@@ -210,175 +230,196 @@ ERESULT eQueueTake (EASYRTOS_QUEUE *qptr, int32_t timeout, void *msgptr)
     QUEUE_TIMER timerData;
     EASYRTOS_TIMER timerCb;
     EASYRTOS_TCB *curr_tcb_ptr;
+    uint8_t *slot;
+    uint32_t deadline = 0;
+    uint8_t retry;
 
-    /*  */
+    /* 参数检查 */
     if ((qptr == NULL)) //|| (msgptr == NULL))
     {
       status = EASYRTOS_ERR_PARAM;
     }
     else
     {
-      /* ٽ */
-      CRITICAL_ENTER ();
+      /* timeout>0时记录到期的时间,唤醒后重新悬挂时计算剩余的时间 */
+      if (timeout > 0)
+      {
+        CRITICAL_ENTER ();
+        deadline = eTimeGet () + (uint32_t)timeout;
+        CRITICAL_EXIT ();
+      }
 
-      /* ûϢ */
-      if (qptr->num_msgs_stored == 0)
+      do
       {
-        
-        /* timeout>0  */
-        if (timeout >= 0)
-        {
+        retry = FALSE;
 
-          /* ȡǰTCB */
-          curr_tcb_ptr = eCurrentContext();
+        /* 进入临界区 */
+        CRITICAL_ENTER ();
 
-          /* Ƿ */
-          if (curr_tcb_ptr)
+        /* 预留一条消息,若队列中没有消息，则悬挂任务 */
+        slot = queue_reserve_remove (qptr);
+        if (slot == NULL)
+        {
+        
+          /* timeout>0 悬挂任务 */
+          if (timeout >= 0)
           {
-            
-            /* ǰӵreceiveҶ */
-            if (tcbEnqueuePriority (&qptr->getSuspQ, curr_tcb_ptr) == EASYRTOS_OK)
-            {
-              
-              /* ״̬Ϊ */
-              curr_tcb_ptr->state = TASK_PENDED;
 
-              status = EASYRTOS_OK;
+            /* 获取当前任务TCB */
+            curr_tcb_ptr = eCurrentContext();
 
-              /* עᶨʱص */
-              if (timeout)
+            /* 检查我们是否在任务上下文 */
+            if (curr_tcb_ptr)
+            {
+            
+              /* 将当前任务增加到receive悬挂队列中 */
+              if (tcbEnqueuePriority (&qptr->getSuspQ, curr_tcb_ptr) == EASYRTOS_OK)
               {
-                /* 䶨ʱҪ */
-                timerData.tcb_ptr = curr_tcb_ptr;
-                timerData.queue_ptr = qptr;
-                timerData.suspQ = &qptr->getSuspQ;
-
-                /* صҪ */
-                timerCb.cb_func = eQueueTimerCallback;
-                timerCb.cb_data = (POINTER)&timerData;
-                timerCb.cb_ticks = timeout;
+              
+                /* 将任务状态设置为悬挂 */
+                curr_tcb_ptr->state = TASK_PENDED;
+                curr_tcb_ptr->pended_q = &qptr->getSuspQ;
 
-                /* TCBд洢ʱصȡ */
-                curr_tcb_ptr->pended_timo_cb = &timerCb;
+                status = EASYRTOS_OK;
 
-                /* עᶨʱ */
-                if (eTimerRegister (&timerCb) != EASYRTOS_OK)
+                /* 注册定时器回调 */
+                if (timeout)
                 {
-                  /* עʧ */
-                  status = EASYRTOS_ERR_TIMER;
+                  /* 填充定时器需要的数据 */
+                  timerData.tcb_ptr = curr_tcb_ptr;
+                  timerData.queue_ptr = qptr;
+                  timerData.suspQ = &qptr->getSuspQ;
+
+                  /* 填充回调需要的数据 */
+                  timerCb.cb_func = eQueueTimerCallback;
+                  timerCb.cb_data = (POINTER)&timerData;
+                  timerCb.cb_ticks = timeout;
+
+                  /* 在任务TCB中存储定时器回调，方便对其进行取消操作 */
+                  curr_tcb_ptr->pended_timo_cb = &timerCb;
+
+                  /* 注册定时器 */
+                  if (eTimerRegister (&timerCb) != EASYRTOS_OK)
+                  {
+                    /* 注册失败 */
+                    status = EASYRTOS_ERR_TIMER;
 
-                  (void)tcb_dequeue_entry (&qptr->getSuspQ, curr_tcb_ptr);
-                  curr_tcb_ptr->state = TASK_RUN;
-                  curr_tcb_ptr->pended_timo_cb = NULL;
+                    (void)tcb_dequeue_entry (&qptr->getSuspQ, curr_tcb_ptr);
+                    curr_tcb_ptr->state = TASK_RUN;
+                    curr_tcb_ptr->pended_timo_cb = NULL;
+                  }
                 }
-              }
 
-              /* Ҫעᶨʱ */
-              else
-              {
-                curr_tcb_ptr->pended_timo_cb = NULL;
-              }
+                /* 不需要注册定时器 */
+                else
+                {
+                  curr_tcb_ptr->pended_timo_cb = NULL;
+                }
 
-              /* ˳ٽ */
-              CRITICAL_EXIT();
+                /* 退出临界区 */
+                CRITICAL_EXIT();
               
-              if (status == EASYRTOS_OK)
-              {
-                /* ǰңǽõ */
-                easyRTOSSched (FALSE);
-                
-                /* ´񽫴Ӵ˴ʼУʱбɾ timeout ߵeQueueGive */
-                status = curr_tcb_ptr->pendedWakeStatus;
-
-                /** 
-                 * pendedWakeStatusֵΪEASYRTOS_OK˵
-                 * ȡǳɹģΪֵ˵пܶбɾ
-                 * timeoutڣʱֻҪ˳ͺ
-                 */
                 if (status == EASYRTOS_OK)
                 {
-                  /* ٽ */
-                  CRITICAL_ENTER();
-
-                  /* ϢƳ */
-                  status = queue_remove (qptr, msgptr);
+                  TRACE_EVENT (TRACE_QUEUE_BLOCK, curr_tcb_ptr->taskID, qptr, timeout);
 
-                  /* ˳ٽ */
-                  CRITICAL_EXIT();
+                  /* 当前任务被悬挂，我们将调用调度器 */
+                  easyRTOSSched (FALSE);
+                
+                  /* 下次任务将从此处开始运行，此时队列被删除 或者timeout到期 或者调用了eQueueGive */
+                  status = curr_tcb_ptr->pendedWakeStatus;
+
+                  /** 
+                   * 检测pendedWakeStatus，若其值为EASYRTOS_OK，则说明
+                   * 读取是成功的，若为其他的值，则说明有可能队列被删除
+                   * 或者timeout到期，此时我们只需要退出就好了
+                   */
+                  if (status == EASYRTOS_OK)
+                  {
+                    /**
+                     * 唤醒后重新预留消息,消息可能已经被中断或者更高优先级
+                     * 的任务取走,此时以剩余的timeout重新悬挂
+                     */
+                    retry = queue_timeout_remain (&timeout, deadline, &status);
+                  }
                 }
               }
+              else
+              {
+                /* 将任务加入悬挂列表失败 */
+                CRITICAL_EXIT ();
+                status = EASYRTOS_ERR_QUEUE;
+              }
             }
             else
             {
-              /* бʧ */
+              /* 不在任务上下文中们，无法悬挂任务 */
               CRITICAL_EXIT ();
-              status = EASYRTOS_ERR_QUEUE;
+              status = EASYRTOS_ERR_CONTEXT;
             }
           }
           else
           {
-            /* ǣ޷ */
-            CRITICAL_EXIT ();
-            status = EASYRTOS_ERR_CONTEXT;
+            /* timeout == -1, 不需要悬挂任务，且队列此时数据量为0 */
+            CRITICAL_EXIT();
+            status = EASYRTOS_WOULDBLOCK;
           }
         }
         else
         {
-          /* timeout == -1, ҪҶдʱΪ0 */
-          CRITICAL_EXIT();
-          status = EASYRTOS_WOULDBLOCK;
-        }
-      }
-      else
-      {
-        /* ҪֱӰϢƳ */
-        status = queue_remove (qptr, msgptr);
+          /* 退出临界区 */
+          CRITICAL_EXIT ();
 
-        /* ˳ٽ */
-        CRITICAL_EXIT ();
+          /* 不需要阻塞任务，直接把消息复制出来 */
+          status = queue_remove (qptr, slot, msgptr);
 
-        /**
-         * ֻĻõ
-         * жϻeIntExit()õ.
-         */
-        if (eCurrentContext())
-          easyRTOSSched (FALSE);
-      }
+          /**
+           * 只在任务上下文环境调用调度器。
+           * 中断环境会有eIntExit()调用调度器。.
+           */
+          if (eCurrentContext())
+            easyRTOSSched (FALSE);
+        }
+      } while (retry == TRUE);
     }
 
+    TRACE_EVENT (TRACE_QUEUE_TAKE, status, qptr, (qptr != NULL) ? qptr->num_msgs_stored : 0);
+
     return (status);
 }
 
 /**
- * : ȡе,ԶΪ,timeoutĲֵͬвͬĴʽ.
- * 1.timeout>0 ҵõ,timeoutڵʱ񲢷timeout־
- * 2.timeout=0 ҵõ,ֱӶеȵ.
- * 3.timeout=-1 ,Ϊջ᷵ضΪձ־.
- * ҵʱ,õ.
+ * 功能: 取出队列中的数据,若对队列为空,根据timeout的不同值有不同的处理方式.
+ * 1.timeout>0 悬挂调用的任务,当timeout到期的时候唤醒任务并返回timeout标志
+ * 2.timeout=0 永久悬挂调用的任务,直到从队列中等到数据.
+ * 3.timeout=-1 不悬挂任务,若队列为空会返回队列为空标志.
+ * 当有任务被悬挂的时候,将会调用调度器.被唤醒后空位已经被中断或者更高优先级
+ * 的任务占用时,以剩余的timeout重新悬挂.
  *
- * :
- * :                                        :
- * EASYRTOS_QUEUE *qptr ָ                EASYRTOS_QUEUE *qptr ָ
- * int32_t timeout timeoutʱ,ʱ   void *msgptr еϢ
- * void *msgptr еϢ                
+ * 参数:
+ * 输入:                                        输出:
+ * EASYRTOS_QUEUE *qptr 队列指针                EASYRTOS_QUEUE *qptr 队列指针
+ * int32_t timeout timeout时间,依赖于心跳时间   void *msgptr 放入队列的消息
+ * void *msgptr 放入队列的消息                
  * 
- * :
- * EASYRTOS_OK ɹ
- * EASYRTOS_WOULDBLOCK ᱻҵtimeoutΪ-1Է
- * EASYRTOS_TIMEOUT źtimeout
- * EASYRTOS_ERR_DELETED ʱɾ
- * EASYRTOS_ERR_CONTEXT ĵ
- * EASYRTOS_ERR_PARAM 
- * EASYRTOS_ERR_QUEUE жʧ
- * EASYRTOS_ERR_TIMER עᶨʱδɹ
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_WOULDBLOCK 本来会被悬挂但由于timeout为-1所以返回了
+ * EASYRTOS_TIMEOUT 信号量timeout到期
+ * EASYRTOS_ERR_DELETED 队列在悬挂任务时被删除
+ * EASYRTOS_ERR_CONTEXT 错误的上下文调用
+ * EASYRTOS_ERR_PARAM 参数错误
+ * EASYRTOS_ERR_QUEUE 将任务加入运行队列失败
+ * EASYRTOS_ERR_TIMER 注册定时器未成功
  * 
- * õĺ:
+ * 调用的函数:
  * eCurrentContext();
  * tcbEnqueuePriority (&qptr->getSuspQ, curr_tcb_ptr);
  * eTimerRegister (&timerCb);
  * tcb_dequeue_entry (&qptr->getSuspQ, curr_tcb_ptr);
  * easyRTOSSched (FALSE);
- * queue_remove (qptr, msgptr);
+ * queue_reserve_insert (qptr);
+ * queue_insert (qptr, slot, msgptr);
  */
 ERESULT eQueueGive (EASYRTOS_QUEUE *qptr, int32_t timeout, void *msgptr)
 {
@@ -387,357 +428,516 @@ ERESULT eQueueGive (EASYRTOS_QUEUE *qptr, int32_t timeout, void *msgptr)
     QUEUE_TIMER timerData;
     EASYRTOS_TIMER timerCb;
     EASYRTOS_TCB *curr_tcb_ptr;
+    uint8_t *slot;
+    uint32_t deadline = 0;
+    uint8_t retry;
 
-    /*  */
+    /* 参数检查 */
     if ((qptr == NULL) || (msgptr == NULL))
     {
         status = EASYRTOS_ERR_PARAM;
     }
     else
     {
-        /* ٽ */
-        CRITICAL_ENTER ();
+        /* timeout>0时记录到期的时间,唤醒后重新悬挂时计算剩余的时间 */
+        if (timeout > 0)
+        {
+            CRITICAL_ENTER ();
+            deadline = eTimeGet () + (uint32_t)timeout;
+            CRITICAL_EXIT ();
+        }
 
-        /* ҵô˺ */
-        if (qptr->num_msgs_stored == qptr->max_num_msgs)
+        do
         {
-            /* timeout >= 0, 񽫱 */
-            if (timeout >= 0)
-            {
+            retry = FALSE;
 
-                /* ȡǰTCB */
-                curr_tcb_ptr = eCurrentContext();
+            /* 进入临界区 */
+            CRITICAL_ENTER ();
 
-                /* Ƿ */
-                if (curr_tcb_ptr)
+            /* 预留一个位置,若队列已满，悬挂调用此函数的任务 */
+            slot = queue_reserve_insert (qptr);
+            if (slot == NULL)
+            {
+                /* timeout >= 0, 任务将被悬挂 */
+                if (timeout >= 0)
                 {
-                    /* ǰӵsendб */
-                    if (tcbEnqueuePriority (&qptr->putSuspQ, curr_tcb_ptr) == EASYRTOS_OK)
-                    {
-                        /* ״̬־λΪ */
-                        curr_tcb_ptr->state = TASK_PENDED;
 
-                        status = EASYRTOS_OK;
+                    /* 获取当前任务TCB */
+                    curr_tcb_ptr = eCurrentContext();
 
-                        /* timeout>0 עᶨʱص */
-                        if (timeout)
+                    /* 检查是否在任务上下文 */
+                    if (curr_tcb_ptr)
+                    {
+                        /* 将当前任务添加到send悬挂列表中 */
+                        if (tcbEnqueuePriority (&qptr->putSuspQ, curr_tcb_ptr) == EASYRTOS_OK)
                         {
-                            /* 䶨ʱҪ */
-                            timerData.tcb_ptr = curr_tcb_ptr;
-                            timerData.queue_ptr = qptr;
-                            timerData.suspQ = &qptr->putSuspQ;
+                            /* 设置任务状态标志位为悬挂 */
+                            curr_tcb_ptr->state = TASK_PENDED;
+                            curr_tcb_ptr->pended_q = &qptr->putSuspQ;
 
+                            status = EASYRTOS_OK;
 
-                            /* صҪ */
-                            timerCb.cb_func = eQueueTimerCallback;
-                            timerCb.cb_data = (POINTER)&timerData;
-                            timerCb.cb_ticks = timeout;
+                            /* timeout>0 注册定时器回调 */
+                            if (timeout)
+                            {
+                                /* 填充定时器需要的数据 */
+                                timerData.tcb_ptr = curr_tcb_ptr;
+                                timerData.queue_ptr = qptr;
+                                timerData.suspQ = &qptr->putSuspQ;
 
-                            /* TCBд洢ʱصȡ */
-                            curr_tcb_ptr->pended_timo_cb = &timerCb;
 
-                            /* עᶨʱ */
-                            if (eTimerRegister (&timerCb) != EASYRTOS_OK)
-                            {
-                                /* עʧ */
-                                status = EASYRTOS_ERR_TIMER;
+                                /* 填充回调需要的数据 */
+                                timerCb.cb_func = eQueueTimerCallback;
+                                timerCb.cb_data = (POINTER)&timerData;
+                                timerCb.cb_ticks = timeout;
+
+                                /* 在任务TCB中存储定时器回调，方便对其进行取消操作 */
+                                curr_tcb_ptr->pended_timo_cb = &timerCb;
+
+                                /* 注册定时器 */
+                                if (eTimerRegister (&timerCb) != EASYRTOS_OK)
+                                {
+                                    /* 注册失败 */
+                                    status = EASYRTOS_ERR_TIMER;
                                 
-                                (void)tcb_dequeue_entry (&qptr->putSuspQ, curr_tcb_ptr);
-                                curr_tcb_ptr->state = TASK_RUN;
-                                curr_tcb_ptr->pended_timo_cb = NULL;
+                                    (void)tcb_dequeue_entry (&qptr->putSuspQ, curr_tcb_ptr);
+                                    curr_tcb_ptr->state = TASK_RUN;
+                                    curr_tcb_ptr->pended_timo_cb = NULL;
+                                }
                             }
-                        }
 
-                        /* Ҫעᶨʱ */
-                        else
-                        {
-                            curr_tcb_ptr->pended_timo_cb = NULL;
-                        }
+                            /* 不需要注册定时器 */
+                            else
+                            {
+                                curr_tcb_ptr->pended_timo_cb = NULL;
+                            }
 
-                        /* ˳ٽ */
-                        CRITICAL_EXIT ();
+                            /* 退出临界区 */
+                            CRITICAL_EXIT ();
 
-                        /* Ƿעɹ */
-                        if (status == EASYRTOS_OK)
-                        {
-                            /* ǰңǽõ */
-                            easyRTOSSched (FALSE);
-                            
-                            /* ´񽫴Ӵ˴ʼУʱбɾ timeout ߵeQueueGive */
-                            status = curr_tcb_ptr->pendedWakeStatus;
-
-                            /** 
-                             * pendedWakeStatusֵΪEASYRTOS_OK˵
-                             * ȡǳɹģΪֵ˵пܶбɾ
-                             * timeoutڣʱֻҪ˳ͺ
-                             */
+                            /* 检测是否注册成功 */
                             if (status == EASYRTOS_OK)
                             {
-                                /* ٽ */
-                                CRITICAL_ENTER();
-
-                                /* Ϣ */
-                                status = queue_insert (qptr, msgptr);
+                                TRACE_EVENT (TRACE_QUEUE_BLOCK, curr_tcb_ptr->taskID, qptr, timeout);
 
-                                /* ˳ٽ */
-                                CRITICAL_EXIT();
+                                /* 当前任务被悬挂，我们将调用调度器 */
+                                easyRTOSSched (FALSE);
+                            
+                                /* 下次任务将从此处开始运行，此时队列被删除 或者timeout到期 或者调用了eQueueGive */
+                                status = curr_tcb_ptr->pendedWakeStatus;
+
+                                /** 
+                                 * 检测pendedWakeStatus，若其值为EASYRTOS_OK，则说明
+                                 * 读取是成功的，若为其他的值，则说明有可能队列被删除
+                                 * 或者timeout到期，此时我们只需要退出就好了
+                                 */
+                                if (status == EASYRTOS_OK)
+                                {
+                                    /**
+                                     * 唤醒后重新预留位置,位置可能已经被中断或者更高
+                                     * 优先级的任务占用,此时以剩余的timeout重新悬挂
+                                     */
+                                    retry = queue_timeout_remain (&timeout, deadline, &status);
+                                }
                             }
                         }
+                        else
+                        {
+                            /* 将任务加入悬挂队列失败 */
+                            CRITICAL_EXIT();
+                            status = EASYRTOS_ERR_QUEUE;
+                        }
                     }
                     else
                     {
-                        /* Ҷʧ */
-                        CRITICAL_EXIT();
-                        status = EASYRTOS_ERR_QUEUE;
+                        /* 不再任务上下文，不能悬挂任务 */
+                        CRITICAL_EXIT ();
+                        status = EASYRTOS_ERR_CONTEXT;
                     }
                 }
                 else
                 {
-                    /* ģ */
-                    CRITICAL_EXIT ();
-                    status = EASYRTOS_ERR_CONTEXT;
+                    /* timeout == -1, 不需要悬挂任务，且队列此时数据量为0 */
+                    CRITICAL_EXIT();
+                    status = EASYRTOS_WOULDBLOCK;
                 }
             }
             else
             {
-                /* timeout == -1, ҪҶдʱΪ0 */
-                CRITICAL_EXIT();
-                status = EASYRTOS_WOULDBLOCK;
-            }
-        }
-        else
-        {
-            /* ֱӽݸƽ */
-            status = queue_insert (qptr, msgptr);
+                /* 退出临界区 */
+                CRITICAL_EXIT ();
 
-            /* ˳ٽ */
-            CRITICAL_EXIT ();
+                /* 不用悬挂任务，直接将数据复制进队列 */
+                status = queue_insert (qptr, slot, msgptr);
 
-            /**
-             * ֻĻõ
-             * жϻeIntExit()õ.
-             */
-            if (eCurrentContext())
-                easyRTOSSched (FALSE);
-        }
+                /**
+                 * 只在任务上下文环境调用调度器。
+                 * 中断环境会有eIntExit()调用调度器。.
+                 */
+                if (eCurrentContext())
+                    easyRTOSSched (FALSE);
+            }
+        } while (retry == TRUE);
     }
 
+    TRACE_EVENT (TRACE_QUEUE_GIVE, status, qptr, (qptr != NULL) ? qptr->num_msgs_stored : 0);
+
     return (status);
 }
 
 /**
- * : עĶʱĻص,ڵ񷵻EASYRTOS_TIMEOUTı־.
- * ڵƳб,Readyб.
+ * 功能: 悬挂的任务被唤醒后没有预留成功,计算重新悬挂使用的timeout.
+ * timeout为0时永久悬挂,不需要计算;大于0时为到期时间减去当前时间,
+ * 已经到期则返回EASYRTOS_TIMEOUT.
+ *
+ * 参数:
+ * 输入:                                   输出:
+ * int32_t *timeout 原来的timeout          int32_t *timeout 剩余的timeout
+ * uint32_t deadline 到期的系统心跳        ERESULT *status 已经到期时为EASYRTOS_TIMEOUT
+ *
+ * 返回:
+ * TRUE 重新悬挂
+ * FALSE 已经到期
  *
- * :
- * :                                                :
- * POINTER cb_data صݰҪѵTCBϢ   POINTER cb_data صݰҪѵTCBϢ                              
+ * 调用的函数:
+ * eTimeGet ();
+ */
+static uint8_t queue_timeout_remain (int32_t *timeout, uint32_t deadline, ERESULT *status)
+{
+    CRITICAL_STORE;
+    int32_t remain;
+
+    if (*timeout == 0)
+    {
+      return (TRUE);
+    }
+
+    CRITICAL_ENTER ();
+    remain = (int32_t)(deadline - eTimeGet ());
+    CRITICAL_EXIT ();
+
+    if (remain <= 0)
+    {
+      *status = EASYRTOS_TIMEOUT;
+      return (FALSE);
+    }
+
+    *timeout = remain;
+    return (TRUE);
+}
+
+/**
+ * 功能: 队列注册的定时器的回调函数,给到期的任务返回EASYRTOS_TIMEOUT的标志.
+ * 将到期的任务移除队列悬挂列表,并加入Ready列表.
+ *
+ * 参数:
+ * 输入:                                                输出:
+ * POINTER cb_data 回调函数数据包含需要唤醒的TCB等信息   POINTER cb_data 回调函数数据包含需要唤醒的TCB等信息                              
  * 
- * :void
+ * 返回:void
  * 
- * õĺ:
+ * 调用的函数:
  * (void)tcb_dequeue_entry (timer_data_ptr->suspQ, timer_data_ptr->tcb_ptr);
- * (void)tcbEnqueuePriority (&tcb_readyQ, timer_data_ptr->tcb_ptr);
+ * (void)tcbEnqueueReady (timer_data_ptr->tcb_ptr);
  */
 static void eQueueTimerCallback (POINTER cb_data)
 {
     QUEUE_TIMER *timer_data_ptr;
     CRITICAL_STORE;
 
-    /* ȡжʱصָ */
+    /* 获取队列定时器回调指针 */
     timer_data_ptr = (QUEUE_TIMER *)cb_data;
 
-    /* ǷΪ */
+    /* 检测参数是否为空 */
     if (timer_data_ptr)
     {
-        /* ٽ  */
+        /* 进入临界区  */
         CRITICAL_ENTER ();
 
-        /* ñ־λʶΪʱصѵ */
+        /* 给任务设置标志位，标识任务是因为定时器回调唤醒的 */
         timer_data_ptr->tcb_ptr->pendedWakeStatus = EASYRTOS_TIMEOUT;
 
-        /* ȡʱע */
+        /* 取消定时器注册 */
         timer_data_ptr->tcb_ptr->pended_timo_cb = NULL;
 
-        /* ƳбƳreceivesendб */
+        /* 将任务移除悬挂列表，将任务移出receive或者send列表 */
         (void)tcb_dequeue_entry (timer_data_ptr->suspQ, timer_data_ptr->tcb_ptr);
 
-        /* Ready */
-        if (tcbEnqueuePriority (&tcb_readyQ, timer_data_ptr->tcb_ptr) == EASYRTOS_OK)
+        /* 将任务加入Ready队列 */
+        if (tcbEnqueueReady (timer_data_ptr->tcb_ptr) == EASYRTOS_OK)
         {
           timer_data_ptr->tcb_ptr->state= TASK_READY;
         }
 
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
     }
 }
 
 /**
- * : ȡеϢ,ڵȴ(ȡϢ,нһλ),
- * ȡעĶʱ.
+ * 功能: 预留队列中最早的一条消息,之后的取出操作不会再得到这条消息.消息所在的
+ * 位置在queue_remove()复制完成之前不会被插入操作覆盖.需要在临界区中调用.
  *
- * :
- * :                                :
- * EASYRTOS_QUEUE *qptr ָ        EASYRTOS_QUEUE *qptr ָ                              
- * void* msgptr ȡϢ              void* msgptr ȡϢ
+ * 参数:
+ * 输入:                                输出:
+ * EASYRTOS_QUEUE *qptr 队列指针        EASYRTOS_QUEUE *qptr 队列指针
  *
- * :
- * EASYRTOS_OK ɹ
- * EASYRTOS_ERR_PARAM 
- * EASYRTOS_ERR_QUEUE жʧ
- * EASYRTOS_ERR_TIMER ȡʱʧ
+ * 返回:
+ * uint8_t * 预留的消息地址,队列中没有消息时返回NULL
  *
- * õĺ:
- * memcpy ((uint8_t*)msgptr, ((uint8_t*)qptr->buff_ptr + qptr->remove_index), qptr->unit_size);
- * tcb_dequeue_head (&qptr->putSuspQ);
- * tcbEnqueuePriority (&tcb_readyQ, tcb_ptr);
- * eTimerCancel (tcb_ptr->pended_timo_cb);
+ * 调用的函数:
+ * 无.
+ */
+static uint8_t *queue_reserve_remove (EASYRTOS_QUEUE *qptr)
+{
+  uint8_t *slot;
+
+  if (qptr->num_msgs_stored == 0)
+  {
+    return (NULL);
+  }
+
+  slot = (uint8_t*)qptr->buff_ptr + qptr->remove_index;
+  qptr->remove_index += qptr->unit_size;
+  qptr->num_msgs_stored--;
+  qptr->get_busy++;
+
+  /* 队列为循环存储数据，目的是为了加快查找速度 */
+  /* 检查是否重置remove_index */
+  if (qptr->remove_index >= (qptr->unit_size * qptr->max_num_msgs))
+      qptr->remove_index = 0;
+
+  return (slot);
+}
+
+/**
+ * 功能: 预留队列中的一个空闲位置.正在复制以及等待提交的消息都占用位置,
+ * 需要在临界区中调用.
+ *
+ * 参数:
+ * 输入:                                输出:
+ * EASYRTOS_QUEUE *qptr 队列指针        EASYRTOS_QUEUE *qptr 队列指针
+ *
+ * 返回:
+ * uint8_t * 预留的位置地址,队列已满时返回NULL
+ *
+ * 调用的函数:
+ * 无.
+ */
+static uint8_t *queue_reserve_insert (EASYRTOS_QUEUE *qptr)
+{
+  uint8_t *slot;
+
+  if ((qptr->num_msgs_stored + qptr->put_busy + qptr->put_done
+       + qptr->get_busy + qptr->get_done) >= qptr->max_num_msgs)
+  {
+    return (NULL);
+  }
+
+  slot = (uint8_t*)qptr->buff_ptr + qptr->insert_index;
+  qptr->insert_index += qptr->unit_size;
+  qptr->put_busy++;
+
+  /* 检查是否重置insert_index */
+  if (qptr->insert_index >= (qptr->unit_size * qptr->max_num_msgs))
+      qptr->insert_index = 0;
+
+  return (slot);
+}
+
+/**
+ * 功能: 将预留的消息复制出来,复制时调度器上锁但不关闭中断,中断中的队列操作
+ * 可以插入进来.最后一个完成复制的取出操作统一释放位置,并唤醒相同数量的等待
+ * 发送的任务,取消其注册的定时器.
+ *
+ * 参数:
+ * 输入:                                输出:
+ * EASYRTOS_QUEUE *qptr 队列指针        EASYRTOS_QUEUE *qptr 队列指针
+ * uint8_t *slot 预留的消息地址         void* msgptr 取出的消息
+ * void* msgptr 取出的消息
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 参数错误
+ * EASYRTOS_ERR_QUEUE 将任务加入运行队列失败
+ * EASYRTOS_ERR_TIMER 取消定时器失败
+ *
+ * 调用的函数:
+ * eSchedLock ();
+ * memcpy ((uint8_t*)msgptr, slot, qptr->unit_size);
+ * queue_wake (&qptr->putSuspQ, count);
+ * eSchedUnlock ();
  */
-static ERESULT queue_remove (EASYRTOS_QUEUE *qptr, void* msgptr)
+static ERESULT queue_remove (EASYRTOS_QUEUE *qptr, uint8_t *slot, void* msgptr)
 {
+  CRITICAL_STORE;
   ERESULT status;
-  EASYRTOS_TCB *tcb_ptr;
+  uint8_t count = 0;
 
-  /*  */
-  if ((qptr == NULL)) //|| (msgptr == NULL))
+  /* 参数检查 */
+  if ((qptr == NULL) || (slot == NULL)) //|| (msgptr == NULL))
   {
     status = EASYRTOS_ERR_PARAM;
   }
   else
   {
-    /* ݣ临Ƴ */
-    memcpy ((uint8_t*)msgptr, ((uint8_t*)qptr->buff_ptr + qptr->remove_index), qptr->unit_size);
-    qptr->remove_index += qptr->unit_size;
-    qptr->num_msgs_stored--;
-    
-    /* Ϊѭ洢ݣĿΪ˼ӿٶ */
-    /* Ƿremove_index */
-    if (qptr->remove_index >= (qptr->unit_size * qptr->max_num_msgs))
-        qptr->remove_index = 0;
-
-    /* ڵȴͣ份 */    
-    tcb_ptr = tcb_dequeue_head (&qptr->putSuspQ);
-    if (tcb_ptr)
-    {
-      /* ҵReadyб */
-      if (tcbEnqueuePriority (&tcb_readyQ, tcb_ptr) == EASYRTOS_OK)
-      {
-        
-        tcb_ptr->pendedWakeStatus = EASYRTOS_OK;
-        tcb_ptr->state = TASK_READY;
-        
-        /* ע˶ʱصȡ */
-        if ((tcb_ptr->pended_timo_cb != NULL)
-            && (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK))
-        {
-          status = EASYRTOS_ERR_TIMER;
-        }
-        else
-        {
-          tcb_ptr->pended_timo_cb = NULL;
+    /* 复制期间只禁止任务切换 */
+    eSchedLock ();
 
-          /* ɹ */
-          status = EASYRTOS_OK;
-        }
-      }
-      else
-      {
-        /* Readyбʧ */              
-        status = EASYRTOS_ERR_QUEUE;
-      }
-    }
-    else
+    /* 队列中有数据，将其复制出来 */
+    memcpy ((uint8_t*)msgptr, slot, qptr->unit_size);
+
+    /* 进入临界区 */
+    CRITICAL_ENTER ();
+
+    /* 先预留的取出操作可能还没有复制完,由最后完成的操作释放所有位置 */
+    qptr->get_busy--;
+    qptr->get_done++;
+    if (qptr->get_busy == 0)
     {
-      /* ûȴ */
-      status = EASYRTOS_OK;
+      count = qptr->get_done;
+      qptr->get_done = 0;
     }
+
+    /* 若有任务正在等待发送，则将其唤醒 */
+    status = queue_wake (&qptr->putSuspQ, count);
+
+    /* 退出临界区 */
+    CRITICAL_EXIT ();
+
+    eSchedUnlock ();
   }
 
   return (status);
 }
 
 /**
- * : мϢ,ȴϢ(ϢɻȡϢ),
- * ȡעĶʱ.
+ * 功能: 将消息复制到预留的位置,复制时调度器上锁但不关闭中断,中断中的队列操作
+ * 可以插入进来.最后一个完成复制的插入操作统一提交消息,并唤醒相同数量的等待
+ * 接收的任务,取消其注册的定时器.
  *
- * :
- * :                                :
- * EASYRTOS_QUEUE *qptr ָ        EASYRTOS_QUEUE *qptr ָ                              
- * void* msgptr Ϣ             void* msgptr Ϣ
+ * 参数:
+ * 输入:                                输出:
+ * EASYRTOS_QUEUE *qptr 队列指针        EASYRTOS_QUEUE *qptr 队列指针
+ * uint8_t *slot 预留的位置地址
+ * void* msgptr 插入的消息
  *
- * :
- * EASYRTOS_OK ɹ
- * EASYRTOS_ERR_PARAM 
- * EASYRTOS_ERR_QUEUE жʧ
- * EASYRTOS_ERR_TIMER ȡʱʧ
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 参数错误
+ * EASYRTOS_ERR_QUEUE 将任务加入运行队列失败
+ * EASYRTOS_ERR_TIMER 取消定时器失败
  *
- * õĺ:
- * memcpy (((uint8_t*)qptr->buff_ptr + qptr->insert_index), (uint8_t*)msgptr, qptr->unit_size);
- * tcb_dequeue_head (&qptr->getSuspQ)
- * tcbEnqueuePriority (&tcb_readyQ, tcb_ptr);
- * eTimerCancel (tcb_ptr->pended_timo_cb);
+ * 调用的函数:
+ * eSchedLock ();
+ * memcpy (slot, (uint8_t*)msgptr, qptr->unit_size);
+ * queue_wake (&qptr->getSuspQ, count);
+ * eSchedUnlock ();
  */
-static ERESULT queue_insert (EASYRTOS_QUEUE *qptr, void *msgptr)
+static ERESULT queue_insert (EASYRTOS_QUEUE *qptr, uint8_t *slot, void *msgptr)
 {
+    CRITICAL_STORE;
     ERESULT status;
-    EASYRTOS_TCB *tcb_ptr;
+    uint8_t count = 0;
 
-    /*  */
-    if ((qptr == NULL)|| (msgptr == NULL))
+    /* 参数检查 */
+    if ((qptr == NULL) || (slot == NULL) || (msgptr == NULL))
     {
         status = EASYRTOS_ERR_PARAM;
     }
     else
     {
-        /* пλãݸƽȥ */
-        memcpy (((uint8_t*)qptr->buff_ptr + qptr->insert_index), (uint8_t*)msgptr, qptr->unit_size);
-        qptr->insert_index += qptr->unit_size;
-        qptr->num_msgs_stored++;
-
-        /* Ϊѭ洢ݣĿΪ˼ӿٶ */
-        /* Ƿremove_index */
-        if (qptr->insert_index >= (qptr->unit_size * qptr->max_num_msgs))
-            qptr->insert_index = 0;
-
-        /* ڵȴգ份 */    
-        tcb_ptr = tcb_dequeue_head (&qptr->getSuspQ);
-        if (tcb_ptr)
-        {
-            /* ҵReadyб */
-            if (tcbEnqueuePriority (&tcb_readyQ, tcb_ptr) == EASYRTOS_OK)
-            {
+        /* 复制期间只禁止任务切换 */
+        eSchedLock ();
 
-                tcb_ptr->pendedWakeStatus = EASYRTOS_OK;
-                tcb_ptr->state = TASK_READY;
-                
-                /* ע˶ʱصȡ */
-                if ((tcb_ptr->pended_timo_cb != NULL)
-                    && (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK))
-                {
-                    status = EASYRTOS_ERR_TIMER;
-                }
-                else
-                {
-                  
-                    tcb_ptr->pended_timo_cb = NULL;
+        /* 队列中有空闲位置，将数据复制进去 */
+        memcpy (slot, (uint8_t*)msgptr, qptr->unit_size);
 
-                    /* ɹ */
-                    status = EASYRTOS_OK;
-                }
-            }
-            else
-            {
-                /* Readyбʧ */  
-                status = EASYRTOS_ERR_QUEUE;
-            }
-        }
-        else
+        /* 进入临界区 */
+        CRITICAL_ENTER ();
+
+        /**
+         * 先预留的插入操作可能还没有复制完,此时提交会让接收方读到没有复制
+         * 完的位置,由最后完成的操作一起提交
+         */
+        qptr->put_busy--;
+        qptr->put_done++;
+        if (qptr->put_busy == 0)
         {
-            /* ûȴ */
-            status = EASYRTOS_OK;
+            count = qptr->put_done;
+            qptr->num_msgs_stored += count;
+            qptr->put_done = 0;
         }
+
+        /* 若有任务正在等待接收，则将其唤醒 */
+        status = queue_wake (&qptr->getSuspQ, count);
+
+        /* 退出临界区 */
+        CRITICAL_EXIT ();
+
+        eSchedUnlock ();
     }
 
     return (status);
 }
+
+/**
+ * 功能: 唤醒悬挂列表中最多count个任务,并取消其注册的定时器.需要在临界区中调用.
+ *
+ * 参数:
+ * 输入:                                输出:
+ * EASYRTOS_TCB **suspQ 悬挂列表        EASYRTOS_TCB **suspQ 悬挂列表
+ * uint8_t count 唤醒的任务数量
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_QUEUE 将任务加入运行队列失败
+ * EASYRTOS_ERR_TIMER 取消定时器失败
+ *
+ * 调用的函数:
+ * tcb_dequeue_head (suspQ);
+ * tcbEnqueueReady (tcb_ptr);
+ * eTimerCancel (tcb_ptr->pended_timo_cb);
+ */
+static ERESULT queue_wake (EASYRTOS_TCB **suspQ, uint8_t count)
+{
+  ERESULT status = EASYRTOS_OK;
+  EASYRTOS_TCB *tcb_ptr;
+
+  while (count > 0)
+  {
+    count--;
+
+    tcb_ptr = tcb_dequeue_head (suspQ);
+    if (tcb_ptr == NULL)
+    {
+      /* 没有任务在等待 */
+      break;
+    }
+
+    /* 将悬挂的任务加入Ready列表 */
+    if (tcbEnqueueReady (tcb_ptr) == EASYRTOS_OK)
+    {
+      tcb_ptr->pendedWakeStatus = EASYRTOS_OK;
+      tcb_ptr->state = TASK_READY;
+
+      /* 若注册了定时器回调，则先取消 */
+      if ((tcb_ptr->pended_timo_cb != NULL)
+          && (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK))
+      {
+        status = EASYRTOS_ERR_TIMER;
+      }
+      else
+      {
+        tcb_ptr->pended_timo_cb = NULL;
+      }
+    }
+    else
+    {
+      /* 将任务加入Ready列表失败 */
+      status = EASYRTOS_ERR_QUEUE;
+    }
+  }
+
+  return (status);
+}
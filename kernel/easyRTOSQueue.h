@@ -1,7 +1,7 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #ifndef __EASYRTOSQUEUE_H
@@ -9,14 +9,18 @@
 
 typedef struct eQueue
 {
-    EASYRTOS_TCB *  putSuspQ;   /* ȴݷ͵ */
-    EASYRTOS_TCB *  getSuspQ;   /* ȴݽյ */
-    void *   buff_ptr;          /* ָ */
-    uint32_t    unit_size;      /* ϢĴС */
-    uint32_t    max_num_msgs;   /* Ϣ */
-    uint32_t    insert_index;   /* Ϣ */
-    uint32_t    remove_index;   /* ϢƳ */
-    uint32_t    num_msgs_stored;/* Ϣ */
+    EASYRTOS_TCB *  putSuspQ;   /* 等待任务数据发送的任务队列 */
+    EASYRTOS_TCB *  getSuspQ;   /* 等待任务数据接收的任务队列 */
+    void *   buff_ptr;          /* 队列数据指针 */
+    uint32_t    unit_size;      /* 单个消息的大小 */
+    uint32_t    max_num_msgs;   /* 总消息数量 */
+    uint32_t    insert_index;   /* 消息插入索引 */
+    uint32_t    remove_index;   /* 消息移除索引 */
+    uint32_t    num_msgs_stored;/* 现有消息数量 */
+    uint8_t     put_busy;       /* 正在复制的插入操作数量 */
+    uint8_t     put_done;       /* 复制完成,等待提交的插入操作数量 */
+    uint8_t     get_busy;       /* 正在复制的取出操作数量 */
+    uint8_t     get_done;       /* 复制完成,等待提交的取出操作数量 */
 } EASYRTOS_QUEUE;
 
 typedef struct eQueuetimer
@@ -26,7 +30,7 @@ typedef struct eQueuetimer
     EASYRTOS_TCB   **suspQ;     /* TCB queue which thread is suspended on */
 } QUEUE_TIMER;
 
-/* ȫֺ */
+/* 全局函数 */
 extern EASYRTOS_QUEUE eQueueCreate ( void *buff_ptr, uint32_t unit_size, uint32_t max_num_msgs);
 extern ERESULT eQueueDelete (EASYRTOS_QUEUE *qptr);
 extern ERESULT eQueueTake (EASYRTOS_QUEUE *qptr, int32_t timeout, void *msgptr);
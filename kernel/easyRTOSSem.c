@@ -1,7 +1,7 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #include "easyRTOS.h"
@@ -9,127 +9,163 @@
 #include "easyRTOSport.h"
 #include "easyRTOSTimer.h"
 #include "easyRTOSSem.h"
+#include "easyRTOSTrace.h"
 
-/* ȫֺ */
+/* 全局函数 */
 EASYRTOS_SEM eSemCreateCount (uint8_t initial_count);
 EASYRTOS_SEM eSemCreateBinary (void);
 EASYRTOS_SEM eSemCreateMutex (void);
+EASYRTOS_SEM eSemCreateCeiling (uint8_t ceiling);
 ERESULT eSemDelete (EASYRTOS_SEM *sem);
 ERESULT eSemTake (EASYRTOS_SEM *sem, int32_t timeout);
 ERESULT eSemGive (EASYRTOS_SEM * sem);
 ERESULT eSemResetCount (EASYRTOS_SEM *sem, uint8_t count);
+void eSemMutexPrioUpdate (EASYRTOS_TCB *tcb_ptr);
 
-/* ˽к */
+/* 私有函数 */
 static void eSemTimerCallback (POINTER cb_data);
+static void eSemMutexRelease (EASYRTOS_SEM *sem);
 
 /**
- * : ź,ʼźṹڵĲ,.
+ * 功能: 计数信号量创建,初始化计数信号量结构体内的参数,并返回.
  *
- * :
- * :                                   :
- * uint8_t initial_count ʼ      
+ * 参数:
+ * 输入:                                   输出:
+ * uint8_t initial_count 初始化计数量      无
  *
- * :
+ * 返回:
  * EASYRTOS_SEM
  * 
- * õĺ:
- * .
+ * 调用的函数:
+ * 无.
  */
 EASYRTOS_SEM eSemCreateCount (uint8_t initial_count)
 {
   EASYRTOS_SEM sem;
 
-  /* óʼ */
+  /* 设置初始计数 */
   sem.count = initial_count;
 
-  /* ʼźҵĶ */
+  /* 初始化被信号量悬挂的任务的队列 */
   sem.suspQ = NULL;
   
-  /* ʼź */
+  /* 初始化被信号量类型 */
   sem.type = SEM_COUNTY;
 
   return sem;
 }
 
 /**
- * : ֵź,ʼֵźṹڵĲ,.
+ * 功能: 二值信号量创建,初始化二值信号量结构体内的参数,并返回.
  *
- * :
- * :                     :
- *                         
+ * 参数:
+ * 输入:                     输出:
+ * 无                        无
  *
- * :
+ * 返回:
  * EASYRTOS_SEM
  * 
- * õĺ:
- * .
+ * 调用的函数:
+ * 无.
  */
 EASYRTOS_SEM eSemCreateBinary (void)
 {
   EASYRTOS_SEM sem;
 
-  /* óʼ */
+  /* 设置初始计数 */
   sem.count = 0;
 
-  /* ʼźҵĶ */
+  /* 初始化被信号量悬挂的任务的队列 */
   sem.suspQ = NULL;
   
-  /* ʼź */
+  /* 初始化被信号量类型 */
   sem.type = SEM_BINARY;
 
   return sem;
 }
 
 /**
- * : ,ʼṹڵĲ,.
+ * 功能: 互斥锁创建,初始化互斥锁结构体内的参数,并返回.
  *
- * :
- * :                   :
- *                       
+ * 参数:
+ * 输入:                   输出:
+ * 无                      无
  *
- * :
+ * 返回:
  * EASYRTOS_SEM
  * 
- * õĺ:
- * .
+ * 调用的函数:
+ * 无.
  */
 EASYRTOS_SEM eSemCreateMutex (void)
 {
     EASYRTOS_SEM sem;
 
-    /* ʼʱûowner */
+    /* 初始化时没有owner */
     sem.owner = NULL;
 
-    /* ʼ */
+    /* 初始化计数 */
     sem.count = 1;
 
-    /* ʼҵ */
+    /* 初始化被其悬挂的任务 */
     sem.suspQ = NULL;
+    sem.next_held = NULL;
     
-    /* ʼź */
+    /* 初始化被信号量类型 */
     sem.type = SEM_MUTEX;
     return (sem);
 }
 
 /**
- * : ɾź,бźҵReadyб.ͬʱȡ
- * עĶʱ.񱻻,.
+ * 功能: 天花板互斥锁创建.任务获取该互斥锁时立即提升到天花板优先级,释放时恢复.
+ * 天花板优先级应不低于所有使用该互斥锁的任务中最高的优先级,这样在单CPU上
+ * 拥有者运行期间其他使用者不会得到运行,获取时不会发生阻塞,也不会形成死锁链.
  *
- * :
- * :                                   :
- * EASYRTOS_SEM *sem źָ            EASYRTOS_SEM *sem źָ
+ * 参数:
+ * 输入:                                   输出:
+ * uint8_t ceiling 天花板优先级            无
  *
- * :
- *  EASYRTOS_OK ɹ
- *  EASYRTOS_ERR_QUEUE õReadyʧ
- *  EASYRTOS_ERR_TIMER ȡʱʧ
- *  EASYRTOS_ERR_PARAM 
- *  EASYRTOS_ERR_DELETED źʱɾ
+ * 返回:
+ * EASYRTOS_SEM
+ * 
+ * 调用的函数:
+ * eSemCreateMutex ();
+ */
+EASYRTOS_SEM eSemCreateCeiling (uint8_t ceiling)
+{
+    EASYRTOS_SEM sem;
+
+    /* 与互斥锁相同的初始化 */
+    sem = eSemCreateMutex ();
+
+    /* 初始化被信号量类型 */
+    sem.type = SEM_CEILING;
+    sem.ceiling = ceiling;
+    return (sem);
+}
+
+/**
+ * 功能: 删除信号量,并唤醒所有被该信号量悬挂的任务加入Ready列表中.同时取消该任务
+ * 注册的定时器.若有任务被唤醒,则会启动调度器.
+ *
+ * 参数:
+ * 输入:                                   输出:
+ * EASYRTOS_SEM *sem 信号量指针            EASYRTOS_SEM *sem 信号量指针
+ *
+ * 返回:
+ * 返回 EASYRTOS_OK 成功
+ * 返回 EASYRTOS_ERR_QUEUE 将任务放置到Ready队列中失败
+ * 返回 EASYRTOS_ERR_TIMER 取消定时器失败
+ * 返回 EASYRTOS_ERR_PARAM 输入参数错误
+ * 返回 EASYRTOS_ERR_DELETED 信号量在悬挂任务时被删除
  * 
- * õĺ:
+ * 调用的函数:
+ * eSemMutexRelease (sem);
  * tcb_dequeue_head (&sem->suspQ);
- * tcbEnqueuePriority (&tcb_readyQ, tcb_ptr);
+ * tcbEnqueueReady (tcb_ptr);
  * eTimerCancel (tcb_ptr->pended_timo_cb);
+ * eSchedLock ();
+ * eSchedUnlock ();
  */
 ERESULT eSemDelete (EASYRTOS_SEM *sem)
 {
@@ -138,7 +174,7 @@ ERESULT eSemDelete (EASYRTOS_SEM *sem)
   EASYRTOS_TCB *tcb_ptr;
   uint8_t woken_threads = FALSE;
 
-  /*  */
+  /* 参数检查 */
   if (sem == NULL)
   {
     status = EASYRTOS_ERR_PARAM;
@@ -147,74 +183,87 @@ ERESULT eSemDelete (EASYRTOS_SEM *sem)
   {
     status = EASYRTOS_OK;
 
-    /* бҵ */
+    /* 互斥锁被删除,拥有者不再继承等待任务的优先级 */
+    if (SEM_HAS_OWNER(sem->type) && (sem->owner != NULL))
+    {
+      CRITICAL_ENTER ();
+      eSemMutexRelease (sem);
+      CRITICAL_EXIT ();
+    }
+
+    /* 唤醒完所有任务之前不切换任务 */
+    eSchedLock ();
+
+    /* 唤醒所有被悬挂的任务 */
     while (1)
     {
-      /* ٽ */
+      /* 进入临界区 */
       CRITICAL_ENTER ();
 
-      /* Ƿ кܶ񱻸ź &sem->suspQΪ */
+      /* 检查是否有任务被悬挂 可能有很多任务被该信号量悬挂 &sem->suspQ为悬挂链表 */
       tcb_ptr = tcb_dequeue_head (&sem->suspQ);
 
-      /* ź */
+      /* 若有任务被信号量悬挂 */
       if (tcb_ptr)
       {
-        /* Աҵ񷵻ش־ */
+        /* 对被悬挂的任务返回错误标志 */
         tcb_ptr->pendedWakeStatus = EASYRTOS_ERR_DELETED;
 
-        /* TCBReady */
-        if (tcbEnqueuePriority (&tcb_readyQ, tcb_ptr) != EASYRTOS_OK)
+        /* 将任务TCB加入Ready的链表 */
+        if (tcbEnqueueReady (tcb_ptr) != EASYRTOS_OK)
         {
-          /* ʧܣ˳ٽ */
+          /* 若加入失败，退出临界区 */
           CRITICAL_EXIT ();
 
-          /* ˳ѭؼReadyʧ */
+          /* 退出循环，返回加入Ready链表失败 */
           status = EASYRTOS_ERR_QUEUE;
           break;
         }
         
-        /* ɹΪREADY״̬ */
+        /* 成功则把任务设置为READY状态 */
         else tcb_ptr->state = TASK_READY;
 
-        /* timeoutȡӦĶʱ */
+        /* 若悬挂有timeout，取消对应的定时器 */
         if (tcb_ptr->pended_timo_cb)
         {
           if (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK)
           {
-            /* ȡʱʧܣ˳ٽ */
+            /* 取消定时器失败，退出临界区 */
             CRITICAL_EXIT ();
 
-            /* ˳ѭشʶ */
+            /* 退出循环，返回错误标识 */
             status = EASYRTOS_ERR_TIMER;
             break;
           }
 
-          /* ־ûtimeoutʱע */
+          /* 标志没有timeout定时器注册 */
           tcb_ptr->pended_timo_cb = NULL;
         }
 
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
 
-        /*  */
+        /* 请求调度器 */
         woken_threads = TRUE;
       }
 
-      /* ûбҵ */
+      /* 没有被悬挂的任务了 */
       else
       {
-        /* ˳ٽѭ */
+        /* 退出临界区并结束循环 */
         CRITICAL_EXIT ();
         break;
       }
     }
 
-    /* 񱻻õ */
+    eSchedUnlock ();
+
+    /* 有任务被唤醒则调用调度器 */
     if (woken_threads == TRUE)
     {
       /**
-       *  ֻвежʱ˳ж
-       *  ʱeIntExit()
+       *  只有在任务中才运行调度器，在中断中时会在退出中断
+       *  时eIntExit()调用
        */
       if (eCurrentContext())
           easyRTOSSched (FALSE);
@@ -225,41 +274,45 @@ ERESULT eSemDelete (EASYRTOS_SEM *sem)
 }
 
 /**
- * : ȡź,źΪ0,timeoutĲֵͬźĲͬвͬĴʽ.
+ * 功能: 获取信号量,若信号量数量为0,根据timeout的不同值和信号量的不同类型有不同的处理方式.
  *
- * һֵźͼź
- * 1.timeout>0 ҵõ,timeoutڵʱ񲢷timeout־
- * 2.timeout=0 ҵõ,ֱȡź.
- * 3.timeout=-1 ,źΪ0᷵źΪ0ı־.
+ * 一、二值信号量和计数信号量
+ * 1.timeout>0 悬挂调用的任务,当timeout到期的时候唤醒任务并返回timeout标志
+ * 2.timeout=0 永久悬挂调用的任务,直到获取到信号量.
+ * 3.timeout=-1 不悬挂任务,若信号量计数为0会返回信号量为0的标志.
  *
- * 
- * ΪӵߣݹģʽΪֵ
- * ߲ӵߣtimeoutĲֵͬµĴʽ
- * 1.timeout>0 ҵõ,timeoutڵʱ񲢷timeout־
- * 2.timeout=0 ҵõ,ֱȡź.
- * 3.timeout=-1 ,źΪ0᷵źΪ0ı־.
+ * 二、互斥锁(包括天花板互斥锁)
+ * 若调用者为拥有者，则进入递归调用模式，计数变为负值，并不会悬挂任务。
+ * 天花板互斥锁被获取时，拥有者立即提升到天花板优先级。
+ * 若调用者不是拥有者，则根据timeout的不同值有以下的处理方式。任务被悬挂时，
+ * 拥有者(以及拥有者正在等待的互斥锁的拥有者)的优先级会提升到该任务的优先级。
+ * 1.timeout>0 悬挂调用的任务,当timeout到期的时候唤醒任务并返回timeout标志
+ * 2.timeout=0 永久悬挂调用的任务,直到获取到信号量.
+ * 3.timeout=-1 不悬挂任务,若信号量计数为0会返回信号量为0的标志.
  *
- * ҵʱ,õ.
+ * 当有任务被悬挂的时候,将会调用调度器.
  *
- * :
- * :                                        :
- * EASYRTOS_SEM *sem  źָ                EASYRTOS_SEM *sem  źָ
- * int32_t timeout timeoutʱ,ʱ                  
+ * 参数:
+ * 输入:                                        输出:
+ * EASYRTOS_SEM *sem  信号量指针                EASYRTOS_SEM *sem  信号量指针
+ * int32_t timeout timeout时间,依赖于心跳时间                  
  * 
- * :
- * EASYRTOS_OK ɹ
- * EASYRTOS_TIMEOUT źtimeout
- * EASYRTOS_WOULDBLOCK Ϊ0ʱtimeout=-1
- * EASYRTOS_ERR_DELETED źʱɾ
- * EASYRTOS_ERR_CONTEXT ĵ
- * EASYRTOS_ERR_PARAM  Ĳ
- * EASYRTOS_ERR_QUEUE жʧ
- * EASYRTOS_ERR_TIMER עûгɹ
- * EASYRTOS_SEM_UINIT źûбʼ
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_TIMEOUT 信号量timeout到期
+ * EASYRTOS_WOULDBLOCK 技术为0的时候，timeout=-1
+ * EASYRTOS_ERR_DELETED 信号量在悬挂任务时被删除
+ * EASYRTOS_ERR_CONTEXT 错误的上下文调用
+ * EASYRTOS_ERR_PARAM  错误的参数
+ * EASYRTOS_ERR_QUEUE 将任务加入运行队列失败
+ * EASYRTOS_ERR_TIMER 注册没有成功
+ * EASYRTOS_SEM_UINIT 信号量没有被初始化
+ * EASYRTOS_ERR_CEILING 任务优先级高于天花板优先级
  * 
- * õĺ:
+ * 调用的函数:
  * eCurrentContext();
  * tcbEnqueuePriority (&sem->suspQ, curr_tcb_ptr);
+ * eSemMutexPrioUpdate (sem->owner);
  * eTimerRegister (&timerCb);
  * (void)tcb_dequeue_entry (&sem->suspQ, curr_tcb_ptr);
  * easyRTOSSched (FALSE);
@@ -272,141 +325,168 @@ ERESULT eSemTake (EASYRTOS_SEM *sem, int32_t timeout)
   EASYRTOS_TIMER timerCb;
   EASYRTOS_TCB *curr_tcb_ptr;
 
-  /*  */
+  /* 参数检查 */
   if (sem == NULL)
   {
     status = EASYRTOS_ERR_PARAM;
   }
-  else if (sem->type == NULL)
+  else if (sem->type == 0)
   {
     status = EASYRTOS_SEM_UINIT;
   }
   else
   {
-    /* ٽ ֹڴʱź仯 */
+    /* 进入临界区 防止在此时信号量发生变化 */
     CRITICAL_ENTER ();
     
-    /* ȡTCB */
+    /* 获取正在运行任务的TCB */
     curr_tcb_ptr = eCurrentContext();
         
     /**
-     * Ƿ(ж),ΪMUTEXҪһӵ,Բ
-     * ISR
+     * 检测是否在任务上下文(而不是中断),因为MUTEX需要一个拥有者,所以不能
+     * 被ISR调用
      */
     if (curr_tcb_ptr == NULL)
     {
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
 
-        /* ,޷ */
+        /* 不在任务上下文中,无法悬挂任务 */
         status = EASYRTOS_ERR_CONTEXT;
     }
 
+    /* 天花板优先级必须不低于所有使用者的优先级 */
+    else if ((sem->type == SEM_CEILING) && (curr_tcb_ptr->basePriority < sem->ceiling))
+    {
+        /* 退出临界区 */
+        CRITICAL_EXIT ();
+
+        status = EASYRTOS_ERR_CEILING;
+    }
+
     /** 
-     * ΪֵźŻ߼źʱ,жcountǷΪ0.
-     * Ϊź,жǷӵͬ.
-     * һ,Ҹ. 
+     * 当为二值信号或者计数信号量的时候,则判断count是否为0.
+     * 若为互斥锁信号量,则判断是否上下文与拥有任务不相同.
+     * 满足其一,则悬挂该任务. 
      */
-    else if (((sem->type != SEM_MUTEX) && (sem->count == 0)) || \\
-             ((sem->type == SEM_MUTEX) && (sem->owner != curr_tcb_ptr) && (sem->owner != NULL)))
+    else if ((!SEM_HAS_OWNER(sem->type) && (sem->count == 0)) ||
+             (SEM_HAS_OWNER(sem->type) && (sem->owner != curr_tcb_ptr) && (sem->owner != NULL)))
     {
-      /* timeout >= 0  */
+      /* 若timeout >= 0 则悬挂任务 */
       if (timeout >= 0)
       {
-        /* CountΪ0,  */
+        /* Count为0, 悬挂任务 */
 
-        /*  */
+        /* 若是在任务上下文中 */
         if (curr_tcb_ptr)
         {
-          /* źб */
+          /* 将该任务加入该信号量的悬挂列表 */
           if (tcbEnqueuePriority (&sem->suspQ, curr_tcb_ptr) != EASYRTOS_OK)
           {
-            /* ʧܣ˳ٽ */
+            /* 若失败，退出临界区 */
             CRITICAL_EXIT ();
 
-            /* ش */
+            /* 返回错误 */
             status = EASYRTOS_ERR_QUEUE;
           }
           else
           {
-            /* ״̬Ϊ */
+            /* 将任务状态设置为悬挂 */
             curr_tcb_ptr->state = TASK_PENDED;
+            curr_tcb_ptr->pended_q = &sem->suspQ;
             
             status = EASYRTOS_OK;
 
-            /* timeoutֵǷҪעᶨʱص */
+            /* 优先级继承,提升互斥锁拥有者的优先级 */
+            if (SEM_HAS_OWNER(sem->type))
+            {
+              curr_tcb_ptr->pended_mutex = sem;
+              eSemMutexPrioUpdate (sem->owner);
+            }
+
+            /* 根据timeout的值，决定是否需要注册定时器回调 */
             if (timeout)
             {
-              /* صҪ */
+              /* 保存回调需要的数据 */
               timerData.tcb_ptr = curr_tcb_ptr;
               timerData.sem_ptr = sem;
 
-              /* ʱصҪ */
+              /* 定时器回调需要的数据 */
               timerCb.cb_func = eSemTimerCallback;
               timerCb.cb_data = (POINTER)&timerData;
               timerCb.cb_ticks = timeout;
 
               /**
-               * 涨ʱصTCBУźGIVEʱ򣬷ȡ
-               * timeoutעĶʱ
+               * 保存定时器回调在TCB中，当信号量GIVE的时候，方便取消
+               * timeout注册的定时器
                */
               curr_tcb_ptr->pended_timo_cb = &timerCb;
 
-              /* עtimeoutĶʱ */
+              /* 注册timeout的定时器 */
               if (eTimerRegister (&timerCb) != EASYRTOS_OK)
               {
-                /* עʧܣش */
+                /* 若注册失败，返回错误 */
                 status = EASYRTOS_ERR_TIMER;
 
-                /*  */
+                /* 清除队列 */
                 (void)tcb_dequeue_entry (&sem->suspQ, curr_tcb_ptr);
                 curr_tcb_ptr->state = TASK_READY;
                 curr_tcb_ptr->pended_timo_cb = NULL;
+                curr_tcb_ptr->pended_q = NULL;
+
+                /* 撤销对拥有者的优先级提升 */
+                if (SEM_HAS_OWNER(sem->type))
+                {
+                  curr_tcb_ptr->pended_mutex = NULL;
+                  eSemMutexPrioUpdate (sem->owner);
+                }
               }
             }
 
-            /* ûtimeout */
+            /* 没有timeout请求 */
             else
             {
               curr_tcb_ptr->pended_timo_cb = NULL;
             }
 
-            /* ˳ٽ */
+            /* 退出临界区 */
             CRITICAL_EXIT ();
 
-            /* Ƿд */
+            /* 检查是否有错误发生 */
             if (status == EASYRTOS_OK)
             {
-              /* ңõһµ */
+              TRACE_EVENT (TRACE_SEM_BLOCK, curr_tcb_ptr->taskID, sem, timeout);
+
+              /* 任务被悬挂，调用调度器启动一个新的任务 */
               easyRTOSSched (FALSE);
 
               /**
-               * ͨeSemGive()ѻ᷵EASYRTOS_OKtimeoutʱ䵽
-               * EASYRTOS_TIMEOUTźɾʱEASYRTOS_ERR_DELETED
+               * 通过eSemGive()唤醒会返回EASYRTOS_OK，当timeout时间到返回
+               * EASYRTOS_TIMEOUT，当信号量被删除时，返回EASYRTOS_ERR_DELETED
                */
               status = curr_tcb_ptr->pendedWakeStatus;
 
               /**
-               * ߳EASYRTOS_OK±ʱź
-               * ѿȨϣ֮ǰź
-               * ȻźΪܹȼߵ
-               * ռǰѼټĵطeSemGive()
+               * 若线程在EASYRTOS_OK的情况下被唤醒时，其他任务增加了信号量
+               * 计数并把控制权交给该任务。理论上，之前的任务增加信号量计数，
+               * 然后这个任务减少信号量计数，但是为了能够让其他优先级更高的
+               * 任务抢占，我们把减少计数的地方放在了eSemGive()中
                */
             }
           }
         }
         else
         {
-          /* ˳ٽ */
+          /* 退出临界区 */
           CRITICAL_EXIT ();
 
-          /* ģ */
+          /* 不在任务上下文，不能悬挂 */
           status = EASYRTOS_ERR_CONTEXT;
         }
       }
       else
       {
-        /* timeout == -1, Ҫ */
+        /* timeout == -1, 不需要悬挂 */
         CRITICAL_EXIT();
         status = EASYRTOS_WOULDBLOCK;
       }
@@ -421,19 +501,28 @@ ERESULT eSemTake (EASYRTOS_SEM *sem, int32_t timeout)
             status = EASYRTOS_OK;
           break;
         case SEM_MUTEX:
+        case SEM_CEILING:
           
-          /* Count0Countֵ */
+          /* 没有拥有者，调用者成为拥有者，并加入其拥有的互斥锁链表 */
           if (sem->owner == NULL)
           {
             sem->owner = curr_tcb_ptr;
+            sem->next_held = curr_tcb_ptr->mutex_held;
+            curr_tcb_ptr->mutex_held = sem;
+
+            /* 天花板互斥锁立即提升拥有者的优先级 */
+            if (sem->type == SEM_CEILING)
+            {
+              eSemMutexPrioUpdate (curr_tcb_ptr);
+            }
           }
       
-          /* Count0Countֵ */
+          /* Count不是0，减少Count的值，并返回 */
           if (sem->count>-32768)
           {
             sem->count--;
         
-            /* ɹ */
+            /* 成功 */
             status = EASYRTOS_OK;
           }
           else {
@@ -444,93 +533,99 @@ ERESULT eSemTake (EASYRTOS_SEM *sem, int32_t timeout)
           status = EASYRTOS_SEM_UINIT;
       }
 
-      /* ˳ٽ */
+      /* 退出临界区 */
       CRITICAL_EXIT ();
   
     }
   }
 
+  TRACE_EVENT (TRACE_SEM_TAKE, status, sem, (sem != NULL) ? sem->count : 0);
+
   return (status);
 }
 
 /**
- * : ź,źͲͬ²ͬӦ
- * 1ֵź
- * Ϊ0ʱ1ѾΪ1᷵
- * 2ź
- * 1127ʱ᷵
- * 3
- * ӵߵõʱ<=01ﵽ1ʱӵ
- * ӵߵõʱ򷵻EASYRTOS_ERR_OWNERSHIP
- * ҵʱ,õ.
+ * 功能: 放置信号量,根据信号量类型不同会有以下不同反应：
+ * 1、二值信号量
+ * 当计数为0的时候计数加1，计数已经为1则会返回溢出错误。
+ * 2、计数信号量
+ * 计数加1，当计数大于127时，则会返回溢出错误。
+ * 3、互斥锁
+ * 当互斥锁拥有者调用的时候，若计数<=0，则计数加1，当计数达到1时，清除拥有任务。
+ * 当非拥有者调用的时候返回EASYRTOS_ERR_OWNERSHIP
+ * 释放互斥锁时拥有者恢复到其设置的优先级(或仍拥有的互斥锁上等待任务的最高优先级)。
+ * 天花板互斥锁释放后拥有者优先级降低，会调用调度器。
+ * 当有任务被悬挂的时候,将会调用调度器.
  *
- * :
- * :                                      :
- * EASYRTOS_SEM * sem źָ              EASYRTOS_SEM * sem źָ       
+ * 参数:
+ * 输入:                                      输出:
+ * EASYRTOS_SEM * sem 信号量指针              EASYRTOS_SEM * sem 信号量指针       
  * 
- * :
- * EASYRTOS_OK ɹ
- * EASYRTOS_ERR_OVF źcount>32767(>32767)
- * EASYRTOS_ERR_PARAM Ĳ
- * EASYRTOS_ERR_QUEUE жʧ
- * EASYRTOS_ERR_TIMER עᶨʱδɹ
- * EASYRTOS_ERR_BIN_OVF ֵźcountѾΪ1
- * EASYRTOS_SEM_UINIT źûбʼ
- * EASYRTOS_ERR_OWNERSHIP ԽMutexMutexӵ
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_OVF 计数信号量count>32767(>32767)
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_QUEUE 将任务加入运行队列失败
+ * EASYRTOS_ERR_TIMER 注册定时器未成功
+ * EASYRTOS_ERR_BIN_OVF 二值信号量count已经为1
+ * EASYRTOS_SEM_UINIT 信号量没有被初始化
+ * EASYRTOS_ERR_OWNERSHIP 尝试解锁Mutex的任务不是Mutex拥有者
  * 
- * õĺ:
+ * 调用的函数:
  * eCurrentContext();
  * tcb_dequeue_head (&sem->suspQ);
- * tcbEnqueuePriority (&tcb_readyQ, tcb_ptr);
+ * tcbEnqueueReady (tcb_ptr);
+ * eSemMutexRelease (sem);
+ * eSemMutexPrioUpdate (tcb_ptr);
  * eTimerCancel (tcb_ptr->pended_timo_cb);
  * easyRTOSSched (FALSE);
  */
 ERESULT eSemGive (EASYRTOS_SEM * sem)
 {
-  ERESULT status;
+  ERESULT status = EASYRTOS_ERR_PARAM;
+  uint8_t released = FALSE;
   CRITICAL_STORE;
   EASYRTOS_TCB *tcb_ptr;
   EASYRTOS_TCB *curr_tcb_ptr;
   
-  /*  */
+  /* 参数检查 */
   if (sem == NULL)
   {
     status = EASYRTOS_ERR_PARAM;
   }
-  else if (sem->type == NULL)
+  else if (sem->type == 0)
   {
     status = EASYRTOS_SEM_UINIT;
   }
   else
   {
     
-    /* ȡеTCB */
+    /* 获取正在运行的任务的TCB */
     curr_tcb_ptr = eCurrentContext();
         
-    /* ٽ */
+    /* 进入临界区 */
     CRITICAL_ENTER ();
     
-    if (sem->type == SEM_MUTEX && sem->owner != curr_tcb_ptr)
+    if (SEM_HAS_OWNER(sem->type) && sem->owner != curr_tcb_ptr)
     {
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
         
         status = EASYRTOS_ERR_OWNERSHIP;
     }
 
-    /* źҵReadyб */
+    /* 将被信号量悬挂的任务置入Ready任务列表 */
     else 
     {
       
       if (sem->suspQ && sem->count == 0)
       {
-        sem->owner = NULL;
         //if ( sem->type == SEM_MUTEX )sem->count++;
         tcb_ptr = tcb_dequeue_head (&sem->suspQ);
-        if (tcbEnqueuePriority (&tcb_readyQ, tcb_ptr) != EASYRTOS_OK)
+        if (tcbEnqueueReady (tcb_ptr) != EASYRTOS_OK)
         {
           
-          /* Readyбʧܣ˳ٽ */
+          /* 若加入Ready列表失败，退出临界区 */
           CRITICAL_EXIT ();
 
           status = EASYRTOS_ERR_QUEUE;
@@ -538,32 +633,46 @@ ERESULT eSemGive (EASYRTOS_SEM * sem)
         else
         {
           
-          /* ȴ񷵻EASYRTOS_OK */
+          /* 给等待的任务返回EASYRTOS_OK */
           tcb_ptr->pendedWakeStatus = EASYRTOS_OK;
           tcb_ptr->state = TASK_READY;
           
-          /* ΪµĻower */
-          sem->owner = tcb_ptr;
+          /* 设置任务为新的互斥锁ower */
+          if (SEM_HAS_OWNER(sem->type))
+          {
+            /* 原拥有者释放互斥锁,恢复优先级 */
+            eSemMutexRelease (sem);
+
+            /* 新的拥有者继承剩余等待任务的优先级 */
+            sem->next_held = tcb_ptr->mutex_held;
+            tcb_ptr->mutex_held = sem;
+            sem->owner = tcb_ptr;
+            eSemMutexPrioUpdate (tcb_ptr);
+          }
+          else
+          {
+            sem->owner = tcb_ptr;
+          }
           
-          /* źtimeoutעĶʱ */
+          /* 解除该信号量timeout注册的定时器 */
           if ((tcb_ptr->pended_timo_cb != NULL)
               && (eTimerCancel (tcb_ptr->pended_timo_cb) != EASYRTOS_OK))
           {
             
-              /* ʱʧ */
+              /* 解除定时器失败 */
               status = EASYRTOS_ERR_TIMER;
           }
           else
           {
             
-              /* ûtimeoutʱע */
+              /* 没有timeout定时器注册 */
               tcb_ptr->pended_timo_cb = NULL;
 
-              /* ɹ */
+              /* 成功 */
               status = EASYRTOS_OK;
           }
 
-          /* ˳ٽ */
+          /* 退出临界区 */
           CRITICAL_EXIT ();
 
           if (eCurrentContext())
@@ -572,24 +681,24 @@ ERESULT eSemGive (EASYRTOS_SEM * sem)
       }
     
 
-      /* û񱻸źңcountȻ󷵻 */
+      /* 若没有任务被该信号量悬挂，则增加count，然后返回 */
       else
       {
         switch (sem->type)
         {
           case SEM_COUNTY:
             
-            /* Ƿ */
+            /* 检查是否溢出 */
             if (sem->count == 32767)
             {
               
-              /* شʶ */
+              /* 返回错误标识 */
               status = EASYRTOS_ERR_OVF;
             }
             else
             {
               
-              /* count */
+              /* 增加count并返回 */
               sem->count++;
               status = EASYRTOS_OK;
             }
@@ -597,62 +706,76 @@ ERESULT eSemGive (EASYRTOS_SEM * sem)
           
           case SEM_BINARY:
             
-            /* ǷѾΪ1 */
+            /* 检查是否已经为1 */
             if (sem->count == 1)
             {
               
-              /* شʶ */
+              /* 返回错误标识 */
               status = EASYRTOS_ERR_OVF;
             }
             else
             {
               
-              /* count */
+              /* 增加count并返回 */
               sem->count = 1;
               status = EASYRTOS_OK;
             }
           break;
           
           case SEM_MUTEX:
+          case SEM_CEILING:
             if (sem->count>1)
             {
               
-              /* شʶ */
+              /* 返回错误标识 */
               status = EASYRTOS_ERR_OVF;
             }
             else
             {
               sem->count++;
-              // sem->count==1 ӵ
-              if (sem->count>=1)sem->owner=NULL;
+              //测试 若sem->count==1 清除掉拥有者
+              if (sem->count>=1)
+              {
+                eSemMutexRelease (sem);
+
+                /* 天花板互斥锁的拥有者恢复了优先级,可能需要切换任务 */
+                released = (sem->type == SEM_CEILING);
+              }
               status = EASYRTOS_OK;
             }
           break;
         }
       }
 
-      /* ˳ٽ */
+      /* 退出临界区 */
       CRITICAL_EXIT ();
+
+      if (released == TRUE)
+      {
+        easyRTOSSched (FALSE);
+      }
     }
   }
 
+  TRACE_EVENT (TRACE_SEM_GIVE, status, sem, (sem != NULL) ? sem->count : 0);
+
   return (status);
 }
 
 /**
- * : üźCount
+ * 功能: 设置计数信号量的Count
  *
- * :
- * :                                        :
- * EASYRTOS_SEM *sem źָ                 EASYRTOS_SEM *sem źָ
- * uint8_t countõCount               
+ * 参数:
+ * 输入:                                        输出:
+ * EASYRTOS_SEM *sem 信号量指针                 EASYRTOS_SEM *sem 信号量指针
+ * uint8_t count设置的Count数               
  * 
- * :
- *  EASYRTOS_OK ɹ
- *  EASYRTOS_ERR_PARAM Ĳ
+ * 返回:
+ * 返回 EASYRTOS_OK 成功
+ * 返回 EASYRTOS_ERR_PARAM 错误的参数
  * 
- * õĺ:
- * 
+ * 调用的函数:
+ * 无
  */
 ERESULT eSemResetCount (EASYRTOS_SEM *sem, uint8_t count)
 {
@@ -662,7 +785,7 @@ ERESULT eSemResetCount (EASYRTOS_SEM *sem, uint8_t count)
   
 
   
-  /*  */
+  /* 参数检查 */
   if (sem == NULL || sem->type != SEM_COUNTY)
   {
     status = EASYRTOS_ERR_PARAM;
@@ -671,13 +794,13 @@ ERESULT eSemResetCount (EASYRTOS_SEM *sem, uint8_t count)
   {
     if (sem->suspQ && sem->count == 0)
     {
-      /* ٽ */
+      /* 进入临界区 */
       CRITICAL_ENTER ();
       tcb_ptr = tcb_dequeue_head (&sem->suspQ);
-      if (tcbEnqueuePriority (&tcb_readyQ, tcb_ptr) != EASYRTOS_OK)
+      if (tcbEnqueueReady (tcb_ptr) != EASYRTOS_OK)
       {
         
-        /* Readyбʧܣ˳ٽ */
+        /* 若加入Ready列表失败，退出临界区 */
         CRITICAL_EXIT ();
 
         status = EASYRTOS_ERR_QUEUE;
@@ -686,60 +809,164 @@ ERESULT eSemResetCount (EASYRTOS_SEM *sem, uint8_t count)
         CRITICAL_EXIT ();
     }
     
-    /* countֵ */
+    /* 设置count值 */
     sem->count = count;
 
-    /* ɹ */
+    /* 成功 */
     status = EASYRTOS_OK;
   }
   return (status);  
 }
 
 /**
- * : źעĶʱĻص,ڵ񷵻EASYRTOS_TIMEOUTı־.
- * ڵƳб,Readyб.
+ * 功能: 信号量注册的定时器的回调函数,给到期的任务返回EASYRTOS_TIMEOUT的标志.
+ * 将到期的任务移除队列悬挂列表,并加入Ready列表.
  *
- * :
- * :                                                :
- * POINTER cb_data صݰҪѵTCBϢ   POINTER cb_data صݰҪѵTCBϢ                              
+ * 参数:
+ * 输入:                                                输出:
+ * POINTER cb_data 回调函数数据包含需要唤醒的TCB等信息   POINTER cb_data 回调函数数据包含需要唤醒的TCB等信息                              
  * 
- * :void
+ * 返回:void
  * 
- * õĺ:
+ * 调用的函数:
  * (void)tcb_dequeue_entry (timer_data_ptr->suspQ, timer_data_ptr->tcb_ptr);
- * (void)tcbEnqueuePriority (&tcb_readyQ, timer_data_ptr->tcb_ptr);
+ * (void)tcbEnqueueReady (timer_data_ptr->tcb_ptr);
+ * eSemMutexPrioUpdate (timer_data_ptr->sem_ptr->owner);
  */
 static void eSemTimerCallback (POINTER cb_data)
 {
     SEM_TIMER *timer_data_ptr;
     CRITICAL_STORE;
 
-    /* ȡSEM_TIMERṹָ */
+    /* 获取SEM_TIMER结构指针 */
     timer_data_ptr = (SEM_TIMER *)cb_data;
 
-    /* ǷΪ */
+    /* 检查参数是否为空 */
     if (timer_data_ptr)
     {
-      /* ٽ */
+      /* 进入临界区 */
       CRITICAL_ENTER ();
 
-      /* ñ־timeoutڶѵ  */
+      /* 设置标志，表明任务是由于timeout到期而唤醒的  */
       timer_data_ptr->tcb_ptr->pendedWakeStatus = EASYRTOS_TIMEOUT ;
 
-      /* timeoutʱע */
+      /* 解除timeout定时器注册 */
       timer_data_ptr->tcb_ptr->pended_timo_cb = NULL;
 
-      /* ƳźҶ */
+      /* 将任务移除信号量悬挂队列 */
       (void)tcb_dequeue_entry (&timer_data_ptr->sem_ptr->suspQ, timer_data_ptr->tcb_ptr);
 
-      /* Ready */
-      if (tcbEnqueuePriority (&tcb_readyQ, timer_data_ptr->tcb_ptr) == EASYRTOS_OK)
+      /* 将任务加入Ready队列 */
+      if (tcbEnqueueReady (timer_data_ptr->tcb_ptr) == EASYRTOS_OK)
       {
         timer_data_ptr->tcb_ptr->state = TASK_READY;
       }
-      /* ˳ٽ */
+
+      /* 等待任务离开,重新计算互斥锁拥有者的继承优先级 */
+      if (SEM_HAS_OWNER(timer_data_ptr->sem_ptr->type))
+      {
+        eSemMutexPrioUpdate (timer_data_ptr->sem_ptr->owner);
+      }
+
+      /* 退出临界区 */
       CRITICAL_EXIT ();
 
-      /* ûΪ֮˳timer ISRʱͨatomIntExit() */
+      /* 这里没有启动调度器，因为之后在退出timer ISR的时候会通过atomIntExit()启动 */
+    }
+}
+
+/**
+ * 功能: 互斥锁的拥有者释放互斥锁,将其移出拥有者的互斥锁链表,清除拥有者,并
+ * 重新计算原拥有者的优先级.需要在临界区中调用.
+ *
+ * 参数:
+ * 输入:                                        输出:
+ * EASYRTOS_SEM *sem 互斥锁指针                 EASYRTOS_SEM *sem 互斥锁指针
+ * 
+ * 返回:void
+ * 
+ * 调用的函数:
+ * eSemMutexPrioUpdate (owner);
+ */
+static void eSemMutexRelease (EASYRTOS_SEM *sem)
+{
+  EASYRTOS_TCB *owner = sem->owner;
+  EASYRTOS_SEM **held_ptr;
+
+  if (owner)
+  {
+    /* 从拥有者的互斥锁链表中移除 */
+    held_ptr = &owner->mutex_held;
+    while (*held_ptr)
+    {
+      if (*held_ptr == sem)
+      {
+        *held_ptr = sem->next_held;
+        break;
+      }
+      held_ptr = &(*held_ptr)->next_held;
     }
+    sem->next_held = NULL;
+    sem->owner = NULL;
+
+    /* 恢复原拥有者的优先级 */
+    eSemMutexPrioUpdate (owner);
+  }
+}
+
+/**
+ * 功能: 优先级继承.任务的实际优先级为其设置的优先级、其拥有的所有互斥锁上
+ * 等待任务的最高优先级以及拥有的天花板互斥锁的天花板优先级中最高的一个.若任务的优先级改变且它自己也在等待另一个
+ * 互斥锁,则继续调整那个互斥锁的拥有者,直到优先级不再改变.提升与恢复都使用该
+ * 函数.需要在临界区中调用.
+ *
+ * 参数:
+ * 输入:                                        输出:
+ * EASYRTOS_TCB *tcb_ptr 需要重新计算的任务     无
+ * 
+ * 返回:void
+ * 
+ * 调用的函数:
+ * tcbSetPriority (tcb_ptr, priority);
+ */
+void eSemMutexPrioUpdate (EASYRTOS_TCB *tcb_ptr)
+{
+  EASYRTOS_SEM *sem;
+  uint8_t priority;
+
+  while (tcb_ptr)
+  {
+    /* 悬挂队列按优先级排序,队列头即为等待任务中优先级最高的 */
+    priority = tcb_ptr->basePriority;
+    for (sem = tcb_ptr->mutex_held; sem != NULL; sem = sem->next_held)
+    {
+      if (sem->suspQ && (sem->suspQ->priority < priority))
+      {
+        priority = sem->suspQ->priority;
+      }
+      if ((sem->type == SEM_CEILING) && (sem->ceiling < priority))
+      {
+        priority = sem->ceiling;
+      }
+    }
+
+    /* 优先级没有变化,链上的其他任务也不需要调整 */
+    if (priority == tcb_ptr->priority)
+    {
+      break;
+    }
+
+    /* 修改优先级并在所在的队列中重新排序 */
+    tcbSetPriority (tcb_ptr, priority);
+
+    /* 该任务正在等待其他互斥锁,传递给那个互斥锁的拥有者 */
+    if ((tcb_ptr->state == TASK_PENDED) && (tcb_ptr->pended_mutex != NULL))
+    {
+      tcb_ptr = tcb_ptr->pended_mutex->owner;
+    }
+    else
+    {
+      tcb_ptr = NULL;
+    }
+  }
 }
@@ -1,38 +1,46 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #ifndef __EASYRTOSSEM_H
 #define __EASYRTOSSEM_H
 
-/* ź */
+/* 信号量类型 */
 #define SEM_BINARY  0x01
 #define SEM_MUTEX   0x02
 #define SEM_COUNTY  0x03
+#define SEM_CEILING 0x04
+
+/* 互斥锁和天花板互斥锁都有拥有者 */
+#define SEM_HAS_OWNER(type) (((type) == SEM_MUTEX) || ((type) == SEM_CEILING))
 
 typedef struct easyRTOSSem
 {
-    EASYRTOS_TCB * suspQ;  /* Sem */
-    EASYRTOS_TCB * owner;  /* MUTEXס */
-    int16_t        count;  /* ź -3276832767*/
-    uint8_t        type;   /* ź */
+    EASYRTOS_TCB * suspQ;  /* 被Sem阻塞的任务队列 */
+    EASYRTOS_TCB * owner;  /* 被MUTEX锁住的任务 */
+    int16_t        count;  /* 信号量计数 -32768到32767*/
+    uint8_t        type;   /* 信号量类型 */
+    uint8_t        ceiling;/* 天花板互斥锁的天花板优先级 */
+    struct easyRTOSSem *next_held;  /* owner拥有的下一个互斥锁 */
 } EASYRTOS_SEM;
 
 typedef struct easyRTOSSemTimer
 {
-    EASYRTOS_TCB *tcb_ptr;  /* timeout */
-    EASYRTOS_SEM *sem_ptr;  /* ź */
+    EASYRTOS_TCB *tcb_ptr;  /* 具有timeout的悬挂任务 */
+    EASYRTOS_SEM *sem_ptr;  /* 阻塞任务的信号量 */
 } SEM_TIMER;
 
-/* ȫֺ */
+/* 全局函数 */
 extern EASYRTOS_SEM eSemCreateBinary ();
 extern EASYRTOS_SEM eSemCreateCount  (uint8_t initial_count);
 extern EASYRTOS_SEM eSemCreateMutex  ();
+extern EASYRTOS_SEM eSemCreateCeiling (uint8_t ceiling);
 extern ERESULT eSemDelete (EASYRTOS_SEM *sem);
 extern ERESULT eSemTake (EASYRTOS_SEM *sem, int32_t timeout);
 extern ERESULT eSemGive (EASYRTOS_SEM *sem);
 extern ERESULT eSemResetCount (EASYRTOS_SEM *sem, uint8_t count);
+extern void eSemMutexPrioUpdate (EASYRTOS_TCB *tcb_ptr);
 
 #endif
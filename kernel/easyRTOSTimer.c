@@ -1,7 +1,7 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 
@@ -9,82 +9,266 @@
 #include "easyRTOSkernel.h"
 #include "easyRTOSport.h"
 #include "easyRTOSTimer.h"
-//RTC
+#include "easyRTOSWork.h"
+#include "easyRTOSTrace.h"
+//增加RTC功能
 #include "bsp_rtc.h"
-/*  */
+/* 本地数据 */
 
-/* timerеָ */
-static EASYRTOS_TIMER *timer_queue = NULL;
+#if (EASYRTOS_TIMER_WHEEL == 1)
 
-/* easyRTOSϵͳδ */
-static uint32_t systemTicks = 0;
+#if ((EASYRTOS_TIMER_WHEEL_SIZE & (EASYRTOS_TIMER_WHEEL_SIZE - 1)) != 0)
+#error "EASYRTOS_TIMER_WHEEL_SIZE must be a power of 2"
+#endif
 
-/* ˽к */
+/**
+ * 哈希时间轮.
+ * 注册时cb_ticks转换为到期时的wheelTicks,按其低位放入对应的槽.每个心跳只检查
+ * 当前槽中的timer,到期时间相同的才会回调,其余的等待时间轮转过下一圈.
+ * 槽中的timer为双向链表,prev_next指向前一个timer的next_timer或者槽头,
+ * 取消时不需要搜索.
+ */
+static EASYRTOS_NODE_LOCAL EASYRTOS_TIMER *timerWheel[EASYRTOS_TIMER_WHEEL_SIZE];
+
+/* 时间轮计数,与systemTicks分开,不受eTimeSet()影响 */
+static EASYRTOS_NODE_LOCAL uint32_t wheelTicks = 0;
+
+#define TIMER_WHEEL_SLOT(ticks) ((uint8_t)((ticks) & (EASYRTOS_TIMER_WHEEL_SIZE - 1)))
+
+#else
+
+/**
+ * timer队列的指针.
+ * 队列按到期时间排序,每个timer的cb_ticks保存的是与前一个timer到期时间的差值,
+ * 队列头的cb_ticks即为距离下一次到期的心跳数.心跳中断只需要减少队列头的计数.
+ */
+static EASYRTOS_NODE_LOCAL EASYRTOS_TIMER *timer_queue = NULL;
+
+#endif
+
+/* easyRTOS系统滴答数量 */
+static EASYRTOS_NODE_LOCAL uint32_t systemTicks = 0;
+
+/* RTC秒计数使用的心跳计数 */
+static EASYRTOS_NODE_LOCAL uint16_t rtcTicks = 0;
+
+/* 私有函数 */
 static void eTimerCallbacks (void);
+static void eTimerCallbackRun (EASYRTOS_TIMER *timer_ptr);
 static void eTimerDelayCallback (POINTER cb_data);
 
-/* ȫֺ */
-void eTimerCallbacks (void);
+/* 全局函数 */
 void eTimerTick (void);
 ERESULT eTimerRegister (EASYRTOS_TIMER *timer_ptr);
 ERESULT eTimerCancel (EASYRTOS_TIMER *timer_ptr);
+#if (EASYRTOS_WORK_QUEUE == 1)
+ERESULT eTimerRegisterDeferred (EASYRTOS_TIMER *timer_ptr);
+#endif
 ERESULT eTimerDelay (uint32_t ticks);
 uint32_t eTimeGet(void);
 void eTimeSet(uint32_t newTime);
+uint32_t eTimerNextExpiry (void);
+void eTimerTickSkip (uint32_t ticks);
 
+#if (EASYRTOS_TIMER_WHEEL == 1)
 /**
- * : עᶨʱµĶʱб
+ * 功能: 注册定时器，将cb_ticks转换为到期时间,插入时间轮对应槽的头.
  *
- * :
- * :                         :
- * EASYRTOS_TIMER *timer_ptr                                  
+ * 参数:
+ * 输入:                         输出:
+ * EASYRTOS_TIMER *timer_ptr     无                             
  * 
- * :
+ * 返回:
  * EASYRTOS_OK
  * EASYRTOS_ERR_PARAM
  *
- * õĺ:
- * 
+ * 调用的函数:
+ * 无
  */
 ERESULT eTimerRegister (EASYRTOS_TIMER *timer_ptr)
 {
     ERESULT status;
+    EASYRTOS_TIMER **slot_ptr;
     CRITICAL_STORE;
-    /*  */
+    /* 检查参数 */
     if ((timer_ptr == NULL) || (timer_ptr->cb_func == NULL)
         || (timer_ptr->cb_ticks == 0))
     {
-        /* 󷵻 */
+        /* 注册失败的定时器也可以安全地取消 */
+        if (timer_ptr != NULL)
+        {
+            timer_ptr->prev_next = NULL;
+        }
+
+        /* 错误返回 */
         status = EASYRTOS_ERR_PARAM;
     }
     else
     {
-        /* ٽ */
+        /* 进入临界区 */
         CRITICAL_ENTER ();
 
+#if (EASYRTOS_WORK_QUEUE == 1)
+        /* 默认在心跳中断中回调,eTimerRegisterDeferred()在注册之后修改 */
+        timer_ptr->deferred = FALSE;
+#endif
+
+        /* 转换为到期时间 */
+        timer_ptr->cb_ticks += wheelTicks;
+        slot_ptr = &timerWheel[TIMER_WHEEL_SLOT(timer_ptr->cb_ticks)];
+
+        /* 插入槽的头 */
+        timer_ptr->next_timer = *slot_ptr;
+        if (*slot_ptr)
+        {
+            (*slot_ptr)->prev_next = &timer_ptr->next_timer;
+        }
+        timer_ptr->prev_next = slot_ptr;
+        *slot_ptr = timer_ptr;
+
+        /* 退出临界区 */
+        CRITICAL_EXIT ();
+
+        /* 注册成功 */
+        status = EASYRTOS_OK;
+    }
+
+    return (status);
+}
+
+/**
+ * 功能: 取消定时器，通过prev_next直接将定时器移出时间轮.已经到期、取消或者
+ * 注册失败的定时器prev_next为NULL,返回EASYRTOS_ERR_NOT_FOUND.从未注册过的
+ * 定时器需要先将prev_next清零(例如静态变量),否则不能取消.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * EASYRTOS_TIMER *timer_ptr     无                             
+ * 
+ * 返回:
+ * EASYRTOS_OK
+ * EASYRTOS_ERR_PARAM
+ * EASYRTOS_ERR_NOT_FOUND
+ *
+ * 调用的函数:
+ * 无
+ */
+ERESULT eTimerCancel (EASYRTOS_TIMER *timer_ptr)
+{
+    ERESULT status = EASYRTOS_ERR_NOT_FOUND;
+    CRITICAL_STORE;
+
+    /* 检查参数 */
+    if (timer_ptr == NULL)
+    {
+        /* 参数错误返回 */
+        status = EASYRTOS_ERR_PARAM;
+    }
+    else
+    {
+        /* 进入临界区 */
+        CRITICAL_ENTER ();
+
+        /* 检查timer是否在时间轮中 */
+        if (timer_ptr->prev_next)
+        {
+            *timer_ptr->prev_next = timer_ptr->next_timer;
+            if (timer_ptr->next_timer)
+            {
+                timer_ptr->next_timer->prev_next = timer_ptr->prev_next;
+            }
+            timer_ptr->prev_next = NULL;
+
+            /* 删除成功 */
+            status = EASYRTOS_OK;
+        }
+
+        /* 退出临界区 */
+        CRITICAL_EXIT ();
+     }
+  return (status);
+}
+
+#else
+/**
+ * 功能: 注册定时器，将新的定时器按到期时间插入列表.插入时将cb_ticks转换为
+ * 与前一个定时器的差值,并从后一个定时器的差值中减去.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * EASYRTOS_TIMER *timer_ptr     无                             
+ * 
+ * 返回:
+ * EASYRTOS_OK
+ * EASYRTOS_ERR_PARAM
+ *
+ * 调用的函数:
+ * 无
+ */
+ERESULT eTimerRegister (EASYRTOS_TIMER *timer_ptr)
+{
+    ERESULT status;
+    EASYRTOS_TIMER *prev_ptr, *next_ptr;
+    uint32_t ticks;
+    CRITICAL_STORE;
+    /* 检查参数 */
+    if ((timer_ptr == NULL) || (timer_ptr->cb_func == NULL)
+        || (timer_ptr->cb_ticks == 0))
+    {
+        /* 错误返回 */
+        status = EASYRTOS_ERR_PARAM;
+    }
+    else
+    {
+        /* 进入临界区 */
+        CRITICAL_ENTER ();
+
+#if (EASYRTOS_WORK_QUEUE == 1)
+        /* 默认在心跳中断中回调,eTimerRegisterDeferred()在注册之后修改 */
+        timer_ptr->deferred = FALSE;
+#endif
+
         /*
-         *  timerб
+         *  timer加入列表
          *
-         *  бû˳,еtimerбͷ.ÿϵͳ,б
-         *  ем1,count0,timerĻصᱻ.
+         *  列表按到期时间排序.从列表头开始减去每个timer的差值,找到插入的位置.
+         *  到期时间相同的timer插入在已有timer之后,保证回调按注册顺序执行.
          */
-        if (timer_queue == NULL)
+        ticks = timer_ptr->cb_ticks;
+        prev_ptr = NULL;
+        next_ptr = timer_queue;
+        while (next_ptr && (ticks >= next_ptr->cb_ticks))
+        {
+            ticks -= next_ptr->cb_ticks;
+            prev_ptr = next_ptr;
+            next_ptr = next_ptr->next_timer;
+        }
+
+        /* 保存与前一个timer的差值 */
+        timer_ptr->cb_ticks = ticks;
+        timer_ptr->next_timer = next_ptr;
+
+        /* 后一个timer的差值相应减少 */
+        if (next_ptr)
+        {
+            next_ptr->cb_ticks -= ticks;
+        }
+
+        if (prev_ptr == NULL)
         {
-            /* бΪ,ͷбͷ */
-            timer_ptr->next_timer = NULL;
+            /* 插入列表的头 */
             timer_queue = timer_ptr;
         }
         else
         {
-            /* бѾtimer,бͷµtimer */
-            timer_ptr->next_timer = timer_queue;
-            timer_queue = timer_ptr;
+            /* 插入列表中或者列表尾 */
+            prev_ptr->next_timer = timer_ptr;
         }
 
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
 
-        /* עɹ */
+        /* 注册成功 */
         status = EASYRTOS_OK;
     }
 
@@ -92,19 +276,19 @@ ERESULT eTimerRegister (EASYRTOS_TIMER *timer_ptr)
 }
 
 /**
- * : ȡʱʱƳб
+ * 功能: 取消定时器，将定时器移除列表,其差值累加到后一个定时器上
  *
- * :
- * :                         :
- * EASYRTOS_TIMER *timer_ptr                                  
+ * 参数:
+ * 输入:                         输出:
+ * EASYRTOS_TIMER *timer_ptr     无                             
  * 
- * :
+ * 返回:
  * EASYRTOS_OK
  * EASYRTOS_ERR_PARAM
  * EASYRTOS_ERR_NOT_FOUND
  *
- * õĺ:
- * 
+ * 调用的函数:
+ * 无
  */
 ERESULT eTimerCancel (EASYRTOS_TIMER *timer_ptr)
 {
@@ -112,36 +296,42 @@ ERESULT eTimerCancel (EASYRTOS_TIMER *timer_ptr)
     EASYRTOS_TIMER *prev_ptr, *next_ptr;
     CRITICAL_STORE;
 
-    /*  */
+    /* 检查参数 */
     if (timer_ptr == NULL)
     {
-        /* 󷵻 */
+        /* 参数错误返回 */
         status = EASYRTOS_ERR_PARAM;
     }
     else
     {
-        /* ٽ */
+        /* 进入临界区 */
         CRITICAL_ENTER ();
 
-        /* Ѱб,ҵصtimer*/
+        /* 搜寻列表,找到相关的timer*/
         prev_ptr = next_ptr = timer_queue;
         while (next_ptr)
         {
-            /* ǷѰҵtimer */
+            /* 是否是我们寻找的timer */
             if (next_ptr == timer_ptr)
             {
                 if (next_ptr == timer_queue)
                 {
-                    /* Ƴбͷ */
+                    /* 移除的是列表头 */
                     timer_queue = next_ptr->next_timer;
                 }
                 else
                 {
-                    /* Ƴблбβ */
+                    /* 移除的是列表中或者列表尾 */
                     prev_ptr->next_timer = next_ptr->next_timer;
                 }
 
-                /* ɾɹ */
+                /* 保持后一个timer的到期时间不变 */
+                if (next_ptr->next_timer)
+                {
+                    next_ptr->next_timer->cb_ticks += next_ptr->cb_ticks;
+                }
+
+                /* 删除成功 */
                 status = EASYRTOS_OK;
                 break;
             }
@@ -151,28 +341,64 @@ ERESULT eTimerCancel (EASYRTOS_TIMER *timer_ptr)
 
         }
 
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
      }
   return (status);
 }
 
+#endif
+
+#if (EASYRTOS_WORK_QUEUE == 1)
 /**
- * : ʱʱDelay񣬵ʱ䵽ʱDelay״̬
- * ָΪReadyΪӳ,õ.
+ * 功能: 注册定时器,到期后回调函数由工作任务执行,而不是在心跳中断中执行.
+ * 回调函数可以执行较长的处理,但执行时间会受到工作任务调度的影响.
  *
- * :
- * :                                            :
- * uint32_t ticks  ӳٵʱ䣬Ƶй                                     
+ * 参数:
+ * 输入:                         输出:
+ * EASYRTOS_TIMER *timer_ptr     无                             
  * 
- * :
+ * 返回:
+ * EASYRTOS_OK
+ * EASYRTOS_ERR_PARAM
+ *
+ * 调用的函数:
+ * eTimerRegister (timer_ptr);
+ */
+ERESULT eTimerRegisterDeferred (EASYRTOS_TIMER *timer_ptr)
+{
+    ERESULT status;
+    CRITICAL_STORE;
+
+    /* 在同一个临界区中设置标志,防止定时器在设置之前到期 */
+    CRITICAL_ENTER ();
+    status = eTimerRegister (timer_ptr);
+    if (status == EASYRTOS_OK)
+    {
+        timer_ptr->deferred = TRUE;
+    }
+    CRITICAL_EXIT ();
+
+    return (status);
+}
+#endif
+
+/**
+ * 功能: 延时函数，暂时Delay任务，当时间到达的时候解除Delay，任务状态
+ * 恢复为Ready。因为有任务被延迟,函数最后会调用调度器.
+ *
+ * 参数:
+ * 输入:                                            输出:
+ * uint32_t ticks  延迟的时间，与心跳频率有关        无                             
+ * 
+ * 返回:
  * EASYRTOS_OK 
  * EASYRTOS_ERR_PARAM 
  * EASYRTOS_ERR_CONTEXT 
  *
- * õĺ:
+ * 调用的函数:
  * eCurrentContext();
- * eTimerRegister (&timerCb)
+ * eTimerRegister (&timerCb)；
  * easyRTOSSched (FALSE);
  */
 ERESULT eTimerDelay (uint32_t ticks)
@@ -183,63 +409,63 @@ ERESULT eTimerDelay (uint32_t ticks)
     CRITICAL_STORE;
     ERESULT status;
 
-    /* ȡеTCB */
+    /* 获取现在运行的任务TCB */
     curr_tcb_ptr = eCurrentContext();
 
-    /*  */
+    /* 检查参数 */
     if (ticks == 0)
     {
         /** 
-         *  󷵻
+         *  错误返回
          */
         status = EASYRTOS_ERR_PARAM;
     }
 
-    /* Ƿ */
+    /* 检查是否运行在任务中 */
     else if (curr_tcb_ptr == NULL)
     {
-        /* û */
+        /* 没有运行在任务中 */
         status = EASYRTOS_ERR_CONTEXT;
     }
 
     else
     {
-        /* ٽ,*/
+        /* 进入临界区,保护任务队列*/
         CRITICAL_ENTER ();
 
-        /* ״̬ΪDelay */
+        /* 设置运行任务状态为Delay */
         curr_tcb_ptr->state = TASK_DELAY;
 
-        /* עtimerĻص */
+        /* 注册timer的回调函数 */
 
-        /* ص */
+        /* 填入回调函数 */
         timerData.tcb_ptr = curr_tcb_ptr;
 
         timerCb.cb_func = eTimerDelayCallback;
         timerCb.cb_data = (POINTER)&timerData;
         timerCb.cb_ticks = ticks;
 
-        /* 洢ʱص(ʱǲʹ)*/
+        /* 存储超时回调(暂时我们不会使用他)*/
         curr_tcb_ptr->delay_timo_cb = &timerCb;
 
-        /* עᶨʱص */
+        /* 注册定时器回调 */
         if (eTimerRegister (&timerCb) != EASYRTOS_OK)
         {
-            /* ˳ٽ */
+            /* 退出临界区 */
             CRITICAL_EXIT ();
 
-            /* timerעδɹ */
+            /* timer注册未成功 */
             status = EASYRTOS_ERR_TIMER;
         }
         else
         {
-            /* ˳ٽ */
+            /* 退出临界区 */
             CRITICAL_EXIT ();
 
-            /* timerעɹ */
+            /* timer注册成功 */
             status = EASYRTOS_OK;
 
-            /* еӳ,ʼ */
+            /* 正在运行的任务被延迟,调度其他任务开始运行 */
             easyRTOSSched (FALSE);
         }
     }
@@ -248,187 +474,435 @@ ERESULT eTimerDelay (uint32_t ticks)
 }
 
 /**
- * : жϵʱãϵͳtickжʱи£
- * ʱǷcountΪ0
+ * 功能: 心跳中断的时候调用，增加系统tick计数，对所有定时器进行更新，检测
+ * 定时器是否count为0
  *
- * :
- * :                   :
- *                                                    
+ * 参数:
+ * 输入:                   输出:
+ * 无                      无                             
  * 
- * :void
+ * 返回:void
  *
- * õĺ:
+ * 调用的函数:
  * eTimerCallbacks ();
  */
 void eTimerTick (void)
 {
-  static uint16_t temp=0;
-  //Ƭϵ
-  temp++;
-  if (temp>=2000)
+  //单片机上电就运行
+  rtcTicks++;
+  if (rtcTicks>=SYSTEM_TICKS_HZ)
   {
-    //λS
+    //单位S
     RTCCount++;
-    temp=0;
+    rtcTicks=0;
   }
-  /* ϵͳʱ */
+  /* 当系统启动的时候才运行 */
   if (easyRTOSStarted)
   {
-    /* ϵͳtick*/
+    /* 增加系统tick计数*/
     systemTicks++;
 
-    /* ǷкҪص */
+    /* 检测是否有函数需要回调 */
     eTimerCallbacks ();
   }
 }
 
+#if (EASYRTOS_TIMER_WHEEL == 1)
 /**
- * : жʱãעᶨʱcountcountΪ0ǵöʱ
- * ص
+ * 功能: 心跳中断时调用，时间轮前进一格,将当前槽中到期的定时器移出并调用其
+ * 回调函数。每次只检查一个槽。
  *
- * :
- * :                   :
- *                                                    
+ * 参数:
+ * 输入:                   输出:
+ * 无                      无                             
  * 
- * :void
+ * 返回:void
  *
- * õĺ:
- * 
+ * 调用的函数:
+ * 无
  */
 static void eTimerCallbacks (void)
 {
-  EASYRTOS_TIMER *prev_ptr = NULL, *next_ptr = NULL, *saved_next_ptr = NULL;
+  EASYRTOS_TIMER *next_ptr = NULL, *saved_next_ptr = NULL;
   EASYRTOS_TIMER *callback_list_tail = NULL, *callback_list_head = NULL;
 
-  /* ,жʱļ,ǷҪص */
-  prev_ptr = next_ptr = timer_queue;
+  /* 时间轮前进一格 */
+  wheelTicks++;
+
+  /* 检查当前槽,没有到期的timer留在槽中等待下一圈 */
+  next_ptr = timerWheel[TIMER_WHEEL_SLOT(wheelTicks)];
   while (next_ptr)
   {
-    /* next timerб */
+    /* 将next timer保存在列表中 */
     saved_next_ptr = next_ptr->next_timer;
 
-    /* timer Ƿ? */
-    if (--(next_ptr->cb_ticks) == 0)
+    /* timer 入口是否到期? */
+    if (next_ptr->cb_ticks == wheelTicks)
     {
-      /* бƳ */
-      if (next_ptr == timer_queue)
+      /* 从槽中移除该入口 */
+      *next_ptr->prev_next = next_ptr->next_timer;
+      if (next_ptr->next_timer)
       {
-        /** 
-         *  Ƴбͷ
-         */
-        timer_queue = next_ptr->next_timer;
+        next_ptr->next_timer->prev_next = next_ptr->prev_next;
       }
-      else
-      {
-        /* Ƴблбβ */
-        prev_ptr->next_timer = next_ptr->next_timer;
-      }
-
-      /*
-       *  ڼҪִеĻصб.Ǳб֮
-       *  ִ,Ϊп֮лصҪִ.
+      next_ptr->prev_next = NULL;
 
-       *  ظEASYRTOS_TIMERṹ next_ptr ָصб.
-       */
+      /* 重复利用 next_timer 指针来保存回调列表 */
       if (callback_list_head == NULL)
       {
-        /* бӵһص */
         callback_list_head = callback_list_tail = next_ptr;
       }
       else
       {
-        /* бβӻص */
         callback_list_tail->next_timer = next_ptr;
-        callback_list_tail = callback_list_tail->next_timer;
+        callback_list_tail = next_ptr;
       }
 
-      /* Ǹtimerǻصбһ */
+      /* 标记该timer就是回调列表的最后一个 */
       next_ptr->next_timer = NULL;
+    }
+
+    next_ptr = saved_next_ptr;
+  }
 
+  /* 遍历整个回调列表 */
+  next_ptr = callback_list_head;
+  while (next_ptr)
+  {
+    /* 保存列表中的 next timer,避免列表被修改 */
+    saved_next_ptr = next_ptr->next_timer;
+
+    /* 调用回调 */
+    eTimerCallbackRun (next_ptr);
+
+    /* 找到回调列表中的下一个回调 */
+    next_ptr = saved_next_ptr;
+  }
+}
+
+/**
+ * 功能: 获取距离下一个定时器到期的心跳数,用于无心跳空闲模式.需要遍历整个
+ * 时间轮,只在idleTask中调用.
+ *
+ * 参数:
+ * 输入:                   输出:
+ * 无                      无                             
+ * 
+ * 返回:
+ * uint32_t 距离下一个定时器到期的心跳数,没有注册定时器时返回0xFFFFFFFF
+ *
+ * 调用的函数:
+ * 无
+ */
+uint32_t eTimerNextExpiry (void)
+{
+  CRITICAL_STORE;
+  EASYRTOS_TIMER *next_ptr;
+  uint32_t ticks = 0xFFFFFFFF;
+  uint8_t i;
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  for (i = 0; i < EASYRTOS_TIMER_WHEEL_SIZE; i++)
+  {
+    next_ptr = timerWheel[i];
+    while (next_ptr)
+    {
+      if ((next_ptr->cb_ticks - wheelTicks) < ticks)
+      {
+        ticks = next_ptr->cb_ticks - wheelTicks;
+      }
+      next_ptr = next_ptr->next_timer;
     }
+  }
 
-    /* صûе.ڴ˳,countֵ */
-    else
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  return (ticks);
+}
+
+/**
+ * 功能: 补偿低功耗期间停止的系统心跳.ticks不小于eTimerNextExpiry()的返回值时
+ * 只补偿到下一个定时器到期之前,保证跳过的槽中没有到期的定时器,时间轮直接
+ * 前进即可.
+ *
+ * 参数:
+ * 输入:                                输出:
+ * uint32_t ticks 需要补偿的心跳数       无                             
+ * 
+ * 返回:void
+ *
+ * 调用的函数:
+ * eTimerNextExpiry ();
+ */
+void eTimerTickSkip (uint32_t ticks)
+{
+  CRITICAL_STORE;
+  uint32_t next;
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  /* 到期的心跳留给心跳中断处理 */
+  next = eTimerNextExpiry ();
+  if (ticks >= next)
+  {
+    ticks = (next > 0) ? (next - 1) : 0;
+  }
+
+  /* RTC秒计数 */
+  rtcTicks += (uint16_t)(ticks % SYSTEM_TICKS_HZ);
+  RTCCount += ticks / SYSTEM_TICKS_HZ;
+  if (rtcTicks >= SYSTEM_TICKS_HZ)
+  {
+    RTCCount++;
+    rtcTicks -= SYSTEM_TICKS_HZ;
+  }
+
+  /* 增加系统tick计数*/
+  systemTicks += ticks;
+
+  /* 时间轮前进 */
+  wheelTicks += ticks;
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+}
+
+#else
+/**
+ * 功能: 心跳中断时调用，减少列表头定时器的count，将count为0的定时器从列表头
+ * 移除并调用其回调函数。执行时间与注册的定时器数量无关。
+ *
+ * 参数:
+ * 输入:                   输出:
+ * 无                      无                             
+ * 
+ * 返回:void
+ *
+ * 调用的函数:
+ * 无
+ */
+static void eTimerCallbacks (void)
+{
+  EASYRTOS_TIMER *next_ptr = NULL, *saved_next_ptr = NULL;
+  EASYRTOS_TIMER *callback_list_head = NULL;
+
+  /* 列表为空 */
+  if (timer_queue == NULL)
+  {
+    return;
+  }
+
+  /* 只需要减少列表头的计数 */
+  timer_queue->cb_ticks--;
+
+  /*
+   *  列表头差值为0的timer全部到期,包括到期时间相同(差值为0)的后续timer.
+   *  将它们整体从列表头移除作为回调列表,在列表更新完之后再执行回调,
+   *  因为回调函数中有可能重新注册timer.
+   */
+  if (timer_queue->cb_ticks == 0)
+  {
+    callback_list_head = next_ptr = timer_queue;
+    while (next_ptr->next_timer && (next_ptr->next_timer->cb_ticks == 0))
     {
-      prev_ptr = next_ptr;
+      next_ptr = next_ptr->next_timer;
     }
+    timer_queue = next_ptr->next_timer;
 
-    next_ptr = saved_next_ptr;
+    /* 标记该timer就是回调列表的最后一个 */
+    next_ptr->next_timer = NULL;
   }
 
-  /* Ƿлص */
+  /* 检测是否有回调函数 */
   if (callback_list_head)
   {
-      /* صб */
+      /* 遍历整个回调列表 */
       next_ptr = callback_list_head;
       while (next_ptr)
       {
-          /* бе next timer,б޸ */
+          /* 保存列表中的 next timer,避免列表被修改 */
           saved_next_ptr = next_ptr->next_timer;
 
-          /* ûص */
-          if (next_ptr->cb_func)
-          {
-              next_ptr->cb_func (next_ptr->cb_data);
-          }
+          /* 调用回调 */
+          eTimerCallbackRun (next_ptr);
 
-          /* ҵصбеһص */
+          /* 找到回调列表中的下一个回调 */
           next_ptr = saved_next_ptr;
       }
   }
 }
 
 /**
- * : ʱʱĻص,ʱעĶʱ,ô˺
+ * 功能: 获取距离下一个定时器到期的心跳数,用于无心跳空闲模式.
+ *
+ * 参数:
+ * 输入:                   输出:
+ * 无                      无                             
+ * 
+ * 返回:
+ * uint32_t 距离下一个定时器到期的心跳数,没有注册定时器时返回0xFFFFFFFF
+ *
+ * 调用的函数:
+ * 无
+ */
+uint32_t eTimerNextExpiry (void)
+{
+  CRITICAL_STORE;
+  uint32_t ticks = 0xFFFFFFFF;
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  /* 列表头的差值即为距离下一次到期的心跳数 */
+  if (timer_queue)
+  {
+    ticks = timer_queue->cb_ticks;
+  }
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  return (ticks);
+}
+
+/**
+ * 功能: 补偿低功耗期间停止的系统心跳,增加系统tick计数并减少列表头定时器的
+ * count.ticks不小于eTimerNextExpiry()的返回值时只补偿到下一个定时器到期之前,
+ * 所以这里不会有定时器到期.
+ *
+ * 参数:
+ * 输入:                                输出:
+ * uint32_t ticks 需要补偿的心跳数       无                             
+ * 
+ * 返回:void
+ *
+ * 调用的函数:
+ * eTimerNextExpiry ();
+ */
+void eTimerTickSkip (uint32_t ticks)
+{
+  CRITICAL_STORE;
+  uint32_t next;
+
+  /* 进入临界区 */
+  CRITICAL_ENTER ();
+
+  /* 到期的心跳留给心跳中断处理 */
+  next = eTimerNextExpiry ();
+  if (ticks >= next)
+  {
+    ticks = (next > 0) ? (next - 1) : 0;
+  }
+
+  /* RTC秒计数 */
+  rtcTicks += (uint16_t)(ticks % SYSTEM_TICKS_HZ);
+  RTCCount += ticks / SYSTEM_TICKS_HZ;
+  if (rtcTicks >= SYSTEM_TICKS_HZ)
+  {
+    RTCCount++;
+    rtcTicks -= SYSTEM_TICKS_HZ;
+  }
+
+  /* 增加系统tick计数*/
+  systemTicks += ticks;
+
+  /* 后续定时器保存的是差值,只需要减少列表头的计数 */
+  if (timer_queue)
+  {
+    timer_queue->cb_ticks -= ticks;
+  }
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+}
+
+#endif
+
+/**
+ * 功能: 执行到期定时器的回调.eTimerRegisterDeferred()注册的定时器交给工作任务
+ * 执行,工作队列已满时仍在中断中执行,不丢失回调.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * EASYRTOS_TIMER *timer_ptr     无                             
+ * 
+ * 返回:void
+ *
+ * 调用的函数:
+ * eWorkPost (timer_ptr->cb_func, timer_ptr->cb_data);
+ */
+static void eTimerCallbackRun (EASYRTOS_TIMER *timer_ptr)
+{
+  TRACE_EVENT (TRACE_TIMER_EXPIRE, 0, timer_ptr, 0);
+
+  if (timer_ptr->cb_func)
+  {
+#if (EASYRTOS_WORK_QUEUE == 1)
+    if (timer_ptr->deferred
+        && (eWorkPost (timer_ptr->cb_func, timer_ptr->cb_data) == EASYRTOS_OK))
+    {
+      return;
+    }
+#endif
+    timer_ptr->cb_func (timer_ptr->cb_data);
+  }
+}
+
+/**
+ * 功能: 延时定时器的回调函数,若延时注册的定时器到期,则会调用此函数
  *
- * :
- * :                                 :
- * POINTER cb_data  ص         POINTER cb_data     ص                       
+ * 参数:
+ * 输入:                                 输出:
+ * POINTER cb_data  回调函数参数         POINTER cb_data     回调函数参数                       
  * 
- * :void
+ * 返回:void
  *
- * õĺ:
- * tcbEnqueuePriority (&tcb_readyQ, timer_data_ptr->tcb_ptr);
+ * 调用的函数:
+ * tcbEnqueueReady (timer_data_ptr->tcb_ptr);
  */
 static void eTimerDelayCallback (POINTER cb_data)
 {
     DELAY_TIMER *timer_data_ptr;
     CRITICAL_STORE;
 
-    /* ȡDELAY_TIMERĽṹָ */
+    /* 获取DELAY_TIMER的结构体指针 */
     timer_data_ptr = (DELAY_TIMER *)cb_data;
 
     /** 
-     *  ǷΪNULL
+     *  检查参数是否为NULL
      */
     if (timer_data_ptr)
     {
-        /* ٽ */
+        /* 进入临界区 */
         CRITICAL_ENTER ();
 
-        /* Ready */
-        if (tcbEnqueuePriority (&tcb_readyQ, timer_data_ptr->tcb_ptr) == EASYRTOS_OK)
+        /* 将任务加入Ready队列 */
+        if (tcbEnqueueReady (timer_data_ptr->tcb_ptr) == EASYRTOS_OK)
         {
           timer_data_ptr->tcb_ptr->state = TASK_READY;
         }
 
-        /* ˳ٽ */
+        /* 退出临界区 */
         CRITICAL_EXIT ();
     }
 }
 
 /**
- * : ȡ.
+ * 功能: 心跳次数获取.
  *
- * :
- * :                             :
- *                                                       
+ * 参数:
+ * 输入:                             输出:
+ * 无                                无                      
  * 
- * :
- * uint32_t systemTicks ϵͳ
+ * 返回:
+ * uint32_t systemTicks 系统心跳数
  *
- * õĺ:
- * 
+ * 调用的函数:
+ * 无
  */
 uint32_t eTimeGet(void)
 {
@@ -436,17 +910,17 @@ uint32_t eTimeGet(void)
 }
 
 /**
- * : 
+ * 功能: 心跳次数设置
  *
- * :
- * :                             :
- *                                                       
+ * 参数:
+ * 输入:                             输出:
+ * 无                                无                      
  * 
- * :
- * uint32_t systemTicks ϵͳ
+ * 返回:
+ * uint32_t systemTicks 系统心跳数
  *
- * õĺ:
- * 
+ * 调用的函数:
+ * 无
  */
 void eTimeSet(uint32_t newTime)
 {
@@ -0,0 +1,260 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 内核跟踪记录:任务切换,中断进出,信号量/队列操作以及定时器到期时写入一条
+ * 8Byte的记录到RAM环形缓冲区,缓冲区满后覆盖最早的记录.时间戳为TIM2的1us
+ * 自由计数(与运行时间统计共用),65ms回零,由解析工具根据记录顺序展开.
+ * 系统心跳的中断进出都有记录,相邻记录的间隔总是小于65ms.无心跳睡眠以及
+ * 停止记录期间没有记录,此时在前后各写入一条TRACE_TICK_SYNC,由解析工具按
+ * 两条记录之间的心跳数修正时间,精度为一个心跳,间隔不能超过65535个心跳.
+ * eTraceDump()通过UART1导出缓冲区,格式为:
+ * 'E' 'T' 'R' 'C'             4Byte 标识
+ * TRACE_VERSION               1Byte
+ * sizeof(EASYRTOS_TRACE_REC)  1Byte
+ * 0x1234                      2Byte 用于判断字节序
+ * count                       2Byte 导出的记录数量
+ * written                     2Byte 写入的记录总数,大于count时有记录被覆盖.
+ *                             总数超过0xFFFF后固定为0xFFFF,被覆盖的数量至少为
+ *                             written-count
+ * count条记录,从最早到最新
+ * 多字节数据均为CPU的字节序.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSTrace.h"
+
+#if (EASYRTOS_TRACE == 1)
+
+#if ((EASYRTOS_TRACE_BUF_SIZE & (EASYRTOS_TRACE_BUF_SIZE - 1)) != 0)
+#error "EASYRTOS_TRACE_BUF_SIZE must be a power of 2"
+#endif
+
+#define TRACE_SLOT(index) ((index) & (EASYRTOS_TRACE_BUF_SIZE - 1))
+
+/* 本地数据 */
+static EASYRTOS_NODE_LOCAL EASYRTOS_TRACE_REC traceBuf[EASYRTOS_TRACE_BUF_SIZE];
+
+/* 写入的记录总数,低位即为下一条记录的位置 */
+static EASYRTOS_NODE_LOCAL uint16_t traceWritten = 0;
+
+/* traceWritten曾经回零,缓冲区一定已经写满 */
+static EASYRTOS_NODE_LOCAL uint8_t traceWrapped = FALSE;
+
+/* 是否正在记录 */
+static EASYRTOS_NODE_LOCAL uint8_t traceOn = FALSE;
+
+/* 全局函数 */
+void eTraceInit (void);
+void eTraceRecord (uint8_t event, uint8_t arg8, uint16_t obj, uint16_t arg);
+void eTraceSync (void);
+void eTraceStart (void);
+void eTraceStop (void);
+void eTraceDump (void);
+
+/* 私有函数 */
+static void traceDumpBytes (const uint8_t *data, uint16_t size);
+
+/**
+ * 功能: 初始化跟踪记录,启动TIM2时间戳并开始记录.由easyRTOSInit()调用.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * archRunTimeInit ();
+ */
+void eTraceInit (void)
+{
+  traceWritten = 0;
+  traceWrapped = FALSE;
+  archRunTimeInit ();
+  traceOn = TRUE;
+}
+
+/**
+ * 功能: 写入一条跟踪记录.中断中也可以调用,一般通过TRACE_EVENT()调用,关闭
+ * EASYRTOS_TRACE时TRACE_EVENT()为空.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * uint8_t event 事件类型        无
+ * uint8_t arg8 事件参数
+ * uint16_t obj 事件对象地址
+ * uint16_t arg 事件参数
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * archRunTimeGet ();
+ */
+void eTraceRecord (uint8_t event, uint8_t arg8, uint16_t obj, uint16_t arg)
+{
+  EASYRTOS_TRACE_REC *rec;
+  CRITICAL_STORE;
+
+  if (traceOn == FALSE)
+  {
+    return;
+  }
+
+  CRITICAL_ENTER ();
+  rec = &traceBuf[TRACE_SLOT(traceWritten)];
+  traceWritten++;
+  if (traceWritten == 0)
+  {
+    traceWrapped = TRUE;
+  }
+  rec->time = archRunTimeGet ();
+  rec->event = event;
+  rec->arg8 = arg8;
+  rec->obj = obj;
+  rec->arg = arg;
+  CRITICAL_EXIT ();
+}
+
+/**
+ * 功能: 写入一条TRACE_TICK_SYNC记录,给出当前的系统心跳计数.在时间戳可能
+ * 回零或者停止计数的区间前后调用,一般通过TRACE_SYNC()调用.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * eTimeGet ();
+ * eTraceRecord (TRACE_TICK_SYNC, 0, period, ticks);
+ */
+void eTraceSync (void)
+{
+  eTraceRecord (TRACE_TICK_SYNC, 0, (uint16_t)((uint32_t)1000000 / SYSTEM_TICKS_HZ),
+                (uint16_t)eTimeGet ());
+}
+
+/**
+ * 功能: 开始记录.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * eTraceSync ();
+ */
+void eTraceStart (void)
+{
+  traceOn = TRUE;
+  eTraceSync ();
+}
+
+/**
+ * 功能: 停止记录.检测到异常时停止记录,可以保留异常之前的记录.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * eTraceSync ();
+ */
+void eTraceStop (void)
+{
+  eTraceSync ();
+  traceOn = FALSE;
+}
+
+/**
+ * 功能: 停止记录并通过UART1导出缓冲区中的记录,格式见文件头.导出后清空缓冲区,
+ * 导出前正在记录则继续记录.以查询方式发送,需要在任务中调用.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * archTraceUartInit ();
+ * traceDumpBytes (data, size);
+ */
+void eTraceDump (void)
+{
+  static const uint8_t magic[4] = {'E', 'T', 'R', 'C'};
+  uint8_t wasOn = traceOn;
+  uint8_t header[2];
+  uint16_t bom = 0x1234;
+  uint16_t written;
+  uint16_t total;
+  uint16_t count;
+  uint16_t index;
+
+  traceOn = FALSE;
+
+  /* 回零之后written只用于定位,导出的总数固定为0xFFFF */
+  written = traceWritten;
+  if ((traceWrapped == TRUE) || (written > EASYRTOS_TRACE_BUF_SIZE))
+  {
+    count = EASYRTOS_TRACE_BUF_SIZE;
+  }
+  else
+  {
+    count = written;
+  }
+  total = (traceWrapped == TRUE) ? 0xFFFF : written;
+
+  archTraceUartInit ();
+
+  header[0] = TRACE_VERSION;
+  header[1] = sizeof(EASYRTOS_TRACE_REC);
+  traceDumpBytes (magic, sizeof(magic));
+  traceDumpBytes (header, sizeof(header));
+  traceDumpBytes ((uint8_t *)&bom, sizeof(bom));
+  traceDumpBytes ((uint8_t *)&count, sizeof(count));
+  traceDumpBytes ((uint8_t *)&total, sizeof(total));
+
+  /* 从最早的记录开始 */
+  for (index = (uint16_t)(written - count); index != written; index++)
+  {
+    traceDumpBytes ((uint8_t *)&traceBuf[TRACE_SLOT(index)], sizeof(EASYRTOS_TRACE_REC));
+  }
+
+  traceWritten = 0;
+  traceWrapped = FALSE;
+  traceOn = wasOn;
+}
+
+/**
+ * 功能: 通过UART1发送数据.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * const uint8_t *data 数据      无
+ * uint16_t size 数据长度
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * archTraceUartPut (c);
+ */
+static void traceDumpBytes (const uint8_t *data, uint16_t size)
+{
+  while (size--)
+  {
+    archTraceUartPut (*data++);
+  }
+}
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ */
+#ifndef __EASYRTOSTRACE_H
+#define __EASYRTOSTRACE_H
+
+/* 导出数据的格式版本 */
+#define TRACE_VERSION           2
+
+/**
+ * 事件类型.记录中arg8,obj,arg的含义:
+ * TRACE_TASK_SWITCH  新任务ID      新任务TCB     高8位原任务ID,低8位新任务优先级
+ * TRACE_INT_ENTER    中断嵌套层数  0             0
+ * TRACE_INT_EXIT     中断嵌套层数  0             0
+ * TRACE_TASK_CREATE  任务ID        任务TCB       任务优先级
+ * TRACE_TASK_READY   任务ID        任务TCB       任务优先级
+ * TRACE_TICK_SYNC    0             心跳周期(us)  系统心跳计数低16位
+ * TRACE_SEM_GIVE     返回值        信号量        计数
+ * TRACE_SEM_TAKE     返回值        信号量        计数
+ * TRACE_SEM_BLOCK    任务ID        信号量        timeout低16位
+ * TRACE_QUEUE_GIVE   返回值        队列          消息数量
+ * TRACE_QUEUE_TAKE   返回值        队列          消息数量
+ * TRACE_QUEUE_BLOCK  任务ID        队列          timeout低16位
+ * TRACE_TIMER_EXPIRE 0             定时器        0
+ */
+#define TRACE_TASK_SWITCH       0x01
+#define TRACE_INT_ENTER         0x02
+#define TRACE_INT_EXIT          0x03
+#define TRACE_TASK_CREATE       0x04
+#define TRACE_TASK_READY        0x05
+#define TRACE_TICK_SYNC         0x06
+#define TRACE_SEM_GIVE          0x10
+#define TRACE_SEM_TAKE          0x11
+#define TRACE_SEM_BLOCK         0x12
+#define TRACE_QUEUE_GIVE        0x20
+#define TRACE_QUEUE_TAKE        0x21
+#define TRACE_QUEUE_BLOCK       0x22
+#define TRACE_TIMER_EXPIRE      0x30
+
+#if (EASYRTOS_TRACE == 1)
+
+/* 8Byte的跟踪记录,按CPU的字节序保存 */
+typedef struct easyRTOSTraceRec
+{
+    uint16_t  time;   /* 时间戳,TIM2的1us自由计数 */
+    uint8_t   event;  /* 事件类型 TRACE_XXX */
+    uint8_t   arg8;   /* 事件参数 */
+    uint16_t  obj;    /* 事件对象地址 */
+    uint16_t  arg;    /* 事件参数 */
+} EASYRTOS_TRACE_REC;
+
+#define TRACE_EVENT(event, arg8, obj, arg) \
+  eTraceRecord ((uint8_t)(event), (uint8_t)(arg8), (uint16_t)(size_t)(obj), (uint16_t)(arg))
+#define TRACE_SYNC()  eTraceSync ()
+
+/* 全局函数 */
+extern void eTraceInit (void);
+extern void eTraceRecord (uint8_t event, uint8_t arg8, uint16_t obj, uint16_t arg);
+extern void eTraceSync (void);
+extern void eTraceStart (void);
+extern void eTraceStop (void);
+extern void eTraceDump (void);
+
+#else
+
+#define TRACE_EVENT(event, arg8, obj, arg)
+#define TRACE_SYNC()
+
+#endif
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 中断下半部工作队列:中断通过eWorkPost()把函数和参数放入环形缓冲区,由一个
+ * 高优先级的工作任务依次取出执行.较长的处理移出中断,中断的执行时间保持不变,
+ * 也不需要为每个中断源单独建立任务和堆栈.
+ * 环形缓冲区只有工作任务一个读者,读取不需要进入临界区.写者可能是嵌套的多个
+ * 中断,STM8没有原子比较交换指令,写入时进入一个很短的临界区.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSNotify.h"
+#include "easyRTOSWork.h"
+
+#if (EASYRTOS_WORK_QUEUE == 1)
+
+#if ((EASYRTOS_WORK_QUEUE_SIZE & (EASYRTOS_WORK_QUEUE_SIZE - 1)) != 0) || (EASYRTOS_WORK_QUEUE_SIZE > 128)
+#error "EASYRTOS_WORK_QUEUE_SIZE must be a power of 2 and not greater than 128"
+#endif
+
+#define WORK_SLOT(index) ((uint8_t)((index) & (EASYRTOS_WORK_QUEUE_SIZE - 1)))
+
+/* 本地数据 */
+
+/* 工作任务TCB */
+static EASYRTOS_NODE_LOCAL EASYRTOS_TCB workTcb;
+
+/* 环形缓冲区,workHead只由工作任务修改,workTail只由eWorkPost()修改 */
+static EASYRTOS_NODE_LOCAL EASYRTOS_WORK workRing[EASYRTOS_WORK_QUEUE_SIZE];
+static EASYRTOS_NODE_LOCAL volatile uint8_t workHead = 0;
+static EASYRTOS_NODE_LOCAL volatile uint8_t workTail = 0;
+
+/* 全局函数 */
+ERESULT eWorkInit (void *work_task_stack, uint32_t workTaskStackSize);
+ERESULT eWorkPost (WORK_FUNC func, POINTER arg);
+
+/* 私有函数 */
+static void workTask (uint32_t param);
+
+/**
+ * 功能: 创建工作任务,优先级为EASYRTOS_WORK_PRIO.在easyRTOSInit()之后,
+ * easyRTOSStart()之前调用.
+ *
+ * 参数:
+ * 输入:                                          输出:
+ * void *work_task_stack 工作任务堆栈             无
+ * uint32_t workTaskStackSize 工作任务堆栈大小
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_QUEUE 将任务加入Ready队列失败
+ *
+ * 调用的函数:
+ * eTaskCreat(&workTcb,EASYRTOS_WORK_PRIO,workTask,0,work_task_stack,workTaskStackSize,"WORK",0);
+ */
+ERESULT eWorkInit (void *work_task_stack, uint32_t workTaskStackSize)
+{
+  workHead = 0;
+  workTail = 0;
+
+  return (eTaskCreat(&workTcb,
+                     EASYRTOS_WORK_PRIO,
+                     workTask,
+                     0,
+                     work_task_stack,
+                     workTaskStackSize,
+                     "WORK",
+                     0));
+}
+
+/**
+ * 功能: 提交一个工作,由工作任务调用func(arg).可以在中断和任务中调用.
+ * 只有缓冲区由空变为非空时才通知工作任务,工作任务每次会执行完缓冲区中所有的工作.
+ *
+ * 参数:
+ * 输入:                                          输出:
+ * WORK_FUNC func 工作函数                        无
+ * POINTER arg 工作函数的参数
+ *
+ * 返回:
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_OVF 缓冲区已满
+ *
+ * 调用的函数:
+ * eTaskNotifyGive (&workTcb);
+ */
+ERESULT eWorkPost (WORK_FUNC func, POINTER arg)
+{
+  uint8_t tail;
+  uint8_t wasEmpty;
+  CRITICAL_STORE;
+
+  if (func == NULL)
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  /* 进入临界区,防止嵌套的中断同时写入 */
+  CRITICAL_ENTER ();
+
+  tail = workTail;
+  if ((uint8_t)(tail - workHead) >= EASYRTOS_WORK_QUEUE_SIZE)
+  {
+    CRITICAL_EXIT ();
+    return (EASYRTOS_ERR_OVF);
+  }
+  wasEmpty = (tail == workHead);
+
+  /* 先写入数据再移动workTail,工作任务看到workTail变化时数据已经完整 */
+  workRing[WORK_SLOT(tail)].func = func;
+  workRing[WORK_SLOT(tail)].arg = arg;
+  workTail = (uint8_t)(tail + 1);
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  /* 中断中由eIntExit()切换到工作任务 */
+  if (wasEmpty)
+  {
+    (void)eTaskNotifyGive (&workTcb);
+  }
+
+  return (EASYRTOS_OK);
+}
+
+/**
+ * 功能: 工作任务,等待通知,然后执行缓冲区中所有的工作,直到缓冲区为空.
+ *
+ * 参数:
+ * 输入:                                          输出:
+ * uint32_t param 未使用                          无
+ *
+ * 返回:void
+ *
+ * 调用的函数:
+ * eTaskNotifyTake (TRUE, 0, NULL);
+ */
+static void workTask (uint32_t param)
+{
+  EASYRTOS_WORK work;
+  uint8_t head;
+
+  while (1)
+  {
+    (void)eTaskNotifyTake (TRUE, 0, NULL);
+
+    head = workHead;
+    while (head != workTail)
+    {
+      /* 先复制再释放槽,释放之后该槽可能被中断重新写入 */
+      work = workRing[WORK_SLOT(head)];
+      head++;
+      workHead = head;
+
+      work.func (work.arg);
+    }
+  }
+}
+
+#endif
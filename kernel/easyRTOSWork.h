@@ -0,0 +1,26 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ */
+#ifndef __EASYRTOSWORK_H
+#define __EASYRTOSWORK_H
+
+#if (EASYRTOS_WORK_QUEUE == 1)
+
+typedef void ( * WORK_FUNC ) ( POINTER arg ) ;
+
+typedef struct easyRTOSWork
+{
+    WORK_FUNC   func;   /* 工作函数 */
+    POINTER     arg;    /* 工作函数的参数 */
+} EASYRTOS_WORK;
+
+/* 全局函数 */
+extern ERESULT eWorkInit (void *work_task_stack, uint32_t workTaskStackSize);
+extern ERESULT eWorkPost (WORK_FUNC func, POINTER arg);
+
+#endif
+
+#endif
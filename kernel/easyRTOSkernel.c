@@ -1,66 +1,179 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #include "easyRTOS.h"
 #include "easyRTOSkernel.h"
 #include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+#include "easyRTOSMm.h"
+#include "easyRTOSTrace.h"
+#include "easyRTOSLatency.h"
 
-/* еTCB */
-static EASYRTOS_TCB *curr_tcb = NULL;
-/* easyRTOS־λ */
-uint8_t easyRTOSStarted = FALSE;
+/* 正在运行的任务的TCB */
+static EASYRTOS_NODE_LOCAL EASYRTOS_TCB *curr_tcb = NULL;
+/* easyRTOS启动标志位 */
+EASYRTOS_NODE_LOCAL uint8_t easyRTOSStarted = FALSE;
 
-/* easyRTOS */
-EASYRTOS_TCB *tcb_readyQ = NULL;
+/**
+ * easyRTOS就绪任务队列.
+ * 每个优先级对应一个FIFO循环双向链表,链表头的prev_tcb即为链表尾.
+ * readyGroup的每一位对应readyTable中的一组(16个优先级),readyTable的每一位
+ * 对应一个优先级的链表是否为空,查找最高优先级只需两次查表,与任务数量无关.
+ */
+static EASYRTOS_NODE_LOCAL EASYRTOS_TCB *tcb_readyQ[EASYRTOS_PRIO_NUM];
+static EASYRTOS_NODE_LOCAL uint16_t readyGroup = 0;
+static EASYRTOS_NODE_LOCAL uint16_t readyTable[EASYRTOS_PRIO_GRP];
+
+/* 位掩码表,避免8位机上的变长移位 */
+static const uint16_t readyMapTbl[16] =
+{
+  0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080,
+  0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000, 0x8000
+};
+
+/* 查找一个字节中最低的置位位置 */
+static const uint8_t readyUnmapTbl[256] =
+{
+  0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  7, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+  4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+};
+
+/* 16位数据中最低的置位位置,x不能为0 */
+#define READY_UNMAP16(x) ((((x) & 0xFF) != 0) ? readyUnmapTbl[(x) & 0xFF] \
+                                               : (uint8_t)(readyUnmapTbl[(x) >> 8] + 8))
+
+#if (EASYRTOS_RESCHED_FLAG == 1)
+/**
+ * 调度请求标志.相同或者更高优先级的任务加入就绪队列、当前任务的优先级被降低
+ * 时置位,调度器执行时清除.
+ */
+static EASYRTOS_NODE_LOCAL uint8_t reschedPending = FALSE;
+#endif
+
+/* 调度器上锁的嵌套计数,不为0时不切换任务 */
+static EASYRTOS_NODE_LOCAL uint8_t schedLockCnt = 0;
+
+/* 上锁期间被推迟的调度,以及推迟的调度是否包含用完的时间片 */
+static EASYRTOS_NODE_LOCAL uint8_t schedLockPending = FALSE;
+static EASYRTOS_NODE_LOCAL uint8_t schedLockTick = FALSE;
+
+/**
+ * 删除自己的任务在切换出去之前仍在使用TCB和堆栈,需要释放的内存先保存在这里,
+ * 由idleTask或者下一次eTaskDelete()释放.
+ */
+static EASYRTOS_NODE_LOCAL uint8_t *reclaimTcb = NULL;
+static EASYRTOS_NODE_LOCAL uint8_t *reclaimStack = NULL;
+
+/* easyRTOS中断嵌套计数 */
+static EASYRTOS_NODE_LOCAL int easyITCnt = 0;
 
-/* easyRTOSжǶ׼ */
-static int easyITCnt = 0;
+static EASYRTOS_NODE_LOCAL EASYRTOS_TCB idleTcb;
 
-static EASYRTOS_TCB idleTcb;
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+/* idleTask正处于低功耗模式,系统时间还没有补偿,此时不允许调度 */
+static EASYRTOS_NODE_LOCAL uint8_t ticklessSleeping = FALSE;
+#endif
 
-/* ȫֺ */
+#if (EASYRTOS_RUNTIME_STATS == 1)
+/* 所有已创建任务的链表 */
+static EASYRTOS_NODE_LOCAL EASYRTOS_TCB *taskList = NULL;
+
+/* 上一次统计时的计数器值 */
+static EASYRTOS_NODE_LOCAL uint16_t runTimeLast = 0;
+
+/* 统计开始后的总时间以及中断占用的时间,单位us */
+static EASYRTOS_NODE_LOCAL uint32_t runTimeTotal = 0;
+static EASYRTOS_NODE_LOCAL uint32_t isrRunTime = 0;
+#endif
+
+/* 全局函数 */
 ERESULT eTaskCreat(EASYRTOS_TCB *tcb_ptr, uint8_t priority, void (*entry_point)(uint32_t), uint32_t entryParam, void* task_stack, uint32_t stackSize,const char* task_name,uint32_t taskID);
 void easyRTOSStart (void);
 void easyRTOSSched (uint8_t timer_tick);
 ERESULT easyRTOSInit (void *idle_task_stack, uint32_t idleTaskStackSize);
+ERESULT eSetTaskPriority(EASYRTOS_TCB *tcb_ptr,uint8_t priority);
+ERESULT eTaskSetTimeSlice (EASYRTOS_TCB *tcb_ptr, uint8_t ticks);
+void eTaskYield (void);
+ERESULT eTaskSuspend (EASYRTOS_TCB *tcb_ptr);
+ERESULT eTaskResume (EASYRTOS_TCB *tcb_ptr);
+ERESULT eTaskDelete (EASYRTOS_TCB *tcb_ptr, uint8_t free_flags);
+void eSchedLock (void);
+void eSchedUnlock (void);
 ERESULT tcbEnqueuePriority (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr);
+ERESULT tcbEnqueueReady (EASYRTOS_TCB *tcb_ptr);
+EASYRTOS_TCB *tcb_dequeue_ready (EASYRTOS_TCB *tcb_ptr);
 EASYRTOS_TCB *tcb_dequeue_entry (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr);
 EASYRTOS_TCB *tcb_dequeue_head (EASYRTOS_TCB **tcb_queue_ptr);
-EASYRTOS_TCB *tcb_dequeue_priority (EASYRTOS_TCB **tcb_queue_ptr, uint8_t priority);
+EASYRTOS_TCB *tcb_dequeue_priority (uint8_t priority);
+void tcbSetPriority (EASYRTOS_TCB *tcb_ptr, uint8_t priority);
 EASYRTOS_TCB *eCurrentContext (void);
 void eIntEnter (void);
 void eIntExit (uint8_t timerTick);
+#if (EASYRTOS_STACK_CHECK == 1)
+uint16_t eTaskStackFree (EASYRTOS_TCB *tcb_ptr);
+#endif
+#if (EASYRTOS_RUNTIME_STATS == 1)
+uint8_t eTaskCpuUsage (EASYRTOS_TCB *tcb_ptr);
+uint8_t eIdleCpuUsage (void);
+uint8_t eIsrCpuUsage (void);
+void eRunTimeStatsReset (void);
+#endif
 /* end */
 
-/* ˽к */
+/* 私有函数 */
 static void idleTask (uint32_t param);
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+static void idleTickless (void);
+#endif
 static void eTaskSwitch(EASYRTOS_TCB *old_tcb, EASYRTOS_TCB *new_tcb);
+static void tcbDetach (EASYRTOS_TCB *tcb_ptr, ERESULT wake_status);
+static void taskReclaim (void);
+#if (EASYRTOS_RUNTIME_STATS == 1)
+static void eRunTimeCharge (uint32_t *run_time);
+static void eRunTimeScale (void);
+static uint8_t eRunTimePercent (uint32_t run_time);
+#endif
 /* end */
 
 /**
- * : һ,ȼ,,ջλüС,Ƽ,TCB.
+ * 功能: 创建一个新任务,设置其优先级,函数参数,堆栈位置及大小,任务名称及编号,保存在TCB中.
  *
- * :
- * :                                  :
- * EASYRTOS_TCB *tcb_ptr TCB          EASYRTOS_TCB *tcb_ptr TCB 
- * uint8_t priority ȼ
- * uint32_t entryParam 
- * void* task_stack ջ
- * uint32_t stackSize ջС
- * const char* task_name  
- * uint32_t taskID ID
+ * 参数:
+ * 输入:                                  输出:
+ * EASYRTOS_TCB *tcb_ptr 任务TCB          EASYRTOS_TCB *tcb_ptr 任务TCB 
+ * uint8_t priority 任务优先级 0~EASYRTOS_PRIO_NUM-2
+ * uint32_t entryParam 任务参数
+ * void* task_stack 任务堆栈
+ * uint32_t stackSize 任务堆栈大小
+ * const char* task_name 任务名称 
+ * uint32_t taskID 任务ID编号
  *
- * : ERESULT
- * EASYRTOS_OK ɹ
- * EASYRTOS_ERR_PARAM Ĳ
- * EASYRTOS_ERR_QUEUE Readyʧ
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_QUEUE 将任务加入Ready队列失败
  *
- * õĺ:
+ * 调用的函数:
  * archTaskContextInit (tcb_ptr, stack_top, entry_point, entryParam);
- * tcbEnqueuePriority (&tcb_readyQ, tcb_ptr);
+ * tcbEnqueueReady (tcb_ptr);
  */
 ERESULT eTaskCreat(EASYRTOS_TCB *tcb_ptr, uint8_t priority, void (*entry_point)(uint32_t), uint32_t entryParam, void* task_stack, uint32_t stackSize,const char* task_name,uint32_t taskID)
 {
@@ -72,12 +185,19 @@ ERESULT eTaskCreat(EASYRTOS_TCB *tcb_ptr, uint8_t priority, void (*entry_point)(
 
   if ((tcb_ptr == NULL) || (entry_point == NULL) || (task_stack == NULL) || (stackSize == 0) || task_name == NULL)
   {
-    /*  */
+    /* 参数错误 */
+    status = EASYRTOS_ERR_PARAM;
+  }
+#if (EASYRTOS_PRIO_NUM < 256)
+  else if (priority >= EASYRTOS_PRIO_NUM)
+  {
+    /* 优先级超出范围 */
     status = EASYRTOS_ERR_PARAM;
   }
+#endif
   else
   {
-    /* ʼTCB */
+    /* 初始化TCB */
     for (p_string=(char *)task_name;(*p_string)!='\0';p_string++)
     {
       tcb_ptr->taskName[i]=*p_string;
@@ -90,50 +210,79 @@ ERESULT eTaskCreat(EASYRTOS_TCB *tcb_ptr, uint8_t priority, void (*entry_point)(
     tcb_ptr->taskID = taskID;
     tcb_ptr->state = TASK_READY;
     tcb_ptr->priority = priority;
+    tcb_ptr->basePriority = priority;
+    tcb_ptr->timeSlice = EASYRTOS_TIME_SLICE;
+    tcb_ptr->sliceLeft = EASYRTOS_TIME_SLICE;
     tcb_ptr->prev_tcb = NULL;
     tcb_ptr->next_tcb = NULL;
     tcb_ptr->pended_timo_cb = NULL;
     tcb_ptr->delay_timo_cb = NULL;
+    tcb_ptr->pended_q = NULL;
+    tcb_ptr->pended_mutex = NULL;
+    tcb_ptr->mutex_held = NULL;
+    tcb_ptr->notifyValue = 0;
+    tcb_ptr->notifyState = 0;
+    tcb_ptr->eventWait = 0;
+    tcb_ptr->eventOpt = 0;
+    tcb_ptr->taskRunTime = 0;
+    tcb_ptr->stack_base = task_stack;
+    tcb_ptr->stack_size = (uint16_t)stackSize;
 
-    /* TCBбԼ */
+    /* 在TCB中保存任务函数入口以及参数 */
     tcb_ptr->entry_point = entry_point;
     tcb_ptr->entryParam  = entryParam;;
 
-    /* ջڵַ */
+#if (EASYRTOS_STACK_CHECK == 1)
+    /* 填充整个堆栈,用于统计堆栈的使用量 */
+    for (stack_top = (uint8_t *)task_stack; stack_top < (uint8_t *)task_stack + stackSize; stack_top++)
+    {
+      *stack_top = STACK_PAINT_BYTE;
+    }
+#endif
+
+    /* 计算栈顶入口地址 */
     stack_top = (uint8_t *)task_stack + (stackSize & ~(STACK_ALIGN_SIZE - 1)) - STACK_ALIGN_SIZE;
 
     /**
-     * arch-specificȥʼջ,һĴ洢,
-     * ԱeasyRTOSTaskSwitch()Ըе.archContextSwitch() (
-     * ȵһʼͻᱻ)ڻָԼһЩõ
-     * ֵ,Աִ.
+     * 调用arch-specific函数去初始化堆栈,这个函数负责建立一个任务上下文存储区域,
+     * 以便easyRTOSTaskSwitch()对该任务进行调度.archContextSwitch() (在任务被
+     * 调度的一开始就会被调用)函数会从任务入口恢复程序计数以及其他的一些必须用到寄
+     * 存器值,以便以任务继续执行.
      */
     archTaskContextInit (tcb_ptr, stack_top, entry_point, entryParam);
 
-    /* ٽ,ϵͳ */
+    /* 进入临界区,保护系统任务队列 */
     CRITICAL_ENTER ();
 
-    /* ½ */
-    if (tcbEnqueuePriority (&tcb_readyQ, tcb_ptr) != EASYRTOS_OK)
+#if (EASYRTOS_RUNTIME_STATS == 1)
+    /* 加入任务链表 */
+    tcb_ptr->next_task = taskList;
+    taskList = tcb_ptr;
+#endif
+
+    /* 将新建的任务加入就绪队列 */
+    if (tcbEnqueueReady (tcb_ptr) != EASYRTOS_OK)
     {
-      /* ʧ˳ٽ */
+      /* 若加入失败则退出临界区 */
       CRITICAL_EXIT ();
 
-      /* صĴ */
+      /* 返回与就绪队列相关的错误 */
       status = EASYRTOS_ERR_QUEUE;
     }
     else
     {
       tcb_ptr->state = TASK_READY;
       
-      /* ˳ٽ */
+      /* 正常退出临界区 */
       CRITICAL_EXIT ();
 
-      /* ϵͳѾ,Ѿ. */
+      TRACE_EVENT (TRACE_TASK_CREATE, tcb_ptr->taskID, tcb_ptr, tcb_ptr->priority);
+
+      /* 若系统已经启动,已经进入任务.则立刻启动调度器 */
       if (easyRTOSStarted == TRUE)
           easyRTOSSched (FALSE);
 
-      /* 񴴽ɹ־ */
+      /* 返回任务创建成功标志 */
       status = EASYRTOS_OK;
     }
   }
@@ -141,68 +290,474 @@ ERESULT eTaskCreat(EASYRTOS_TCB *tcb_ptr, uint8_t priority, void (*entry_point)(
 }
 
 /**
- * 2016.9.19 V0.2
- * : ޸һȼ
+ * 2016.9.19 V0.2新增函数
+ * 功能: 修改一个任务的优先级.若任务拥有的互斥锁上有更高优先级的任务在等待,
+ * 实际运行的优先级仍保持继承的优先级.
  * 
- * :
- * :                                            :
- * EASYRTOS_TCB *tcb_ptr  TCB                 .
- * uint8_t priority Ҫõȼ
+ * 参数:
+ * 输入:                                            输出:
+ * EASYRTOS_TCB *tcb_ptr  任务的TCB                 无.
+ * uint8_t priority 要设置的优先级
  *
- * : ERESULT
- * EASYRTOS_OK ɹ
- * EASYRTOS_ERR_PARAM Ĳ
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
  *
- * õĺ:
- * tcb_dequeue_entry (&tcb_readyQ, tcb_ptr);
- * tcbEnqueuePriority (&tcb_readyQ, tcb_ptr);
+ * 调用的函数:
+ * eSemMutexPrioUpdate (tcb_ptr);
  */
 ERESULT eSetTaskPriority(EASYRTOS_TCB *tcb_ptr,uint8_t priority)
 {
   CRITICAL_STORE;
   ERESULT status = EASYRTOS_OK;
-  EASYRTOS_TCB *new_tcb = NULL;
-  /* ٽ,ϵͳ */
+
+  /* 参数检查 */
+  if ((tcb_ptr == NULL)
+#if (EASYRTOS_PRIO_NUM < 256)
+      || (priority >= EASYRTOS_PRIO_NUM)
+#endif
+     )
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  /* 进入临界区,保护系统任务队列 */
+  CRITICAL_ENTER ();
+  tcb_ptr->basePriority = priority;
+
+  /* 结合互斥锁上等待的任务计算实际的优先级,并在所在的队列中重新排序 */
+  eSemMutexPrioUpdate (tcb_ptr);
+
+  /*退出临界区*/
+  CRITICAL_EXIT ();
+  return (status);
+}
+
+/**
+ * 功能: 设置任务的时间片长度,同时重新装载本次运行的剩余时间片.
+ * 
+ * 参数:
+ * 输入:                                            输出:
+ * EASYRTOS_TCB *tcb_ptr  任务的TCB                 无.
+ * uint8_t ticks 时间片长度(心跳数),0为不轮转
+ *
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ *
+ * 调用的函数:
+ * 无.
+ */
+ERESULT eTaskSetTimeSlice (EASYRTOS_TCB *tcb_ptr, uint8_t ticks)
+{
+  CRITICAL_STORE;
+
+  /* 参数检查 */
+  if (tcb_ptr == NULL)
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  CRITICAL_ENTER ();
+  tcb_ptr->timeSlice = ticks;
+  tcb_ptr->sliceLeft = ticks;
+  CRITICAL_EXIT ();
+
+  return (EASYRTOS_OK);
+}
+
+/**
+ * 功能: 当前任务主动让出CPU.若有相同或者更高优先级的任务就绪,当前任务放到
+ * 同优先级链表的末尾并切换.主动让出后时间片重新装载,下次运行时有完整的时间片.
+ * 只能在任务中调用.
+ * 
+ * 参数:
+ * 输入:                    输出:
+ * 无.                      无.
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * tcb_dequeue_priority (curr_tcb->priority);
+ * tcbEnqueueReady (curr_tcb);
+ * eTaskSwitch (curr_tcb, new_tcb);
+ */
+void eTaskYield (void)
+{
+  CRITICAL_STORE;
+  EASYRTOS_TCB *new_tcb;
+
+  /* 中断中、系统没有启动或者调度器上锁时不能切换 */
+  if ((easyRTOSStarted == FALSE) || (eCurrentContext () == NULL)
+      || (schedLockCnt != 0))
+  {
+    return;
+  }
+
+  CRITICAL_ENTER ();
+
+  /* 退还剩余的时间片 */
+  curr_tcb->sliceLeft = curr_tcb->timeSlice;
+
+  /* 相同或者更高优先级的任务可以运行 */
+  new_tcb = tcb_dequeue_priority (curr_tcb->priority);
+  if (new_tcb)
+  {
+    (void)tcbEnqueueReady (curr_tcb);
+    eTaskSwitch (curr_tcb, new_tcb);
+  }
+
+  CRITICAL_EXIT ();
+}
+
+/**
+ * 功能: 挂起任务.任务从就绪队列、悬挂队列以及定时器中移除,直到eTaskResume()
+ * 才会再次运行.正在悬挂的任务恢复后,等待的接口返回EASYRTOS_ERR_SUSPENDED;
+ * 正在延迟的任务恢复后延迟提前结束.可以挂起自己,可以在中断中调用.
+ * 
+ * 参数:
+ * 输入:                                            输出:
+ * EASYRTOS_TCB *tcb_ptr  任务的TCB                 无.
+ *
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ *
+ * 调用的函数:
+ * tcbDetach (tcb_ptr, EASYRTOS_ERR_SUSPENDED);
+ * eCurrentContext ();
+ * easyRTOSSched (FALSE);
+ */
+ERESULT eTaskSuspend (EASYRTOS_TCB *tcb_ptr)
+{
+  CRITICAL_STORE;
+
+  /* 参数检查,idleTask不能挂起 */
+  if ((tcb_ptr == NULL) || (tcb_ptr == &idleTcb) || (tcb_ptr->state == TASK_DELETED))
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  CRITICAL_ENTER ();
+
+  if (tcb_ptr->state != TASK_SUSPEND)
+  {
+    tcbDetach (tcb_ptr, EASYRTOS_ERR_SUSPENDED);
+    tcb_ptr->state = TASK_SUSPEND;
+  }
+
+  CRITICAL_EXIT ();
+
+  /**
+   * 挂起的是当前任务时切换到其他任务.
+   * 中断中由eIntExit()调用调度器.
+   */
+  if (eCurrentContext () == tcb_ptr)
+  {
+    easyRTOSSched (FALSE);
+  }
+
+  return (EASYRTOS_OK);
+}
+
+/**
+ * 功能: 恢复被挂起的任务,将其加入就绪队列.任务没有被挂起时不做任何操作.
+ * 可以在中断中调用.
+ * 
+ * 参数:
+ * 输入:                                            输出:
+ * EASYRTOS_TCB *tcb_ptr  任务的TCB                 无.
+ *
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_QUEUE 将任务加入Ready队列失败
+ *
+ * 调用的函数:
+ * tcbEnqueueReady (tcb_ptr);
+ * eCurrentContext ();
+ * easyRTOSSched (FALSE);
+ */
+ERESULT eTaskResume (EASYRTOS_TCB *tcb_ptr)
+{
+  CRITICAL_STORE;
+  ERESULT status = EASYRTOS_OK;
+
+  if (tcb_ptr == NULL)
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
   CRITICAL_ENTER ();
-  new_tcb = tcb_dequeue_entry (&tcb_readyQ, tcb_ptr);
-  tcb_ptr->priority = priority;
-  if (new_tcb!=NULL)
+
+  if (tcb_ptr->state == TASK_SUSPEND)
   {
-    status = tcbEnqueuePriority (&tcb_readyQ, tcb_ptr);
+    /* 下次运行时有完整的时间片 */
+    tcb_ptr->sliceLeft = tcb_ptr->timeSlice;
+
+    if (tcbEnqueueReady (tcb_ptr) == EASYRTOS_OK)
+    {
+      tcb_ptr->state = TASK_READY;
+    }
+    else
+    {
+      status = EASYRTOS_ERR_QUEUE;
+    }
   }
-  /*˳ٽ*/
+
   CRITICAL_EXIT ();
+
+  /* 只在任务上下文环境调用调度器,中断环境会有eIntExit()调用调度器 */
+  if ((status == EASYRTOS_OK) && eCurrentContext ())
+  {
+    easyRTOSSched (FALSE);
+  }
+
   return (status);
 }
 
 /**
- * : ϵͳʼ,һIdle Task.
+ * 功能: 删除任务.任务从就绪队列、悬挂队列以及定时器中移除,之后不会再运行,
+ * TCB可以用eTaskCreat()重新创建任务.free_flags中可以指定用eFree()释放由
+ * eMalloc()分配的堆栈和TCB.删除自己时不会返回,调度器锁随任务一起释放,
+ * 堆栈和TCB在切换出去之后由idleTask或者下一次eTaskDelete()释放.
+ * 拥有互斥锁的任务不能删除,需要先释放互斥锁.只能在任务中调用.
+ * 
+ * 参数:
+ * 输入:                                            输出:
+ * EASYRTOS_TCB *tcb_ptr  任务的TCB                 无.
+ * uint8_t free_flags EASYRTOS_FREE_STACK/EASYRTOS_FREE_TCB的组合,0为不释放
+ *
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_CONTEXT 在中断中调用
+ * EASYRTOS_ERR_MUTEX_HELD 任务仍然拥有互斥锁
+ *
+ * 调用的函数:
+ * taskReclaim ();
+ * tcbDetach (tcb_ptr, EASYRTOS_ERR_DELETED);
+ * easyRTOSSched (FALSE);
+ * eFree (tcb);
+ * eFree (stack);
+ */
+ERESULT eTaskDelete (EASYRTOS_TCB *tcb_ptr, uint8_t free_flags)
+{
+  CRITICAL_STORE;
+  uint8_t *stack = NULL;
+  uint8_t *tcb = NULL;
+#if (EASYRTOS_RUNTIME_STATS == 1)
+  EASYRTOS_TCB **list_ptr;
+#endif
+
+  /* 参数检查,idleTask不能删除 */
+  if ((tcb_ptr == NULL) || (tcb_ptr == &idleTcb) || (tcb_ptr->state == TASK_DELETED))
+  {
+    return (EASYRTOS_ERR_PARAM);
+  }
+
+  /* 释放内存不能在中断中进行 */
+  if (eCurrentContext () == NULL)
+  {
+    return (EASYRTOS_ERR_CONTEXT);
+  }
+
+  /* 等待该互斥锁的任务将永远无法获得互斥锁 */
+  if (tcb_ptr->mutex_held != NULL)
+  {
+    return (EASYRTOS_ERR_MUTEX_HELD);
+  }
+
+  /* 释放之前删除自己的任务留下的内存,该任务已经切换出去 */
+  taskReclaim ();
+
+  CRITICAL_ENTER ();
+
+  tcbDetach (tcb_ptr, EASYRTOS_ERR_DELETED);
+  tcb_ptr->state = TASK_DELETED;
+
+#if (EASYRTOS_RUNTIME_STATS == 1)
+  /* 从任务链表中移除 */
+  for (list_ptr = &taskList; *list_ptr != NULL; list_ptr = &(*list_ptr)->next_task)
+  {
+    if (*list_ptr == tcb_ptr)
+    {
+      *list_ptr = tcb_ptr->next_task;
+      break;
+    }
+  }
+#endif
+
+  if ((free_flags & EASYRTOS_FREE_TCB) != 0)
+  {
+    tcb = (uint8_t *)tcb_ptr;
+  }
+  if ((free_flags & EASYRTOS_FREE_STACK) != 0)
+  {
+    stack = (uint8_t *)tcb_ptr->stack_base;
+  }
+
+  /* 删除的是自己,切换到其他任务后不会再返回 */
+  if (tcb_ptr == curr_tcb)
+  {
+    /* 切换出去之前仍在使用TCB和堆栈,交给taskReclaim()释放 */
+    reclaimTcb = tcb;
+    reclaimStack = stack;
+
+    /* 任务持有的调度器锁随任务一起释放,被推迟的调度在这里执行 */
+    schedLockCnt = 0;
+    schedLockPending = FALSE;
+    schedLockTick = FALSE;
+
+    easyRTOSSched (FALSE);
+  }
+
+  CRITICAL_EXIT ();
+
+  /* 删除的是其他任务,该任务不在运行,可以直接释放 */
+  if (tcb != NULL)
+  {
+    eFree (tcb);
+  }
+  if (stack != NULL)
+  {
+    eFree (stack);
+  }
+
+  return (EASYRTOS_OK);
+}
+
+/**
+ * 功能: 调度器上锁,可以嵌套.上锁后当前任务不会被其他任务抢占,但不关闭中断,
+ * 中断中唤醒的任务在eSchedUnlock()解锁到最外层时才会运行.
+ * 只在任务中有效,中断中调用没有任何作用.上锁期间不能调用会阻塞任务的接口.
+ * 
+ * 参数:
+ * 输入:                    输出:
+ * 无.                      无.
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * eCurrentContext ();
+ */
+void eSchedLock (void)
+{
+  CRITICAL_STORE;
+
+  /* 中断中不会发生任务切换,不需要上锁 */
+  if (eCurrentContext () == NULL)
+  {
+    return;
+  }
+
+  CRITICAL_ENTER ();
+  schedLockCnt++;
+  CRITICAL_EXIT ();
+}
+
+/**
+ * 功能: 调度器解锁,与eSchedLock()成对调用.解锁到最外层时,若上锁期间有被推迟
+ * 的调度则立刻调用调度器.
+ * 
+ * 参数:
+ * 输入:                    输出:
+ * 无.                      无.
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * eCurrentContext ();
+ * easyRTOSSched (tick);
+ */
+void eSchedUnlock (void)
+{
+  CRITICAL_STORE;
+  uint8_t pending = FALSE;
+  uint8_t tick = FALSE;
+
+  if (eCurrentContext () == NULL)
+  {
+    return;
+  }
+
+  CRITICAL_ENTER ();
+  if (schedLockCnt > 0)
+  {
+    schedLockCnt--;
+    if ((schedLockCnt == 0) && (schedLockPending == TRUE))
+    {
+      pending = TRUE;
+      tick = schedLockTick;
+      schedLockPending = FALSE;
+      schedLockTick = FALSE;
+    }
+  }
+  CRITICAL_EXIT ();
+
+  /* 执行被推迟的调度 */
+  if (pending == TRUE)
+  {
+    easyRTOSSched (tick);
+  }
+}
+
+/**
+ * 功能: 系统初始化,创建一个Idle Task.
  * 
- * :
- * :                                            :
- * void *idle_task_stack  ջλ          .
- * uint32_t idleTaskStackSize ջС
+ * 参数:
+ * 输入:                                            输出:
+ * void *idle_task_stack  空闲任务堆栈位置          无.
+ * uint32_t idleTaskStackSize 空闲任务堆栈大小
  *
- * : ERESULT
- * EASYRTOS_OK ɹ
- * EASYRTOS_ERR_PARAM Ĳ
- * EASYRTOS_ERR_QUEUE Readyʧ
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ * EASYRTOS_ERR_QUEUE 将任务加入Ready队列失败
  *
- * õĺ:
- * eTaskCreat(&idleTcb,255,idleTask,0,idle_task_stack,idleTaskStackSize,"IDLE",0);
+ * 调用的函数:
+ * archInitIrqLevel ();
+ * archIsrStackInit ();
+ * eTaskCreat(&idleTcb,EASYRTOS_IDLE_PRIO,idleTask,0,idle_task_stack,idleTaskStackSize,"IDLE",0);
  */
 ERESULT easyRTOSInit (void *idle_task_stack, uint32_t idleTaskStackSize)
 {
     ERESULT status;
+    uint16_t i;
 
-    /* ʼ */
+    /* 初始化数据 */
     curr_tcb = NULL;
-    tcb_readyQ = NULL;
+    for (i = 0; i < EASYRTOS_PRIO_NUM; i++)
+    {
+      tcb_readyQ[i] = NULL;
+    }
+    for (i = 0; i < EASYRTOS_PRIO_GRP; i++)
+    {
+      readyTable[i] = 0;
+    }
+    readyGroup = 0;
     easyRTOSStarted = FALSE;
+#if (EASYRTOS_RUNTIME_STATS == 1)
+    taskList = NULL;
+    runTimeTotal = 0;
+    isrRunTime = 0;
+#endif
+
+    /* 调用内核接口的中断设置为内核优先级 */
+    archInitIrqLevel ();
+    archIsrStackInit ();
+
+#if (EASYRTOS_TRACE == 1)
+    eTraceInit ();
+#endif
 
-    /*  */
+#if (EASYRTOS_LATENCY_HIST == 1)
+    eLatencyInit ();
+#endif
+
+    /* 创建空任务 */
     status = eTaskCreat(&idleTcb,
-                 255,
+                 EASYRTOS_IDLE_PRIO,
                  idleTask,
                  0,
                  idle_task_stack,
@@ -214,57 +769,69 @@ ERESULT easyRTOSInit (void *idle_task_stack, uint32_t idleTaskStackSize)
 }
 
 /**
- * : ϵͳ,ȼߵ
+ * 功能: 系统启动,启动优先级最高的任务
  * 
- * :
- * :                    :
- * .                      .
+ * 参数:
+ * 输入:                    输出:
+ * 无.                      无.
  * 
- * : void
+ * 返回: void
  *
- * õĺ:
- * tcb_dequeue_priority (&tcb_readyQ, 255);
+ * 调用的函数:
+ * archRunTimeInit ();
+ * tcb_dequeue_priority (EASYRTOS_IDLE_PRIO);
  * archFirstTaskRestore (new_tcb);
  */
 void easyRTOSStart (void)
 {
     EASYRTOS_TCB *new_tcb;
 
-    /* λϵͳ־λ,־λӰeTaskCreate(),ʹøú */
+#if (EASYRTOS_RUNTIME_STATS == 1)
+    /* 启动运行时间计数器,从第一个任务开始统计 */
+    archRunTimeInit ();
+    runTimeLast = archRunTimeGet ();
+#endif
+
+    /* 置位系统启动标志位,这个标志位会影响eTaskCreate(),使得该函数不会启动调度器 */
     easyRTOSStarted = TRUE;
 
-    /* ȡȼߵTCB,.ûдκȼ͵Ŀ */
-    new_tcb = tcb_dequeue_priority (&tcb_readyQ, 255);
+    /* 取出优先级最高的TCB,并启动调度器.若没有创建任何任务则会启动优先级最低的空任务 */
+    new_tcb = tcb_dequeue_priority (EASYRTOS_IDLE_PRIO);
     if (new_tcb)
     {
       curr_tcb = new_tcb;
 			new_tcb->state = TASK_RUN;
-      /* ָеһ */
+      TRACE_EVENT (TRACE_TASK_SWITCH, new_tcb->taskID, new_tcb, 0xFF00 | new_tcb->priority);
+      /* 恢复并运行第一个任务 */
       archFirstTaskRestore (new_tcb);
 
     }
     else
     {
-      /* ûҵе */
+      /* 没找到可以运行的任务 */
     }
 }
 
 /**
- * : .
- * 1.false:Ready״̬Run,ֻȼڵǰĲռ
- * 2.true:Ready״̬Run,ͬ߸ȼĿռǰ
+ * 功能: 启动调度器.
+ * 1.参数false:在所有Ready状态和Run的任务中,只有优先级高于当前任务的才能抢占
+ * 2.参数true:心跳中断调用,减少当前任务的时间片,时间片用完时相同或者高优先级
+ * 的任务可以抢占当前任务,否则只有更高优先级的任务可以抢占
+ * 被更高优先级抢占的任务保留剩余的时间片,阻塞的任务重新装载时间片.
+ * 当前任务仍在运行且没有调度请求时直接返回,心跳中断中只减少时间片.
+ * 调度器上锁时只记录调度请求,解锁时再调度;当前任务阻塞时仍然会切换.
  *
- * :
- * :                                            :
- * uint8_t timer_tick  ʱжϵ               .
+ * 参数:
+ * 输入:                                            输出:
+ * uint8_t timer_tick  定时器中断调用               无.
  *
- * : void
+ * 返回: void
  * 
- * õĺ:
- * tcb_dequeue_head (&tcb_readyQ);
+ * 调用的函数:
+ * tcb_dequeue_priority (EASYRTOS_IDLE_PRIO);
  * eTaskSwitch (curr_tcb, new_tcb);
- * tcb_dequeue_priority (&tcb_readyQ, (uint8_t)lowest_pri);
- * tcbEnqueuePriority (&tcb_readyQ, curr_tcb);
+ * tcb_dequeue_priority ((uint8_t)lowest_pri);
+ * tcbEnqueueReady (curr_tcb);
  */
 void easyRTOSSched (uint8_t timer_tick)
 {
@@ -272,112 +839,181 @@ void easyRTOSSched (uint8_t timer_tick)
     EASYRTOS_TCB *new_tcb = NULL;
     int16_t lowest_pri;
 
-    /* RTOSǷ */
+    /* 检测RTOS是否开启 */
     if (easyRTOSStarted == FALSE)
     {
       return;
     }
 
-    /* ٽ */
+#if (EASYRTOS_ISR_STACK_SIZE > 0)
+    /**
+     * 嵌套的中断运行在中断堆栈上,不能在这里保存任务的栈指针.
+     * 只在最外层中断退出时切换任务,调度请求保留到那时处理.
+     */
+    if (easyITCnt != 0)
+    {
+      return;
+    }
+#endif
+
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+    /* 唤醒中断中不切换任务,由idleTask补偿系统时间后再调度 */
+    if (ticklessSleeping == TRUE)
+    {
+      return;
+    }
+#endif
+
+    /* 调度器上锁,推迟到解锁时调度.时间片最多减到1,由解锁时的调度用完 */
+    if ((schedLockCnt != 0) && (curr_tcb->state == TASK_RUN))
+    {
+      if ((timer_tick == TRUE) && (curr_tcb->timeSlice != 0))
+      {
+        if (curr_tcb->sliceLeft > 1)
+        {
+          curr_tcb->sliceLeft--;
+        }
+        else
+        {
+          schedLockTick = TRUE;
+        }
+      }
+      schedLockPending = TRUE;
+      return;
+    }
+
+#if (EASYRTOS_RESCHED_FLAG == 1)
+    /* 没有任务状态变化,不需要调度 */
+    if ((reschedPending == FALSE) && (curr_tcb->state == TASK_RUN))
+    {
+      if (timer_tick == FALSE)
+      {
+        return;
+      }
+
+      /* 心跳中断中,时间片没有用完则只减少时间片 */
+      if (curr_tcb->timeSlice == 0)
+      {
+        return;
+      }
+      if (curr_tcb->sliceLeft > 1)
+      {
+        curr_tcb->sliceLeft--;
+        return;
+      }
+    }
+#endif
+
+    /* 进入临界区 */
     CRITICAL_ENTER();
 
+#if (EASYRTOS_RESCHED_FLAG == 1)
+    /* 处理调度请求 */
+    reschedPending = FALSE;
+#endif
+
     if (curr_tcb->state != TASK_RUN)
     {
-      /* Ѿȡһ.бȻidleTask */
-      new_tcb = tcb_dequeue_head (&tcb_readyQ);
+      /* 任务主动阻塞,下次运行时有完整的时间片 */
+      curr_tcb->sliceLeft = curr_tcb->timeSlice;
 
-      /* л */
+      /* 从已经就绪的任务队列中取出一个.队列中必然有idleTask */
+      new_tcb = tcb_dequeue_priority (EASYRTOS_IDLE_PRIO);
+
+      /* 切换成新任务 */
       eTaskSwitch (curr_tcb, new_tcb);
     }
 
-    /* ȻΪ̬,ǷѾ,Ҫ */
+    /* 若任务仍然为运行态,则检查是否有其他任务已经就绪,并需要运行 */
     else
     {
-      /* ȵȼ */
-      if (timer_tick == TRUE)
+      /* 计算允许调度的优先级 */
+      if ((timer_tick == TRUE) && (curr_tcb->timeSlice != 0)
+          && (--curr_tcb->sliceLeft == 0))
       {
-        /* ͬ߸ȼռ */
+        /* 时间片用完,重新装载,相同或者更高优先级的任务可以抢占 */
+        curr_tcb->sliceLeft = curr_tcb->timeSlice;
         lowest_pri = (int16_t)curr_tcb->priority;
       }
       else if (curr_tcb->priority > 0)
       {
-        /* ֻиߵȼռCPU,ȼΪ0 */
+        /* 只有更高的优先级才能抢占CPU,最高优先级为0 */
         lowest_pri = (int16_t)(curr_tcb->priority - 1);
       }
       else
       {
-        /* ĿǰȼѾ,κ߳ռ */
+        /* 目前的优先级已经最高了,不允许任何线程抢占 */
         lowest_pri = -1;
       }
 
-      /* Ƿе */
+      /* 检查是否进行调度 */
       if (lowest_pri >= 0)
       {
-        /* Ƿвڸȼ */
-        new_tcb = tcb_dequeue_priority (&tcb_readyQ, (uint8_t)lowest_pri);
+        /* 检查是否有不低于给出优先级的任务 */
+        new_tcb = tcb_dequeue_priority ((uint8_t)lowest_pri);
 
-        /* ҵӦ,֮ */
+        /* 若找到对应任务,运行之 */
         if (new_tcb)
         {
-          /* е */
-          if (tcbEnqueuePriority (&tcb_readyQ, curr_tcb) == EASYRTOS_OK)
+          /* 将现在运行的任务加入就绪队列 */
+          if (tcbEnqueueReady (curr_tcb) == EASYRTOS_OK)
           {
             curr_tcb->state = TASK_READY;
           }
-          /* л */
+          /* 切换到新任务 */
           eTaskSwitch (curr_tcb, new_tcb);
         }
       }
     }
 
-    /* ˳ٽ */
+    /* 退出临界区 */
     CRITICAL_EXIT ();
 }
 
 /**
- * : ȼTCBб
+ * 功能: 按任务优先级将任务TCB加入列表
  * 
- * :
- * :                                           :
- * EASYRTOS_TCB **tcb_queue_ptr Ķ       EASYRTOS_TCB **tcb_queue_ptr Ķ
- * EASYRTOS_TCB *tcb_ptr ҪTCB
+ * 参数:
+ * 输入:                                           输出:
+ * EASYRTOS_TCB **tcb_queue_ptr 被加入的队列       EASYRTOS_TCB **tcb_queue_ptr 被加入的队列
+ * EASYRTOS_TCB *tcb_ptr 要加入的任务TCB
  *
- * : ERESULT
- * EASYRTOS_OK ɹ
- * EASYRTOS_ERR_PARAM Ĳ
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
  *
- * õĺ:
- * .
+ * 调用的函数:
+ * 无.
  */
 ERESULT tcbEnqueuePriority (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr)
 {
     ERESULT status;
     EASYRTOS_TCB *prev_ptr, *next_ptr;
 
-    /*  */
+    /* 参数检查 */
     if ((tcb_queue_ptr == NULL) || (tcb_ptr == NULL))
     {
       
-      /* ش */
+      /* 返回错误 */
       status = EASYRTOS_ERR_PARAM;
     }
     else
     {
       
-      /*  */
+      /* 搜索整个队列 */
       prev_ptr = next_ptr = *tcb_queue_ptr;
       do
       {
         
         /** 
-         *  :
-         *   next_ptr = NULL (Ѿеĩβ.)
-         *   һTCBȼҪTCBȼ.
+         *  插入条件:
+         *   next_ptr = NULL (已经到队列的末尾了.)
+         *   下一个TCB的优先级比要插入的TCB优先级低.
          */
         if ((next_ptr == NULL) || (next_ptr->priority > tcb_ptr->priority))
         {
           
-          /* ȼΪ,򽫸TCBΪеͷ */
+          /* 若优先级为队列最高,则将该TCB作为队列的头 */
           if (next_ptr == *tcb_queue_ptr)
           {
             *tcb_queue_ptr = tcb_ptr;
@@ -387,7 +1023,7 @@ ERESULT tcbEnqueuePriority (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr)
                 next_ptr->prev_tcb = tcb_ptr;
           }
           
-          /* ڶвTCBĩβ */
+          /* 在队列中插入TCB或者在末尾插入 */
           else
           {
             tcb_ptr->prev_tcb = prev_ptr;
@@ -397,12 +1033,12 @@ ERESULT tcbEnqueuePriority (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr)
                 next_ptr->prev_tcb = tcb_ptr;
           }
 
-          /* ɲ,˳ѭ */
+          /* 完成插入,退出循环 */
           break;
         }
         else
         {
-          /* λò,һλ */
+          /* 插入位置不对,尝试下一个位置 */
           prev_ptr = next_ptr;
           next_ptr = next_ptr->next_tcb;
         }
@@ -410,62 +1046,138 @@ ERESULT tcbEnqueuePriority (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr)
       }
       while (prev_ptr != NULL);
 
-      /* ɹ */
+      /* 成功 */
       status = EASYRTOS_OK;
     }
     return (status);
 }
 
 /**
- * : ȡǰеTCB
+ * 功能: 将任务TCB加入就绪队列,放在同优先级链表的末尾,并置位优先级位图.
  * 
- * :
- * :                     :
- *                         .
+ * 参数:
+ * 输入:                                           输出:
+ * EASYRTOS_TCB *tcb_ptr 要加入就绪队列的TCB        无.
  *
- * : EASYRTOS_TCB*
- * ǰTCBָ
- *  
- * õĺ:
- * .
+ * 返回: ERESULT
+ * EASYRTOS_OK 成功
+ * EASYRTOS_ERR_PARAM 错误的参数
+ *
+ * 调用的函数:
+ * 无.
  */
-EASYRTOS_TCB *eCurrentContext (void)
+ERESULT tcbEnqueueReady (EASYRTOS_TCB *tcb_ptr)
 {
-    if (easyITCnt == 0)
-        return (curr_tcb);
-    else
-        return (NULL);
-}
+    ERESULT status;
+    EASYRTOS_TCB *head_ptr;
+    uint8_t prio;
+
+    /* 参数检查 */
+    if (tcb_ptr == NULL)
+    {
+      status = EASYRTOS_ERR_PARAM;
+    }
+    else
+    {
+      prio = tcb_ptr->priority;
+      head_ptr = tcb_readyQ[prio];
+
+      /* 该优先级链表为空,TCB成为链表头,并置位位图 */
+      if (head_ptr == NULL)
+      {
+        tcb_ptr->prev_tcb = tcb_ptr;
+        tcb_ptr->next_tcb = tcb_ptr;
+        tcb_readyQ[prio] = tcb_ptr;
+        readyTable[prio >> 4] |= readyMapTbl[prio & 0x0F];
+        readyGroup |= readyMapTbl[prio >> 4];
+      }
+
+      /* 插入到链表尾,即链表头的前面 */
+      else
+      {
+        tcb_ptr->prev_tcb = head_ptr->prev_tcb;
+        tcb_ptr->next_tcb = head_ptr;
+        head_ptr->prev_tcb->next_tcb = tcb_ptr;
+        head_ptr->prev_tcb = tcb_ptr;
+      }
+
+      tcb_ptr->state = TASK_READY;
+
+      /* 被抢占的当前任务在eTaskSwitch()中记录 */
+      if (tcb_ptr != curr_tcb)
+      {
+        TRACE_EVENT (TRACE_TASK_READY, tcb_ptr->taskID, tcb_ptr, prio);
+      }
+
+#if (EASYRTOS_RESCHED_FLAG == 1)
+      /* 就绪的任务可以抢占当前任务,请求调度.被抢占的当前任务重新入队时不需要 */
+      if ((curr_tcb == NULL)
+          || ((tcb_ptr != curr_tcb) && (tcb_ptr->priority <= curr_tcb->priority)))
+      {
+        reschedPending = TRUE;
+      }
+#endif
+
+      /* 任务已就绪,不再悬挂在任何队列上 */
+      tcb_ptr->pended_q = NULL;
+      tcb_ptr->pended_mutex = NULL;
+
+      /* 成功 */
+      status = EASYRTOS_OK;
+    }
+    return (status);
+}
 
 /**
- * : ȡбͷTCB
+ * 功能: 获取当前运行的任务TCB
  * 
- * :
- * :                                           :
- * EASYRTOS_TCB **tcb_queue_ptr ȡб         EASYRTOS_TCB **tcb_queue_ptr ȡб
+ * 参数:
+ * 输入:                     输出:
+ * 无                        无.
  *
- * : EASYRTOS_TCB *
- * бͷTCBָ
+ * 返回: EASYRTOS_TCB*
+ * 当前运行任务TCB指针
+ *  
+ * 调用的函数:
+ * 无.
+ */
+EASYRTOS_TCB *eCurrentContext (void)
+{
+    if (easyITCnt == 0)
+        return (curr_tcb);
+    else
+        return (NULL);
+}
+
+/**
+ * 功能: 取出列表头的任务TCB
+ * 
+ * 参数:
+ * 输入:                                           输出:
+ * EASYRTOS_TCB **tcb_queue_ptr 被取的列表         EASYRTOS_TCB **tcb_queue_ptr 被取的列表
  *
- * õĺ:
- * .
+ * 返回: EASYRTOS_TCB *
+ * 返回列表头的任务TCB指针
+ *
+ * 调用的函数:
+ * 无.
  */
 EASYRTOS_TCB *tcb_dequeue_head (EASYRTOS_TCB **tcb_queue_ptr)
 {
     EASYRTOS_TCB *ret_ptr;
 
-    /*  */
+    /* 参数检查 */
     if (tcb_queue_ptr == NULL)
     {
-        /* NULL */
+        /* 返回NULL */
         ret_ptr = NULL;
     }
     else if (*tcb_queue_ptr == NULL)
     {
-        /* NULL */
+        /* 返回NULL */
         ret_ptr = NULL;
     }
-    /* ضͷ,Ƴ */
+    /* 返回队列头,并将其移除队列 */
     else
     {
         ret_ptr = *tcb_queue_ptr;
@@ -478,35 +1190,35 @@ EASYRTOS_TCB *tcb_dequeue_head (EASYRTOS_TCB **tcb_queue_ptr)
 }
 
 /**
- * : бƳָTCB
+ * 功能: 从列表中移除指定的任务TCB
  * 
- * :
- * :                                           :
- * EASYRTOS_TCB **tcb_queue_ptr ȡб         EASYRTOS_TCB **tcb_queue_ptr ȡб 
- * EASYRTOS_TCB *tcb_ptr ҪƳTCB
+ * 参数:
+ * 输入:                                           输出:
+ * EASYRTOS_TCB **tcb_queue_ptr 被取的列表         EASYRTOS_TCB **tcb_queue_ptr 被取的列表 
+ * EASYRTOS_TCB *tcb_ptr 需要移除的任务TCB
  * 
- * : EASYRTOS_TCB *
- * ƳTCBָ
+ * 返回: EASYRTOS_TCB *
+ * 返回移除的TCB指针
  *
- * õĺ:
- * .
+ * 调用的函数:
+ * 无.
  */
 EASYRTOS_TCB *tcb_dequeue_entry (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr)
 {
     EASYRTOS_TCB *ret_ptr, *prev_ptr, *next_ptr;
 
-    /*  */
+    /* 参数检查 */
     if (tcb_queue_ptr == NULL)
     {
-        /* NULL */
+        /* 返回NULL */
         ret_ptr = NULL;
     }
     else if (*tcb_queue_ptr == NULL)
     {
-        /* NULL */
+        /* 返回NULL */
         ret_ptr = NULL;
     }
-    /* ҵ,Ƴָtcb */
+    /* 找到,移除并返回指定的tcb */
     else
     {
         ret_ptr = NULL;
@@ -514,20 +1226,20 @@ EASYRTOS_TCB *tcb_dequeue_entry (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb
         while (next_ptr)
         {
           
-            /* ǷTCB? */
+            /* 是否是我们搜索的TCB? */
             if (next_ptr == tcb_ptr)
             {
               
-                /* ѰҵTCBΪͷ */
+                /* 寻找的TCB为队列头 */
                 if (next_ptr == *tcb_queue_ptr)
                 {
-                    /* Ƴͷ */
+                    /* 移除队列头 */
                     *tcb_queue_ptr = next_ptr->next_tcb;
                     if (*tcb_queue_ptr)
                         (*tcb_queue_ptr)->prev_tcb = NULL;
                 }
                 
-                /* ѰҵTCBڶмĩβ.*/
+                /* 寻找的TCB在队列中间或末尾.*/
                 else
                 {
                     prev_ptr->next_tcb = next_ptr->next_tcb;
@@ -539,7 +1251,7 @@ EASYRTOS_TCB *tcb_dequeue_entry (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb
                 break;
             }
 
-            /* ƶеһTCB */
+            /* 移动到队列中的下一个TCB */
             prev_ptr = next_ptr;
             next_ptr = next_ptr->next_tcb;
         }
@@ -548,139 +1260,696 @@ EASYRTOS_TCB *tcb_dequeue_entry (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb
 }
 
 /**
- * : бȡȼpriorityTCB,ֻһ
+ * 功能: 从就绪队列中移除指定的任务TCB,若该优先级链表被取空则清除位图.
  * 
- * :
- * :                                           :
- * EASYRTOS_TCB **tcb_queue_ptr ȡб         .
- * uint8_t priority
+ * 参数:
+ * 输入:                                           输出:
+ * EASYRTOS_TCB *tcb_ptr 需要移除的任务TCB          无.
  * 
- * : EASYRTOS_TCB *
- * ƳTCBָ
+ * 返回: EASYRTOS_TCB *
+ * 返回移出的TCB指针,任务不在就绪队列中则返回NULL
  *
- * õĺ:
- * .
+ * 调用的函数:
+ * 无.
  */
-EASYRTOS_TCB *tcb_dequeue_priority (EASYRTOS_TCB **tcb_queue_ptr, uint8_t priority)
+EASYRTOS_TCB *tcb_dequeue_ready (EASYRTOS_TCB *tcb_ptr)
 {
     EASYRTOS_TCB *ret_ptr;
+    uint8_t prio;
 
-    /*  */
-    if (tcb_queue_ptr == NULL)
+    /* 参数检查,只有就绪状态且在链表中的任务才可以移除 */
+    if ((tcb_ptr == NULL) || (tcb_ptr->state != TASK_READY) || (tcb_ptr->next_tcb == NULL))
     {
-      ret_ptr = NULL;
+        ret_ptr = NULL;
     }
-    else if (*tcb_queue_ptr == NULL)
+    else
+    {
+        prio = tcb_ptr->priority;
+
+        /* 该优先级只有这一个任务,清空链表及位图 */
+        if (tcb_ptr->next_tcb == tcb_ptr)
+        {
+            tcb_readyQ[prio] = NULL;
+            readyTable[prio >> 4] &= (uint16_t)~readyMapTbl[prio & 0x0F];
+            if (readyTable[prio >> 4] == 0)
+            {
+                readyGroup &= (uint16_t)~readyMapTbl[prio >> 4];
+            }
+        }
+        else
+        {
+            tcb_ptr->prev_tcb->next_tcb = tcb_ptr->next_tcb;
+            tcb_ptr->next_tcb->prev_tcb = tcb_ptr->prev_tcb;
+            if (tcb_readyQ[prio] == tcb_ptr)
+            {
+                tcb_readyQ[prio] = tcb_ptr->next_tcb;
+            }
+        }
+        ret_ptr = tcb_ptr;
+        ret_ptr->prev_tcb = ret_ptr->next_tcb = NULL;
+    }
+    return (ret_ptr);
+}
+
+/**
+ * 功能: 从就绪队列中取出优先级最高的任务TCB,该任务的优先级需高于或等于priority.
+ * 通过两级位图查表找到最高优先级,与就绪任务的数量无关.
+ * 
+ * 参数:
+ * 输入:                                           输出:
+ * uint8_t priority 可接受的最低优先级             无.
+ * 
+ * 返回: EASYRTOS_TCB *
+ * 返回移出的TCB指针,没有满足条件的任务则返回NULL
+ *
+ * 调用的函数:
+ * tcb_dequeue_ready (tcb_readyQ[top_prio]);
+ */
+EASYRTOS_TCB *tcb_dequeue_priority (uint8_t priority)
+{
+    EASYRTOS_TCB *ret_ptr;
+    uint8_t grp;
+    uint8_t top_prio;
+
+    /* 就绪队列为空 */
+    if (readyGroup == 0)
     {
       ret_ptr = NULL;
     }
-    
-    /* Ƿкȼ */
-    else if ((*tcb_queue_ptr)->priority <= priority)
+    else
     {
-      ret_ptr = *tcb_queue_ptr;
-      *tcb_queue_ptr = (*tcb_queue_ptr)->next_tcb;
-      if (*tcb_queue_ptr)
+      /* 查表得到最高的就绪优先级 */
+      grp = READY_UNMAP16(readyGroup);
+      top_prio = (uint8_t)((grp << 4) + READY_UNMAP16(readyTable[grp]));
+
+      /* 检查是否有合适优先级的任务 */
+      if (top_prio <= priority)
       {
-        (*tcb_queue_ptr)->prev_tcb = NULL;
-        ret_ptr->next_tcb = NULL;
+        /* 取出该优先级链表的头,同优先级任务先进先出 */
+        ret_ptr = tcb_dequeue_ready (tcb_readyQ[top_prio]);
       }
+      else
+      {
+        /* 没有合适任务  */
+        ret_ptr = NULL;
+      }
+    }
+    return (ret_ptr);
+}
+
+/**
+ * 功能: 修改任务的实际运行优先级,并在任务所在的队列中重新排序.就绪的任务
+ * 重新加入就绪队列,悬挂的任务在其悬挂队列中重新按优先级插入.需要在临界区
+ * 中调用.
+ * 
+ * 参数:
+ * 输入:                                           输出:
+ * EASYRTOS_TCB *tcb_ptr 任务TCB                   无.
+ * uint8_t priority 新的优先级
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * tcb_dequeue_ready (tcb_ptr);
+ * tcbEnqueueReady (tcb_ptr);
+ * tcb_dequeue_entry (tcb_ptr->pended_q, tcb_ptr);
+ * tcbEnqueuePriority (tcb_ptr->pended_q, tcb_ptr);
+ */
+void tcbSetPriority (EASYRTOS_TCB *tcb_ptr, uint8_t priority)
+{
+    if ((tcb_ptr->state == TASK_READY) && (tcb_dequeue_ready (tcb_ptr) != NULL))
+    {
+      /* 在就绪队列中,移到新优先级的链表尾 */
+      tcb_ptr->priority = priority;
+      (void)tcbEnqueueReady (tcb_ptr);
+    }
+    else if ((tcb_ptr->state == TASK_PENDED) && (tcb_ptr->pended_q != NULL)
+             && (tcb_dequeue_entry (tcb_ptr->pended_q, tcb_ptr) != NULL))
+    {
+      /* 在悬挂队列中,按新优先级重新插入 */
+      tcb_ptr->priority = priority;
+      (void)tcbEnqueuePriority (tcb_ptr->pended_q, tcb_ptr);
     }
     else
     {
-      /* ûк  */      
-      ret_ptr = NULL;
+      /* 正在运行或者延迟,直接修改 */
+      tcb_ptr->priority = priority;
+
+#if (EASYRTOS_RESCHED_FLAG == 1)
+      /* 当前任务的优先级改变,可能有就绪任务的优先级比它更高了 */
+      if (tcb_ptr == curr_tcb)
+      {
+        reschedPending = TRUE;
+      }
+#endif
     }
-    return (ret_ptr);
 }
 
 /**
- * : л2
+ * 功能: 将任务从所在的就绪队列或者悬挂队列中移除,并取消注册的定时器.悬挂的
+ * 任务返回wake_status,若在等待互斥锁,重新计算互斥锁拥有者的优先级.
+ * 需要在临界区中调用.
  * 
- * :
- * :                                           :
- * EASYRTOS_TCB *old_tcb л              .
- * EASYRTOS_TCB *new_tcb л
+ * 参数:
+ * 输入:                                           输出:
+ * EASYRTOS_TCB *tcb_ptr 任务TCB                   无.
+ * ERESULT wake_status 悬挂的任务返回的状态
  * 
- * : void
+ * 返回: void
  *
- * õĺ:
+ * 调用的函数:
+ * tcb_dequeue_ready (tcb_ptr);
+ * tcb_dequeue_entry (tcb_ptr->pended_q, tcb_ptr);
+ * eTimerCancel (tcb_ptr->pended_timo_cb);
+ * eTimerCancel (tcb_ptr->delay_timo_cb);
+ * eSemMutexPrioUpdate (mutex->owner);
+ */
+static void tcbDetach (EASYRTOS_TCB *tcb_ptr, ERESULT wake_status)
+{
+    EASYRTOS_SEM *mutex;
+
+    switch (tcb_ptr->state)
+    {
+      case TASK_READY:
+        (void)tcb_dequeue_ready (tcb_ptr);
+        break;
+
+      case TASK_PENDED:
+        if (tcb_ptr->pended_q != NULL)
+        {
+          (void)tcb_dequeue_entry (tcb_ptr->pended_q, tcb_ptr);
+        }
+        if (tcb_ptr->pended_timo_cb != NULL)
+        {
+          (void)eTimerCancel (tcb_ptr->pended_timo_cb);
+          tcb_ptr->pended_timo_cb = NULL;
+        }
+        tcb_ptr->pendedWakeStatus = wake_status;
+
+        mutex = tcb_ptr->pended_mutex;
+        tcb_ptr->pended_q = NULL;
+        tcb_ptr->pended_mutex = NULL;
+
+        /* 互斥锁的拥有者不再继承该任务的优先级 */
+        if (mutex != NULL)
+        {
+          eSemMutexPrioUpdate (mutex->owner);
+        }
+        break;
+
+      case TASK_DELAY:
+        if (tcb_ptr->delay_timo_cb != NULL)
+        {
+          (void)eTimerCancel (tcb_ptr->delay_timo_cb);
+          tcb_ptr->delay_timo_cb = NULL;
+        }
+        break;
+
+      default:
+        /* 正在运行或者已经挂起,不在任何队列中 */
+        break;
+    }
+}
+
+/**
+ * 功能: 切换2个任务上下文
+ * 
+ * 参数:
+ * 输入:                                           输出:
+ * EASYRTOS_TCB *old_tcb 被切换的任务              无.
+ * EASYRTOS_TCB *new_tcb 切换到的任务
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * eRunTimeCharge (&old_tcb->taskRunTime);
  * archContextSwitch (old_tcb, new_tcb);
+ * eLatencySwitchIn ();
  */
 static void eTaskSwitch(EASYRTOS_TCB *old_tcb, EASYRTOS_TCB *new_tcb)
 {
     
-    /* еĳлµ,Խ״̬лRUN */
+    /* 运行的程序将切换到新的任务,所以将任务状态切换到RUN */
     new_tcb->state = TASK_RUN;
 
-    /* µǷĿǰе,,Ҫл */
+    /* 检查新的任务是否是目前运行的任务,如果是,则不需要进行切换 */
     if (old_tcb != new_tcb)
     {
+#if (EASYRTOS_RUNTIME_STATS == 1)
+        /* 结算被切换任务的运行时间 */
+        eRunTimeCharge (&old_tcb->taskRunTime);
+#endif
+
         curr_tcb = new_tcb;
 
-        /* л */
+        /* 被抢占的任务仍然就绪,解析工具从此时开始计算其响应时间 */
+        if (old_tcb->state == TASK_READY)
+        {
+          TRACE_EVENT (TRACE_TASK_READY, old_tcb->taskID, old_tcb, old_tcb->priority);
+        }
+        TRACE_EVENT (TRACE_TASK_SWITCH, new_tcb->taskID, new_tcb,
+                     ((uint16_t)old_tcb->taskID << 8) | new_tcb->priority);
+
+        /* 调用任务切换函数 */
         archContextSwitch (old_tcb, new_tcb);
+
+        /* 此处已经是恢复运行的任务,记录中断到达后的调度延迟 */
+        LATENCY_SWITCH_IN ();
     }
 }
 
 /**
- * : жϵ,˵ж
+ * 功能: 进入中断调用,说明上下文在中断中
  * 
- * :
- * :                :             
- * .                  .
+ * 参数:
+ * 输入:                输出:             
+ * 无.                  无.
  * 
- * : void
+ * 返回: void
  *
- * õĺ:
- * .
+ * 调用的函数:
+ * eRunTimeCharge (&curr_tcb->taskRunTime);
+ * eLatencyIntEnter ();
  */
 void eIntEnter (void)
 {
-    /* жϼ */
+#if (EASYRTOS_RUNTIME_STATS == 1)
+    /* 进入最外层中断,结算被中断任务的运行时间 */
+    if ((easyITCnt == 0) && (curr_tcb != NULL))
+    {
+      eRunTimeCharge (&curr_tcb->taskRunTime);
+    }
+#endif
+
+    /* 增加中断计数 */
     easyITCnt++;
+
+    TRACE_EVENT (TRACE_INT_ENTER, easyITCnt, 0, 0);
+
+    LATENCY_INT_ENTER ();
 }
 
 /**
- * : ˳жϵ,֮õ
+ * 功能: 退出中断调用,之后调用调度器
  * 
- * :
- * :                :             
- * uint8_t timerTick    .
+ * 参数:
+ * 输入:                输出:             
+ * uint8_t timerTick    无.
  * 
- * : void
+ * 返回: void
  *
- * õĺ:
+ * 调用的函数:
+ * eRunTimeCharge (&isrRunTime);
+ * eLatencyIntExit (easyITCnt);
  * easyRTOSSched (timerTick);
+ * eLatencySchedDone ();
  */
 void eIntExit (uint8_t timerTick)
 {
-    /* ˳жʱ */
+    /* 退出中断时减少 */
     easyITCnt--;
 
-    /* ˳жʱõ */
+    TRACE_EVENT (TRACE_INT_EXIT, easyITCnt, 0, 0);
+
+#if (EASYRTOS_RUNTIME_STATS == 1)
+    /* 退出最外层中断,结算中断占用的时间 */
+    if (easyITCnt == 0)
+    {
+      eRunTimeCharge (&isrRunTime);
+    }
+#endif
+
+    /* 退出中断时调用调度器,发生切换时由恢复运行的任务记录调度延迟 */
+    LATENCY_INT_EXIT (easyITCnt);
     easyRTOSSched (timerTick);
+    LATENCY_SCHED_DONE ();
 }
 
 /**
- * : idleTask
+ * 功能: idleTask任务
  * 
- * :
- * :                :             
- * uint32_t param       .
+ * 参数:
+ * 输入:                输出:             
+ * uint32_t param       无.
  * 
- * : void
+ * 返回: void
  *
- * õĺ:
- * 
+ * 调用的函数:
+ * taskReclaim ();
+ * idleTickless ();
+ * ARCH_IDLE ();
  */
 static void idleTask (uint32_t param)
 {
-  /*  */
+  /* 消除编译器警告 */
   param = param;
 
   while (1)
   {
-     /* պִ */
+     /* 释放删除自己的任务留下的TCB和堆栈 */
+     taskReclaim ();
+
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+     /* 没有其他任务就绪时进入低功耗 */
+     idleTickless ();
+#else
+     /* 空函数执行,仿真移植在这里推进虚拟时间 */
+     ARCH_IDLE ();
+#endif
+  }
+}
+
+/**
+ * 功能: 释放删除自己的任务留下的TCB和堆栈.调用时该任务已经切换出去,
+ * 只能在任务中调用.
+ * 
+ * 参数:
+ * 输入:                输出:             
+ * 无.                  无.
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * eFree (tcb);
+ * eFree (stack);
+ */
+static void taskReclaim (void)
+{
+  CRITICAL_STORE;
+  uint8_t *tcb;
+  uint8_t *stack;
+
+  CRITICAL_ENTER ();
+  tcb = reclaimTcb;
+  stack = reclaimStack;
+  reclaimTcb = NULL;
+  reclaimStack = NULL;
+  CRITICAL_EXIT ();
+
+  if (tcb != NULL)
+  {
+    eFree (tcb);
+  }
+  if (stack != NULL)
+  {
+    eFree (stack);
+  }
+}
+
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+/**
+ * 功能: 无心跳空闲处理.若就绪队列为空(只有idleTask可以运行),计算下一个定时器
+ * 到期的时间,停止系统心跳并进入低功耗,唤醒后补偿睡眠期间的系统心跳.
+ * 留出最后一个心跳由TIM4正常中断处理,定时器的回调仍然在心跳中断中执行.
+ * 
+ * 参数:
+ * 输入:                输出:             
+ * 无.                  无.
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * eTimerNextExpiry ();
+ * archTicklessSleep (ticks);
+ * eTimerTickSkip (ticks);
+ * easyRTOSSched (FALSE);
+ */
+static void idleTickless (void)
+{
+  CRITICAL_STORE;
+  uint32_t ticks;
+
+  /* 进入临界区,睡眠指令会自动打开中断 */
+  CRITICAL_ENTER ();
+
+  /* 当前运行的是idleTask,就绪队列为空说明没有其他任务可以运行 */
+  if (readyGroup == 0)
+  {
+    ticks = eTimerNextExpiry ();
+    if (ticks > EASYRTOS_TICKLESS_MIN_TICKS)
+    {
+      /* 最后一个心跳交给TIM4中断,由其调用到期定时器的回调 */
+      ticks--;
+      if (ticks > EASYRTOS_TICKLESS_MAX_TICKS)
+      {
+        ticks = EASYRTOS_TICKLESS_MAX_TICKS;
+      }
+
+      ticklessSleeping = TRUE;
+
+      /* 睡眠期间没有跟踪记录,前后的心跳计数用于修正时间戳 */
+      TRACE_SYNC ();
+
+      /* 返回实际睡眠的心跳数,此时中断已经被重新关闭 */
+      ticks = archTicklessSleep (ticks);
+
+      /* 补偿系统心跳 */
+      eTimerTickSkip (ticks);
+      TRACE_SYNC ();
+
+#if (EASYRTOS_RUNTIME_STATS == 1)
+      /* 低功耗期间计数器停止,睡眠时间计入idleTask */
+      eRunTimeCharge (&idleTcb.taskRunTime);
+      idleTcb.taskRunTime += ticks * (RUNTIME_COUNTER_HZ / SYSTEM_TICKS_HZ);
+      runTimeTotal += ticks * (RUNTIME_COUNTER_HZ / SYSTEM_TICKS_HZ);
+      eRunTimeScale ();
+#endif
+
+      ticklessSleeping = FALSE;
+    }
+  }
+
+  /* 退出临界区 */
+  CRITICAL_EXIT ();
+
+  /* 睡眠期间可能有中断唤醒了任务 */
+  easyRTOSSched (FALSE);
+}
+#endif
+
+#if (EASYRTOS_STACK_CHECK == 1)
+/**
+ * 功能: 获取任务堆栈的最小剩余量.堆栈从高地址向低地址使用,从栈底开始统计
+ * 仍然是填充数据的字节数.耗时与剩余量成正比,可以在监控任务中周期调用.
+ * 
+ * 参数:
+ * 输入:                                   输出:             
+ * EASYRTOS_TCB *tcb_ptr 任务的TCB         无.
+ * 
+ * 返回: 
+ * uint16_t 从未被使用过的堆栈字节数,为0说明堆栈已经用完或者溢出
+ *
+ * 调用的函数:
+ * 无.
+ */
+uint16_t eTaskStackFree (EASYRTOS_TCB *tcb_ptr)
+{
+  uint8_t *stack_ptr;
+  uint16_t free_bytes = 0;
+
+  if ((tcb_ptr != NULL) && (tcb_ptr->stack_base != NULL))
+  {
+    stack_ptr = (uint8_t *)tcb_ptr->stack_base;
+    while ((free_bytes < tcb_ptr->stack_size) && (*stack_ptr++ == STACK_PAINT_BYTE))
+    {
+      free_bytes++;
+    }
+  }
+
+  return (free_bytes);
+}
+#endif
+
+#if (EASYRTOS_RUNTIME_STATS == 1)
+/**
+ * 功能: 将上一次结算到现在的时间累加到run_time中.计数器为16位,两次结算之间
+ * 的间隔不能超过65ms,系统心跳中断保证了这一点.
+ * 
+ * 参数:
+ * 输入:                                   输出:             
+ * uint32_t *run_time 累加的运行时间       uint32_t *run_time 累加的运行时间
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * archRunTimeGet ();
+ * eRunTimeScale ();
+ */
+static void eRunTimeCharge (uint32_t *run_time)
+{
+  CRITICAL_STORE;
+  uint16_t now, delta;
+
+  CRITICAL_ENTER ();
+
+  now = archRunTimeGet ();
+  delta = now - runTimeLast;
+  runTimeLast = now;
+
+  *run_time += delta;
+  runTimeTotal += delta;
+  eRunTimeScale ();
+
+  CRITICAL_EXIT ();
+}
+
+/**
+ * 功能: 总时间超过2^31us(约36分钟)时,把所有任务,中断以及总时间同时减半,
+ * 比例不变,32位计数不会溢出.之后的使用率中较早的时间权重逐渐减小.
+ * 调用时已经在临界区中.
+ * 
+ * 参数:
+ * 输入:                                   输出:             
+ * 无.                                     无.
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无.
+ */
+static void eRunTimeScale (void)
+{
+  EASYRTOS_TCB *tcb_ptr;
+
+  if (runTimeTotal < 0x80000000UL)
+  {
+    return;
+  }
+
+  for (tcb_ptr = taskList; tcb_ptr != NULL; tcb_ptr = tcb_ptr->next_task)
+  {
+    tcb_ptr->taskRunTime >>= 1;
+  }
+  isrRunTime >>= 1;
+  runTimeTotal >>= 1;
+}
+
+/**
+ * 功能: 计算运行时间占统计总时间的百分比.避免run_time*100溢出,先缩小总时间.
+ * 
+ * 参数:
+ * 输入:                                   输出:             
+ * uint32_t run_time 运行时间              无.
+ * 
+ * 返回: 
+ * uint8_t 0~100
+ *
+ * 调用的函数:
+ * 无.
+ */
+static uint8_t eRunTimePercent (uint32_t run_time)
+{
+  uint32_t total = runTimeTotal / 100;
+
+  if (total == 0)
+  {
+    return (0);
   }
+  run_time /= total;
+
+  return ((run_time > 100) ? 100 : (uint8_t)run_time);
+}
+
+/**
+ * 功能: 获取任务的CPU使用率,统计自easyRTOSStart()或者上一次
+ * eRunTimeStatsReset()开始,总时间超过2^31us后较早的时间按减半计算.
+ * 当前任务正在运行的时间片尚未结算.
+ * 
+ * 参数:
+ * 输入:                                   输出:             
+ * EASYRTOS_TCB *tcb_ptr 任务的TCB         无.
+ * 
+ * 返回: 
+ * uint8_t CPU使用率 0~100
+ *
+ * 调用的函数:
+ * eRunTimePercent (tcb_ptr->taskRunTime);
+ */
+uint8_t eTaskCpuUsage (EASYRTOS_TCB *tcb_ptr)
+{
+  CRITICAL_STORE;
+  uint8_t usage = 0;
+
+  if (tcb_ptr)
+  {
+    CRITICAL_ENTER ();
+    usage = eRunTimePercent (tcb_ptr->taskRunTime);
+    CRITICAL_EXIT ();
+  }
+
+  return (usage);
+}
+
+/**
+ * 功能: 获取idleTask的CPU使用率,即CPU的空闲率.
+ * 
+ * 参数:
+ * 输入:                                   输出:             
+ * 无.                                     无.
+ * 
+ * 返回: 
+ * uint8_t 空闲率 0~100
+ *
+ * 调用的函数:
+ * eTaskCpuUsage (&idleTcb);
+ */
+uint8_t eIdleCpuUsage (void)
+{
+  return (eTaskCpuUsage (&idleTcb));
+}
+
+/**
+ * 功能: 获取中断占用的CPU使用率.只统计调用了eIntEnter()/eIntExit()的中断.
+ * 
+ * 参数:
+ * 输入:                                   输出:             
+ * 无.                                     无.
+ * 
+ * 返回: 
+ * uint8_t 中断占用率 0~100
+ *
+ * 调用的函数:
+ * eRunTimePercent (isrRunTime);
+ */
+uint8_t eIsrCpuUsage (void)
+{
+  CRITICAL_STORE;
+  uint8_t usage;
+
+  CRITICAL_ENTER ();
+  usage = eRunTimePercent (isrRunTime);
+  CRITICAL_EXIT ();
+
+  return (usage);
+}
+
+/**
+ * 功能: 清零所有任务以及中断的运行时间,开始新的统计.
+ * 
+ * 参数:
+ * 输入:                                   输出:             
+ * 无.                                     无.
+ * 
+ * 返回: void
+ *
+ * 调用的函数:
+ * archRunTimeGet ();
+ */
+void eRunTimeStatsReset (void)
+{
+  CRITICAL_STORE;
+  EASYRTOS_TCB *tcb_ptr;
+
+  CRITICAL_ENTER ();
+
+  for (tcb_ptr = taskList; tcb_ptr != NULL; tcb_ptr = tcb_ptr->next_task)
+  {
+    tcb_ptr->taskRunTime = 0;
+  }
+  isrRunTime = 0;
+  runTimeTotal = 0;
+  runTimeLast = archRunTimeGet ();
+
+  CRITICAL_EXIT ();
 }
+#endif
@@ -1,7 +1,7 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #ifndef __EASYRTOSKERNEL_H__
@@ -9,36 +9,62 @@
 
 #include "easyRTOS.h"
 #define ERESULT int8_t
-#define EASYRTOS_OK            ( 0) /* ɹ */
-#define EASYRTOS_ERR_PARAM     (-1) /* Ĳ */
-#define EASYRTOS_ERR_QUEUE     (-2) /* Readyʧ */
-#define EASYRTOS_ERR_NOT_FOUND (-3) /* ûҵעtimer */
-#define EASYRTOS_ERR_CONTEXT   (-4) /* ĵ */
-#define EASYRTOS_ERR_TIMER     (-5) /* עᶨʱʧ/ȡʱʧ*/
-#define EASYRTOS_ERR_DELETED   (-6) /* ʱɾ */
-#define EASYRTOS_TIMEOUT       (-7) /* źtimeout */
-#define EASYRTOS_ERR_OVF       (-8) /* źcount>127С -127 */
-#define EASYRTOS_WOULDBLOCK    (-9) /* ᱻҵtimeoutΪ-1Է */
-#define EASYRTOS_ERR_BIN_OVF   (-10)/* ֵźcountѾΪ1 */
-#define EASYRTOS_SEM_UINIT     (-11)/* źûбʼ */
-#define EASYRTOS_ERR_OWNERSHIP (-12)/* Խǻӵ */
+#define EASYRTOS_OK            ( 0) /* 成功 */
+#define EASYRTOS_ERR_PARAM     (-1) /* 错误的参数 */
+#define EASYRTOS_ERR_QUEUE     (-2) /* 将任务加入Ready队列失败 */
+#define EASYRTOS_ERR_NOT_FOUND (-3) /* 没有找到注册的timer */
+#define EASYRTOS_ERR_CONTEXT   (-4) /* 错误的上下文调用 */
+#define EASYRTOS_ERR_TIMER     (-5) /* 注册定时器失败/取消定时器失败*/
+#define EASYRTOS_ERR_DELETED   (-6) /* 在悬挂任务时被删除 */
+#define EASYRTOS_TIMEOUT       (-7) /* 信号量timeout到期 */
+#define EASYRTOS_ERR_OVF       (-8) /* 计数信号量count>127或者小于 -127 */
+#define EASYRTOS_WOULDBLOCK    (-9) /* 本来会被悬挂但由于timeout为-1所以返回了 */
+#define EASYRTOS_ERR_BIN_OVF   (-10)/* 二值信号量count已经为1 */
+#define EASYRTOS_SEM_UINIT     (-11)/* 信号量没有被初始化 */
+#define EASYRTOS_ERR_OWNERSHIP (-12)/* 尝试解锁互斥锁的任务不是互斥锁拥有者 */
+#define EASYRTOS_ERR_CEILING   (-13)/* 任务优先级高于天花板互斥锁的天花板优先级 */
+#define EASYRTOS_ERR_SUSPENDED (-14)/* 在悬挂任务时任务被挂起 */
+#define EASYRTOS_ERR_MUTEX_HELD (-15)/* 任务仍然拥有互斥锁,不能删除 */
 
-/* ȫֺ */
+/* eTaskDelete()释放的内存 */
+#define EASYRTOS_FREE_STACK    0x01 /* 用eFree()释放任务堆栈 */
+#define EASYRTOS_FREE_TCB      0x02 /* 用eFree()释放TCB */
+
+/* 全局函数 */
 extern ERESULT eTaskCreat(EASYRTOS_TCB *task_tcb, uint8_t priority, void (*entry_point)(uint32_t), uint32_t entryParam, void* taskStack, uint32_t stackSize,const char* taskName,uint32_t taskID);
 extern void easyRTOSStart (void);
 extern void easyRTOSSched (uint8_t timer_tick);
 ERESULT easyRTOSInit (void *idle_task_stack, uint32_t idleTaskStackSize);
+extern ERESULT eSetTaskPriority(EASYRTOS_TCB *tcb_ptr,uint8_t priority);
+extern ERESULT eTaskSetTimeSlice (EASYRTOS_TCB *tcb_ptr, uint8_t ticks);
+extern void eTaskYield (void);
+extern ERESULT eTaskSuspend (EASYRTOS_TCB *tcb_ptr);
+extern ERESULT eTaskResume (EASYRTOS_TCB *tcb_ptr);
+extern ERESULT eTaskDelete (EASYRTOS_TCB *tcb_ptr, uint8_t free_flags);
+extern void eSchedLock (void);
+extern void eSchedUnlock (void);
 extern ERESULT tcbEnqueuePriority (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr);
+extern ERESULT tcbEnqueueReady (EASYRTOS_TCB *tcb_ptr);
 extern EASYRTOS_TCB *eCurrentContext (void);
 extern void eIntEnter (void);
 extern void eIntExit (uint8_t timerTick);
 extern EASYRTOS_TCB *tcb_dequeue_entry (EASYRTOS_TCB **tcb_queue_ptr, EASYRTOS_TCB *tcb_ptr);
 extern EASYRTOS_TCB *tcb_dequeue_head (EASYRTOS_TCB **tcb_queue_ptr);
-extern EASYRTOS_TCB *tcb_dequeue_priority (EASYRTOS_TCB **tcb_queue_ptr, uint8_t priority);
+extern EASYRTOS_TCB *tcb_dequeue_ready (EASYRTOS_TCB *tcb_ptr);
+extern EASYRTOS_TCB *tcb_dequeue_priority (uint8_t priority);
+extern void tcbSetPriority (EASYRTOS_TCB *tcb_ptr, uint8_t priority);
+#if (EASYRTOS_STACK_CHECK == 1)
+extern uint16_t eTaskStackFree (EASYRTOS_TCB *tcb_ptr);
+#endif
+#if (EASYRTOS_RUNTIME_STATS == 1)
+extern uint8_t eTaskCpuUsage (EASYRTOS_TCB *tcb_ptr);
+extern uint8_t eIdleCpuUsage (void);
+extern uint8_t eIsrCpuUsage (void);
+extern void eRunTimeStatsReset (void);
+#endif
 /* end */
 
-/* ȫֱ */
-extern uint8_t easyRTOSStarted;
-extern EASYRTOS_TCB *tcb_readyQ;
+/* 全局变量 */
+extern EASYRTOS_NODE_LOCAL uint8_t easyRTOSStarted;
 
 #endif
\ No newline at end of file
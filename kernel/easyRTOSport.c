@@ -1,7 +1,7 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #include "easyRTOS.h"
@@ -9,30 +9,82 @@
 #include "easyRTOSport.h"
 #include "easyRTOSTimer.h"
 #include "stm8s_tim3.h"
+#include "stm8s_uart1.h"
 
-/* ȫֺ */
+/* 全局函数 */
 void archTaskContextInit (EASYRTOS_TCB *tcb_ptr, void *stack_top, void (*entry_point)(uint32_t), uint32_t entryParam);
 void archInitSystemTickTimer ( void );
+void archInitIrqLevel (void);
+void archIsrStackInit (void);
+#if (EASYRTOS_ISR_STACK_SIZE > 0) && (EASYRTOS_STACK_CHECK == 1)
+uint16_t archIsrStackFree (void);
+#endif
+uint32_t archTicklessSleep (uint32_t ticks);
+void archRunTimeInit (void);
+uint16_t archRunTimeGet (void);
+#if (EASYRTOS_TRACE == 1)
+void archTraceUartInit (void);
+void archTraceUartPut (uint8_t c);
+#endif
+#if (EASYRTOS_LATENCY_HIST == 1)
+void archLatencyInit (void);
+uint16_t archLatencyStamp (void);
+uint16_t archLatencyCapture (void);
+#endif
 /* end */
 
-/* ˽к */
+/* 私有函数 */
 static void taskShell (void);
+static void systemTickHandler (void);
 /* end */
 
+#if (EASYRTOS_ISR_STACK_SIZE > 0)
+/* 中断堆栈 */
+NEAR static uint8_t isrStack[EASYRTOS_ISR_STACK_SIZE];
+
+/* 以下变量由easyRTOSportAsm.s(SDCC为easyRTOSportSdcc.c)中的archIsrStackCall()使用 */
+/* 中断堆栈栈顶 */
+uint8_t *isrStackTop = &isrStack[EASYRTOS_ISR_STACK_SIZE - 1];
+
+/* 切换到中断堆栈前被中断任务的栈指针 */
+uint8_t *isrStackSaved = NULL;
+
+/* archIsrStackCall()嵌套计数 */
+uint8_t isrStackNest = 0;
+#endif
+
+#if (EASYRTOS_TICKLESS_IDLE == 1)
 /**
- * : ں,tcb.entry_pointݸ,
- * õǰ,ʹж.
+ * 无心跳睡眠使用TIM3计时,主频16M时256分频,每个计数16us,最长约1s.
+ * TIM4心跳为128分频,每个TIM3计数对应2个TIM4计数.TIM4_TimeBaseInit()设置的是
+ * 自动重载值,心跳周期为该值加1个TIM4计数.
+ */
+#define TICKLESS_TIM3_PSC      8
+#define TICKLESS_TIM3_HZ       ((uint32_t)16000000 >> TICKLESS_TIM3_PSC)
+#define TICKLESS_TIM4_PER_TIM3 ((uint32_t)125000 / TICKLESS_TIM3_HZ)
+#define TICKLESS_TIM4_PERIOD   ((uint32_t)125000 / SYSTEM_TICKS_HZ + 1)
+
+/* TIM3计满唤醒标志,在TIM3中断中置位 */
+static volatile uint8_t ticklessTimeout = FALSE;
+#endif
+
+/**
+ * 功能: 任务入口函数,将tcb.entry_point参数传递给任务函数,
+ * 并设置当前运行上下文,使能中断.任务函数返回后删除任务,若仍然拥有
+ * 互斥锁无法删除,则永久挂起.
  *
- * :
- * :                         :
- *                             .
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
  *
- * : void
+ * 返回: void
  * 
- * õĺ:
+ * 调用的函数:
  * eCurrentContext();
  * rim();
  * curr_tcb->entry_point(curr_tcb->entryParam);
+ * eTaskDelete (curr_tcb, 0);
+ * eTaskSuspend (curr_tcb);
  */
 static void taskShell (void)
 {
@@ -40,27 +92,35 @@ static void taskShell (void)
 
     curr_tcb = eCurrentContext();
 
-    /* ʹж */
+    /* 使能中断 */
     rim();
 
-    /*  */
+    /* 任务函数入口 */
     if (curr_tcb && curr_tcb->entry_point)
     {
         curr_tcb->entry_point(curr_tcb->entryParam);
     }
+
+    /* 任务函数返回,删除任务,不会再返回 */
+    (void)eTaskDelete (curr_tcb, 0);
+
+    while (1)
+    {
+        (void)eTaskSuspend (curr_tcb);
+    }
 }
 
 /**
- * : ʼĶջ,ȷĴ?b8-?b15λ,
- * Լڵַ,RETʹ.
+ * 功能: 初始化各个任务的堆栈,确定虚拟寄存器?b8-?b15的位置,
+ * 以及函数入口地址,供汇编中RET使用.
  *
- * :
- * :                         :
- *                             .
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
  *
- * : void
+ * 返回: void
  * 
- * õĺ:
+ * 调用的函数:
  * eCurrentContext();
  * rim();
  * curr_tcb->entry_point(curr_tcb->entryParam);
@@ -70,19 +130,20 @@ void archTaskContextInit (EASYRTOS_TCB *tcb_ptr, void *stack_top, void (*entry_p
     uint8_t *stack_ptr;
     stack_ptr = (uint8_t *)stack_top;
     /**
-     *  ִָ RET ָ.ָҪڶջҵлĳַ.
-     *  һһʱ,᷵.ǽڴ洢ڶջ,ͬʱRET
-     *  ҲڶջѰ򷵻صַ.
+     *  任务恢复程序会执行 RET 指令.该指令需要在堆栈中找到被切换的任务的程序地址.
+     *  当一个任务第一次运行时,会返回任务入口.我们将任务入口存储在堆栈中,同时RET
+     *  也将在堆栈中寻找任务程序返回地址.
 
-     *   taskShell() е,ʵǽtaskShell()
-     *  ַ洢.
+     *  我们用 taskShell() 函数启动所有的任务,所以实际上我们将taskShell()的
+     *  地址存储在这里.
 
-     *  ϵʹöջ.
+     *  从上到下使用堆栈.
      */
     *stack_ptr-- = (uint8_t)((uint16_t)taskShell & 0xFF);
     *stack_ptr-- = (uint8_t)(((uint16_t)taskShell >> 8) & 0xFF);
 
-    /* ʹIARʱһЩĴ,ʼЩĴλ */
+#if !defined(__SDCC)
+    /* 使用IAR的时候会有一些虚拟寄存器,初始化这些虚拟寄存器的位置 */
     *stack_ptr-- = 0;    // ?b8
     *stack_ptr-- = 0;    // ?b9
     *stack_ptr-- = 0;    // ?b10
@@ -91,25 +152,26 @@ void archTaskContextInit (EASYRTOS_TCB *tcb_ptr, void *stack_top, void (*entry_p
     *stack_ptr-- = 0;    // ?b13
     *stack_ptr-- = 0;    // ?b14
     *stack_ptr-- = 0;    // ?b15
+#endif
 
     /**
-     *  йصݶѳʼ.ʣµľTCBбջָ,
-     *  ʹ.
+     *  与任务上下文有关的数据都已初始化完毕.剩下的就是在TCB中保存栈指针,供调度器
+     *  使用.
      */
     tcb_ptr->sp_save_ptr = stack_ptr;
 }
 
 /**
- * : ʼϵͳʹõĶʱ,ʹõTIM3,Ҳʹʱ
- * ƵSYSTEM_TICKS_HZ,ƵʼΪϵͳԶлʱ.
+ * 功能: 初始化系统心跳使用的定时器,这里使用的是TIM3,也可以使用其他定时器
+ * 频率由SYSTEM_TICKS_HZ调整,该频率即为系统自动切换任务的时间.
  *
- * :
- * :                         :
- *                             .
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
  *
- * : void
+ * 返回: void
  * 
- * õĺ:
+ * 调用的函数:
  * TIM4_DeInit();
  * TIM4_TimeBaseInit(TIM3_PRESCALER_16, (uint16_t)((uint32_t)1000000/SYSTEM_TICKS_HZ));
  * TIM4_ITConfig(TIM3_IT_UPDATE, ENABLE);
@@ -117,42 +179,445 @@ void archTaskContextInit (EASYRTOS_TCB *tcb_ptr, void *stack_top, void (*entry_p
  */
 void archInitSystemTickTimer ( void )
 {
-    /* ʼTIM3*/
+    /* 初始化TIM3*/
     TIM4_DeInit();
 
-    /* ϵͳ */
+    /* 配置系统心跳 */
     TIM4_TimeBaseInit(TIM4_PRESCALER_128, (uint16_t)((uint32_t)125000/SYSTEM_TICKS_HZ));
 
     TIM4_ITConfig(TIM4_IT_UPDATE, ENABLE);
 
-    /* ʹTIM3 */
+    /* 使能TIM3 */
     TIM4_Cmd(ENABLE);
 }
 
 /**
- * : ϵͳʱжϳ,жʱcount,Ҫ
- * Ķʱص,˳ʱõ.
+ * 功能: 设置所有中断的软件优先级.EASYRTOS_KERNEL_IRQ_LEVEL不为0时,把所有中断
+ * 设置为内核优先级,保证调用内核接口的中断都会被临界区屏蔽.为0时保持复位值.
+ * 必须在关中断的情况下调用.
  *
- * :
- * :                         :
- *                             .
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
  *
- * : void
+ * 返回: void
  * 
- * õĺ:
- * eIntEnter ();
+ * 调用的函数:
+ * 无
+ */
+void archInitIrqLevel (void)
+{
+#if (EASYRTOS_KERNEL_IRQ_LEVEL != 0)
+    uint8_t i;
+    volatile uint8_t *ispr = &ITC->ISPR1;
+
+    /* ISPR1~ISPR8 */
+    for (i = 0; i < 8; i++)
+    {
+        ispr[i] = ITC_SPR_KERNEL;
+    }
+#endif
+}
+
+/**
+ * 功能: 初始化中断堆栈.使能堆栈检查时填充整个中断堆栈,用于统计使用量.
+ * 必须在关中断的情况下调用.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ * 
+ * 调用的函数:
+ * 无
+ */
+void archIsrStackInit (void)
+{
+#if (EASYRTOS_ISR_STACK_SIZE > 0)
+    isrStackNest = 0;
+#if (EASYRTOS_STACK_CHECK == 1)
+    {
+        uint16_t i;
+
+        for (i = 0; i < EASYRTOS_ISR_STACK_SIZE; i++)
+        {
+            isrStack[i] = STACK_PAINT_BYTE;
+        }
+    }
+#endif
+#endif
+}
+
+#if (EASYRTOS_ISR_STACK_SIZE > 0) && (EASYRTOS_STACK_CHECK == 1)
+/**
+ * 功能: 获取中断堆栈的最小剩余量,从栈底开始统计未被改写的字节数.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: 
+ * uint16_t 中断堆栈从未使用过的字节数
+ * 
+ * 调用的函数:
+ * 无
+ */
+uint16_t archIsrStackFree (void)
+{
+    uint16_t i = 0;
+
+    while ((i < EASYRTOS_ISR_STACK_SIZE) && (isrStack[i] == STACK_PAINT_BYTE))
+    {
+        i++;
+    }
+
+    return (i);
+}
+#endif
+
+/**
+ * 功能: 初始化运行时间统计使用的TIM2,16分频(主频16M)后以1us自由计数,
+ * 不使用中断.两次读取之间的间隔不能超过65ms,系统心跳保证了这一点.
+ * 运行时间统计,跟踪记录和延迟统计共用,已经启动时不再初始化,
+ * 保留应用设置的比较通道.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ * 
+ * 调用的函数:
+ * TIM2_DeInit();
+ * TIM2_TimeBaseInit(TIM2_PRESCALER_16, 0xFFFF);
+ * TIM2_Cmd(ENABLE);
+ */
+void archRunTimeInit (void)
+{
+    if (TIM2->CR1 & TIM2_CR1_CEN)
+    {
+      return;
+    }
+
+    TIM2_DeInit();
+
+    /* 1us计数,计满0xFFFF后回零 */
+    TIM2_TimeBaseInit(TIM2_PRESCALER_16, 0xFFFF);
+
+    TIM2_Cmd(ENABLE);
+}
+
+/**
+ * 功能: 读取运行时间计数器.必须先读高字节,低字节在读取高字节时被锁存.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: 
+ * uint16_t 计数器的值,单位us
+ * 
+ * 调用的函数:
+ * 无
+ */
+uint16_t archRunTimeGet (void)
+{
+    uint8_t h;
+
+    h = TIM2->CNTRH;
+    return ((uint16_t)(((uint16_t)h << 8) | TIM2->CNTRL));
+}
+
+#if (EASYRTOS_TRACE == 1)
+/**
+ * 功能: 初始化导出跟踪记录使用的UART1,8位数据,1位停止位,无校验,只发送.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ * 
+ * 调用的函数:
+ * UART1_DeInit();
+ * UART1_Init(...);
+ */
+void archTraceUartInit (void)
+{
+    UART1_DeInit();
+    UART1_Init((uint32_t)EASYRTOS_TRACE_BAUD, UART1_WORDLENGTH_8D, UART1_STOPBITS_1,
+               UART1_PARITY_NO, UART1_SYNCMODE_CLOCK_DISABLE, UART1_MODE_TX_ENABLE);
+}
+
+/**
+ * 功能: 以查询方式通过UART1发送一个字节.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * uint8_t c 发送的字节          无.
+ *
+ * 返回: void
+ * 
+ * 调用的函数:
+ * 无
+ */
+void archTraceUartPut (uint8_t c)
+{
+    while ((UART1->SR & UART1_SR_TXE) == 0)
+    {
+    }
+    UART1->DR = c;
+}
+#endif
+
+#if (EASYRTOS_LATENCY_HIST == 1)
+/**
+ * 功能: 初始化延迟测量的时间戳.EASYRTOS_LATENCY_TIMER为1时TIM1不分频
+ * 自由计数,CH1输入捕获TI1(PC1)的上升沿,不使能中断,被测中断由应用设置;
+ * 为2时使用运行时间统计的TIM2.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ * 
+ * 调用的函数:
+ * archRunTimeInit ();
+ */
+void archLatencyInit (void)
+{
+#if (EASYRTOS_LATENCY_TIMER == 1)
+    TIM1->CR1 = 0;
+    TIM1->PSCRH = 0;
+    TIM1->PSCRL = 0;
+    TIM1->ARRH = 0xFF;
+    TIM1->ARRL = 0xFF;
+
+    /* IC1映射到TI1,不分频不滤波,上升沿捕获 */
+    TIM1->CCER1 = 0;
+    TIM1->CCMR1 = 0x01;
+    TIM1->CCER1 = TIM1_CCER1_CC1E;
+
+    TIM1->SR1 = 0;
+    TIM1->CR1 = TIM1_CR1_CEN;
+#else
+    archRunTimeInit ();
+#endif
+}
+
+/**
+ * 功能: 读取延迟测量的时间戳.必须先读高字节,低字节在读取高字节时被锁存.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: 
+ * uint16_t 计数器的值,单位见EASYRTOS_LATENCY_TIMER
+ * 
+ * 调用的函数:
+ * archRunTimeGet ();
+ */
+uint16_t archLatencyStamp (void)
+{
+#if (EASYRTOS_LATENCY_TIMER == 1)
+    uint8_t h;
+
+    h = TIM1->CNTRH;
+    return ((uint16_t)(((uint16_t)h << 8) | TIM1->CNTRL));
+#else
+    return (archRunTimeGet ());
+#endif
+}
+
+/**
+ * 功能: 读取CH1的捕获/比较值,作为被测中断的到达时间.TIM1读取低字节时
+ * 清除捕获标志.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: 
+ * uint16_t CCR1的值
+ * 
+ * 调用的函数:
+ * 无
+ */
+uint16_t archLatencyCapture (void)
+{
+    uint8_t h;
+
+#if (EASYRTOS_LATENCY_TIMER == 1)
+    h = TIM1->CCR1H;
+    return ((uint16_t)(((uint16_t)h << 8) | TIM1->CCR1L));
+#else
+    h = TIM2->CCR1H;
+    return ((uint16_t)(((uint16_t)h << 8) | TIM2->CCR1L));
+#endif
+}
+#endif
+
+/**
+ * 功能: 系统心跳的中断处理,更新所有定时器的count,调用所有要调用的定时器
+ * 回调.在中断堆栈上运行.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ * 
+ * 调用的函数:
  * eTimerTick();
+ */
+static void systemTickHandler (void)
+{
+    eTimerTick();
+
+    TIM4->SR1 = (uint8_t)(~(uint8_t)TIM4_IT_UPDATE);
+}
+
+/**
+ * 功能: 系统心跳时钟中断程序,在中断堆栈上处理定时器,并在退出的时候调用调度器.
+ * 调度器可能切换任务,必须回到任务堆栈后才能调用eIntExit().
+ * 其他调用内核接口的中断也按照这个结构编写.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ * 
+ * 调用的函数:
+ * eIntEnter ();
+ * archIsrStackCall (systemTickHandler);
  * eIntExit (TRUE);
  */
-/* IARж */
+#if defined(__SDCC)
+INTERRUPT_HANDLER(TIM3_SystemTickISR, 23)           /* ITC_IRQ_TIM4_OVF */
+#else
+/* IAR中中断向量 */
 #pragma vector = ITC_IRQ_TIM4_OVF + 2
 __interrupt  void TIM3_SystemTickISR (void)
+#endif
 {
     eIntEnter ();
     
-    eTimerTick();
-
-    TIM4->SR1 = (uint8_t)(~(uint8_t)TIM4_IT_UPDATE);
+    archIsrStackCall (systemTickHandler);
     
     eIntExit (TRUE);
 }
+
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+/**
+ * 功能: 无心跳低功耗.停止TIM4系统心跳,TIM3单脉冲计时ticks个心跳后产生更新
+ * 中断,用wfi等待TIM3或者其他中断唤醒.唤醒后读取TIM3的计数得到实际睡眠的
+ * 时间,不足一个心跳的部分预置到TIM4的计数器中,系统时间不会因为提前唤醒而
+ * 丢失.必须在关中断的情况下调用,返回时中断仍为关闭状态.
+ * wait模式下外设时钟不停止,功耗高于Active-halt.TIM2运行时间计数在睡眠期间
+ * 暂停,与Active-halt相同,睡眠时间由内核按返回的心跳数计入idleTask.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * uint32_t ticks 最多睡眠的心跳数     无.
+ *
+ * 返回: 
+ * uint32_t 实际睡眠的心跳数,不超过ticks
+ * 
+ * 调用的函数:
+ * TIM4_Cmd(DISABLE);
+ * wfi();
+ * TIM4_Cmd(ENABLE);
+ */
+uint32_t archTicklessSleep (uint32_t ticks)
+{
+    uint32_t counts;
+    uint32_t elapsed;
+    uint8_t tim2Cr1;
+    uint8_t h;
+
+    /* 按实际的心跳周期换算为TIM3的计数,向下取整,不超过16位 */
+    counts = ticks * TICKLESS_TIM4_PERIOD / TICKLESS_TIM4_PER_TIM3;
+    if (counts > 0xFFFF)
+    {
+      counts = 0xFFFF;
+    }
+    if (counts == 0)
+    {
+      return (0);
+    }
+
+    /* 停止系统心跳以及运行时间计数 */
+    TIM4_Cmd(DISABLE);
+    tim2Cr1 = TIM2->CR1;
+    TIM2->CR1 = (uint8_t)(tim2Cr1 & (uint8_t)(~TIM2_CR1_CEN));
+
+    /* TIM3从0开始单脉冲计数,计满时停止并产生更新中断 */
+    ticklessTimeout = FALSE;
+    TIM3->CR1 = 0;
+    TIM3->PSCR = TICKLESS_TIM3_PSC;
+    TIM3->ARRH = (uint8_t)((counts - 1) >> 8);
+    TIM3->ARRL = (uint8_t)((counts - 1) & 0xFF);
+    TIM3->EGR = TIM3_EGR_UG;
+    TIM3->SR1 = 0;
+    TIM3->IER = TIM3_IER_UIE;
+    TIM3->CR1 = (uint8_t)(TIM3_CR1_OPM | TIM3_CR1_CEN);
+
+    /* 进入wait模式,wfi指令会打开中断 */
+    wfi();
+
+    /* 被唤醒,在唤醒中断执行完毕后关闭中断 */
+    __disable_interrupt();
+
+    if (ticklessTimeout == TRUE)
+    {
+      elapsed = counts;
+    }
+    else
+    {
+      /* 其他中断提前唤醒,计数器中为已经睡眠的时间 */
+      h = TIM3->CNTRH;
+      elapsed = ((uint16_t)h << 8) | TIM3->CNTRL;
+    }
+    TIM3->CR1 = 0;
+    TIM3->IER = 0;
+    TIM3->SR1 = 0;
+
+    /* 换算为TIM4的计数,整数部分为心跳数,余数预置到TIM4 */
+    elapsed *= TICKLESS_TIM4_PER_TIM3;
+    TIM4->CNTR = (uint8_t)(elapsed % TICKLESS_TIM4_PERIOD);
+    TIM4_Cmd(ENABLE);
+    TIM2->CR1 = tim2Cr1;
+
+    /* 不超过请求的心跳数,否则会跳过下一个定时器的到期时间 */
+    elapsed /= TICKLESS_TIM4_PERIOD;
+    return ((elapsed > ticks) ? ticks : elapsed);
+}
+
+/**
+ * 功能: TIM3无心跳睡眠计满中断,清除更新标志.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ * 
+ * 调用的函数:
+ * 无
+ */
+#if defined(__SDCC)
+INTERRUPT_HANDLER(TIM3_TicklessISR, 15)             /* ITC_IRQ_TIM3_OVF */
+#else
+#pragma vector = ITC_IRQ_TIM3_OVF + 2
+__interrupt void TIM3_TicklessISR (void)
+#endif
+{
+    TIM3->SR1 = (uint8_t)(~TIM3_SR1_UIF);
+
+    ticklessTimeout = TRUE;
+}
+#endif
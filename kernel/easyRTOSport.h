@@ -1,31 +1,125 @@
 /**
- * : Roy.yu
- * ʱ: 2017.04.26
- * 汾: V1.2
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #ifndef __EASYRTOSPORT__H__
 #define __EASYRTOSPORT__H__
 
+#if defined(EASYRTOS_PORT_LINUX)
+/* 临界区由easyRTOSportLinux.h用信号屏蔽实现 */
+#else
+#if defined(__SDCC)
+/**
+ * SDCC没有intrinsics.h,CC寄存器由easyRTOSportSdcc.c中的函数读写,
+ * 下面的临界区宏与IAR相同.
+ */
+#include <stddef.h>
+typedef uint8_t __istate_t;
+#define __get_interrupt_state()     archCcGet ()
+#define __set_interrupt_state(s)    archCcSet (s)
+#define __disable_interrupt()       __asm__("sim")
+
+extern uint8_t archCcGet (void) ARCH_ASM_CALL;
+extern void archCcSet (uint8_t cc) ARCH_ASM_CALL;
+#else
 #include "intrinsics.h"
 #include "stddef.h"
+#endif
 
+#if (EASYRTOS_KERNEL_IRQ_LEVEL == 0)
 #define CRITICAL_STORE      __istate_t _istate
 #define CRITICAL_ENTER()    _istate = __get_interrupt_state(); __disable_interrupt()
 #define CRITICAL_EXIT()     __set_interrupt_state(_istate)
+#else
+/**
+ * CC寄存器中I1(bit5),I0(bit3)为CPU当前的优先级:
+ * level 0(主程序)=10 level 1=01 level 2=00 level 3(关中断)=11
+ * 进入临界区时把CPU优先级提升到内核优先级,已经不低于内核优先级时保持不变.
+ */
+#define CC_I_MASK           0x28
+#define CC_LEVEL_0          0x20
+#define CC_LEVEL_1          0x08
+#define CC_LEVEL_2          0x00
+
+#if (EASYRTOS_KERNEL_IRQ_LEVEL == 1)
+#define CC_KERNEL_LEVEL     CC_LEVEL_1
+#define CC_BELOW_KERNEL(cc) (((cc) & CC_I_MASK) == CC_LEVEL_0)
+/* ITC_SPRx中每个中断占2bit,level 1为01 */
+#define ITC_SPR_KERNEL      0x55
+#elif (EASYRTOS_KERNEL_IRQ_LEVEL == 2)
+#define CC_KERNEL_LEVEL     CC_LEVEL_2
+#define CC_BELOW_KERNEL(cc) ((((cc) & CC_I_MASK) == CC_LEVEL_0) \
+                             || (((cc) & CC_I_MASK) == CC_LEVEL_1))
+/* level 2为00 */
+#define ITC_SPR_KERNEL      0x00
+#else
+#error "EASYRTOS_KERNEL_IRQ_LEVEL must be 0, 1 or 2"
+#endif
+
+#define CRITICAL_STORE      __istate_t _istate
+#define CRITICAL_ENTER()    do { _istate = __get_interrupt_state(); \
+                              if (CC_BELOW_KERNEL(_istate)) \
+                                __set_interrupt_state((__istate_t)((_istate & ~CC_I_MASK) | CC_KERNEL_LEVEL)); \
+                            } while (0)
+#define CRITICAL_EXIT()     __set_interrupt_state(_istate)
+#endif
+#endif
 
-/* ϵͳƵ */
+/* 系统心跳频率 */
 #define SYSTEM_TICKS_HZ                 2000
 
-/* ʱʱתλms min(N) = 1000/SYSTEM_TICKS_HZ INT */
+/* 延时时间转化，单位ms min(N) = 1000/SYSTEM_TICKS_HZ INT */
 #define DELAY_MS(x) ((uint32_t)(x)*(SYSTEM_TICKS_HZ)/(1000))
 
-/* ʱʱתλs min(N) = 1/SYSTEM_TICKS_HZ INT */
+/* 延时时间转化，单位s min(N) = 1/SYSTEM_TICKS_HZ INT */
 #define DELAY_S(x) ((uint32_t)(x)*(SYSTEM_TICKS_HZ))
 
-/* ջλС stm8Ϊ8bit */
+/* 运行时间统计计数器频率,单位us */
+#define RUNTIME_COUNTER_HZ              1000000
+
+/* 堆栈检查时填充的数据 */
+#define STACK_PAINT_BYTE                0x5A
+
+/* 堆栈单位大小 stm8为8bit */
 #define STACK_ALIGN_SIZE                sizeof(u8)
 
+/* 空闲任务每次循环调用,移植没有定义时为空 */
+#ifndef ARCH_IDLE
+#define ARCH_IDLE()
+#endif
+
 extern void archTaskContextInit (EASYRTOS_TCB *tcb_ptr, void *stack_top, void (*entry_point)(uint32_t), uint32_t entryParam);
 extern void archInitSystemTickTimer ( void );
+extern void archInitIrqLevel (void);
+extern void archIsrStackInit (void);
+#if (EASYRTOS_ISR_STACK_SIZE > 0)
+extern void archIsrStackCall (void (*handler)(void)) ARCH_ASM_CALL;
+#if (EASYRTOS_STACK_CHECK == 1)
+extern uint16_t archIsrStackFree (void);
+#endif
+#else
+#define archIsrStackCall(handler) (handler)()
+#endif
+extern uint32_t archTicklessSleep (uint32_t ticks);
+extern void archRunTimeInit (void);
+extern uint16_t archRunTimeGet (void);
+#if (EASYRTOS_TRACE == 1)
+extern void archTraceUartInit (void);
+extern void archTraceUartPut (uint8_t c);
+#endif
+#if (EASYRTOS_LATENCY_HIST == 1)
+extern void archLatencyInit (void);
+extern uint16_t archLatencyStamp (void);
+extern uint16_t archLatencyCapture (void);
+#endif
+
+#if defined(__SDCC)
+/* SDCC要求中断函数的原型在main()所在的文件中可见,应用包含本文件即可 */
+INTERRUPT_HANDLER(TIM3_SystemTickISR, 23);          /* ITC_IRQ_TIM4_OVF */
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+INTERRUPT_HANDLER(TIM3_TicklessISR, 15);            /* ITC_IRQ_TIM3_OVF */
+#endif
+#endif
 #endif
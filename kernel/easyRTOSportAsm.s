@@ -1,13 +1,14 @@
  /**
- * : Roy.yu
- * ʱ: 2016.11.01
- * 汾: V1.1
+ * 作者: Roy.yu
+ * 时间: 2016.11.01
+ * 版本: V1.1
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
  NAME EASYRTOSPORTASM
  SECTION .near_func.text:code
 
 #include "vregs.inc"
+#include "easyRTOSConfig.h"
 
 ;void archFirstThreadRestore (EASYRTOS_TCB *new_tcb_ptr)
   PUBLIC archFirstTaskRestore
@@ -18,10 +19,10 @@ archFirstTaskRestore:
   ; (X) = *sp_save_ptr
   ldw X,(X)
 
-  ; лջָ뵽Ķջ
+  ; 切换栈指针到新任务的堆栈
   ldw SP,X
 
-  ; ?b15 - ?b8 ջ
+  ; ?b15 - ?b8 出栈
   POP ?b15
   POP ?b14
   POP ?b13
@@ -42,13 +43,13 @@ archContextSwitch:
   ;   old_tcb_ptr = X register (word-width)
   ;   new_tcb_ptr = Y register (word-width)
 
-  ; λ:
-  ;   old_tcb_ptr = X Ĵ (16bit)
-  ;   new_tcb_ptr = Y Ĵ (16bit)
+  ; 参数传递位置:
+  ;   old_tcb_ptr = X 寄存器 (16bit)
+  ;   new_tcb_ptr = Y 寄存器 (16bit)
   ; STM8 CPU Registers:
-  ; STM8CPUĴ
+  ; STM8的CPU寄存器
 
-  ; һЩĴѾԶ,ֻҪⱣЩϣƻļĴ.
+  ; 一些寄存器已经被自动保存了,我只需要额外保存那些不希望被破坏的寄存器.
 
   PUSH ?b8
   PUSH ?b9
@@ -59,12 +60,12 @@ archContextSwitch:
   PUSH ?b14
   PUSH ?b15
   
-  ; YĴиƳnew_tcb_ptr,?b0
+  ; 从Y寄存器中复制出new_tcb_ptr,保存在?b0中
   ldw ?b0, Y
 
-  ; 浱ǰջָ뵽old_tcb_ptr
-  ldw Y, SP    ; ǰջָ(л)浽YĴ
-  ldw (X), Y   ; ջָ뱣(X)ĵַ,
+  ; 保存当前的栈指针到old_tcb_ptr中
+  ldw Y, SP    ; 将当前的栈指针(被切换的任务)保存到Y寄存器中
+  ldw (X), Y   ; 将栈指针保存在(X)的地址中,
 
   ldw X,?b0
   ldw X,(X)
@@ -72,7 +73,7 @@ archContextSwitch:
   
   ldw SP,X
 
-  ; IARҪͻָ ?b8 to ?b15
+  ; IAR中需要保存和恢复 ?b8 to ?b15
   POP ?b15
   POP ?b14
   POP ?b13
@@ -84,5 +85,58 @@ archContextSwitch:
 
   ret
 
+#if (EASYRTOS_ISR_STACK_SIZE > 0)
+  EXTERN isrStackTop
+  EXTERN isrStackSaved
+  EXTERN isrStackNest
+
+  ;void archIsrStackCall (void (*handler)(void))
+    PUBLIC archIsrStackCall
+archIsrStackCall:
+
+  ; 参数传递位置:
+  ;   handler = X 寄存器 (16bit)
+  ; 最外层调用时保存当前任务的栈指针并切换到中断堆栈,调用handler后切换回来.
+  ; 判断嵌套和切换栈指针时关闭中断,调用handler时恢复原来的中断优先级.
+
+  ; 保存CC到A,关中断
+  PUSH CC
+  POP A
+  SIM
+
+  TNZ isrStackNest
+  JRNE archIsrStackNested
+
+  ; 最外层:保存任务栈指针,切换到中断堆栈
+  ldw Y, SP
+  ldw isrStackSaved, Y
+  ldw Y, isrStackTop
+  ldw SP, Y
+
+archIsrStackNested:
+  INC isrStackNest
+
+  ; CC保存在当前堆栈中,返回前恢复;同时恢复中断优先级
+  PUSH A
+  PUSH A
+  POP CC
+
+  call (X)
+
+  SIM
+  POP A
+  DEC isrStackNest
+  JRNE archIsrStackRestore
+
+  ; 回到最外层:切换回任务堆栈
+  ldw Y, isrStackSaved
+  ldw SP, Y
+
+archIsrStackRestore:
+  PUSH A
+  POP CC
+  ret
+#endif
+
   end
   
\ No newline at end of file
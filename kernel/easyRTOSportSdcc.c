@@ -0,0 +1,195 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * easyRTOSportAsm.s的SDCC版本,用SDCC编译时代替easyRTOSportAsm.s加入工程.
+ * SDCC没有虚拟寄存器,任务切换只需要保存栈指针.
+ * 函数按照sdcccall(0)编写(见ARCH_ASM_CALL):参数从右向左入栈,调用者清理,
+ * 进入函数时(1,SP)(2,SP)为返回地址,第一个参数从(3,SP)开始.
+ * 只支持medium存储模型(call/ret),large模型的返回地址为3字节.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSport.h"
+
+#if defined(__SDCC)
+
+#if defined(__SDCC_MODEL_LARGE)
+#error "easyRTOSportSdcc.c supports the medium memory model only"
+#endif
+
+/**
+ * 功能: 启动第一个任务,切换到新任务的堆栈,RET到archTaskContextInit()
+ * 中保存的taskShell()地址.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * EASYRTOS_TCB *new_tcb_ptr 新任务的TCB   无.
+ *
+ * 返回: 不返回
+ *
+ * 调用的函数:
+ * 无
+ */
+void archFirstTaskRestore (EASYRTOS_TCB *new_tcb_ptr) ARCH_ASM_CALL __naked
+{
+    (void)new_tcb_ptr;
+
+    __asm
+    ; X = new_tcb_ptr->sp_save_ptr
+    ldw x, (3, sp)
+    ldw x, (x)
+
+    ; 切换栈指针到新任务的堆栈, RET PCH=SP++;PCL=SP++;
+    ldw sp, x
+    ret
+    __endasm;
+}
+
+/**
+ * 功能: 任务切换,把当前栈指针保存到old_tcb_ptr->sp_save_ptr,
+ * 切换到new_tcb_ptr的堆栈后返回到新任务中调用archContextSwitch()的位置.
+ * 其余寄存器由编译器在调用前保存.
+ *
+ * 参数:
+ * 输入:                                    输出:
+ * EASYRTOS_TCB *old_tcb_ptr 被切换的任务    无.
+ * EASYRTOS_TCB *new_tcb_ptr 新任务
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void archContextSwitch (EASYRTOS_TCB *old_tcb_ptr, EASYRTOS_TCB *new_tcb_ptr) ARCH_ASM_CALL __naked
+{
+    (void)old_tcb_ptr;
+    (void)new_tcb_ptr;
+
+    __asm
+    ; old_tcb_ptr->sp_save_ptr = SP
+    ldw y, sp
+    ldw x, (3, sp)
+    ldw (x), y
+
+    ; SP = new_tcb_ptr->sp_save_ptr
+    ldw x, (5, sp)
+    ldw x, (x)
+    ldw sp, x
+    ret
+    __endasm;
+}
+
+/**
+ * 功能: 读取CC寄存器,代替IAR的__get_interrupt_state().
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint8_t CC寄存器的值
+ *
+ * 调用的函数:
+ * 无
+ */
+uint8_t archCcGet (void) ARCH_ASM_CALL __naked
+{
+    __asm
+    push cc
+    pop a
+    ret
+    __endasm;
+}
+
+/**
+ * 功能: 写CC寄存器,恢复中断优先级,代替IAR的__set_interrupt_state().
+ *
+ * 参数:
+ * 输入:                         输出:
+ * uint8_t cc 保存的CC寄存器      无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void archCcSet (uint8_t cc) ARCH_ASM_CALL __naked
+{
+    (void)cc;
+
+    __asm
+    ld a, (3, sp)
+    push a
+    pop cc
+    ret
+    __endasm;
+}
+
+#if (EASYRTOS_ISR_STACK_SIZE > 0)
+/**
+ * 功能: 在中断堆栈上调用handler.最外层调用时保存当前任务的栈指针并切换到
+ * 中断堆栈,调用handler后切换回来.判断嵌套和切换栈指针时关闭中断,
+ * 调用handler时恢复原来的中断优先级.isrStackTop,isrStackSaved,isrStackNest
+ * 定义在easyRTOSport.c中.
+ *
+ * 参数:
+ * 输入:                                输出:
+ * void (*handler)(void) 中断处理函数    无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * handler();
+ */
+void archIsrStackCall (void (*handler)(void)) ARCH_ASM_CALL __naked
+{
+    (void)handler;
+
+    __asm
+    ; X = handler, 切换堆栈前读取
+    ldw x, (3, sp)
+
+    ; 保存CC到A,关中断
+    push cc
+    pop a
+    sim
+
+    tnz _isrStackNest
+    jrne 00001$
+
+    ; 最外层:保存任务栈指针,切换到中断堆栈
+    ldw y, sp
+    ldw _isrStackSaved, y
+    ldw y, _isrStackTop
+    ldw sp, y
+
+00001$:
+    inc _isrStackNest
+
+    ; CC保存在当前堆栈中,返回前恢复;同时恢复中断优先级
+    push a
+    push a
+    pop cc
+
+    call (x)
+
+    sim
+    pop a
+    dec _isrStackNest
+    jrne 00002$
+
+    ; 回到最外层:切换回任务堆栈
+    ldw y, _isrStackSaved
+    ldw sp, y
+
+00002$:
+    push a
+    pop cc
+    ret
+    __endasm;
+}
+#endif
+
+#endif
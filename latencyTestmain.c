@@ -0,0 +1,194 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 中断延迟测试:TIM1不分频,每LATENCY_PERIOD个周期产生一次更新中断,中断中读取
+ * 计数器的值即为从更新事件到进入中断的周期数.同时运行两个任务通过队列传递较大的
+ * 消息,系统心跳正常工作,使内核频繁进入临界区.
+ * 分别以EASYRTOS_KERNEL_IRQ_LEVEL为0和1编译运行,结果保存在latencyResult中,
+ * 在C-SPY的Watch窗口中查看,单位为CPU周期.
+ * 为1时TIM1设置为软件优先级3,不会被内核的临界区延迟,TIM1中断中不能调用内核接口.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSQueue.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define LOAD_STACK_SIZE_BYTES  192
+
+/* TIM1更新周期,不与系统心跳成整数倍,使采样均匀分布 */
+#define LATENCY_PERIOD         997
+#define LATENCY_SAMPLES        20000
+#define LATENCY_HIST_NUM       8
+#define LATENCY_HIST_STEP      16
+
+#define LOAD_MSG_SIZE          32
+#define LOAD_MSG_NUM           4
+
+NEAR static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+NEAR static uint8_t sendTaskStack[LOAD_STACK_SIZE_BYTES];
+NEAR static uint8_t recvTaskStack[LOAD_STACK_SIZE_BYTES];
+
+EASYRTOS_TCB sendTcb;
+EASYRTOS_TCB recvTcb;
+EASYRTOS_QUEUE loadQueue;
+static uint8_t loadQueueBuff[LOAD_MSG_SIZE * LOAD_MSG_NUM];
+
+typedef struct latencyResult
+{
+  uint8_t  irqLevel;                  /* EASYRTOS_KERNEL_IRQ_LEVEL */
+  uint16_t samples;                   /* 采样次数 */
+  uint16_t min;                       /* 最小周期数 */
+  uint16_t max;                       /* 最大周期数 */
+  uint16_t avg;                       /* 平均周期数 */
+  uint16_t hist[LATENCY_HIST_NUM];    /* 每格LATENCY_HIST_STEP个周期,最后一格包含更大的值 */
+  uint32_t messages;                  /* 负载任务传递的消息数 */
+} LATENCY_RESULT;
+
+LATENCY_RESULT latencyResult;
+static uint32_t latencySum = 0;
+
+void sendTaskFunc (uint32_t param);
+void recvTaskFunc (uint32_t param);
+static void latencyTimerInit (void);
+
+int main( void )
+{
+  ERESULT status;
+
+  /* 内部时钟 16M */
+  CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
+
+  latencyResult.irqLevel = EASYRTOS_KERNEL_IRQ_LEVEL;
+  latencyResult.min = 0xFFFF;
+
+  status = easyRTOSInit(&idleTaskStack[0], IDLE_STACK_SIZE_BYTES);
+  if (status == EASYRTOS_OK)
+  {
+#if (EASYRTOS_KERNEL_IRQ_LEVEL != 0)
+    /* easyRTOSInit()之后再提高TIM1的优先级 */
+    ITC_SetSoftwarePriority(ITC_IRQ_TIM1_OVF, ITC_PRIORITYLEVEL_3);
+#endif
+
+    archInitSystemTickTimer();
+
+    loadQueue = eQueueCreate ((void *)loadQueueBuff, LOAD_MSG_SIZE, LOAD_MSG_NUM);
+
+    status += eTaskCreat(&sendTcb,
+                 10,
+                 sendTaskFunc,
+                 0,
+                 &sendTaskStack[0],
+                 LOAD_STACK_SIZE_BYTES,
+                 "SEND",
+                 1);
+    status += eTaskCreat(&recvTcb,
+                 9,
+                 recvTaskFunc,
+                 0,
+                 &recvTaskStack[0],
+                 LOAD_STACK_SIZE_BYTES,
+                 "RECV",
+                 2);
+    if (status == EASYRTOS_OK)
+    {
+      latencyTimerInit ();
+      easyRTOSStart();
+    }
+  }
+  return 0;
+}
+
+/* 发送任务,队列满时阻塞 */
+void sendTaskFunc (uint32_t param)
+{
+  uint8_t msg[LOAD_MSG_SIZE];
+  uint8_t i;
+
+  for (i = 0; i < LOAD_MSG_SIZE; i++)
+  {
+    msg[i] = i;
+  }
+
+  while (1)
+  {
+    (void)eQueueGive (&loadQueue, 0, msg);
+    msg[0]++;
+  }
+}
+
+/* 接收任务,每次接收都会唤醒发送任务 */
+void recvTaskFunc (uint32_t param)
+{
+  uint8_t msg[LOAD_MSG_SIZE];
+
+  while (1)
+  {
+    if (eQueueTake (&loadQueue, 0, msg) == EASYRTOS_OK)
+    {
+      latencyResult.messages++;
+    }
+
+    if (latencyResult.samples >= LATENCY_SAMPLES)
+    {
+      /* 在此处设置断点查看 latencyResult */
+      latencyResult.avg = (uint16_t)(latencySum / latencyResult.samples);
+      eTimerDelay (DELAY_S(1));
+    }
+  }
+}
+
+/* TIM1不分频,向上计数,更新中断 */
+static void latencyTimerInit (void)
+{
+  TIM1->PSCRH = 0;
+  TIM1->PSCRL = 0;
+  TIM1->ARRH = (uint8_t)((LATENCY_PERIOD - 1) >> 8);
+  TIM1->ARRL = (uint8_t)((LATENCY_PERIOD - 1) & 0xFF);
+  TIM1->SR1 = 0;
+  TIM1->IER = TIM1_IER_UIE;
+  TIM1->CR1 = TIM1_CR1_CEN;
+}
+
+/**
+ * TIM1更新中断,计数器在更新事件时回到0,进入中断时的计数值即为中断延迟
+ * (包含硬件入栈的固定开销).不调用内核接口.
+ */
+#pragma vector = ITC_IRQ_TIM1_OVF + 2
+__interrupt void TIM1_LatencyISR (void)
+{
+  uint8_t h = TIM1->CNTRH;
+  uint16_t cycles = (uint16_t)(((uint16_t)h << 8) | TIM1->CNTRL);
+  uint8_t slot;
+
+  TIM1->SR1 = (uint8_t)(~TIM1_SR1_UIF);
+
+  if (latencyResult.samples >= LATENCY_SAMPLES)
+  {
+    /* 采样完成,停止TIM1 */
+    TIM1->IER = 0;
+    return;
+  }
+
+  latencyResult.samples++;
+  latencySum += cycles;
+  if (cycles < latencyResult.min)
+  {
+    latencyResult.min = cycles;
+  }
+  if (cycles > latencyResult.max)
+  {
+    latencyResult.max = cycles;
+  }
+
+  slot = (uint8_t)(cycles / LATENCY_HIST_STEP);
+  if (slot >= LATENCY_HIST_NUM)
+  {
+    slot = LATENCY_HIST_NUM - 1;
+  }
+  latencyResult.hist[slot]++;
+}
@@ -1,7 +1,7 @@
 /**  
- * : Roy.yu
- * ʱ: 2016.8.23
- * 汾: V0.1
+ * 作者: Roy.yu
+ * 时间: 2016.8.23
+ * 版本: V0.1
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #include "easyRTOS.h"
@@ -28,17 +28,17 @@ uint8_t flag=0;
 int main( void )
 {
   ERESULT status;
-  //ڲʱ 16M
+  //内部时钟 16M
   CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
   
   status = easyRTOSInit(&idleTaskStack[0], IDLE_STACK_SIZE_BYTES);
   
   if (status == EASYRTOS_OK)
   {
-      /* ʹϵͳʱ */
+      /* 使能系统时钟 */
       archInitSystemTickTimer();
 
-      /*  */
+      /* 创建任务 */
       status += eTaskCreat(&testTcb,
                    10, 
                    testTaskFunc, 
@@ -0,0 +1,17 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * Linux主机仿真移植中代替板级的bsp_rtc.h,只提供easyRTOSTimer.c使用的秒计数.
+ */
+#ifndef __BSP_RTC_H__
+#define __BSP_RTC_H__
+
+#include "easyRTOS.h"
+
+/* 系统运行的秒数,由eTimerTick()更新 */
+extern EASYRTOS_NODE_LOCAL volatile uint32_t RTCCount;
+
+#endif
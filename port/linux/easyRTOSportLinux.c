@@ -0,0 +1,1921 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * Linux主机仿真移植,代替easyRTOSport.c和easyRTOSportAsm.s.
+ * 任务切换使用swapcontext(),系统心跳为setitimer()产生的SIGALRM,
+ * 信号处理函数就是心跳中断,在被打断任务的堆栈上运行并可能在退出时切换任务.
+ * 所有任务共用一个Linux线程,任务中调用不可重入的C库函数(printf,malloc等)
+ * 时需要自己用临界区或者eSchedLock()保护.
+ *
+ * 虚拟时间仿真(EASYRTOS_LINUX_VIRTUAL_TIME == 1)不使用信号,中断开关是一个
+ * 变量,中断在开中断的时刻(退出临界区,空闲任务,archSimConsume())按照虚拟时间
+ * 的先后同步调用.只在任务中使用的C库函数不再需要保护.
+ *
+ * 多节点仿真(EASYRTOS_LINUX_NODES == 1)中每个节点是一个线程,同时运行的线程
+ * 数量由信号量限制.所有节点每运行quantum的虚拟时间在同步点等待一次,
+ * 然后取出之前发给自己的串口数据.串口传输一个字节的时间不小于quantum,
+ * 数据总是在接收节点到达发送时间之后才被处理,结果与线程的调度无关.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#if (EASYRTOS_LINUX_NODES == 1)
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "bsp_rtc.h"
+
+/* 每个TCB对应的上下文,TCB中的sp_save_ptr指向它 */
+typedef struct arch_context
+{
+    ucontext_t uc;                    /* 任务上下文 */
+    EASYRTOS_TCB *tcb_ptr;            /* 所属的TCB */
+    struct arch_context *next;        /* 所有上下文的链表 */
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+    uint8_t irqDisabled;              /* 切换出去时的模拟中断开关 */
+#endif
+    uint8_t stack[EASYRTOS_LINUX_STACK_SIZE];
+} ARCH_CONTEXT;
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+/* 场景文件中可以使用的中断数量以及名称长度 */
+#define SIM_IRQ_NUM       16
+#define SIM_IRQ_NAMELEN   16
+
+/* 场景文件中的一个中断事件 */
+typedef struct sim_event
+{
+    uint64_t time;                    /* 发生的虚拟时间,ns */
+    uint32_t seq;                     /* 加入的顺序,相同时间按此排序 */
+    SIM_IRQ_FUNC handler;             /* 中断处理函数 */
+    uint32_t arg;                     /* 中断处理函数的参数 */
+    uint64_t period;                  /* 重复周期,ns */
+    uint32_t count;                   /* 剩余的重复次数 */
+    struct sim_event *next;           /* 按时间排序的链表 */
+} SIM_EVENT;
+
+/* 已连接的中断 */
+typedef struct sim_irq
+{
+    char name[SIM_IRQ_NAMELEN];
+    SIM_IRQ_FUNC handler;
+} SIM_IRQ;
+#endif
+
+#if (EASYRTOS_LINUX_NODES == 1)
+/* 虚拟串口中的一个字节 */
+typedef struct sim_link_data
+{
+    uint64_t time;                    /* 接收节点收到的虚拟时间 */
+    uint64_t sendTime;                /* 发送节点发送时的虚拟时间 */
+    uint8_t data;
+} SIM_LINK_DATA;
+
+/* 单向的虚拟串口,由发送节点写入,接收节点在同步点读取 */
+typedef struct sim_link
+{
+    uint32_t from;                    /* 发送节点 */
+    uint32_t to;                      /* 接收节点 */
+    char irqName[SIM_IRQ_NAMELEN];    /* 接收节点中的中断名称 */
+    uint32_t byteNs;                  /* 传输一个字节的时间 */
+    uint64_t busyUntil;               /* 上一个字节传输完成的时间,只由发送节点使用 */
+    pthread_mutex_t lock;
+    SIM_LINK_DATA *buf;               /* 未读取的数据为buf[head]~buf[tail-1] */
+    uint32_t head;
+    uint32_t tail;
+    uint32_t size;
+} SIM_LINK;
+
+/* 节点 */
+typedef struct sim_node
+{
+    uint32_t id;
+    pthread_t thread;
+} SIM_NODE;
+#endif
+
+/* 全局函数 */
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+uint8_t archCriticalEnter (void);
+void archCriticalExit (uint8_t state);
+void archIdle (void);
+int archSimIrqConnect (const char *name, SIM_IRQ_FUNC handler);
+int archSimLoad (const char *path);
+uint64_t archSimTime (void);
+void archSimConsume (uint32_t ns);
+#else
+void archCriticalEnter (sigset_t *state);
+void archCriticalExit (const sigset_t *state);
+#endif
+void archContextSwitch (EASYRTOS_TCB *old_tcb_ptr, EASYRTOS_TCB *new_tcb_ptr);
+void archFirstTaskRestore (EASYRTOS_TCB *new_tcb_ptr);
+void archTaskContextInit (EASYRTOS_TCB *tcb_ptr, void *stack_top, void (*entry_point)(uint32_t), uint32_t entryParam);
+void archInitSystemTickTimer ( void );
+void archInitIrqLevel (void);
+void archIsrStackInit (void);
+#if (EASYRTOS_ISR_STACK_SIZE > 0)
+void archIsrStackCall (void (*handler)(void));
+#if (EASYRTOS_STACK_CHECK == 1)
+uint16_t archIsrStackFree (void);
+#endif
+#endif
+uint32_t archTicklessSleep (uint32_t ticks);
+void archRunTimeInit (void);
+uint16_t archRunTimeGet (void);
+#if (EASYRTOS_TRACE == 1)
+void archTraceUartInit (void);
+void archTraceUartPut (uint8_t c);
+#endif
+#if (EASYRTOS_LATENCY_HIST == 1)
+void archLatencyInit (void);
+uint16_t archLatencyStamp (void);
+uint16_t archLatencyCapture (void);
+#endif
+void archSoftIrqConnect (SOFT_IRQ_FUNC handler);
+void archSoftIrqRaise (void);
+/* end */
+
+/* 私有函数 */
+static void taskShell (void);
+static void archIrqEnable (void);
+static void systemTickHandler (void);
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+static void simEventInsert (SIM_EVENT *event);
+static uint64_t simNextEventTime (void);
+static void simPoll (void);
+static void simFinish (void);
+static SIM_IRQ_FUNC simIrqFind (const char *name);
+#if (EASYRTOS_LINUX_NODES == 1)
+static void simSync (void);
+static void *nodeThread (void *param);
+#endif
+#else
+static void systemTickISR (int signo);
+static void softIrqISR (int signo);
+static void archTickTimerSet (uint32_t period_us);
+#endif
+/* end */
+
+/* 全局变量 */
+EASYRTOS_NODE_LOCAL volatile uint32_t RTCCount = 0;
+/* end */
+
+/* 本地数据 */
+
+/* 已分配的上下文,任务删除后再次创建时重复使用 */
+static EASYRTOS_NODE_LOCAL ARCH_CONTEXT *contextList = NULL;
+
+/* 软件中断的处理函数 */
+static EASYRTOS_NODE_LOCAL SOFT_IRQ_FUNC softIrqHandler = NULL;
+
+/* 最近一次中断的到达时间,us,相当于STM8定时器的捕获值 */
+static EASYRTOS_NODE_LOCAL uint16_t irqArrival = 0;
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+/* 模拟中断开关,与STM8复位后相同,第一个任务运行前关闭 */
+static EASYRTOS_NODE_LOCAL uint8_t irqDisabled = TRUE;
+
+/* 当前虚拟时间,ns */
+static EASYRTOS_NODE_LOCAL uint64_t simNow = 0;
+
+/* 仿真结束的虚拟时间,0表示不结束 */
+static EASYRTOS_NODE_LOCAL uint64_t simEnd = 0;
+
+/* 系统心跳的周期以及下一次心跳的虚拟时间,周期为0表示心跳没有启动 */
+static EASYRTOS_NODE_LOCAL uint64_t tickPeriod = 0;
+static EASYRTOS_NODE_LOCAL uint64_t tickNext = 0;
+
+/* 开销模型 */
+static EASYRTOS_NODE_LOCAL uint32_t costCritical = EASYRTOS_SIM_CRITICAL_NS;
+static EASYRTOS_NODE_LOCAL uint32_t costSwitch = EASYRTOS_SIM_SWITCH_NS;
+static EASYRTOS_NODE_LOCAL uint32_t costIsr = EASYRTOS_SIM_ISR_NS;
+
+/* 已连接的中断以及按时间排序的事件链表 */
+static EASYRTOS_NODE_LOCAL SIM_IRQ simIrqs[SIM_IRQ_NUM];
+static EASYRTOS_NODE_LOCAL SIM_EVENT *simEvents = NULL;
+
+/* 事件加入链表的顺序 */
+static EASYRTOS_NODE_LOCAL uint32_t simSeq = 0;
+
+/* 等待处理的软件中断以及产生的虚拟时间 */
+static EASYRTOS_NODE_LOCAL uint8_t softIrqPending = FALSE;
+static EASYRTOS_NODE_LOCAL uint64_t softIrqTime = 0;
+
+#if (EASYRTOS_LINUX_NODES == 1)
+/* 以下为所有节点共用 */
+
+/* 虚拟串口 */
+static SIM_LINK *simLinks = NULL;
+static uint32_t simLinkNum = 0;
+
+/* 节点入口,同步的虚拟时间间隔以及仿真结束时间 */
+static NODE_MAIN_FUNC nodeMainFunc = NULL;
+static uint64_t nodeQuantum = 0;
+static uint64_t nodeEnd = 0;
+
+/* 同步点以及同时运行的节点数量,nodeLimited为FALSE时不限制 */
+static pthread_barrier_t nodeBarrier;
+static sem_t nodeRunners;
+static uint8_t nodeLimited = FALSE;
+
+/* 以下为每个节点一份 */
+
+/* 当前线程运行的节点 */
+static EASYRTOS_NODE_LOCAL SIM_NODE *simNode = NULL;
+
+/* 下一个同步点的虚拟时间 */
+static EASYRTOS_NODE_LOCAL uint64_t simBoundary = 0;
+
+/* 节点结束时返回nodeThread() */
+static EASYRTOS_NODE_LOCAL ucontext_t nodeExitCtx;
+static EASYRTOS_NODE_LOCAL volatile uint8_t nodeDone = FALSE;
+#endif
+#else
+/* 模拟中断的信号集合 */
+static sigset_t irqSignals;
+#endif
+
+#if (EASYRTOS_TRACE == 1)
+/* 跟踪记录输出文件 */
+static EASYRTOS_NODE_LOCAL FILE *traceFile = NULL;
+#endif
+/* end */
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+/**
+ * 功能: 进入临界区,关闭模拟中断,虚拟时间前进costCritical.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint8_t 进入前的模拟中断开关
+ *
+ * 调用的函数:
+ * 无
+ */
+uint8_t archCriticalEnter (void)
+{
+    uint8_t state = irqDisabled;
+
+    irqDisabled = TRUE;
+    simNow += costCritical;
+
+    return (state);
+}
+
+/**
+ * 功能: 退出临界区,恢复模拟中断开关,打开时处理临界区中到期的中断.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * uint8_t state 进入前的开关         无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * simPoll ();
+ */
+void archCriticalExit (uint8_t state)
+{
+    irqDisabled = state;
+    if (state == FALSE)
+    {
+      simPoll ();
+    }
+}
+#else
+/**
+ * 功能: 进入临界区,屏蔽所有模拟中断的信号,保存原来的屏蔽字.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            sigset_t *state 进入前的信号屏蔽字
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * sigprocmask (SIG_BLOCK, &irqSignals, state);
+ */
+void archCriticalEnter (sigset_t *state)
+{
+    (void)sigprocmask (SIG_BLOCK, &irqSignals, state);
+}
+
+/**
+ * 功能: 退出临界区,恢复进入临界区前的信号屏蔽字.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * const sigset_t *state 保存的屏蔽字  无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * sigprocmask (SIG_SETMASK, state, NULL);
+ */
+void archCriticalExit (const sigset_t *state)
+{
+    (void)sigprocmask (SIG_SETMASK, state, NULL);
+}
+#endif
+
+/**
+ * 功能: 打开模拟中断,相当于rim().
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * simPoll ();
+ * sigprocmask (SIG_UNBLOCK, &irqSignals, NULL);
+ */
+static void archIrqEnable (void)
+{
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+    irqDisabled = FALSE;
+    simPoll ();
+#else
+    (void)sigprocmask (SIG_UNBLOCK, &irqSignals, NULL);
+#endif
+}
+
+/**
+ * 功能: 任务入口函数,与easyRTOSport.c中的taskShell()相同.新任务开始运行时
+ * 模拟中断仍被屏蔽,在这里打开.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * eCurrentContext();
+ * archIrqEnable ();
+ * curr_tcb->entry_point(curr_tcb->entryParam);
+ * eTaskDelete (curr_tcb, 0);
+ * eTaskSuspend (curr_tcb);
+ */
+static void taskShell (void)
+{
+    EASYRTOS_TCB *curr_tcb;
+
+    curr_tcb = eCurrentContext();
+
+    /* 使能中断 */
+    archIrqEnable ();
+
+    /* 任务函数入口 */
+    if (curr_tcb && curr_tcb->entry_point)
+    {
+        curr_tcb->entry_point(curr_tcb->entryParam);
+    }
+
+    /* 任务函数返回,删除任务,不会再返回 */
+    (void)eTaskDelete (curr_tcb, 0);
+
+    while (1)
+    {
+        (void)eTaskSuspend (curr_tcb);
+    }
+}
+
+/**
+ * 功能: 初始化任务上下文.主机上的C库和信号处理需要较大的堆栈,任务使用
+ * 上下文中EASYRTOS_LINUX_STACK_SIZE大小的堆栈,传入的堆栈不被使用.
+ * 同一个TCB再次创建时重复使用原来的上下文.
+ *
+ * 参数:
+ * 输入:                                       输出:
+ * EASYRTOS_TCB *tcb_ptr 任务TCB               无.
+ * void *stack_top 任务堆栈栈顶(不使用)
+ * void (*entry_point)(uint32_t) 任务函数
+ * uint32_t entryParam 任务参数
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * malloc (sizeof(ARCH_CONTEXT));
+ * getcontext (&ctx->uc);
+ * makecontext (&ctx->uc, taskShell, 0);
+ */
+void archTaskContextInit (EASYRTOS_TCB *tcb_ptr, void *stack_top, void (*entry_point)(uint32_t), uint32_t entryParam)
+{
+    ARCH_CONTEXT *ctx;
+
+    (void)stack_top;
+    (void)entry_point;
+    (void)entryParam;
+
+    /* 查找该TCB已有的上下文 */
+    for (ctx = contextList; ctx != NULL; ctx = ctx->next)
+    {
+      if (ctx->tcb_ptr == tcb_ptr)
+      {
+        break;
+      }
+    }
+
+    if (ctx == NULL)
+    {
+      ctx = malloc (sizeof(ARCH_CONTEXT));
+      if (ctx == NULL)
+      {
+        fprintf (stderr, "easyRTOS: out of memory for task context\n");
+        abort ();
+      }
+      ctx->tcb_ptr = tcb_ptr;
+      ctx->next = contextList;
+      contextList = ctx;
+    }
+
+    (void)getcontext (&ctx->uc);
+    ctx->uc.uc_stack.ss_sp = ctx->stack;
+    ctx->uc.uc_stack.ss_size = sizeof(ctx->stack);
+    ctx->uc.uc_link = NULL;
+
+    /* 与复位后相同,任务在taskShell()中打开中断 */
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+    ctx->irqDisabled = TRUE;
+#else
+    ctx->uc.uc_sigmask = irqSignals;
+#endif
+    makecontext (&ctx->uc, taskShell, 0);
+
+    tcb_ptr->sp_save_ptr = ctx;
+}
+
+/**
+ * 功能: 保存当前任务的上下文,恢复新任务的上下文.在临界区或者信号处理函数中
+ * 调用,被切换出的任务在swapcontext()中返回后继续运行.
+ * 虚拟时间仿真中模拟中断开关随任务保存和恢复,并计入任务切换的开销.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * EASYRTOS_TCB *old_tcb_ptr 当前任务     无.
+ * EASYRTOS_TCB *new_tcb_ptr 新任务
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * swapcontext (&old_ctx->uc, &new_ctx->uc);
+ */
+void archContextSwitch (EASYRTOS_TCB *old_tcb_ptr, EASYRTOS_TCB *new_tcb_ptr)
+{
+    ARCH_CONTEXT *old_ctx = (ARCH_CONTEXT *)old_tcb_ptr->sp_save_ptr;
+    ARCH_CONTEXT *new_ctx = (ARCH_CONTEXT *)new_tcb_ptr->sp_save_ptr;
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+    simNow += costSwitch;
+    old_ctx->irqDisabled = irqDisabled;
+    (void)swapcontext (&old_ctx->uc, &new_ctx->uc);
+    irqDisabled = old_ctx->irqDisabled;
+#else
+    (void)swapcontext (&old_ctx->uc, &new_ctx->uc);
+#endif
+}
+
+/**
+ * 功能: 运行第一个任务,main()的上下文被丢弃,不会返回.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * EASYRTOS_TCB *new_tcb_ptr 第一个任务   无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * setcontext (&new_ctx->uc);
+ */
+void archFirstTaskRestore (EASYRTOS_TCB *new_tcb_ptr)
+{
+    ARCH_CONTEXT *new_ctx = (ARCH_CONTEXT *)new_tcb_ptr->sp_save_ptr;
+
+    (void)setcontext (&new_ctx->uc);
+}
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 0)
+/**
+ * 功能: 设置心跳定时器的周期,为0时停止.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * uint32_t period_us 周期,us    无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * setitimer (ITIMER_REAL, &timer, NULL);
+ */
+static void archTickTimerSet (uint32_t period_us)
+{
+    struct itimerval timer;
+
+    timer.it_interval.tv_sec = period_us / 1000000;
+    timer.it_interval.tv_usec = period_us % 1000000;
+    timer.it_value = timer.it_interval;
+    (void)setitimer (ITIMER_REAL, &timer, NULL);
+}
+
+/**
+ * 功能: 初始化系统心跳,用ITIMER_REAL每EASYRTOS_LINUX_TICK_US产生一次SIGALRM.
+ * 与STM8复位后相同,调用者(main)中的模拟中断保持屏蔽,第一个任务运行后打开.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * sigaction (SIGALRM, &sa, NULL);
+ * archTickTimerSet (EASYRTOS_LINUX_TICK_US);
+ */
+void archInitSystemTickTimer ( void )
+{
+    struct sigaction sa;
+
+    (void)sigprocmask (SIG_BLOCK, &irqSignals, NULL);
+
+    memset (&sa, 0, sizeof(sa));
+    sa.sa_handler = systemTickISR;
+    sa.sa_mask = irqSignals;
+    sa.sa_flags = SA_RESTART;
+    (void)sigaction (SIGALRM, &sa, NULL);
+
+    archTickTimerSet (EASYRTOS_LINUX_TICK_US);
+}
+
+/**
+ * 功能: 主机上没有中断优先级,初始化模拟中断的信号集合.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * sigemptyset (&irqSignals);
+ */
+void archInitIrqLevel (void)
+{
+    (void)sigemptyset (&irqSignals);
+    ARCH_IRQ_SIGNALS (&irqSignals);
+}
+#endif
+
+/**
+ * 功能: 信号处理函数运行在被打断任务的堆栈上,没有单独的中断堆栈.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void archIsrStackInit (void)
+{
+}
+
+#if (EASYRTOS_ISR_STACK_SIZE > 0)
+/**
+ * 功能: 直接在当前堆栈上调用中断处理函数.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * void (*handler)(void) 中断处理函数     无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * handler ();
+ */
+void archIsrStackCall (void (*handler)(void))
+{
+    handler ();
+}
+
+#if (EASYRTOS_STACK_CHECK == 1)
+/**
+ * 功能: 中断堆栈没有被使用,返回全部大小.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint16_t EASYRTOS_ISR_STACK_SIZE
+ *
+ * 调用的函数:
+ * 无
+ */
+uint16_t archIsrStackFree (void)
+{
+    return (EASYRTOS_ISR_STACK_SIZE);
+}
+#endif
+#endif
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 0)
+/**
+ * 功能: 读取单调时钟,换算为us.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint16_t 计数器的值,单位us
+ *
+ * 调用的函数:
+ * clock_gettime (CLOCK_MONOTONIC, &ts);
+ */
+uint16_t archRunTimeGet (void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ((uint16_t)((uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000));
+}
+#endif
+
+/**
+ * 功能: 运行时间使用单调时钟或者虚拟时间,不需要初始化.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void archRunTimeInit (void)
+{
+}
+
+#if (EASYRTOS_LATENCY_HIST == 1)
+/**
+ * 功能: 延迟测量的时间戳与运行时间相同,不需要初始化.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void archLatencyInit (void)
+{
+}
+
+/**
+ * 功能: 读取延迟测量的时间戳.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint16_t 时间戳,单位us
+ *
+ * 调用的函数:
+ * archRunTimeGet ();
+ */
+uint16_t archLatencyStamp (void)
+{
+    return (archRunTimeGet ());
+}
+
+/**
+ * 功能: 读取当前中断的到达时间.虚拟时间下为事件或者心跳的时间,中断被
+ * 临界区推迟时包含推迟的时间;实际时间下为进入信号处理函数的时间.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint16_t 到达时间,单位us
+ *
+ * 调用的函数:
+ * 无
+ */
+uint16_t archLatencyCapture (void)
+{
+    return (irqArrival);
+}
+#endif
+
+#if (EASYRTOS_TRACE == 1)
+/**
+ * 功能: 打开跟踪记录输出文件,文件名由环境变量EASYRTOS_TRACE_FILE指定,
+ * 默认为easyRTOS.trc,可以直接用tools/traceDecode解析.多节点仿真中每个节点
+ * 一个文件,文件名后加上节点编号.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * fopen (name, "wb");
+ */
+void archTraceUartInit (void)
+{
+    const char *name = getenv ("EASYRTOS_TRACE_FILE");
+#if (EASYRTOS_LINUX_NODES == 1)
+    char nodeName[256];
+#endif
+
+    if (name == NULL)
+    {
+      name = "easyRTOS.trc";
+    }
+#if (EASYRTOS_LINUX_NODES == 1)
+    snprintf (nodeName, sizeof(nodeName), "%s.%u", name, (unsigned)archNodeId ());
+    name = nodeName;
+#endif
+    traceFile = fopen (name, "wb");
+    if (traceFile)
+    {
+      setvbuf (traceFile, NULL, _IONBF, 0);
+    }
+}
+
+/**
+ * 功能: 向跟踪记录文件写入一个字节.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * uint8_t c 写入的字节          无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * fputc (c, traceFile);
+ */
+void archTraceUartPut (uint8_t c)
+{
+    if (traceFile)
+    {
+      (void)fputc (c, traceFile);
+    }
+}
+#endif
+
+/**
+ * 功能: 系统心跳的中断处理,与easyRTOSport.c相同.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * eTimerTick();
+ */
+static void systemTickHandler (void)
+{
+    eTimerTick();
+}
+
+/**
+ * 功能: 设置软件中断的处理函数,实际时间模式下安装SIGUSR1的处理函数.
+ * 必须在easyRTOSInit()之后调用.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * SOFT_IRQ_FUNC handler 处理函数     无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * sigaction (SIGUSR1, &sa, NULL);
+ */
+void archSoftIrqConnect (SOFT_IRQ_FUNC handler)
+{
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 0)
+    struct sigaction sa;
+#endif
+
+    softIrqHandler = handler;
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 0)
+    memset (&sa, 0, sizeof(sa));
+    sa.sa_handler = softIrqISR;
+    sa.sa_mask = irqSignals;
+    sa.sa_flags = SA_RESTART;
+    (void)sigaction (SIGUSR1, &sa, NULL);
+#endif
+}
+
+/**
+ * 功能: 产生一次软件中断.模拟中断打开时返回前已经执行完处理函数,
+ * 在临界区中调用时退出临界区后执行.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * simPoll ();
+ * raise (SIGUSR1);
+ */
+void archSoftIrqRaise (void)
+{
+    if (softIrqHandler == NULL)
+    {
+      return;
+    }
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+    softIrqPending = TRUE;
+    softIrqTime = simNow;
+    simPoll ();
+#else
+    (void)raise (SIGUSR1);
+#endif
+}
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 0)
+/**
+ * 功能: SIGALRM处理函数,即系统心跳中断.信号处理期间SIGALRM被屏蔽,
+ * 退出时调用调度器,切换任务时整个信号处理的现场保存在被打断任务的上下文中.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * int signo 信号                无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * eIntEnter ();
+ * archIsrStackCall (systemTickHandler);
+ * eIntExit (TRUE);
+ */
+static void systemTickISR (int signo)
+{
+    (void)signo;
+
+    irqArrival = archRunTimeGet ();
+    eIntEnter ();
+
+    archIsrStackCall (systemTickHandler);
+
+    eIntExit (TRUE);
+}
+
+/**
+ * 功能: SIGUSR1处理函数,即软件中断.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * int signo 信号                无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * eIntEnter ();
+ * archIsrStackCall (softIrqHandler);
+ * eIntExit (FALSE);
+ */
+static void softIrqISR (int signo)
+{
+    (void)signo;
+
+    irqArrival = archRunTimeGet ();
+    eIntEnter ();
+
+    archIsrStackCall (softIrqHandler);
+
+    eIntExit (FALSE);
+}
+
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+/**
+ * 功能: 无心跳低功耗.停止心跳定时器,睡眠ticks个心跳的时间后恢复.
+ * 调用时模拟中断已被屏蔽,睡眠中不会被打断,总是返回ticks.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * uint32_t ticks 最多睡眠的心跳数     无.
+ *
+ * 返回:
+ * uint32_t 实际睡眠的心跳数
+ *
+ * 调用的函数:
+ * archTickTimerSet (0);
+ * nanosleep (&ts, NULL);
+ * archTickTimerSet (EASYRTOS_LINUX_TICK_US);
+ */
+uint32_t archTicklessSleep (uint32_t ticks)
+{
+    struct timespec ts;
+    uint64_t us = (uint64_t)ticks * EASYRTOS_LINUX_TICK_US;
+
+    archTickTimerSet (0);
+
+    ts.tv_sec = (time_t)(us / 1000000);
+    ts.tv_nsec = (long)((us % 1000000) * 1000);
+    while (nanosleep (&ts, &ts) != 0)
+    {
+    }
+
+    archTickTimerSet (EASYRTOS_LINUX_TICK_US);
+
+    return (ticks);
+}
+#endif
+#endif
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+/**
+ * 功能: 启动虚拟时间的系统心跳,周期为1/SYSTEM_TICKS_HZ秒.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void archInitSystemTickTimer ( void )
+{
+    tickPeriod = 1000000000ULL / SYSTEM_TICKS_HZ;
+    tickNext = simNow + tickPeriod;
+}
+
+/**
+ * 功能: 虚拟时间仿真中没有中断优先级.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+void archInitIrqLevel (void)
+{
+}
+
+/**
+ * 功能: 读取虚拟时间,换算为us.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint16_t 计数器的值,单位us
+ *
+ * 调用的函数:
+ * 无
+ */
+uint16_t archRunTimeGet (void)
+{
+    return ((uint16_t)(simNow / 1000));
+}
+
+/**
+ * 功能: 读取当前的虚拟时间.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint64_t 虚拟时间,单位ns
+ *
+ * 调用的函数:
+ * 无
+ */
+uint64_t archSimTime (void)
+{
+    return (simNow);
+}
+
+/**
+ * 功能: 按名称连接场景文件中的中断和处理函数,必须在archSimLoad()之前调用.
+ * 处理函数在eIntEnter()和eIntExit(FALSE)之间调用,可以使用内核的中断接口.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * const char *name 场景文件中的名称      无.
+ * SIM_IRQ_FUNC handler 中断处理函数
+ *
+ * 返回:
+ * int 0:成功 -1:名称过长或者没有空闲的位置
+ *
+ * 调用的函数:
+ * 无
+ */
+int archSimIrqConnect (const char *name, SIM_IRQ_FUNC handler)
+{
+    int i;
+
+    if ((name == NULL) || (handler == NULL) || (strlen (name) >= SIM_IRQ_NAMELEN))
+    {
+      return (-1);
+    }
+
+    for (i = 0; i < SIM_IRQ_NUM; i++)
+    {
+      if ((simIrqs[i].handler == NULL) || (strcmp (simIrqs[i].name, name) == 0))
+      {
+        strcpy (simIrqs[i].name, name);
+        simIrqs[i].handler = handler;
+        return (0);
+      }
+    }
+
+    return (-1);
+}
+
+/**
+ * 功能: 按名称查找已连接的中断处理函数.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * const char *name 中断名称              无.
+ *
+ * 返回:
+ * SIM_IRQ_FUNC 中断处理函数,NULL表示没有连接
+ *
+ * 调用的函数:
+ * 无
+ */
+static SIM_IRQ_FUNC simIrqFind (const char *name)
+{
+    int i;
+
+    for (i = 0; i < SIM_IRQ_NUM; i++)
+    {
+      if (simIrqs[i].handler && (strcmp (simIrqs[i].name, name) == 0))
+      {
+        return (simIrqs[i].handler);
+      }
+    }
+
+    return (NULL);
+}
+
+/**
+ * 功能: 读取场景文件.每行一条命令,'#'之后为注释,时间单位为us:
+ * end <time>                                   仿真结束的时间(多节点仿真中无效)
+ * cost critical|switch|isr <ns>                修改开销模型
+ * irq <time> <name> [arg] [every <period> <count>]
+ *                                              在time产生中断name,重复count次
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * const char *path 场景文件              无.
+ *
+ * 返回:
+ * int 0:成功 -1:文件无法打开或者格式错误,错误信息输出到stderr
+ *
+ * 调用的函数:
+ * simEventInsert (event);
+ */
+int archSimLoad (const char *path)
+{
+    FILE *fp;
+    char line[256];
+    char *tok[8];
+    char *p;
+    char *end;
+    int lineNo = 0;
+    int ntok;
+    int i;
+    int status = 0;
+    SIM_EVENT *event;
+
+    fp = fopen (path, "r");
+    if (fp == NULL)
+    {
+      fprintf (stderr, "%s: cannot open\n", path);
+      return (-1);
+    }
+
+    while ((status == 0) && (fgets (line, sizeof(line), fp) != NULL))
+    {
+      lineNo++;
+      p = strchr (line, '#');
+      if (p)
+      {
+        *p = '\0';
+      }
+
+      /* 按空白分割 */
+      ntok = 0;
+      for (p = strtok (line, " \t\r\n"); p && (ntok < 8); p = strtok (NULL, " \t\r\n"))
+      {
+        tok[ntok++] = p;
+      }
+      if (ntok == 0)
+      {
+        continue;
+      }
+
+      status = -1;
+      if ((strcmp (tok[0], "end") == 0) && (ntok == 2))
+      {
+        simEnd = strtoull (tok[1], &end, 0) * 1000;
+        status = (*end == '\0') ? 0 : -1;
+      }
+      else if ((strcmp (tok[0], "cost") == 0) && (ntok == 3))
+      {
+        uint32_t ns = (uint32_t)strtoul (tok[2], &end, 0);
+
+        if (*end == '\0')
+        {
+          status = 0;
+          if (strcmp (tok[1], "critical") == 0)
+          {
+            costCritical = ns;
+          }
+          else if (strcmp (tok[1], "switch") == 0)
+          {
+            costSwitch = ns;
+          }
+          else if (strcmp (tok[1], "isr") == 0)
+          {
+            costIsr = ns;
+          }
+          else
+          {
+            status = -1;
+          }
+        }
+      }
+      else if ((strcmp (tok[0], "irq") == 0) && ((ntok == 3) || (ntok == 4) || (ntok == 6) || (ntok == 7)))
+      {
+        event = calloc (1, sizeof(SIM_EVENT));
+        if (event == NULL)
+        {
+          break;
+        }
+        event->time = strtoull (tok[1], &end, 0) * 1000;
+        event->seq = simSeq++;
+        event->count = 1;
+        status = (*end == '\0') ? 0 : -1;
+
+        event->handler = simIrqFind (tok[2]);
+        if (event->handler == NULL)
+        {
+          fprintf (stderr, "%s:%d: irq '%s' not connected\n", path, lineNo, tok[2]);
+          status = -2;
+        }
+
+        /* 可选的参数 */
+        i = 3;
+        if ((ntok == 4) || (ntok == 7))
+        {
+          event->arg = (uint32_t)strtoul (tok[3], &end, 0);
+          status = (*end == '\0') ? status : -1;
+          i = 4;
+        }
+
+        /* 可选的重复 */
+        if (ntok > 4)
+        {
+          event->period = strtoull (tok[i + 1], &end, 0) * 1000;
+          status = ((*end == '\0') && (strcmp (tok[i], "every") == 0)) ? status : -1;
+          event->count = (uint32_t)strtoul (tok[i + 2], &end, 0);
+          status = ((*end == '\0') && (event->count > 0) && (event->period > 0)) ? status : -1;
+        }
+
+        if (status == 0)
+        {
+          simEventInsert (event);
+        }
+        else
+        {
+          free (event);
+        }
+      }
+
+      if (status == -1)
+      {
+        fprintf (stderr, "%s:%d: syntax error\n", path, lineNo);
+      }
+    }
+
+    fclose (fp);
+    return ((status == 0) ? 0 : -1);
+}
+
+/**
+ * 功能: 把事件按照时间插入事件链表,相同时间按场景文件中的顺序.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * SIM_EVENT *event 事件                  无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * 无
+ */
+static void simEventInsert (SIM_EVENT *event)
+{
+    SIM_EVENT **pp = &simEvents;
+
+    while (*pp && (((*pp)->time < event->time)
+                   || (((*pp)->time == event->time) && ((*pp)->seq < event->seq))))
+    {
+      pp = &(*pp)->next;
+    }
+    event->next = *pp;
+    *pp = event;
+}
+
+/**
+ * 功能: 下一个心跳、场景事件、同步点或者仿真结束的虚拟时间.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint64_t 虚拟时间,ns,UINT64_MAX表示之后不会再有任何事件
+ *
+ * 调用的函数:
+ * 无
+ */
+static uint64_t simNextEventTime (void)
+{
+    uint64_t next = UINT64_MAX;
+
+    if (tickPeriod && (tickNext < next))
+    {
+      next = tickNext;
+    }
+    if (simEvents && (simEvents->time < next))
+    {
+      next = simEvents->time;
+    }
+#if (EASYRTOS_LINUX_NODES == 1)
+    if (simBoundary < next)
+    {
+      next = simBoundary;
+    }
+#else
+    if (simEnd && (simEnd < next))
+    {
+      next = simEnd;
+    }
+#endif
+
+    return (next);
+}
+
+/**
+ * 功能: 在开中断的时刻依次处理所有已经到期的中断,相同时间心跳在前.
+ * 中断退出时可能切换任务,在调用处理函数之前更新心跳时间和事件链表,
+ * 其他任务中的simPoll()不会重复处理同一个中断.到达结束时间时结束仿真,
+ * 多节点仿真中到达同步点时与其他节点同步.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * simSync ();
+ * simFinish ();
+ * eIntEnter ();
+ * archIsrStackCall (systemTickHandler);
+ * archIsrStackCall (softIrqHandler);
+ * handler (arg);
+ * eIntExit (timerTick);
+ */
+static void simPoll (void)
+{
+    SIM_EVENT *event;
+    SIM_IRQ_FUNC handler;
+    uint32_t arg;
+
+    while (irqDisabled == FALSE)
+    {
+#if (EASYRTOS_LINUX_NODES == 1)
+      if (simNow >= simBoundary)
+      {
+        simSync ();
+      }
+#else
+      if (simEnd && (simNow >= simEnd))
+      {
+        simFinish ();
+      }
+#endif
+
+      if (tickPeriod && (tickNext <= simNow))
+      {
+        irqArrival = (uint16_t)(tickNext / 1000);
+        tickNext += tickPeriod;
+
+        irqDisabled = TRUE;
+        simNow += costIsr;
+        eIntEnter ();
+        archIsrStackCall (systemTickHandler);
+        eIntExit (TRUE);
+        irqDisabled = FALSE;
+      }
+      else if (softIrqPending)
+      {
+        softIrqPending = FALSE;
+        irqArrival = (uint16_t)(softIrqTime / 1000);
+
+        irqDisabled = TRUE;
+        simNow += costIsr;
+        eIntEnter ();
+        archIsrStackCall (softIrqHandler);
+        eIntExit (FALSE);
+        irqDisabled = FALSE;
+      }
+      else if (simEvents && (simEvents->time <= simNow))
+      {
+        event = simEvents;
+        simEvents = event->next;
+        handler = event->handler;
+        arg = event->arg;
+        irqArrival = (uint16_t)(event->time / 1000);
+        if (--event->count > 0)
+        {
+          event->time += event->period;
+          simEventInsert (event);
+        }
+        else
+        {
+          free (event);
+        }
+
+        irqDisabled = TRUE;
+        simNow += costIsr;
+        eIntEnter ();
+        handler (arg);
+        eIntExit (FALSE);
+        irqDisabled = FALSE;
+      }
+      else
+      {
+        break;
+      }
+    }
+}
+
+/**
+ * 功能: 结束仿真,程序可以用atexit()注册输出结果的函数.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * exit (0);
+ */
+static void simFinish (void)
+{
+    fflush (stdout);
+    exit (0);
+}
+
+/**
+ * 功能: 空闲任务中调用,没有任务可以运行,虚拟时间直接前进到下一个事件.
+ * 之后不会再有任何事件时结束仿真.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * simNextEventTime ();
+ * simFinish ();
+ * simPoll ();
+ */
+void archIdle (void)
+{
+    uint64_t next;
+
+    next = simNextEventTime ();
+    if (next == UINT64_MAX)
+    {
+      simFinish ();
+    }
+    if (next > simNow)
+    {
+      simNow = next;
+    }
+
+    simPoll ();
+}
+
+/**
+ * 功能: 模拟任务执行ns的计算,期间到期的中断在精确的时间处理.
+ * 被抢占的时间不计入,关中断时只增加虚拟时间.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * uint32_t ns 计算时间          无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * simNextEventTime ();
+ * simPoll ();
+ */
+void archSimConsume (uint32_t ns)
+{
+    uint64_t left = ns;
+    uint64_t step;
+    uint64_t next;
+
+    if (irqDisabled)
+    {
+      simNow += left;
+      return;
+    }
+
+    while (left > 0)
+    {
+      next = simNextEventTime ();
+      step = (next > simNow) ? (next - simNow) : 0;
+      if (step > left)
+      {
+        step = left;
+      }
+      simNow += step;
+      left -= step;
+
+      simPoll ();
+    }
+}
+
+#if (EASYRTOS_TICKLESS_IDLE == 1)
+/**
+ * 功能: 无心跳低功耗.虚拟时间直接前进到最后一个跳过的心跳,
+ * 期间有场景事件或者同步点时提前唤醒,返回已经跳过的心跳数.
+ *
+ * 参数:
+ * 输入:                              输出:
+ * uint32_t ticks 最多睡眠的心跳数     无.
+ *
+ * 返回:
+ * uint32_t 实际睡眠的心跳数
+ *
+ * 调用的函数:
+ * 无
+ */
+uint32_t archTicklessSleep (uint32_t ticks)
+{
+    uint64_t wake;
+    uint64_t first = UINT64_MAX;
+    uint32_t slept = ticks;
+
+    if ((ticks == 0) || (tickPeriod == 0))
+    {
+      return (0);
+    }
+
+    /* 最后一个跳过的心跳 */
+    wake = tickNext + (uint64_t)(ticks - 1) * tickPeriod;
+
+    if (simEvents)
+    {
+      first = simEvents->time;
+    }
+#if (EASYRTOS_LINUX_NODES == 1)
+    if (simBoundary < first)
+    {
+      first = simBoundary;
+    }
+#else
+    if (simEnd && (simEnd < first))
+    {
+      first = simEnd;
+    }
+#endif
+
+    if (first < wake)
+    {
+      /* 提前唤醒,只跳过唤醒之前的心跳 */
+      slept = (first < tickNext) ? 0 : (uint32_t)((first - tickNext) / tickPeriod + 1);
+      wake = first;
+    }
+
+    if (wake > simNow)
+    {
+      simNow = wake;
+    }
+    tickNext += (uint64_t)slept * tickPeriod;
+
+    return (slept);
+}
+#endif
+
+#if (EASYRTOS_LINUX_NODES == 1)
+/**
+ * 功能: 创建一条从节点from到节点to的单向虚拟串口,必须在archNodeRun()之前调用.
+ * 接收节点在收到每个字节时调用名称为irqName的中断,参数为收到的字节.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * uint32_t from 发送节点                 无.
+ * uint32_t to 接收节点
+ * const char *irqName 接收中断的名称
+ * uint32_t byteNs 传输一个字节的时间,ns
+ *
+ * 返回:
+ * int 串口编号,-1表示参数错误或者内存不足
+ *
+ * 调用的函数:
+ * realloc (simLinks, size);
+ */
+int archLinkCreate (uint32_t from, uint32_t to, const char *irqName, uint32_t byteNs)
+{
+    SIM_LINK *links;
+    SIM_LINK *link;
+
+    if ((irqName == NULL) || (strlen (irqName) >= SIM_IRQ_NAMELEN) || (byteNs == 0))
+    {
+      return (-1);
+    }
+
+    links = realloc (simLinks, (simLinkNum + 1) * sizeof(SIM_LINK));
+    if (links == NULL)
+    {
+      return (-1);
+    }
+    simLinks = links;
+
+    link = &simLinks[simLinkNum];
+    memset (link, 0, sizeof(SIM_LINK));
+    link->from = from;
+    link->to = to;
+    strcpy (link->irqName, irqName);
+    link->byteNs = byteNs;
+    (void)pthread_mutex_init (&link->lock, NULL);
+
+    return ((int)simLinkNum++);
+}
+
+/**
+ * 功能: 查找从节点from到节点to的虚拟串口.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * uint32_t from 发送节点                 无.
+ * uint32_t to 接收节点
+ *
+ * 返回:
+ * int 串口编号,-1表示不存在
+ *
+ * 调用的函数:
+ * 无
+ */
+int archLinkFind (uint32_t from, uint32_t to)
+{
+    uint32_t i;
+
+    for (i = 0; i < simLinkNum; i++)
+    {
+      if ((simLinks[i].from == from) && (simLinks[i].to == to))
+      {
+        return ((int)i);
+      }
+    }
+
+    return (-1);
+}
+
+/**
+ * 功能: 从当前节点发送一个字节.字节依次传输,前一个字节传输完成之前发送的
+ * 字节排队等待,接收节点在传输完成的虚拟时间产生中断.任务和中断中都可以调用.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * int link 串口编号                      无.
+ * uint8_t data 发送的字节
+ *
+ * 返回:
+ * int 0:成功 -1:串口不存在,不属于当前节点或者内存不足
+ *
+ * 调用的函数:
+ * realloc (link->buf, size);
+ */
+int archLinkSend (int link, uint8_t data)
+{
+    SIM_LINK *l;
+    SIM_LINK_DATA *buf;
+    uint64_t start;
+    int status = 0;
+
+    if ((simNode == NULL) || (link < 0) || ((uint32_t)link >= simLinkNum)
+        || (simLinks[link].from != simNode->id))
+    {
+      return (-1);
+    }
+    l = &simLinks[link];
+
+    start = (l->busyUntil > simNow) ? l->busyUntil : simNow;
+
+    (void)pthread_mutex_lock (&l->lock);
+    if (l->tail == l->size)
+    {
+      if (l->head > 0)
+      {
+        /* 移到缓冲区开头 */
+        memmove (l->buf, &l->buf[l->head], (l->tail - l->head) * sizeof(SIM_LINK_DATA));
+        l->tail -= l->head;
+        l->head = 0;
+      }
+      else
+      {
+        buf = realloc (l->buf, (l->size ? l->size * 2 : 64) * sizeof(SIM_LINK_DATA));
+        if (buf)
+        {
+          l->buf = buf;
+          l->size = l->size ? l->size * 2 : 64;
+        }
+      }
+    }
+    if (l->tail < l->size)
+    {
+      l->buf[l->tail].time = start + l->byteNs;
+      l->buf[l->tail].sendTime = simNow;
+      l->buf[l->tail].data = data;
+      l->tail++;
+      l->busyUntil = start + l->byteNs;
+    }
+    else
+    {
+      status = -1;
+    }
+    (void)pthread_mutex_unlock (&l->lock);
+
+    return (status);
+}
+
+/**
+ * 功能: 同步点.等待所有节点到达后,取出其他节点在同步点之前发送给本节点的
+ * 数据,作为中断事件加入事件链表.到达仿真结束时间时返回nodeThread().
+ * 每个串口的数据按发送时间排列,串口按编号依次读取,与其他节点是否已经
+ * 开始运行下一个片段无关.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回: void
+ *
+ * 调用的函数:
+ * pthread_barrier_wait (&nodeBarrier);
+ * simEventInsert (event);
+ */
+static void simSync (void)
+{
+    SIM_LINK *l;
+    SIM_EVENT *event;
+    SIM_IRQ_FUNC handler;
+    uint32_t i;
+
+    /* 让出运行名额,等待所有节点 */
+    if (nodeLimited)
+    {
+      (void)sem_post (&nodeRunners);
+    }
+    (void)pthread_barrier_wait (&nodeBarrier);
+
+    if (simBoundary >= nodeEnd)
+    {
+      nodeDone = TRUE;
+      (void)setcontext (&nodeExitCtx);
+    }
+
+    for (i = 0; i < simLinkNum; i++)
+    {
+      l = &simLinks[i];
+      if (l->to != simNode->id)
+      {
+        continue;
+      }
+
+      handler = simIrqFind (l->irqName);
+      (void)pthread_mutex_lock (&l->lock);
+      while ((l->head != l->tail) && (l->buf[l->head].sendTime < simBoundary))
+      {
+        event = (handler) ? calloc (1, sizeof(SIM_EVENT)) : NULL;
+        if (event)
+        {
+          event->time = l->buf[l->head].time;
+          event->seq = simSeq++;
+          event->handler = handler;
+          event->arg = l->buf[l->head].data;
+          event->count = 1;
+          simEventInsert (event);
+        }
+        l->head++;
+      }
+      (void)pthread_mutex_unlock (&l->lock);
+    }
+
+    simBoundary += nodeQuantum;
+    if (nodeLimited)
+    {
+      (void)sem_wait (&nodeRunners);
+    }
+}
+
+/**
+ * 功能: 节点线程.调用节点入口启动easyRTOS,仿真结束时从simSync()返回这里.
+ * 节点入口返回(初始化失败)时节点不运行任务,仍然参加同步.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * void *param 节点              无.
+ *
+ * 返回:
+ * void * NULL
+ *
+ * 调用的函数:
+ * nodeMainFunc (simNode->id);
+ * simSync ();
+ */
+static void *nodeThread (void *param)
+{
+    ARCH_CONTEXT *ctx;
+    SIM_EVENT *event;
+
+    simNode = (SIM_NODE *)param;
+    simBoundary = nodeQuantum;
+
+    if (nodeLimited)
+    {
+      (void)sem_wait (&nodeRunners);
+    }
+    (void)getcontext (&nodeExitCtx);
+    if (nodeDone == FALSE)
+    {
+      nodeMainFunc (simNode->id);
+
+      irqDisabled = TRUE;
+      while (1)
+      {
+        simNow = simBoundary;
+        simSync ();
+      }
+    }
+
+    /* 已经回到线程的堆栈,释放任务上下文 */
+    while (contextList)
+    {
+      ctx = contextList;
+      contextList = ctx->next;
+      free (ctx);
+    }
+    while (simEvents)
+    {
+      event = simEvents;
+      simEvents = event->next;
+      free (event);
+    }
+
+    return (NULL);
+}
+
+/**
+ * 功能: 创建nodeNum个节点并运行到endNs,所有节点结束后返回.
+ * 最多threads个节点同时运行,为0时不限制.quantumNs不能大于任何串口
+ * 传输一个字节的时间,endNs向上取整为quantumNs的整数倍.
+ *
+ * 参数:
+ * 输入:                                  输出:
+ * uint32_t nodeNum 节点数量              无.
+ * NODE_MAIN_FUNC nodeMain 节点入口
+ * uint32_t threads 同时运行的节点数量
+ * uint64_t endNs 仿真结束时间,ns
+ * uint64_t quantumNs 同步间隔,ns
+ *
+ * 返回:
+ * int 0:成功 -1:参数错误或者无法创建线程
+ *
+ * 调用的函数:
+ * pthread_create (&nodes[i].thread, NULL, nodeThread, &nodes[i]);
+ * pthread_join (nodes[i].thread, NULL);
+ */
+int archNodeRun (uint32_t nodeNum, NODE_MAIN_FUNC nodeMain, uint32_t threads,
+                 uint64_t endNs, uint64_t quantumNs)
+{
+    SIM_NODE *nodes;
+    uint32_t i;
+    uint32_t created;
+
+    if ((nodeNum == 0) || (nodeMain == NULL) || (quantumNs == 0))
+    {
+      return (-1);
+    }
+    for (i = 0; i < simLinkNum; i++)
+    {
+      if ((simLinks[i].from >= nodeNum) || (simLinks[i].to >= nodeNum)
+          || (simLinks[i].byteNs < quantumNs))
+      {
+        fprintf (stderr, "easyRTOS: link %u invalid or faster than quantum\n", (unsigned)i);
+        return (-1);
+      }
+    }
+    nodeLimited = ((threads != 0) && (threads < nodeNum)) ? TRUE : FALSE;
+
+    nodes = calloc (nodeNum, sizeof(SIM_NODE));
+    if (nodes == NULL)
+    {
+      return (-1);
+    }
+
+    nodeMainFunc = nodeMain;
+    nodeQuantum = quantumNs;
+    nodeEnd = (endNs + quantumNs - 1) / quantumNs * quantumNs;
+    (void)pthread_barrier_init (&nodeBarrier, NULL, nodeNum);
+    (void)sem_init (&nodeRunners, 0, nodeLimited ? threads : 0);
+
+    for (created = 0; created < nodeNum; created++)
+    {
+      nodes[created].id = created;
+      if (pthread_create (&nodes[created].thread, NULL, nodeThread, &nodes[created]) != 0)
+      {
+        /* 已经创建的节点会永远等待同步点 */
+        fprintf (stderr, "easyRTOS: cannot create node %u\n", (unsigned)created);
+        abort ();
+      }
+    }
+
+    for (i = 0; i < nodeNum; i++)
+    {
+      (void)pthread_join (nodes[i].thread, NULL);
+    }
+
+    (void)pthread_barrier_destroy (&nodeBarrier);
+    (void)sem_destroy (&nodeRunners);
+    free (nodes);
+
+    return (0);
+}
+
+/**
+ * 功能: 当前线程运行的节点编号.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无.
+ *
+ * 返回:
+ * uint32_t 节点编号,不在节点线程中时为0
+ *
+ * 调用的函数:
+ * 无
+ */
+uint32_t archNodeId (void)
+{
+    return ((simNode) ? simNode->id : 0);
+}
+#endif
+#endif
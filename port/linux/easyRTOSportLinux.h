@@ -0,0 +1,135 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * Linux主机仿真移植.编译时定义EASYRTOS_PORT_LINUX,由easyRTOS.h代替stm8s.h
+ * 包含,提供内核需要的整数类型以及临界区.
+ * 中断用信号模拟,系统心跳为SIGALRM,临界区屏蔽ARCH_IRQ_SIGNALS中的信号.
+ * 任务上下文用ucontext保存,所有任务运行在同一个Linux线程中.
+ *
+ * EASYRTOS_LINUX_VIRTUAL_TIME为1时使用虚拟时间的离散事件仿真:没有信号,
+ * 心跳和场景文件中的中断在精确的虚拟时间产生.虚拟时间只在空闲任务、
+ * archSimConsume()以及开销模型(临界区、任务切换、中断)中前进,
+ * 相同的程序和场景文件每次运行的结果完全相同.
+ *
+ * EASYRTOS_LINUX_NODES为1时在一个进程中仿真多个系统(节点),需要虚拟时间.
+ * 内核以及移植的状态变量为线程局部存储,每个节点在自己的线程中运行,
+ * 应用的全局变量同样需要用EASYRTOS_NODE_LOCAL声明.节点按照固定的虚拟时间
+ * 片段同步运行,节点之间用虚拟串口连接,结果与线程数量无关.
+ */
+#ifndef __EASYRTOSPORTLINUX__H__
+#define __EASYRTOSPORTLINUX__H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <signal.h>
+
+typedef uint8_t   u8;
+typedef uint16_t  u16;
+typedef uint32_t  u32;
+
+/* 主机上没有分段的数据区 */
+#define NEAR
+
+/* 1:虚拟时间仿真 0:由实际时间的SIGALRM驱动 */
+#ifndef EASYRTOS_LINUX_VIRTUAL_TIME
+#define EASYRTOS_LINUX_VIRTUAL_TIME 0
+#endif
+
+/* 1:一个进程中仿真多个节点 0:只有一个系统 */
+#ifndef EASYRTOS_LINUX_NODES
+#define EASYRTOS_LINUX_NODES        0
+#endif
+
+#if (EASYRTOS_LINUX_NODES == 1)
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 0)
+#error "EASYRTOS_LINUX_NODES requires EASYRTOS_LINUX_VIRTUAL_TIME"
+#endif
+/* 每个节点线程拥有一份内核状态 */
+#define EASYRTOS_NODE_LOCAL         __thread
+#endif
+
+/* 模拟中断使用的信号,临界区中全部屏蔽.SIGUSR1为软件中断 */
+#define ARCH_IRQ_SIGNALS(set)   (sigaddset((set), SIGALRM), sigaddset((set), SIGUSR1))
+
+/* 任务实际使用的堆栈大小,任务创建时传入的堆栈只用于堆栈检查 */
+#ifndef EASYRTOS_LINUX_STACK_SIZE
+#define EASYRTOS_LINUX_STACK_SIZE   65536
+#endif
+
+/**
+ * 心跳定时器的周期,单位us.默认与SYSTEM_TICKS_HZ一致,
+ * 减小该值可以让仿真的系统时间比实际时间走得更快.
+ */
+#ifndef EASYRTOS_LINUX_TICK_US
+#define EASYRTOS_LINUX_TICK_US      (1000000 / SYSTEM_TICKS_HZ)
+#endif
+
+/**
+ * 软件中断,相当于STM8的trap指令,用于测试中断中调用内核接口的路径.
+ * 在任务中调用archSoftIrqRaise()后立即进入handler,在临界区中调用时
+ * 退出临界区后进入.
+ */
+typedef void ( * SOFT_IRQ_FUNC ) ( void ) ;
+
+extern void archSoftIrqConnect (SOFT_IRQ_FUNC handler);
+extern void archSoftIrqRaise (void);
+
+#if (EASYRTOS_LINUX_VIRTUAL_TIME == 1)
+/**
+ * 虚拟时间的开销模型,单位ns,大致为STM8 16MHz下的时间.
+ * 可以在场景文件中用cost命令修改.
+ */
+#ifndef EASYRTOS_SIM_CRITICAL_NS
+#define EASYRTOS_SIM_CRITICAL_NS    250     /* 每次进入临界区 */
+#endif
+#ifndef EASYRTOS_SIM_SWITCH_NS
+#define EASYRTOS_SIM_SWITCH_NS      4000    /* 每次任务切换 */
+#endif
+#ifndef EASYRTOS_SIM_ISR_NS
+#define EASYRTOS_SIM_ISR_NS         1000    /* 每次中断的进入和退出 */
+#endif
+
+/* 保存进入临界区前的模拟中断开关,可以嵌套,退出到开中断时处理到期的中断 */
+#define CRITICAL_STORE      uint8_t _istate
+#define CRITICAL_ENTER()    (_istate = archCriticalEnter ())
+#define CRITICAL_EXIT()     archCriticalExit (_istate)
+
+/* 空闲任务中把虚拟时间推进到下一个事件 */
+#define ARCH_IDLE()         archIdle ()
+
+/* 场景文件中的中断处理函数,参数为场景文件中给出的值 */
+typedef void ( * SIM_IRQ_FUNC ) ( uint32_t arg ) ;
+
+extern uint8_t archCriticalEnter (void);
+extern void archCriticalExit (uint8_t state);
+extern void archIdle (void);
+extern int archSimIrqConnect (const char *name, SIM_IRQ_FUNC handler);
+extern int archSimLoad (const char *path);
+extern uint64_t archSimTime (void);
+extern void archSimConsume (uint32_t ns);
+
+#if (EASYRTOS_LINUX_NODES == 1)
+/* 节点入口,在节点的线程中初始化并启动easyRTOS,不返回 */
+typedef void ( * NODE_MAIN_FUNC ) ( uint32_t nodeId ) ;
+
+extern int archLinkCreate (uint32_t from, uint32_t to, const char *irqName, uint32_t byteNs);
+extern int archLinkFind (uint32_t from, uint32_t to);
+extern int archLinkSend (int link, uint8_t data);
+extern int archNodeRun (uint32_t nodeNum, NODE_MAIN_FUNC nodeMain, uint32_t threads,
+                        uint64_t endNs, uint64_t quantumNs);
+extern uint32_t archNodeId (void);
+#endif
+#else
+/* 保存进入临界区前的信号屏蔽字,可以嵌套 */
+#define CRITICAL_STORE      sigset_t _istate
+#define CRITICAL_ENTER()    archCriticalEnter (&_istate)
+#define CRITICAL_EXIT()     archCriticalExit (&_istate)
+
+extern void archCriticalEnter (sigset_t *state);
+extern void archCriticalExit (const sigset_t *state);
+#endif
+
+#endif
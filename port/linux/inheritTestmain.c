@@ -0,0 +1,273 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 互斥锁优先级继承和天花板互斥锁的回归测试,用EASYRTOS_LINUX_VIRTUAL_TIME=1
+ * 编译.优先级最低的控制任务依次检查:
+ * 1.传递继承:L拥有m1,M拥有m2并等待m1,H等待m2,L继承H的优先级;
+ *   释放之后每个任务恢复原来的优先级.
+ * 2.等待互斥锁超时后,拥有者不再继承等待任务的优先级.
+ * 3.天花板互斥锁:拥有期间提升到天花板优先级,释放后恢复.
+ * 全部通过时输出PASS.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define TEST_STACK_SIZE_BYTES  128
+
+#define CTRL_PRIO              20
+#define LOW_PRIO               15
+#define MID_PRIO               10
+#define HIGH_PRIO              5
+#define CEILING_PRIO           3
+
+/* lowTaskFunc()的参数,拥有的互斥锁 */
+#define LOW_MUTEX_1            0
+#define LOW_MUTEX_CEILING      1
+
+EASYRTOS_TCB ctrlTcb;
+EASYRTOS_TCB lowTcb;
+EASYRTOS_TCB midTcb;
+EASYRTOS_TCB highTcb;
+EASYRTOS_SEM mutex1;
+EASYRTOS_SEM mutex2;
+EASYRTOS_SEM ceilMutex;
+EASYRTOS_SEM lowGo;
+
+static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+static uint8_t ctrlTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t lowTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t midTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t highTaskStack[TEST_STACK_SIZE_BYTES];
+
+/* 各任务释放互斥锁之后的优先级,以及获取互斥锁的结果 */
+static uint8_t lowAfterGive = 0;
+static uint8_t midAfterGive = 0;
+static uint8_t highHeld = 0;
+static ERESULT highResult = EASYRTOS_OK;
+static int testStep = 0;
+static int testPassed = FALSE;
+
+void ctrlTaskFunc (uint32_t param);
+void lowTaskFunc (uint32_t param);
+void midTaskFunc (uint32_t param);
+void highTaskFunc (uint32_t param);
+void highTimeoutFunc (uint32_t param);
+static int testChain (void);
+static int testTimeout (void);
+static int testCeiling (void);
+static void testReport (void);
+
+int main( int argc, char *argv[] )
+{
+  ERESULT status;
+
+  /* 系统初始化 */
+  status = easyRTOSInit(idleTaskStack, IDLE_STACK_SIZE_BYTES);
+
+  if (archSimLoad ((argc > 1) ? argv[1] : "taskTest.scn") != 0)
+  {
+    return (1);
+  }
+  atexit (testReport);
+
+  if (status == EASYRTOS_OK)
+  {
+      /* 使能系统时钟 */
+      archInitSystemTickTimer();
+
+      mutex1 = eSemCreateMutex ();
+      mutex2 = eSemCreateMutex ();
+      ceilMutex = eSemCreateCeiling (CEILING_PRIO);
+      lowGo = eSemCreateBinary ();
+
+      status = eTaskCreat(&ctrlTcb, CTRL_PRIO, ctrlTaskFunc, 0,
+                   ctrlTaskStack, TEST_STACK_SIZE_BYTES, "CTRL", 1);
+
+      if (status == EASYRTOS_OK)
+      {
+        easyRTOSStart();
+      }
+  }
+
+  printf ("inheritTest: init failed (%d)\n", status);
+  return (1);
+}
+
+/* 依次执行各项测试,全部通过后结束仿真 */
+void ctrlTaskFunc (uint32_t param)
+{
+  testStep = 1;
+  if (testChain () == TRUE)
+  {
+    testStep = 2;
+    if (testTimeout () == TRUE)
+    {
+      testStep = 3;
+      if (testCeiling () == TRUE)
+      {
+        testPassed = TRUE;
+      }
+    }
+  }
+  exit (0);
+}
+
+/* 拥有param指定的互斥锁(LOW_MUTEX_XXX),等待控制任务通知后释放 */
+void lowTaskFunc (uint32_t param)
+{
+  EASYRTOS_SEM *mutex = (param == LOW_MUTEX_CEILING) ? &ceilMutex : &mutex1;
+
+  if (eSemTake (mutex, 0) == EASYRTOS_OK)
+  {
+    (void)eSemTake (&lowGo, 0);
+    (void)eSemGive (mutex);
+    lowAfterGive = eCurrentContext ()->priority;
+  }
+}
+
+/* 拥有m2并等待m1,之后先释放m2 */
+void midTaskFunc (uint32_t param)
+{
+  if ((eSemTake (&mutex2, 0) == EASYRTOS_OK) && (eSemTake (&mutex1, 0) == EASYRTOS_OK))
+  {
+    (void)eSemGive (&mutex2);
+    midAfterGive = eCurrentContext ()->priority;
+    (void)eSemGive (&mutex1);
+  }
+}
+
+/* 等待m2 */
+void highTaskFunc (uint32_t param)
+{
+  highResult = eSemTake (&mutex2, 0);
+  if (highResult == EASYRTOS_OK)
+  {
+    highHeld = eCurrentContext ()->priority;
+    (void)eSemGive (&mutex2);
+  }
+}
+
+/* 带超时等待m1 */
+void highTimeoutFunc (uint32_t param)
+{
+  highResult = eSemTake (&mutex1, DELAY_MS(10));
+}
+
+/* 1.传递继承以及释放后恢复优先级 */
+static int testChain (void)
+{
+  /* L拥有m1 */
+  if ((eTaskCreat (&lowTcb, LOW_PRIO, lowTaskFunc, LOW_MUTEX_1,
+                   lowTaskStack, TEST_STACK_SIZE_BYTES, "LOW", 2) != EASYRTOS_OK)
+      || (mutex1.owner != &lowTcb) || (lowTcb.priority != LOW_PRIO))
+  {
+    return (FALSE);
+  }
+
+  /* M拥有m2并等待m1,L继承M的优先级 */
+  if ((eTaskCreat (&midTcb, MID_PRIO, midTaskFunc, 0,
+                   midTaskStack, TEST_STACK_SIZE_BYTES, "MID", 3) != EASYRTOS_OK)
+      || (midTcb.pended_mutex != &mutex1) || (lowTcb.priority != MID_PRIO))
+  {
+    return (FALSE);
+  }
+
+  /* H等待m2,M继承H的优先级,并经过m1传递给L */
+  if ((eTaskCreat (&highTcb, HIGH_PRIO, highTaskFunc, 0,
+                   highTaskStack, TEST_STACK_SIZE_BYTES, "HIGH", 4) != EASYRTOS_OK)
+      || (highTcb.pended_mutex != &mutex2)
+      || (midTcb.priority != HIGH_PRIO) || (lowTcb.priority != HIGH_PRIO))
+  {
+    return (FALSE);
+  }
+
+  /**
+   * L释放m1后恢复原来的优先级,M获得m1后释放m2,恢复到自己的优先级,
+   * H获得m2后以自己的优先级运行.三个任务都在返回之前运行完毕.
+   */
+  (void)eSemGive (&lowGo);
+  if ((lowAfterGive != LOW_PRIO) || (midAfterGive != MID_PRIO)
+      || (highResult != EASYRTOS_OK) || (highHeld != HIGH_PRIO)
+      || (mutex1.owner != NULL) || (mutex2.owner != NULL)
+      || (lowTcb.state != TASK_DELETED) || (midTcb.state != TASK_DELETED)
+      || (highTcb.state != TASK_DELETED))
+  {
+    return (FALSE);
+  }
+
+  return (TRUE);
+}
+
+/* 2.等待任务超时后,拥有者恢复原来的优先级 */
+static int testTimeout (void)
+{
+  lowAfterGive = 0;
+  if ((eTaskCreat (&lowTcb, LOW_PRIO, lowTaskFunc, LOW_MUTEX_1,
+                   lowTaskStack, TEST_STACK_SIZE_BYTES, "LOW", 2) != EASYRTOS_OK)
+      || (eTaskCreat (&highTcb, HIGH_PRIO, highTimeoutFunc, 0,
+                   highTaskStack, TEST_STACK_SIZE_BYTES, "HIGH", 4) != EASYRTOS_OK)
+      || (lowTcb.priority != HIGH_PRIO))
+  {
+    return (FALSE);
+  }
+
+  (void)eTimerDelay (DELAY_MS(20));
+  if ((highResult != EASYRTOS_TIMEOUT) || (lowTcb.priority != LOW_PRIO)
+      || (mutex1.owner != &lowTcb))
+  {
+    return (FALSE);
+  }
+
+  (void)eSemGive (&lowGo);
+  if ((lowAfterGive != LOW_PRIO) || (mutex1.owner != NULL))
+  {
+    return (FALSE);
+  }
+
+  return (TRUE);
+}
+
+/* 3.天花板互斥锁拥有期间提升优先级,释放后恢复 */
+static int testCeiling (void)
+{
+  lowAfterGive = 0;
+  if ((eTaskCreat (&lowTcb, LOW_PRIO, lowTaskFunc, LOW_MUTEX_CEILING,
+                   lowTaskStack, TEST_STACK_SIZE_BYTES, "LOW", 2) != EASYRTOS_OK)
+      || (ceilMutex.owner != &lowTcb) || (lowTcb.priority != CEILING_PRIO)
+      || (lowTcb.basePriority != LOW_PRIO))
+  {
+    return (FALSE);
+  }
+
+  (void)eSemGive (&lowGo);
+  if ((lowAfterGive != LOW_PRIO) || (ceilMutex.owner != NULL))
+  {
+    return (FALSE);
+  }
+
+  return (TRUE);
+}
+
+/* 仿真结束时输出结果 */
+static void testReport (void)
+{
+  printf ("inheritTest: virtual time %llu ns, step %d: %s\n",
+          (unsigned long long)archSimTime (), testStep,
+          (testPassed == TRUE) ? "PASS" : "FAIL");
+  fflush (stdout);
+  if (testPassed != TRUE)
+  {
+    _exit (1);
+  }
+}
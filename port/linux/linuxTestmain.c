@@ -0,0 +1,149 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * Linux主机仿真移植的自测程序:生产者任务按心跳节拍通过队列发送序号,
+ * 消费者任务检查序号连续,低优先级的忙任务只能靠心跳中断抢占.
+ * 检查任务延时一段时间后比较计数,打印结果,并以此作为进程的退出码.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+#include "easyRTOSQueue.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define TEST_STACK_SIZE_BYTES  128
+
+#define QUEUE_DEEP             8
+#define TEST_TICKS             DELAY_MS(500)
+
+EASYRTOS_TCB checkTcb;
+EASYRTOS_TCB producerTcb;
+EASYRTOS_TCB consumerTcb;
+EASYRTOS_TCB busyTcb;
+EASYRTOS_QUEUE testQueue;
+EASYRTOS_SEM doneSem;
+
+static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+static uint8_t checkTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t producerTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t consumerTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t busyTaskStack[TEST_STACK_SIZE_BYTES];
+static uint32_t queueBuff[QUEUE_DEEP];
+
+static volatile uint32_t produced = 0;
+static volatile uint32_t consumed = 0;
+static volatile uint32_t outOfOrder = 0;
+static volatile uint32_t busyLoops = 0;
+
+void checkTaskFunc (uint32_t param);
+void producerTaskFunc (uint32_t param);
+void consumerTaskFunc (uint32_t param);
+void busyTaskFunc (uint32_t param);
+
+int main( void )
+{
+  ERESULT status;
+
+  /* 系统初始化 */
+  status = easyRTOSInit(idleTaskStack, IDLE_STACK_SIZE_BYTES);
+
+  if (status == EASYRTOS_OK)
+  {
+      /* 使能系统时钟 */
+      archInitSystemTickTimer();
+
+      testQueue = eQueueCreate (queueBuff, sizeof(uint32_t), QUEUE_DEEP);
+      doneSem = eSemCreateCount (0);
+
+      /* 创建任务 */
+      status += eTaskCreat(&checkTcb, 8, checkTaskFunc, 0,
+                   checkTaskStack, TEST_STACK_SIZE_BYTES, "CHECK", 1);
+      status += eTaskCreat(&consumerTcb, 9, consumerTaskFunc, 0,
+                   consumerTaskStack, TEST_STACK_SIZE_BYTES, "CONSUMER", 2);
+      status += eTaskCreat(&producerTcb, 10, producerTaskFunc, 0,
+                   producerTaskStack, TEST_STACK_SIZE_BYTES, "PRODUCER", 3);
+      status += eTaskCreat(&busyTcb, 20, busyTaskFunc, 0,
+                   busyTaskStack, TEST_STACK_SIZE_BYTES, "BUSY", 4);
+
+      if (status == EASYRTOS_OK)
+      {
+        easyRTOSStart();
+      }
+  }
+
+  printf ("linuxTest: init failed (%d)\n", status);
+  return (1);
+}
+
+void producerTaskFunc (uint32_t param)
+{
+  uint32_t seq = 0;
+
+  for (;;)
+  {
+    if (eQueueGive (&testQueue, 0, &seq) == EASYRTOS_OK)
+    {
+      seq++;
+      produced = seq;
+    }
+    eTimerDelay (1);
+  }
+}
+
+void consumerTaskFunc (uint32_t param)
+{
+  uint32_t seq;
+  uint32_t expect = 0;
+
+  for (;;)
+  {
+    if (eQueueTake (&testQueue, 0, &seq) == EASYRTOS_OK)
+    {
+      if (seq != expect)
+      {
+        outOfOrder++;
+      }
+      expect = seq + 1;
+      consumed = expect;
+    }
+  }
+}
+
+void busyTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    busyLoops++;
+  }
+}
+
+void checkTaskFunc (uint32_t param)
+{
+  uint32_t start;
+  uint32_t elapsed;
+  uint8_t pass;
+
+  start = eTimeGet ();
+  (void)eSemTake (&doneSem, TEST_TICKS);
+  elapsed = eTimeGet () - start;
+
+  /* 生产者每个心跳最多发送一次,消费者优先级更高,总能取完 */
+  pass = (elapsed >= TEST_TICKS)
+         && (produced >= TEST_TICKS / 2) && (produced <= TEST_TICKS + 1)
+         && (consumed == produced) && (outOfOrder == 0)
+         && (busyLoops != 0);
+
+  printf ("linuxTest: ticks %lu produced %lu consumed %lu outOfOrder %lu busy %lu: %s\n",
+          (unsigned long)elapsed, (unsigned long)produced, (unsigned long)consumed,
+          (unsigned long)outOfOrder, (unsigned long)busyLoops, pass ? "PASS" : "FAIL");
+
+  exit (pass ? 0 : 1);
+}
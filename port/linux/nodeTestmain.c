@@ -0,0 +1,186 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 多节点仿真的示例以及回归测试,用EASYRTOS_LINUX_VIRTUAL_TIME=1和
+ * EASYRTOS_LINUX_NODES=1编译.节点通过115200波特率的虚拟串口连成一个环,
+ * 节点0发出的令牌在环上依次转发,每个节点还定时向下一个节点发送心跳.
+ * 输出与线程数量无关,用不同的线程数运行两次比较即可检查仿真的确定性.
+ * 用法: nodeTest [节点数量] [线程数量] [仿真秒数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSQueue.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define TEST_STACK_SIZE_BYTES  128
+
+#define QUEUE_DEEP             16
+#define TOKEN_NUM              4
+#define HEARTBEAT              0xFF
+
+/* 115200波特率,10位传输一个字节 */
+#define UART_BYTE_NS           86806
+#define MAX_NODES              1024
+
+/* 以下为每个节点一份 */
+static EASYRTOS_NODE_LOCAL EASYRTOS_TCB rxTcb;
+static EASYRTOS_NODE_LOCAL EASYRTOS_TCB heartbeatTcb;
+static EASYRTOS_NODE_LOCAL EASYRTOS_QUEUE rxQueue;
+static EASYRTOS_NODE_LOCAL uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+static EASYRTOS_NODE_LOCAL uint8_t rxTaskStack[TEST_STACK_SIZE_BYTES];
+static EASYRTOS_NODE_LOCAL uint8_t heartbeatTaskStack[TEST_STACK_SIZE_BYTES];
+static EASYRTOS_NODE_LOCAL uint8_t queueBuff[QUEUE_DEEP];
+static EASYRTOS_NODE_LOCAL int txLink;
+
+/* 每个节点的结果,由各自的线程写入 */
+static uint32_t nodeTokens[MAX_NODES];
+static uint32_t nodeHeartbeats[MAX_NODES];
+static uint32_t nodeDropped[MAX_NODES];
+static uint32_t nodeChecksum[MAX_NODES];
+
+void rxTaskFunc (uint32_t param);
+void heartbeatTaskFunc (uint32_t param);
+static void uartRxIsr (uint32_t arg);
+static void nodeMain (uint32_t nodeId);
+
+int main( int argc, char *argv[] )
+{
+  uint32_t nodeNum = (argc > 1) ? (uint32_t)atoi (argv[1]) : 100;
+  uint32_t threads = (argc > 2) ? (uint32_t)atoi (argv[2]) : 0;
+  uint32_t seconds = (argc > 3) ? (uint32_t)atoi (argv[3]) : 10;
+  uint32_t i;
+  uint32_t tokens = 0;
+  uint32_t heartbeats = 0;
+  uint32_t dropped = 0;
+  uint32_t checksum = 0;
+
+  if ((nodeNum < 2) || (nodeNum > MAX_NODES))
+  {
+    printf ("nodeTest: 2~%d nodes\n", MAX_NODES);
+    return (1);
+  }
+
+  /* 节点连成环 */
+  for (i = 0; i < nodeNum; i++)
+  {
+    if (archLinkCreate (i, (i + 1) % nodeNum, "UART_RX", UART_BYTE_NS) < 0)
+    {
+      return (1);
+    }
+  }
+
+  if (archNodeRun (nodeNum, nodeMain, threads, (uint64_t)seconds * 1000000000ULL, UART_BYTE_NS) != 0)
+  {
+    return (1);
+  }
+
+  for (i = 0; i < nodeNum; i++)
+  {
+    tokens += nodeTokens[i];
+    heartbeats += nodeHeartbeats[i];
+    dropped += nodeDropped[i];
+    checksum = checksum * 31 + nodeChecksum[i];
+  }
+  printf ("nodeTest: %lu nodes, %lu s, tokens %lu heartbeats %lu dropped %lu checksum %08lx\n",
+          (unsigned long)nodeNum, (unsigned long)seconds, (unsigned long)tokens,
+          (unsigned long)heartbeats, (unsigned long)dropped, (unsigned long)checksum);
+
+  return (0);
+}
+
+/* 节点入口,在节点的线程中运行 */
+static void nodeMain (uint32_t nodeId)
+{
+  ERESULT status;
+
+  status = easyRTOSInit(idleTaskStack, IDLE_STACK_SIZE_BYTES);
+  if ((status != EASYRTOS_OK) || (archSimIrqConnect ("UART_RX", uartRxIsr) != 0))
+  {
+    return;
+  }
+  txLink = archLinkFind (nodeId, nodeId + 1);
+  if (txLink < 0)
+  {
+    txLink = archLinkFind (nodeId, 0);
+  }
+
+  /* 使能系统时钟 */
+  archInitSystemTickTimer();
+
+  rxQueue = eQueueCreate (queueBuff, sizeof(uint8_t), QUEUE_DEEP);
+
+  status += eTaskCreat(&rxTcb, 5, rxTaskFunc, nodeId,
+               rxTaskStack, TEST_STACK_SIZE_BYTES, "RX", 1);
+  status += eTaskCreat(&heartbeatTcb, 7, heartbeatTaskFunc, nodeId,
+               heartbeatTaskStack, TEST_STACK_SIZE_BYTES, "HEARTBEAT", 2);
+
+  if (status == EASYRTOS_OK)
+  {
+    easyRTOSStart();
+  }
+}
+
+/* 串口接收中断,队列满时丢弃 */
+static void uartRxIsr (uint32_t arg)
+{
+  uint8_t data = (uint8_t)arg;
+
+  if (eQueueGive (&rxQueue, -1, &data) != EASYRTOS_OK)
+  {
+    nodeDropped[archNodeId ()]++;
+  }
+}
+
+/* 转发令牌,令牌的值每经过一个节点加一 */
+void rxTaskFunc (uint32_t param)
+{
+  uint8_t data;
+  uint8_t i;
+
+  if (param == 0)
+  {
+    for (i = 0; i < TOKEN_NUM; i++)
+    {
+      (void)archLinkSend (txLink, i);
+    }
+  }
+
+  for (;;)
+  {
+    if (eQueueTake (&rxQueue, 0, &data) == EASYRTOS_OK)
+    {
+      nodeChecksum[param] = nodeChecksum[param] * 31 + data + (uint32_t)(eTimeGet () & 0xFF);
+      if (data == HEARTBEAT)
+      {
+        nodeHeartbeats[param]++;
+      }
+      else
+      {
+        nodeTokens[param]++;
+
+        /* 处理后转发 */
+        archSimConsume (50000);
+        (void)archLinkSend (txLink, (uint8_t)((data + 1) % HEARTBEAT));
+      }
+    }
+  }
+}
+
+/* 定时发送心跳,周期与节点编号有关 */
+void heartbeatTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    (void)eTimerDelay (DELAY_MS(20 + param % 7));
+    archSimConsume (1000000);
+    (void)archLinkSend (txLink, HEARTBEAT);
+  }
+}
@@ -0,0 +1,202 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 虚拟时间仿真的示例以及回归测试,用EASYRTOS_LINUX_VIRTUAL_TIME=1编译.
+ * 场景文件(simTest.scn)中的串口中断把收到的字节放入队列,按键中断释放信号量,
+ * 任务用archSimConsume()模拟处理时间.仿真结束时输出每种中断到处理任务开始
+ * 运行的响应时间(虚拟时间,ns),相同的程序和场景每次输出完全相同,
+ * 与simTest.expected比较即可发现队列和信号量路径上的变化.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+#include "easyRTOSQueue.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define TEST_STACK_SIZE_BYTES  128
+
+#define QUEUE_DEEP             16
+
+/* 队列中的消息,带有中断发生的虚拟时间 */
+typedef struct uart_msg
+{
+  uint64_t stamp;
+  uint32_t data;
+} UART_MSG;
+
+/* 响应时间统计 */
+typedef struct resp_stat
+{
+  uint32_t count;
+  uint64_t min;
+  uint64_t max;
+  uint64_t sum;
+} RESP_STAT;
+
+EASYRTOS_TCB uartTcb;
+EASYRTOS_TCB buttonTcb;
+EASYRTOS_TCB periodicTcb;
+EASYRTOS_QUEUE uartQueue;
+EASYRTOS_SEM buttonSem;
+
+static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+static uint8_t uartTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t buttonTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t periodicTaskStack[TEST_STACK_SIZE_BYTES];
+static UART_MSG queueBuff[QUEUE_DEEP];
+
+static uint64_t buttonStamp;
+static uint32_t uartDropped = 0;
+static uint32_t periodicRuns = 0;
+static RESP_STAT uartStat;
+static RESP_STAT buttonStat;
+
+void uartTaskFunc (uint32_t param);
+void buttonTaskFunc (uint32_t param);
+void periodicTaskFunc (uint32_t param);
+static void uartRxIsr (uint32_t arg);
+static void buttonIsr (uint32_t arg);
+static void statAdd (RESP_STAT *stat, uint64_t resp);
+static void statPrint (const char *name, RESP_STAT *stat);
+static void simReport (void);
+
+int main( int argc, char *argv[] )
+{
+  ERESULT status;
+
+  /* 系统初始化 */
+  status = easyRTOSInit(idleTaskStack, IDLE_STACK_SIZE_BYTES);
+
+  /* 连接场景文件中的中断 */
+  if ((archSimIrqConnect ("UART_RX", uartRxIsr) != 0)
+      || (archSimIrqConnect ("BUTTON", buttonIsr) != 0)
+      || (archSimLoad ((argc > 1) ? argv[1] : "simTest.scn") != 0))
+  {
+    return (1);
+  }
+  atexit (simReport);
+
+  if (status == EASYRTOS_OK)
+  {
+      /* 使能系统时钟 */
+      archInitSystemTickTimer();
+
+      uartQueue = eQueueCreate (queueBuff, sizeof(UART_MSG), QUEUE_DEEP);
+      buttonSem = eSemCreateBinary ();
+
+      /* 创建任务 */
+      status += eTaskCreat(&buttonTcb, 3, buttonTaskFunc, 0,
+                   buttonTaskStack, TEST_STACK_SIZE_BYTES, "BUTTON", 1);
+      status += eTaskCreat(&uartTcb, 5, uartTaskFunc, 0,
+                   uartTaskStack, TEST_STACK_SIZE_BYTES, "UART", 2);
+      status += eTaskCreat(&periodicTcb, 7, periodicTaskFunc, 0,
+                   periodicTaskStack, TEST_STACK_SIZE_BYTES, "PERIODIC", 3);
+
+      if (status == EASYRTOS_OK)
+      {
+        easyRTOSStart();
+      }
+  }
+
+  printf ("simTest: init failed (%d)\n", status);
+  return (1);
+}
+
+/* 串口接收中断,队列满时丢弃 */
+static void uartRxIsr (uint32_t arg)
+{
+  UART_MSG msg;
+
+  msg.stamp = archSimTime ();
+  msg.data = arg;
+  if (eQueueGive (&uartQueue, -1, &msg) != EASYRTOS_OK)
+  {
+    uartDropped++;
+  }
+}
+
+/* 按键中断 */
+static void buttonIsr (uint32_t arg)
+{
+  buttonStamp = archSimTime ();
+  (void)eSemGive (&buttonSem);
+}
+
+void uartTaskFunc (uint32_t param)
+{
+  UART_MSG msg;
+
+  for (;;)
+  {
+    if (eQueueTake (&uartQueue, 0, &msg) == EASYRTOS_OK)
+    {
+      statAdd (&uartStat, archSimTime () - msg.stamp);
+
+      /* 处理一个字节 */
+      archSimConsume (20000);
+    }
+  }
+}
+
+void buttonTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    if (eSemTake (&buttonSem, 0) == EASYRTOS_OK)
+    {
+      statAdd (&buttonStat, archSimTime () - buttonStamp);
+      archSimConsume (300000);
+    }
+  }
+}
+
+void periodicTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    (void)eTimerDelay (DELAY_MS(10));
+    periodicRuns++;
+    archSimConsume (2000000);
+  }
+}
+
+static void statAdd (RESP_STAT *stat, uint64_t resp)
+{
+  if ((stat->count == 0) || (resp < stat->min))
+  {
+    stat->min = resp;
+  }
+  if (resp > stat->max)
+  {
+    stat->max = resp;
+  }
+  stat->sum += resp;
+  stat->count++;
+}
+
+static void statPrint (const char *name, RESP_STAT *stat)
+{
+  printf ("%-8s count %6lu min %8llu avg %8llu max %8llu ns\n", name,
+          (unsigned long)stat->count, (unsigned long long)stat->min,
+          (unsigned long long)(stat->count ? stat->sum / stat->count : 0),
+          (unsigned long long)stat->max);
+}
+
+/* 仿真结束时输出结果 */
+static void simReport (void)
+{
+  printf ("simTest: virtual time %llu ns, ticks %lu\n",
+          (unsigned long long)archSimTime (), (unsigned long)eTimeGet ());
+  statPrint ("UART_RX", &uartStat);
+  statPrint ("BUTTON", &buttonStat);
+  printf ("UART_RX  dropped %lu, periodic runs %lu\n",
+          (unsigned long)uartDropped, (unsigned long)periodicRuns);
+}
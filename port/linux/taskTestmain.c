@@ -0,0 +1,318 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 任务挂起,恢复和删除的回归测试,用EASYRTOS_LINUX_VIRTUAL_TIME=1编译.
+ * 优先级较低的控制任务依次检查:
+ * 1.删除带超时悬挂在信号量上的任务,超时定时器不再触发.
+ * 2.挂起以及删除悬挂在队列上的任务,消息不会交给被挂起或者删除的任务.
+ * 3.持有调度器锁的任务删除自己并释放TCB和堆栈,以及任务函数持锁返回,
+ *   调度器不会停止,释放的内存可以重新分配.
+ * 全部通过时输出PASS.调度器停止时仿真在taskTest.scn的结束时间退出,输出FAIL.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+#include "easyRTOSQueue.h"
+#include "easyRTOSMm.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define TEST_STACK_SIZE_BYTES  128
+#define HEAP_SIZE              1024
+
+#define QUEUE_DEEP             4
+
+/* 控制任务的优先级低于被测任务,被测任务创建后立即运行到悬挂 */
+#define CTRL_PRIO              10
+#define WORKER_PRIO            5
+
+EASYRTOS_TCB ctrlTcb;
+EASYRTOS_TCB semTcb;
+EASYRTOS_TCB queueTcb;
+EASYRTOS_TCB shellTcb;
+EASYRTOS_SEM testSem;
+EASYRTOS_QUEUE testQueue;
+
+static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+static uint8_t ctrlTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t semTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t queueTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t shellTaskStack[TEST_STACK_SIZE_BYTES];
+static uint8_t heapRoom[HEAP_SIZE];
+static uint32_t queueBuff[QUEUE_DEEP];
+
+static uint32_t semReturned = 0;
+static uint32_t queueSuspended = 0;
+static uint32_t queueReceived = 0;
+static uint32_t queueLast = 0;
+static uint32_t selfRan = 0;
+static uint32_t selfReturned = 0;
+static uint32_t shellRan = 0;
+static int testStep = 0;
+static int testPassed = FALSE;
+
+void ctrlTaskFunc (uint32_t param);
+void semTaskFunc (uint32_t param);
+void queueTaskFunc (uint32_t param);
+void selfTaskFunc (uint32_t param);
+void shellTaskFunc (uint32_t param);
+static int testDeletePended (void);
+static int testQueueWaiter (void);
+static int testSelfDelete (void);
+static void testReport (void);
+
+int main( int argc, char *argv[] )
+{
+  ERESULT status;
+
+  /* 系统初始化 */
+  status = easyRTOSInit(idleTaskStack, IDLE_STACK_SIZE_BYTES);
+
+  if (archSimLoad ((argc > 1) ? argv[1] : "taskTest.scn") != 0)
+  {
+    return (1);
+  }
+  atexit (testReport);
+
+  if (status == EASYRTOS_OK)
+  {
+      /* 使能系统时钟 */
+      archInitSystemTickTimer();
+
+      eMemInit (heapRoom, HEAP_SIZE);
+      testSem = eSemCreateBinary ();
+      testQueue = eQueueCreate (queueBuff, sizeof(uint32_t), QUEUE_DEEP);
+
+      status = eTaskCreat(&ctrlTcb, CTRL_PRIO, ctrlTaskFunc, 0,
+                   ctrlTaskStack, TEST_STACK_SIZE_BYTES, "CTRL", 1);
+
+      if (status == EASYRTOS_OK)
+      {
+        easyRTOSStart();
+      }
+  }
+
+  printf ("taskTest: init failed (%d)\n", status);
+  return (1);
+}
+
+/* 依次执行各项测试,全部通过后结束仿真 */
+void ctrlTaskFunc (uint32_t param)
+{
+  testStep = 1;
+  if (testDeletePended () == TRUE)
+  {
+    testStep = 2;
+    if (testQueueWaiter () == TRUE)
+    {
+      testStep = 3;
+      if (testSelfDelete () == TRUE)
+      {
+        testPassed = TRUE;
+      }
+    }
+  }
+  exit (0);
+}
+
+/* 带超时悬挂在信号量上,被删除后不会返回 */
+void semTaskFunc (uint32_t param)
+{
+  (void)eSemTake (&testSem, DELAY_MS(50));
+  semReturned++;
+}
+
+/* 悬挂在队列上,记录被挂起的次数和收到的消息 */
+void queueTaskFunc (uint32_t param)
+{
+  uint32_t msg;
+  ERESULT status;
+
+  for (;;)
+  {
+    status = eQueueTake (&testQueue, 0, &msg);
+    if (status == EASYRTOS_ERR_SUSPENDED)
+    {
+      queueSuspended++;
+    }
+    else if (status == EASYRTOS_OK)
+    {
+      queueReceived++;
+      queueLast = msg;
+    }
+  }
+}
+
+/* 持有调度器锁时删除自己,并释放eMalloc()分配的TCB和堆栈 */
+void selfTaskFunc (uint32_t param)
+{
+  selfRan++;
+  eSchedLock ();
+  (void)eTaskDelete (eCurrentContext (), EASYRTOS_FREE_TCB | EASYRTOS_FREE_STACK);
+  selfReturned++;
+}
+
+/* 持有调度器锁时返回,由taskShell()删除 */
+void shellTaskFunc (uint32_t param)
+{
+  shellRan++;
+  eSchedLock ();
+}
+
+/* 1.删除带超时悬挂的任务,超时之后信号量没有残留的悬挂任务 */
+static int testDeletePended (void)
+{
+  if ((eTaskCreat (&semTcb, WORKER_PRIO, semTaskFunc, 0, semTaskStack,
+                   TEST_STACK_SIZE_BYTES, "SEM", 2) != EASYRTOS_OK)
+      || (semTcb.state != TASK_PENDED) || (semTcb.pended_timo_cb == NULL))
+  {
+    return (FALSE);
+  }
+
+  if ((eTaskDelete (&semTcb, 0) != EASYRTOS_OK) || (semTcb.state != TASK_DELETED)
+      || (semTcb.pended_timo_cb != NULL))
+  {
+    return (FALSE);
+  }
+
+  /* 超过原来的超时时间,定时器已经取消,任务不会再运行 */
+  (void)eTimerDelay (DELAY_MS(100));
+  if ((semReturned != 0) || (semTcb.state != TASK_DELETED))
+  {
+    return (FALSE);
+  }
+
+  /* 信号量上没有悬挂的任务,释放的信号量可以立即获取 */
+  if ((eSemGive (&testSem) != EASYRTOS_OK) || (eSemTake (&testSem, -1) != EASYRTOS_OK))
+  {
+    return (FALSE);
+  }
+
+  /* 删除后不能重复删除,TCB可以重新创建任务 */
+  if (eTaskDelete (&semTcb, 0) != EASYRTOS_ERR_PARAM)
+  {
+    return (FALSE);
+  }
+  if ((eTaskCreat (&semTcb, WORKER_PRIO, semTaskFunc, 0, semTaskStack,
+                   TEST_STACK_SIZE_BYTES, "SEM", 2) != EASYRTOS_OK)
+      || (eTaskDelete (&semTcb, 0) != EASYRTOS_OK))
+  {
+    return (FALSE);
+  }
+
+  return (TRUE);
+}
+
+/* 2.挂起和删除悬挂在队列上的任务 */
+static int testQueueWaiter (void)
+{
+  uint32_t msg;
+
+  if ((eTaskCreat (&queueTcb, WORKER_PRIO, queueTaskFunc, 0, queueTaskStack,
+                   TEST_STACK_SIZE_BYTES, "QUEUE", 3) != EASYRTOS_OK)
+      || (queueTcb.state != TASK_PENDED))
+  {
+    return (FALSE);
+  }
+
+  /* 挂起后消息留在队列中 */
+  if ((eTaskSuspend (&queueTcb) != EASYRTOS_OK) || (queueTcb.state != TASK_SUSPEND))
+  {
+    return (FALSE);
+  }
+  msg = 0x1234;
+  if ((eQueueGive (&testQueue, -1, &msg) != EASYRTOS_OK) || (queueReceived != 0))
+  {
+    return (FALSE);
+  }
+
+  /* 恢复后先返回EASYRTOS_ERR_SUSPENDED,再取出消息并重新悬挂 */
+  if ((eTaskResume (&queueTcb) != EASYRTOS_OK) || (queueSuspended != 1)
+      || (queueReceived != 1) || (queueLast != 0x1234)
+      || (queueTcb.state != TASK_PENDED))
+  {
+    return (FALSE);
+  }
+
+  /* 删除后消息不会交给该任务 */
+  if ((eTaskDelete (&queueTcb, 0) != EASYRTOS_OK) || (queueTcb.state != TASK_DELETED))
+  {
+    return (FALSE);
+  }
+  msg = 0x5678;
+  if ((eQueueGive (&testQueue, -1, &msg) != EASYRTOS_OK) || (queueReceived != 1))
+  {
+    return (FALSE);
+  }
+  msg = 0;
+  if ((eQueueTake (&testQueue, -1, &msg) != EASYRTOS_OK) || (msg != 0x5678))
+  {
+    return (FALSE);
+  }
+
+  return (TRUE);
+}
+
+/* 3.持锁删除自己并释放内存,以及持锁返回的任务函数 */
+static int testSelfDelete (void)
+{
+  EASYRTOS_TCB *tcb;
+  uint8_t *stack;
+
+  tcb = (EASYRTOS_TCB *)eMalloc (sizeof(EASYRTOS_TCB));
+  stack = eMalloc (TEST_STACK_SIZE_BYTES);
+  if ((tcb == NULL) || (stack == NULL))
+  {
+    return (FALSE);
+  }
+
+  /* 任务立即运行并删除自己,调度器锁随任务释放,回到控制任务 */
+  if ((eTaskCreat (tcb, WORKER_PRIO, selfTaskFunc, 0, stack,
+                   TEST_STACK_SIZE_BYTES, "SELF", 4) != EASYRTOS_OK)
+      || (selfRan != 1) || (selfReturned != 0))
+  {
+    return (FALSE);
+  }
+
+  /* 调度器没有停止,延时可以返回,期间idleTask释放了TCB和堆栈 */
+  (void)eTimerDelay (DELAY_MS(5));
+  if ((eMalloc (sizeof(EASYRTOS_TCB)) != (uint8_t *)tcb)
+      || (eMalloc (TEST_STACK_SIZE_BYTES) != stack))
+  {
+    return (FALSE);
+  }
+  eFree (stack);
+  eFree ((uint8_t *)tcb);
+
+  /* 任务函数持锁返回 */
+  if ((eTaskCreat (&shellTcb, WORKER_PRIO, shellTaskFunc, 0, shellTaskStack,
+                   TEST_STACK_SIZE_BYTES, "SHELL", 5) != EASYRTOS_OK)
+      || (shellRan != 1) || (shellTcb.state != TASK_DELETED))
+  {
+    return (FALSE);
+  }
+  (void)eTimerDelay (DELAY_MS(5));
+
+  return (TRUE);
+}
+
+/* 仿真结束时输出结果,调度器停止导致仿真超时也在这里报告 */
+static void testReport (void)
+{
+  printf ("taskTest: virtual time %llu ns, step %d: %s\n",
+          (unsigned long long)archSimTime (), testStep,
+          (testPassed == TRUE) ? "PASS" : "FAIL");
+  fflush (stdout);
+  if (testPassed != TRUE)
+  {
+    _exit (1);
+  }
+}
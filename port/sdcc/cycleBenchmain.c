@@ -0,0 +1,367 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 内核周期数基准测试,用SDCC编译,在ucsim的STM8仿真器(sstm8)中运行.
+ * TIM1不分频自由计数作为CPU周期计数器,每项测试重复BENCH_RUNS次,
+ * 减去读取计数器本身的开销后记录最小值和最大值,单位为CPU周期(16MHz).
+ * 测试期间停止TIM4系统心跳,心跳中断由软件产生更新事件触发,因此结果不受
+ * 心跳干扰,仿真器中每次运行的结果完全相同,最小值与最大值相等.
+ * 结果保存在benchResult中,并通过UART1(115200)输出,最后发送一个EOT(0x04).
+ *
+ * switch    eTaskYield()切换到同优先级任务,从调用到对方任务返回
+ * semwake   eSemGive()唤醒高优先级任务,到该任务从eSemTake()返回
+ * queuertt  eQueueGive()到高优先级任务,对方eQueueTake()后回送,到eQueueTake()取回
+ * malloc    eMalloc(BENCH_ALLOC_SIZE)
+ * free      eFree()
+ * tickisr   心跳中断,包括硬件入栈、eTimerTick()、调度检查以及iret
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+#include "easyRTOSQueue.h"
+#include "easyRTOSMm.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define BENCH_STACK_SIZE_BYTES 192
+
+#define BENCH_RUNS             16
+#define BENCH_ALLOC_SIZE       32
+#define HEAP_SIZE              256
+#define QUEUE_DEEP             2
+#define BENCH_BAUD             115200
+
+/* 测试项目 */
+#define BENCH_SWITCH           0
+#define BENCH_SEM_WAKE         1
+#define BENCH_QUEUE_RTT        2
+#define BENCH_MALLOC           3
+#define BENCH_FREE             4
+#define BENCH_TICK_ISR         5
+#define BENCH_NUM              6
+
+typedef struct bench_result
+{
+  uint16_t count;       /* 采样次数 */
+  uint16_t min;         /* 最小周期数 */
+  uint16_t max;         /* 最大周期数 */
+} BENCH_RESULT;
+
+BENCH_RESULT benchResult[BENCH_NUM];
+
+static const char * const benchName[BENCH_NUM] =
+{
+  "switch", "semwake", "queuertt", "malloc", "free", "tickisr"
+};
+
+NEAR static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+NEAR static uint8_t benchTaskStack[BENCH_STACK_SIZE_BYTES];
+NEAR static uint8_t yieldTaskStack[BENCH_STACK_SIZE_BYTES];
+NEAR static uint8_t wakeTaskStack[BENCH_STACK_SIZE_BYTES];
+NEAR static uint8_t echoTaskStack[BENCH_STACK_SIZE_BYTES];
+static uint8_t heapRoom[HEAP_SIZE];
+static uint16_t reqQueueBuff[QUEUE_DEEP];
+static uint16_t ackQueueBuff[QUEUE_DEEP];
+
+EASYRTOS_TCB benchTcb;
+EASYRTOS_TCB yieldTcb;
+EASYRTOS_TCB wakeTcb;
+EASYRTOS_TCB echoTcb;
+EASYRTOS_SEM yieldSem;
+EASYRTOS_SEM wakeSem;
+EASYRTOS_QUEUE reqQueue;
+EASYRTOS_QUEUE ackQueue;
+
+/* 跨任务测量时的起始时间,以及读取计数器本身的周期数 */
+static volatile uint16_t stampStart;
+static uint16_t stampOverhead;
+static volatile uint8_t yieldActive = FALSE;
+
+void benchTaskFunc (uint32_t param);
+void yieldTaskFunc (uint32_t param);
+void wakeTaskFunc (uint32_t param);
+void echoTaskFunc (uint32_t param);
+static uint16_t cycleGet (void);
+static void benchAdd (uint8_t id, uint16_t cycles);
+static void benchReport (void);
+
+int main( void )
+{
+  ERESULT status;
+
+  /* 内部时钟 16M */
+  CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
+
+  status = easyRTOSInit(&idleTaskStack[0], IDLE_STACK_SIZE_BYTES);
+  if (status == EASYRTOS_OK)
+  {
+    archInitSystemTickTimer();
+
+    eMemInit(heapRoom, HEAP_SIZE);
+    yieldSem = eSemCreateCount (0);
+    wakeSem = eSemCreateCount (0);
+    reqQueue = eQueueCreate ((void *)reqQueueBuff, sizeof(uint16_t), QUEUE_DEEP);
+    ackQueue = eQueueCreate ((void *)ackQueueBuff, sizeof(uint16_t), QUEUE_DEEP);
+
+    status += eTaskCreat(&wakeTcb, 5, wakeTaskFunc, 0,
+                 &wakeTaskStack[0], BENCH_STACK_SIZE_BYTES, "WAKE", 1);
+    status += eTaskCreat(&echoTcb, 6, echoTaskFunc, 0,
+                 &echoTaskStack[0], BENCH_STACK_SIZE_BYTES, "ECHO", 2);
+    status += eTaskCreat(&benchTcb, 10, benchTaskFunc, 0,
+                 &benchTaskStack[0], BENCH_STACK_SIZE_BYTES, "BENCH", 3);
+    status += eTaskCreat(&yieldTcb, 10, yieldTaskFunc, 0,
+                 &yieldTaskStack[0], BENCH_STACK_SIZE_BYTES, "YIELD", 4);
+
+    if (status == EASYRTOS_OK)
+    {
+      /* TIM1不分频,向上计数到0xFFFF,作为周期计数器 */
+      TIM1->PSCRH = 0;
+      TIM1->PSCRL = 0;
+      TIM1->ARRH = 0xFF;
+      TIM1->ARRL = 0xFF;
+      TIM1->CR1 = TIM1_CR1_CEN;
+
+      easyRTOSStart();
+    }
+  }
+  return 0;
+}
+
+/* 依次运行所有测试,其他任务都在等待 */
+void benchTaskFunc (uint32_t param)
+{
+  uint16_t start;
+  uint16_t cycles;
+  uint16_t msg = 0;
+  uint8_t *addr;
+  uint8_t i;
+
+  /* 停止系统心跳,测试期间没有其他中断 */
+  TIM4_Cmd(DISABLE);
+
+  /* 读取计数器本身的开销,与测量的写法相同 */
+  stampOverhead = 0xFFFF;
+  for (i = 0; i < BENCH_RUNS; i++)
+  {
+    stampStart = cycleGet ();
+    cycles = cycleGet () - stampStart;
+    if (cycles < stampOverhead)
+    {
+      stampOverhead = cycles;
+    }
+  }
+
+  /**
+   * 两个同优先级任务互相让出CPU.第一次让出时yieldTask从eSemTake()返回,
+   * 不记录;清除yieldActive后再让出一次,yieldTask回到eSemTake()等待,
+   * 不再留在就绪队列中影响后面的测试.
+   */
+  yieldActive = TRUE;
+  (void)eSemGive (&yieldSem);
+  for (i = 0; i < BENCH_RUNS; i++)
+  {
+    stampStart = cycleGet ();
+    eTaskYield ();
+    benchAdd (BENCH_SWITCH, cycleGet () - stampStart);
+  }
+  yieldActive = FALSE;
+  eTaskYield ();
+
+  /* 唤醒高优先级任务 */
+  for (i = 0; i < BENCH_RUNS; i++)
+  {
+    stampStart = cycleGet ();
+    (void)eSemGive (&wakeSem);
+  }
+
+  /* 队列往返 */
+  for (i = 0; i < BENCH_RUNS; i++)
+  {
+    stampStart = cycleGet ();
+    (void)eQueueGive (&reqQueue, 0, &msg);
+    (void)eQueueTake (&ackQueue, -1, &msg);
+    benchAdd (BENCH_QUEUE_RTT, cycleGet () - stampStart);
+    msg++;
+  }
+
+  /* 内存分配和释放 */
+  for (i = 0; i < BENCH_RUNS; i++)
+  {
+    stampStart = cycleGet ();
+    addr = eMalloc (BENCH_ALLOC_SIZE);
+    benchAdd (BENCH_MALLOC, cycleGet () - stampStart);
+    if (addr != NULL)
+    {
+      stampStart = cycleGet ();
+      eFree (addr);
+      benchAdd (BENCH_FREE, cycleGet () - stampStart);
+    }
+  }
+
+  /**
+   * 心跳中断:软件产生更新事件.先在不使能中断时测得写EGR本身的开销,
+   * 使能中断后写EGR立即进入中断,两者之差为整个中断的周期数.
+   */
+  for (i = 0; i < BENCH_RUNS; i++)
+  {
+    TIM4->IER = 0;
+    stampStart = cycleGet ();
+    TIM4->EGR = TIM4_EGR_UG;
+    start = cycleGet () - stampStart;
+    TIM4->SR1 = (uint8_t)(~(uint8_t)TIM4_IT_UPDATE);
+    TIM4->IER = TIM4_IER_UIE;
+
+    stampStart = cycleGet ();
+    TIM4->EGR = TIM4_EGR_UG;
+    cycles = cycleGet () - stampStart;
+    benchAdd (BENCH_TICK_ISR, (uint16_t)(cycles - start + stampOverhead));
+  }
+
+  TIM4_Cmd(ENABLE);
+
+  benchReport ();
+
+  (void)eTaskSuspend (&benchTcb);
+}
+
+/* 同优先级的让出测试,与benchTask交替运行,记录从对方让出到这里的周期数 */
+void yieldTaskFunc (uint32_t param)
+{
+  uint16_t cycles;
+
+  for (;;)
+  {
+    if (eSemTake (&yieldSem, 0) == EASYRTOS_OK)
+    {
+      while (yieldActive)
+      {
+        stampStart = cycleGet ();
+        eTaskYield ();
+        cycles = cycleGet () - stampStart;
+        if (yieldActive)
+        {
+          benchAdd (BENCH_SWITCH, cycles);
+        }
+      }
+    }
+  }
+}
+
+/* 记录从对方eSemGive()到这里的周期数 */
+void wakeTaskFunc (uint32_t param)
+{
+  for (;;)
+  {
+    if (eSemTake (&wakeSem, 0) == EASYRTOS_OK)
+    {
+      benchAdd (BENCH_SEM_WAKE, cycleGet () - stampStart);
+    }
+  }
+}
+
+/* 把收到的消息回送 */
+void echoTaskFunc (uint32_t param)
+{
+  uint16_t msg;
+
+  for (;;)
+  {
+    if (eQueueTake (&reqQueue, 0, &msg) == EASYRTOS_OK)
+    {
+      (void)eQueueGive (&ackQueue, -1, &msg);
+    }
+  }
+}
+
+/* 读取TIM1计数器,先读高字节,低字节在读取高字节时被锁存 */
+static uint16_t cycleGet (void)
+{
+  uint8_t h;
+
+  h = TIM1->CNTRH;
+  return ((uint16_t)(((uint16_t)h << 8) | TIM1->CNTRL));
+}
+
+static void benchAdd (uint8_t id, uint16_t cycles)
+{
+  BENCH_RESULT *result = &benchResult[id];
+
+  cycles -= stampOverhead;
+  if ((result->count == 0) || (cycles < result->min))
+  {
+    result->min = cycles;
+  }
+  if (cycles > result->max)
+  {
+    result->max = cycles;
+  }
+  result->count++;
+}
+
+static void benchPutc (char c)
+{
+  while ((UART1->SR & UART1_SR_TXE) == 0)
+  {
+  }
+  UART1->DR = (uint8_t)c;
+}
+
+static void benchPuts (const char *s)
+{
+  while (*s)
+  {
+    benchPutc (*s++);
+  }
+}
+
+/* 右对齐输出十进制数 */
+static void benchPutDec (uint16_t value, uint8_t width)
+{
+  char buff[6];
+  uint8_t len = 0;
+
+  do
+  {
+    buff[len++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+
+  while (width-- > len)
+  {
+    benchPutc (' ');
+  }
+  while (len)
+  {
+    benchPutc (buff[--len]);
+  }
+}
+
+/* 每行一项: 名称 采样次数 最小值 最大值 */
+static void benchReport (void)
+{
+  uint8_t i;
+  const char *name;
+
+  UART1_DeInit();
+  UART1_Init((uint32_t)BENCH_BAUD, UART1_WORDLENGTH_8D, UART1_STOPBITS_1,
+             UART1_PARITY_NO, UART1_SYNCMODE_CLOCK_DISABLE, UART1_MODE_TX_ENABLE);
+
+  benchPuts ("cycleBench: cycles @16MHz\r\n");
+  for (i = 0; i < BENCH_NUM; i++)
+  {
+    benchPuts (benchName[i]);
+    for (name = benchName[i]; *name; name++)
+    {
+      ;
+    }
+    benchPutDec ((uint16_t)benchResult[i].count, (uint8_t)(12 - (name - benchName[i])));
+    benchPutDec (benchResult[i].min, 8);
+    benchPutDec (benchResult[i].max, 8);
+    benchPuts ("\r\n");
+  }
+  benchPutc (0x04);
+}
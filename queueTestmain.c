@@ -1,7 +1,7 @@
 /**  
- * : Roy.yu
- * ʱ: 2016.8.23
- * 汾: V0.1
+ * 作者: Roy.yu
+ * 时间: 2016.8.23
+ * 版本: V0.1
  * Licence: GNU GENERAL PUBLIC LICENSE
  */
 #include "easyRTOS.h"
@@ -12,7 +12,7 @@
 #include "easyRTOSQueue.h"
 #include "easyRTOSMm.h"
 
-/*  malloc() */
+/* 包含 malloc() */
 //#include "stdlib.h"
 
 #define IDLE_STACK_SIZE_BYTES  128
@@ -43,7 +43,7 @@ int main( void )
   uint8_t *testTaskStack;
   uint8_t *queueTaskStack;
   
-  /* CPUΪڲʱ 16M*/
+  /* 设置CPU为内部时钟 16M*/
   CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
   
   eMemInit(heapRoom,HEAP_DEEP);
@@ -59,15 +59,15 @@ int main( void )
   {
     
   }
-  /* ϵͳʼ */
+  /* 系统初始化 */
   status = easyRTOSInit(idleTaskStack, IDLE_STACK_SIZE_BYTES);
   
   if (status == EASYRTOS_OK)
   {
-      /* ʹϵͳʱ */
+      /* 使能系统时钟 */
       archInitSystemTickTimer();
       
-      /*  */            
+      /* 创建任务 */            
       status += eTaskCreat(&testTcb,         
                    9, 
                    testTaskFunc, 
@@ -85,11 +85,11 @@ int main( void )
                    "QUEUE",
                    2);
       
-      /*  */
+      /* 创建队列 */
       qQueue = eQueueCreate ( (void *)a, sizeof(testStruct *), 2);
       if (status == EASYRTOS_OK)
       {
-        /* ϵͳ */
+        /* 启动系统 */
         easyRTOSStart();
       }
   }
@@ -0,0 +1,177 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 就绪队列性能测试:分别测量4/16/64个任务时,位图就绪队列与原有的按优先级排序的
+ * 双向链表的入队/出队/移除开销.TIM2不分频作为CPU周期计数器,结果保存在
+ * benchResult[]中,在C-SPY的Watch窗口中查看,单位为CPU周期(平均值/最大值).
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+
+#define IDLE_STACK_SIZE_BYTES 128
+#define BENCH_MAX_TASKS       64
+#define BENCH_ROUNDS          3
+
+NEAR static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+static EASYRTOS_TCB benchTcb[BENCH_MAX_TASKS];
+
+typedef struct benchCost
+{
+  uint16_t avg;   /* 平均周期数 */
+  uint16_t max;   /* 最大周期数 */
+} BENCH_COST;
+
+typedef struct benchResult
+{
+  uint8_t    tasks;         /* 任务数量 */
+  BENCH_COST readyEnqueue;  /* tcbEnqueueReady */
+  BENCH_COST readyDequeue;  /* tcb_dequeue_priority */
+  BENCH_COST readyRemove;   /* tcb_dequeue_ready */
+  BENCH_COST listEnqueue;   /* tcbEnqueuePriority */
+  BENCH_COST listDequeue;   /* tcb_dequeue_head */
+  BENCH_COST listRemove;    /* tcb_dequeue_entry */
+} BENCH_RESULT;
+
+static const uint8_t benchTasks[BENCH_ROUNDS] = {4, 16, 64};
+BENCH_RESULT benchResult[BENCH_ROUNDS];
+
+/* 读取计数器本身的开销 */
+static uint16_t benchOverhead;
+
+static uint16_t benchCycles (void);
+static void benchCostAdd (BENCH_COST *cost, uint32_t *sum, uint16_t start);
+static void benchRun (uint8_t tasks, BENCH_RESULT *result);
+
+int main( void )
+{
+  uint8_t i;
+  uint16_t start;
+
+  /* 内部时钟 16M */
+  CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
+
+  /* TIM2不分频,自由计数 */
+  TIM2->PSCR = 0;
+  TIM2->ARRH = 0xFF;
+  TIM2->ARRL = 0xFF;
+  TIM2->CR1 = TIM2_CR1_CEN;
+
+  /* 只需要初始化就绪队列,不启动系统 */
+  if (easyRTOSInit(&idleTaskStack[0], IDLE_STACK_SIZE_BYTES) != EASYRTOS_OK)
+  {
+    return 0;
+  }
+
+  start = benchCycles();
+  benchOverhead = benchCycles() - start;
+
+  for (i = 0; i < BENCH_ROUNDS; i++)
+  {
+    benchRun (benchTasks[i], &benchResult[i]);
+  }
+
+  while (1)
+  {
+    /* 在此处设置断点查看 benchResult */
+  }
+}
+
+/* 读取TIM2计数,先读高位再读低位 */
+static uint16_t benchCycles (void)
+{
+  uint8_t h = TIM2->CNTRH;
+  return (uint16_t)(((uint16_t)h << 8) | TIM2->CNTRL);
+}
+
+/* 统计一次操作的周期数 */
+static void benchCostAdd (BENCH_COST *cost, uint32_t *sum, uint16_t start)
+{
+  uint16_t cycles = benchCycles() - start - benchOverhead;
+
+  *sum += cycles;
+  if (cycles > cost->max)
+  {
+    cost->max = cycles;
+  }
+}
+
+static void benchRun (uint8_t tasks, BENCH_RESULT *result)
+{
+  CRITICAL_STORE;
+  EASYRTOS_TCB *list = NULL;
+  uint32_t sum[6] = {0, 0, 0, 0, 0, 0};
+  uint16_t start;
+  uint8_t i;
+
+  result->tasks = tasks;
+
+  CRITICAL_ENTER ();
+
+  for (i = 0; i < tasks; i++)
+  {
+    benchTcb[i].priority = i % EASYRTOS_IDLE_PRIO;
+  }
+
+  /* 位图就绪队列: 入队,取最高优先级出队 */
+  for (i = 0; i < tasks; i++)
+  {
+    start = benchCycles();
+    (void)tcbEnqueueReady (&benchTcb[i]);
+    benchCostAdd (&result->readyEnqueue, &sum[0], start);
+  }
+  for (i = 0; i < tasks; i++)
+  {
+    start = benchCycles();
+    (void)tcb_dequeue_priority (EASYRTOS_IDLE_PRIO - 1);
+    benchCostAdd (&result->readyDequeue, &sum[1], start);
+  }
+
+  /* 位图就绪队列: 从队尾开始移除指定任务 */
+  for (i = 0; i < tasks; i++)
+  {
+    (void)tcbEnqueueReady (&benchTcb[i]);
+  }
+  for (i = tasks; i > 0; i--)
+  {
+    start = benchCycles();
+    (void)tcb_dequeue_ready (&benchTcb[i - 1]);
+    benchCostAdd (&result->readyRemove, &sum[2], start);
+  }
+
+  /* 原有的排序链表: 优先级递增插入,每次都要遍历到链表尾 */
+  for (i = 0; i < tasks; i++)
+  {
+    start = benchCycles();
+    (void)tcbEnqueuePriority (&list, &benchTcb[i]);
+    benchCostAdd (&result->listEnqueue, &sum[3], start);
+  }
+  for (i = 0; i < tasks; i++)
+  {
+    start = benchCycles();
+    (void)tcb_dequeue_head (&list);
+    benchCostAdd (&result->listDequeue, &sum[4], start);
+  }
+  for (i = 0; i < tasks; i++)
+  {
+    (void)tcbEnqueuePriority (&list, &benchTcb[i]);
+  }
+  for (i = tasks; i > 0; i--)
+  {
+    start = benchCycles();
+    (void)tcb_dequeue_entry (&list, &benchTcb[i - 1]);
+    benchCostAdd (&result->listRemove, &sum[5], start);
+  }
+
+  CRITICAL_EXIT ();
+
+  result->readyEnqueue.avg = (uint16_t)(sum[0] / tasks);
+  result->readyDequeue.avg = (uint16_t)(sum[1] / tasks);
+  result->readyRemove.avg  = (uint16_t)(sum[2] / tasks);
+  result->listEnqueue.avg  = (uint16_t)(sum[3] / tasks);
+  result->listDequeue.avg  = (uint16_t)(sum[4] / tasks);
+  result->listRemove.avg   = (uint16_t)(sum[5] / tasks);
+}
@@ -0,0 +1,168 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * 调度请求标志性能测试:在没有任务状态变化的情况下,测量心跳中断、调度器以及
+ * 非阻塞的队列/信号量操作的开销.TIM2不分频作为CPU周期计数器,结果保存在
+ * benchResult中,单位为CPU周期(平均值/最大值).
+ * 分别以EASYRTOS_RESCHED_FLAG为0和1编译运行,对比两次的结果.
+ * 不启动系统心跳,心跳中断的处理由任务中直接调用模拟.
+ */
+#include "easyRTOS.h"
+#include "easyRTOSkernel.h"
+#include "easyRTOSport.h"
+#include "easyRTOSTimer.h"
+#include "easyRTOSSem.h"
+#include "easyRTOSQueue.h"
+
+#define IDLE_STACK_SIZE_BYTES  128
+#define BENCH_STACK_SIZE_BYTES 256
+#define BENCH_LOOPS            32
+
+NEAR static uint8_t idleTaskStack[IDLE_STACK_SIZE_BYTES];
+NEAR static uint8_t benchTaskStack[BENCH_STACK_SIZE_BYTES];
+
+EASYRTOS_TCB benchTcb;
+EASYRTOS_QUEUE benchQueue;
+EASYRTOS_SEM benchSem;
+static uint8_t benchQueueBuff[4];
+
+typedef struct benchCost
+{
+  uint16_t avg;   /* 平均周期数 */
+  uint16_t max;   /* 最大周期数 */
+} BENCH_COST;
+
+typedef struct benchResult
+{
+  uint8_t    reschedFlag;   /* EASYRTOS_RESCHED_FLAG */
+  BENCH_COST tick;          /* eIntEnter/eTimerTick/eIntExit(TRUE) */
+  BENCH_COST sched;         /* easyRTOSSched(FALSE) */
+  BENCH_COST queueGive;     /* eQueueGive,没有等待任务 */
+  BENCH_COST queueTake;     /* eQueueTake,没有等待任务 */
+  BENCH_COST semGive;       /* eSemGive,没有等待任务 */
+  BENCH_COST semTake;       /* eSemTake,count不为0 */
+} BENCH_RESULT;
+
+BENCH_RESULT benchResult;
+
+/* 读取计数器本身的开销 */
+static uint16_t benchOverhead;
+
+void benchTaskFunc (uint32_t param);
+static uint16_t benchCycles (void);
+static void benchCostAdd (BENCH_COST *cost, uint32_t *sum, uint16_t start);
+
+int main( void )
+{
+  ERESULT status;
+
+  /* 内部时钟 16M */
+  CLK_HSIPrescalerConfig(CLK_PRESCALER_HSIDIV1);
+
+  /* TIM2不分频,自由计数 */
+  TIM2->PSCR = 0;
+  TIM2->ARRH = 0xFF;
+  TIM2->ARRL = 0xFF;
+  TIM2->CR1 = TIM2_CR1_CEN;
+
+  status = easyRTOSInit(&idleTaskStack[0], IDLE_STACK_SIZE_BYTES);
+  if (status == EASYRTOS_OK)
+  {
+    status = eTaskCreat(&benchTcb,
+                 10,
+                 benchTaskFunc,
+                 0,
+                 &benchTaskStack[0],
+                 BENCH_STACK_SIZE_BYTES,
+                 "BENCH",
+                 1);
+    benchQueue = eQueueCreate ((void *)benchQueueBuff, sizeof(uint8_t), 4);
+    benchSem = eSemCreateCount (0);
+    if (status == EASYRTOS_OK)
+    {
+      /* 不调用archInitSystemTickTimer(),避免心跳中断干扰测量 */
+      easyRTOSStart();
+    }
+  }
+  return 0;
+}
+
+void benchTaskFunc (uint32_t param)
+{
+  CRITICAL_STORE;
+  uint32_t sum[6] = {0, 0, 0, 0, 0, 0};
+  uint16_t start;
+  uint8_t msg = 0;
+  uint8_t i;
+
+  start = benchCycles();
+  benchOverhead = benchCycles() - start;
+  benchResult.reschedFlag = EASYRTOS_RESCHED_FLAG;
+
+  for (i = 0; i < BENCH_LOOPS; i++)
+  {
+    /* 心跳中断的处理过程,时间片不会用完 */
+    eTaskSetTimeSlice (&benchTcb, 0xFF);
+    CRITICAL_ENTER ();
+    start = benchCycles();
+    eIntEnter ();
+    eTimerTick ();
+    eIntExit (TRUE);
+    benchCostAdd (&benchResult.tick, &sum[0], start);
+    CRITICAL_EXIT ();
+
+    start = benchCycles();
+    easyRTOSSched (FALSE);
+    benchCostAdd (&benchResult.sched, &sum[1], start);
+
+    start = benchCycles();
+    (void)eQueueGive (&benchQueue, -1, &msg);
+    benchCostAdd (&benchResult.queueGive, &sum[2], start);
+
+    start = benchCycles();
+    (void)eQueueTake (&benchQueue, -1, &msg);
+    benchCostAdd (&benchResult.queueTake, &sum[3], start);
+
+    start = benchCycles();
+    (void)eSemGive (&benchSem);
+    benchCostAdd (&benchResult.semGive, &sum[4], start);
+
+    start = benchCycles();
+    (void)eSemTake (&benchSem, -1);
+    benchCostAdd (&benchResult.semTake, &sum[5], start);
+  }
+
+  benchResult.tick.avg      = (uint16_t)(sum[0] / BENCH_LOOPS);
+  benchResult.sched.avg     = (uint16_t)(sum[1] / BENCH_LOOPS);
+  benchResult.queueGive.avg = (uint16_t)(sum[2] / BENCH_LOOPS);
+  benchResult.queueTake.avg = (uint16_t)(sum[3] / BENCH_LOOPS);
+  benchResult.semGive.avg   = (uint16_t)(sum[4] / BENCH_LOOPS);
+  benchResult.semTake.avg   = (uint16_t)(sum[5] / BENCH_LOOPS);
+
+  while (1)
+  {
+    /* 在此处设置断点查看 benchResult */
+  }
+}
+
+/* 读取TIM2计数,先读高位再读低位 */
+static uint16_t benchCycles (void)
+{
+  uint8_t h = TIM2->CNTRH;
+  return (uint16_t)(((uint16_t)h << 8) | TIM2->CNTRL);
+}
+
+/* 统计一次操作的周期数 */
+static void benchCostAdd (BENCH_COST *cost, uint32_t *sum, uint16_t start)
+{
+  uint16_t cycles = benchCycles() - start - benchOverhead;
+
+  *sum += cycles;
+  if (cycles > cost->max)
+  {
+    cost->max = cycles;
+  }
+}
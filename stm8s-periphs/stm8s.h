@@ -75,6 +75,8 @@
  #define _RAISONANCE_
 #elif defined(__ICCSTM8__)
  #define _IAR_
+#elif defined(__SDCC)
+ #define _SDCC_
 #else
  #error "Unsupported Compiler!"          /* Compiler defines not found */
 #endif
@@ -128,6 +130,13 @@
   /*!< Used with memory Models for code less than 64K */
   #define MEMCPY memcpy
  #endif /* STM8S208 or STM8S207 or STM8S007 or STM8AF62Ax or STM8AF52Ax */ 
+#elif defined (_SDCC_)
+ /* SDCC has no memory qualifiers, medium memory model assumed */
+ #define FAR
+ #define NEAR
+ #define TINY
+ #define EEPROM
+ #define CONST  const
 #else /*_IAR_*/
  #define FAR  __far
  #define NEAR __near
@@ -159,6 +168,8 @@
    #define IN_RAM(a) a
  #elif defined (_RAISONANCE_) /* __RCST7__ */
    #define IN_RAM(a) a inram
+ #elif defined (_SDCC_)
+   #define IN_RAM(a) a
  #else /*_IAR_*/
   #define IN_RAM(a) __ramfunc a
  #endif /* _COSMIC_ */
@@ -2615,6 +2626,15 @@ CFG_TypeDef;
  #define trap()                {_asm("trap\n");} /* Trap (soft IT) */
  #define wfi()                 {_asm("wfi\n");}  /* Wait For Interrupt */
  #define halt()                {_asm("halt\n");} /* Halt */
+#elif defined(_SDCC_)
+ #define enableInterrupts()    __asm__("rim")  /* enable interrupts */
+ #define disableInterrupts()   __asm__("sim")  /* disable interrupts */
+ #define rim()                 __asm__("rim")  /* enable interrupts */
+ #define sim()                 __asm__("sim")  /* disable interrupts */
+ #define nop()                 __asm__("nop")  /* No Operation */
+ #define trap()                __asm__("trap") /* Trap (soft IT) */
+ #define wfi()                 __asm__("wfi")  /* Wait For Interrupt */
+ #define halt()                __asm__("halt") /* Halt */
 #else /*_IAR_*/
  #include <intrinsics.h>
  #define enableInterrupts()    __enable_interrupt()   /* enable interrupts */
@@ -2639,6 +2659,11 @@ CFG_TypeDef;
  #define INTERRUPT_HANDLER_TRAP(a) void a(void) trap
 #endif /* _RAISONANCE_ */
 
+#ifdef _SDCC_
+ #define INTERRUPT_HANDLER(a,b) void a(void) __interrupt(b)
+ #define INTERRUPT_HANDLER_TRAP(a) void a(void) __trap
+#endif /* _SDCC_ */
+
 #ifdef _IAR_
  #define STRINGVECTOR(x) #x
  #define VECTOR_ID(x) STRINGVECTOR( vector = (x) )
@@ -0,0 +1,583 @@
+/**
+ * 作者: Roy.yu
+ * 时间: 2017.04.26
+ * 版本: V1.2
+ * Licence: GNU GENERAL PUBLIC LICENSE
+ *
+ * easyRTOS跟踪记录解析工具,在PC上运行.
+ * 读取eTraceDump()从UART1导出的二进制数据(可以包含多次导出以及导出之间的
+ * 其他串口输出),生成Chrome trace-event格式的JSON,可以在chrome://tracing或者
+ * https://ui.perfetto.dev 中打开,同时在标准输出打印每个任务的统计.
+ *
+ * 用法: traceDecode <dump.bin> [-o trace.json]
+ *
+ * 时间线:
+ * 每个任务一行,显示运行区间以及在信号量/队列上阻塞的区间.
+ * 中断单独一行,嵌套的中断显示为嵌套的区间.
+ * 统计:
+ * 运行时间,切入次数,响应时间(就绪到运行),最长阻塞时间(阻塞到就绪).
+ *
+ * 时间戳为16位的1us计数,65ms回零.相邻两条记录的间隔总是小于65ms
+ * (系统心跳的中断进出都有记录),按记录顺序累加差值即可得到完整的时间.
+ * 无心跳睡眠和停止记录的前后各有一条TRACE_TICK_SYNC,两条之间按时间戳累加
+ * 的时间比心跳数少一个心跳以上时(时间戳回零或者睡眠期间停止计数),
+ * 以心跳数为准.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* 与kernel/easyRTOSTrace.h保持一致 */
+#define TRACE_VERSION           2
+#define TRACE_REC_SIZE          8
+
+#define TRACE_TASK_SWITCH       0x01
+#define TRACE_INT_ENTER         0x02
+#define TRACE_INT_EXIT          0x03
+#define TRACE_TASK_CREATE       0x04
+#define TRACE_TASK_READY        0x05
+#define TRACE_TICK_SYNC         0x06
+#define TRACE_SEM_GIVE          0x10
+#define TRACE_SEM_TAKE          0x11
+#define TRACE_SEM_BLOCK         0x12
+#define TRACE_QUEUE_GIVE        0x20
+#define TRACE_QUEUE_TAKE        0x21
+#define TRACE_QUEUE_BLOCK       0x22
+#define TRACE_TIMER_EXPIRE      0x30
+
+#define TASK_NUM                256
+#define ISR_NEST_MAX            8
+
+/* 中断在时间线中使用的tid */
+#define ISR_TID                 TASK_NUM
+
+/* 解析后的一条记录 */
+typedef struct traceRec
+{
+  uint64_t time;      /* 展开后的时间,us */
+  uint8_t  event;
+  uint8_t  arg8;
+  uint16_t obj;
+  uint16_t arg;
+} TRACE_REC;
+
+/* 每个任务的状态以及统计 */
+typedef struct taskStat
+{
+  int       seen;
+  int       prio;
+  uint32_t  switches;     /* 切入次数 */
+  int       running;
+  uint64_t  runStart;
+  uint64_t  runTotal;
+
+  int       readyPending; /* 就绪但还没有运行 */
+  uint64_t  readyAt;
+  uint32_t  respCnt;
+  uint64_t  respSum;
+  uint64_t  respMax;
+
+  int       blocked;      /* 在信号量/队列上阻塞 */
+  uint64_t  blockAt;
+  uint8_t   blockEvent;
+  uint16_t  blockObj;
+  uint32_t  blocks;
+  uint64_t  blockMax;
+  uint16_t  blockMaxObj;
+} TASK_STAT;
+
+/* 本地数据 */
+static TASK_STAT tasks[TASK_NUM];
+static FILE *json = NULL;
+static int jsonFirst = 1;
+static int currTask = -1;
+static uint64_t lastTime = 0;
+
+/* 上一条TRACE_TICK_SYNC的心跳计数以及展开后的时间 */
+static int syncValid = 0;
+static uint16_t syncTicks = 0;
+static uint64_t syncTime = 0;
+
+static int isrNest = 0;
+static uint64_t isrStart[ISR_NEST_MAX];
+static uint32_t isrCount = 0;
+static uint64_t isrTotal = 0;
+static uint64_t isrMax = 0;
+
+static uint32_t recTotal = 0;
+static uint32_t recLost = 0;
+static int lostSaturated = 0;
+static uint32_t dumps = 0;
+
+/* 私有函数 */
+static uint16_t readU16 (const uint8_t *p, int bigEndian);
+static long findDump (const uint8_t *data, long size, long pos);
+static void tickSync (const TRACE_REC *rec);
+static void decodeRec (const TRACE_REC *rec);
+static void jsonSlice (const char *name, const char *cat, int tid, uint64_t start, uint64_t end);
+static void jsonThreadName (int tid, const char *name);
+static void taskSeen (int id, int prio);
+static void printSummary (void);
+
+/**
+ * 功能: 按导出数据的字节序读取16位数据.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * const uint8_t *p 数据         无
+ * int bigEndian 是否为大端
+ *
+ * 返回:
+ * uint16_t
+ */
+static uint16_t readU16 (const uint8_t *p, int bigEndian)
+{
+  if (bigEndian)
+  {
+    return (uint16_t)((p[0] << 8) | p[1]);
+  }
+  return (uint16_t)((p[1] << 8) | p[0]);
+}
+
+/**
+ * 功能: 从pos开始查找下一次导出的标识"ETRC".
+ *
+ * 参数:
+ * 输入:                         输出:
+ * const uint8_t *data 数据      无
+ * long size 数据长度
+ * long pos 开始位置
+ *
+ * 返回:
+ * long 标识的位置,没有找到时返回-1
+ */
+static long findDump (const uint8_t *data, long size, long pos)
+{
+  for (; pos + 4 <= size; pos++)
+  {
+    if (memcmp (&data[pos], "ETRC", 4) == 0)
+    {
+      return (pos);
+    }
+  }
+  return (-1);
+}
+
+/**
+ * 功能: 输出一个时间线区间(Chrome trace-event的"X"事件).
+ *
+ * 参数:
+ * 输入:                         输出:
+ * const char *name 名称         无
+ * const char *cat 分类
+ * int tid 所在行
+ * uint64_t start 开始时间,us
+ * uint64_t end 结束时间,us
+ *
+ * 返回:void
+ */
+static void jsonSlice (const char *name, const char *cat, int tid, uint64_t start, uint64_t end)
+{
+  if (json == NULL)
+  {
+    return;
+  }
+  fprintf (json, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+           "\"ts\":%llu,\"dur\":%llu}",
+           jsonFirst ? "" : ",", name, cat, tid,
+           (unsigned long long)start, (unsigned long long)(end - start));
+  jsonFirst = 0;
+}
+
+/**
+ * 功能: 输出时间线中一行的名称(Chrome trace-event的"M"事件).
+ *
+ * 参数:
+ * 输入:                         输出:
+ * int tid 所在行                无
+ * const char *name 名称
+ *
+ * 返回:void
+ */
+static void jsonThreadName (int tid, const char *name)
+{
+  if (json == NULL)
+  {
+    return;
+  }
+  fprintf (json, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+           "\"args\":{\"name\":\"%s\"}}",
+           jsonFirst ? "" : ",", tid, name);
+  fprintf (json, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+           "\"args\":{\"sort_index\":%d}}", tid, tid);
+  jsonFirst = 0;
+}
+
+/**
+ * 功能: 第一次见到任务时输出其名称,并更新优先级.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * int id 任务ID                 无
+ * int prio 任务优先级,未知时为-1
+ *
+ * 返回:void
+ */
+static void taskSeen (int id, int prio)
+{
+  char name[32];
+
+  if (!tasks[id].seen)
+  {
+    tasks[id].seen = 1;
+    tasks[id].prio = -1;
+    snprintf (name, sizeof(name), "task %d", id);
+    jsonThreadName (id, name);
+  }
+  if (prio >= 0)
+  {
+    tasks[id].prio = prio;
+  }
+}
+
+/**
+ * 功能: 处理TRACE_TICK_SYNC记录.与上一条同步记录之间的心跳时间比
+ * 累加的时间戳差值多出一个心跳以上时,说明时间戳计数回零或者停止,
+ * 把多出的时间补到lastTime上.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * const TRACE_REC *rec 记录     无
+ *
+ * 返回:void
+ */
+static void tickSync (const TRACE_REC *rec)
+{
+  uint64_t ticked, stamped;
+
+  if (syncValid)
+  {
+    ticked = (uint64_t)(uint16_t)(rec->arg - syncTicks) * rec->obj;
+    stamped = lastTime - syncTime;
+    if (ticked > stamped + rec->obj)
+    {
+      lastTime += ticked - stamped;
+    }
+  }
+  syncValid = 1;
+  syncTicks = rec->arg;
+  syncTime = lastTime;
+}
+
+/**
+ * 功能: 处理一条记录,更新任务状态,输出时间线区间.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * const TRACE_REC *rec 记录     无
+ *
+ * 返回:void
+ */
+static void decodeRec (const TRACE_REC *rec)
+{
+  TASK_STAT *t;
+  uint64_t d;
+  char name[48];
+  int id;
+
+  switch (rec->event)
+  {
+    case TRACE_TASK_CREATE:
+      taskSeen (rec->arg8, rec->arg & 0xFF);
+      break;
+
+    case TRACE_TASK_READY:
+      taskSeen (rec->arg8, rec->arg & 0xFF);
+      t = &tasks[rec->arg8];
+
+      /* 阻塞结束 */
+      if (t->blocked)
+      {
+        d = rec->time - t->blockAt;
+        if (d > t->blockMax)
+        {
+          t->blockMax = d;
+          t->blockMaxObj = t->blockObj;
+        }
+        snprintf (name, sizeof(name), "blocked on %s 0x%04X",
+                  (t->blockEvent == TRACE_SEM_BLOCK) ? "sem" : "queue", t->blockObj);
+        jsonSlice (name, "block", rec->arg8, t->blockAt, rec->time);
+        t->blocked = 0;
+      }
+      if (!t->readyPending)
+      {
+        t->readyPending = 1;
+        t->readyAt = rec->time;
+      }
+      break;
+
+    case TRACE_TASK_SWITCH:
+      /* 原任务结束运行 */
+      id = rec->arg >> 8;
+      if ((id != 0xFF) && tasks[id].running)
+      {
+        t = &tasks[id];
+        t->running = 0;
+        t->runTotal += rec->time - t->runStart;
+        jsonSlice ("run", "run", id, t->runStart, rec->time);
+      }
+
+      /* 新任务开始运行 */
+      taskSeen (rec->arg8, rec->arg & 0xFF);
+      t = &tasks[rec->arg8];
+      t->running = 1;
+      t->runStart = rec->time;
+      t->switches++;
+      if (t->readyPending)
+      {
+        d = rec->time - t->readyAt;
+        t->respCnt++;
+        t->respSum += d;
+        if (d > t->respMax)
+        {
+          t->respMax = d;
+        }
+        t->readyPending = 0;
+      }
+      currTask = rec->arg8;
+      break;
+
+    case TRACE_INT_ENTER:
+      if ((rec->arg8 > 0) && (rec->arg8 <= ISR_NEST_MAX))
+      {
+        isrNest = rec->arg8;
+        isrStart[isrNest - 1] = rec->time;
+      }
+      break;
+
+    case TRACE_INT_EXIT:
+      /* arg8为退出后的嵌套层数 */
+      if ((rec->arg8 < ISR_NEST_MAX) && (rec->arg8 < isrNest))
+      {
+        d = rec->time - isrStart[rec->arg8];
+        jsonSlice (rec->arg8 ? "nested isr" : "isr", "isr", ISR_TID, isrStart[rec->arg8], rec->time);
+        if (rec->arg8 == 0)
+        {
+          isrCount++;
+          isrTotal += d;
+          if (d > isrMax)
+          {
+            isrMax = d;
+          }
+        }
+        isrNest = rec->arg8;
+      }
+      break;
+
+    case TRACE_SEM_BLOCK:
+    case TRACE_QUEUE_BLOCK:
+      taskSeen (rec->arg8, -1);
+      t = &tasks[rec->arg8];
+      t->blocked = 1;
+      t->blockAt = rec->time;
+      t->blockEvent = rec->event;
+      t->blockObj = rec->obj;
+      t->blocks++;
+      break;
+
+    default:
+      /* 其他事件只用于查看原始记录 */
+      break;
+  }
+}
+
+/**
+ * 功能: 打印每个任务的统计.
+ *
+ * 参数:
+ * 输入:                         输出:
+ * 无                            无
+ *
+ * 返回:void
+ */
+static void printSummary (void)
+{
+  TASK_STAT *t;
+  int id;
+
+  printf ("dumps %u, records %u, overwritten %s%u, span %llu us\n",
+          dumps, recTotal, lostSaturated ? ">=" : "", recLost,
+          (unsigned long long)lastTime);
+  printf ("%4s %4s %8s %10s %6s %10s %10s %6s %10s %8s\n",
+          "task", "prio", "switches", "run(us)", "cpu%",
+          "resp avg", "resp max", "blocks", "block max", "on");
+  for (id = 0; id < TASK_NUM; id++)
+  {
+    t = &tasks[id];
+    if (!t->seen)
+    {
+      continue;
+    }
+    printf ("%4d %4d %8u %10llu %6.2f %10llu %10llu %6u %10llu ",
+            id, t->prio, t->switches,
+            (unsigned long long)t->runTotal,
+            lastTime ? (100.0 * (double)t->runTotal / (double)lastTime) : 0.0,
+            (unsigned long long)(t->respCnt ? t->respSum / t->respCnt : 0),
+            (unsigned long long)t->respMax,
+            t->blocks,
+            (unsigned long long)t->blockMax);
+    if (t->blockMax)
+    {
+      printf ("0x%04X\n", t->blockMaxObj);
+    }
+    else
+    {
+      printf ("%8s\n", "-");
+    }
+  }
+  printf ("isr: count %u, total %llu us, max %llu us\n",
+          isrCount, (unsigned long long)isrTotal, (unsigned long long)isrMax);
+}
+
+int main (int argc, char *argv[])
+{
+  const char *inName = NULL;
+  const char *outName = "trace.json";
+  FILE *in;
+  uint8_t *data;
+  long size;
+  long pos;
+  int i;
+  int bigEndian;
+  uint16_t count, written, prev, now;
+  uint16_t n;
+  const uint8_t *p;
+  TRACE_REC rec;
+
+  for (i = 1; i < argc; i++)
+  {
+    if ((strcmp (argv[i], "-o") == 0) && (i + 1 < argc))
+    {
+      outName = argv[++i];
+    }
+    else if (inName == NULL)
+    {
+      inName = argv[i];
+    }
+    else
+    {
+      inName = NULL;
+      break;
+    }
+  }
+  if (inName == NULL)
+  {
+    fprintf (stderr, "usage: %s <dump.bin> [-o trace.json]\n", argv[0]);
+    return (1);
+  }
+
+  /* 读入整个文件 */
+  in = fopen (inName, "rb");
+  if (in == NULL)
+  {
+    perror (inName);
+    return (1);
+  }
+  fseek (in, 0, SEEK_END);
+  size = ftell (in);
+  fseek (in, 0, SEEK_SET);
+  data = (uint8_t *)malloc (size ? size : 1);
+  if ((data == NULL) || (fread (data, 1, size, in) != (size_t)size))
+  {
+    fprintf (stderr, "%s: read error\n", inName);
+    fclose (in);
+    return (1);
+  }
+  fclose (in);
+
+  json = fopen (outName, "w");
+  if (json == NULL)
+  {
+    perror (outName);
+    free (data);
+    return (1);
+  }
+  fprintf (json, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  jsonThreadName (ISR_TID, "ISR");
+
+  /* 依次解析每次导出,多次导出的时间依次接在一起 */
+  pos = 0;
+  while ((pos = findDump (data, size, pos)) >= 0)
+  {
+    p = &data[pos];
+    if ((pos + 12 > size) || (p[4] != TRACE_VERSION) || (p[5] != TRACE_REC_SIZE))
+    {
+      pos += 4;
+      continue;
+    }
+
+    /* 0x1234用于判断字节序,STM8为大端 */
+    bigEndian = (p[6] == 0x12) && (p[7] == 0x34);
+    count = readU16 (&p[8], bigEndian);
+    written = readU16 (&p[10], bigEndian);
+    if (pos + 12 + (long)count * TRACE_REC_SIZE > size)
+    {
+      fprintf (stderr, "dump at offset %ld truncated\n", pos);
+      break;
+    }
+    dumps++;
+    recTotal += count;
+    recLost += (uint16_t)(written - count);
+    if (written == 0xFFFF)
+    {
+      /* 写入总数已经饱和,实际覆盖的更多 */
+      lostSaturated = 1;
+    }
+    p += 12;
+
+    /* 导出之间的时间未知,从上一次导出的结束时间继续 */
+    syncValid = 0;
+    prev = count ? readU16 (p, bigEndian) : 0;
+    for (n = 0; n < count; n++, p += TRACE_REC_SIZE)
+    {
+      now = readU16 (p, bigEndian);
+      lastTime += (uint16_t)(now - prev);
+      prev = now;
+
+      rec.event = p[2];
+      rec.arg8 = p[3];
+      rec.obj = readU16 (&p[4], bigEndian);
+      rec.arg = readU16 (&p[6], bigEndian);
+      if (rec.event == TRACE_TICK_SYNC)
+      {
+        tickSync (&rec);
+      }
+
+      rec.time = lastTime;
+      decodeRec (&rec);
+    }
+
+    pos += 12 + (long)count * TRACE_REC_SIZE;
+  }
+
+  /* 结束仍在运行的任务 */
+  if ((currTask >= 0) && tasks[currTask].running)
+  {
+    tasks[currTask].runTotal += lastTime - tasks[currTask].runStart;
+    jsonSlice ("run", "run", currTask, tasks[currTask].runStart, lastTime);
+  }
+
+  fprintf (json, "\n]}\n");
+  fclose (json);
+  free (data);
+
+  if (dumps == 0)
+  {
+    fprintf (stderr, "%s: no trace dump found\n", inName);
+    return (1);
+  }
+
+  printSummary ();
+  return (0);
+}